@@ -924,6 +924,44 @@ const
    }
 }
 
+// same as ApplyTriangles, but passes a caller-supplied pointer to f (so that callers need no global state)
+void Mesh::ApplyTriangles(void (*f)( Point2d p1, Point2d p2, Point2d p3, void *data ), void *data)
+const
+{
+   QuadEdge *qp;
+   Edge *e;
+   LlistPos p;
+
+   // zero left, right marks for all edges
+    for (p = edges.first(); !edges.isEnd(p); p = edges.next(p)) {
+       qp = (QuadEdge *)edges.retrieve(p);
+       e = qp->edges();
+       e->lmark() = 0;
+       e->Sym()->lmark() = 0;
+       }
+
+   // for each edge, apply f to left and right face
+    for (p = edges.first(); !edges.isEnd(p); p = edges.next(p)) {
+       qp = (QuadEdge *)edges.retrieve(p);
+       e = qp->edges();
+
+       if (hasLeftFace(e) && !e->lmark())
+       {
+               // apply to face e, e->Onext(), e->Dprev()
+               f( e->Org2d(), e->Onext()->Dest2d(), e->Dprev()->Dest2d(), data );
+               e->Onext()->Sym()->lmark() = 1;
+               e->Dprev()->Sym()->lmark() = 1;
+       }
+
+       if (hasRightFace(e) && !e->Sym()->lmark())
+       {
+               f( e->Org2d(), e->Oprev()->Dest2d(), e->Dnext()->Dest2d(), data );
+               e->Oprev()->lmark() = 1;
+               e->Dnext()->lmark() = 1;
+       }
+   }
+}
+
 void Mesh::ApplyTaggedMesh(void (*f)(int isconstrained, void *tag1, void *tag2)) const
 {
 	QuadEdge *qp;
@@ -362,6 +362,7 @@ class Mesh {
 	void Apply(void (*f)(int isconstrained, double x1, double y1, double x2, double y2)) const;
 #if MARKED
 	void ApplyTriangles(void (*f)( Point2d p1, Point2d p2, Point2d p3 )) const;
+	void ApplyTriangles(void (*f)( Point2d p1, Point2d p2, Point2d p3, void *data ), void *data) const;
 #endif
 	void ApplyTaggedMesh(void (*f)(int isconstrained, void *tag1, void *tag2)) const;
 	void ApplyTaggedKey(void *key1, void *key2,
@@ -2,6 +2,7 @@
 #define _SBL_COMMAND_H_
 #include <sbl/core/Config.h>
 #include <sbl/core/Table.h>
+#include <sbl/core/Parallel.h>
 namespace sbl {
 
 
@@ -83,7 +84,8 @@ void runScript( const String &fileName );
 void setCommandEventCallback( void (*commandEventCallback)() );
 
 
-/// check for events (e.g. update GUI) and return true if command cancel
+/// check for events (e.g. update GUI) and return true if command cancel;
+/// on parallel worker threads, this only checks for cancellation (events are handled by the thread running the command)
 bool checkCommandEvents();
 
 
@@ -91,6 +93,15 @@ bool checkCommandEvents();
 void setCancelCommand( bool cancel );
 
 
+/// true if the current command has been cancelled; unlike checkCommandEvents, this doesn't handle events, so it can be called from any thread
+bool commandCancelled();
+
+
+/// the token set when the current command is cancelled (by setCancelCommand or CTRL-C); pass it to parallelFor or TaskGroup
+/// to stop parallel work when the command is cancelled
+CancelToken &commandCancelToken();
+
+
 //-------------------------------------------
 // CLEANUP MANAGEMENT
 //-------------------------------------------
@@ -131,6 +131,9 @@ public:
 	/// copy values for entries that are specified in other config
 	void updateFrom( const Config &conf );
 
+	/// replace the entries, settings, and command args (including the position of the next command arg) with those of another config
+	void copyFrom( const Config &conf );
+
 	/// set an array of command arguments, to be assigned to subsequent calls to read() functions
 	void setCommandArgs( const Array<String> &commandArgs );
 
@@ -28,7 +28,8 @@ void fatalError( const char *str, ... );
 
 /// displays progress bar (assumes index in [0, count - 1]);
 /// closes progress bar when index == count - 1; 
-/// if count == -1, assumes unknown number if items
+/// if count == -1, assumes unknown number if items;
+/// ignored on parallel worker threads (use a ProgressCounter to report progress of parallel work)
 void progress( int index, int count = -1 );
 inline void progressDone() { progress( 0, 1 ); }
 
@@ -49,6 +50,10 @@ void setMaxDisplayedIndent( int maxIndent );
 #define assertAlways( condition ) if (!(condition)) fatalError( "assert failed at %s:%d", __FILE__, __LINE__, #condition );
 
 
+// note: the custom handlers below are only called on the thread running the command (not on worker threads; see workerThread());
+// messages from worker threads are still written to the display and log files
+
+
 /// set a custom handler for disp() messages
 void setDispCallback( void (*dispCallback)( const char *str ) );
 
@@ -0,0 +1,271 @@
+#ifndef _SBL_PARALLEL_H_
+#define _SBL_PARALLEL_H_
+#include <atomic>
+#include <thread>
+#include <stddef.h>
+namespace sbl {
+
+
+/*! \file Parallel.h
+	\brief The Parallel module provides a work-stealing task scheduler, with parallel loops over 1D and 2D ranges
+	and groups of tasks.  Each worker thread keeps its own queue of tasks; a loop's range is split in half repeatedly,
+	with one half queued (where idle threads can steal it) and the other half run immediately.  A thread waiting for
+	a loop or task group runs queued tasks until the work is done.  By default, loops started from inside a parallel
+	loop or task are run serially on the calling thread (see setNestedParallel).  Loops and task groups can be cancelled
+	with a CancelToken, and ProgressCounter objects let worker threads report progress.
+*/
+
+
+// register commands, etc. defined in this module
+void initParallel();
+
+
+/// the number of threads (including the calling thread) used by parallel loops; by default, this is given by
+/// the SBL_THREAD_COUNT environment variable, the threadCount entry of the path config, or the number of processor cores
+int threadCount();
+
+
+/// set the number of threads used by parallel loops; 1 disables threading (call when no parallel work is running)
+void setThreadCount( int count );
+
+
+/// set whether loops started from inside a parallel loop or task are split across the worker threads (rather than run serially)
+void setNestedParallel( bool nestedParallel );
+
+
+//-------------------------------------------
+// CANCELLATION AND PROGRESS
+//-------------------------------------------
+
+
+/// The CancelToken class is a flag that can be set from any thread (or a signal handler) and checked from any thread;
+/// checking it is a single relaxed atomic load, so it can be polled in inner loops.
+class CancelToken {
+public:
+
+	// create a token that isn't cancelled
+	CancelToken() : m_cancelled( false ) {}
+
+	/// request cancellation / clear the request
+	inline void cancel() { m_cancelled.store( true, std::memory_order_relaxed ); }
+	inline void reset() { m_cancelled.store( false, std::memory_order_relaxed ); }
+
+	/// true if cancellation has been requested
+	inline bool cancelled() const { return m_cancelled.load( std::memory_order_relaxed ); }
+
+private:
+
+	// the flag
+	std::atomic<bool> m_cancelled;
+
+	// disable copy constructor and assignment operator
+	CancelToken( const CancelToken &x );
+	CancelToken &operator=( const CancelToken &x );
+};
+
+
+/// true if the loop or task group that the current thread is working on has been cancelled (false if not in a loop or task);
+/// loop bodies can poll this to stop work on the current sub-range early
+bool taskCancelled();
+
+
+/// true if the current thread is one of the scheduler's worker threads or has been marked with markWorkerThread;
+/// worker threads don't handle GUI events or call the display callbacks (these are left to the thread running the command)
+bool workerThread();
+
+
+/// mark the current thread as a worker thread; called by background threads that the library creates outside the scheduler
+void markWorkerThread();
+
+
+/// The ProgressCounter class counts completed work items.  Any thread can add to the count (without locking),
+/// but only the thread that created the counter passes the count to progress() (so that progress callbacks are made
+/// on the same thread as before), at most once per report interval: when report() is called, and while the thread
+/// waits for parallel loops and task groups.  The destructor closes the progress display.
+class ProgressCounter {
+public:
+
+	/// create a counter for the given number of items, reported at most every reportInterval seconds
+	explicit ProgressCounter( int total, double reportInterval = 0.2 );
+
+	// close the progress display
+	~ProgressCounter();
+
+	/// add to the count of completed items (from any thread)
+	inline void add( int count = 1 ) { m_count.fetch_add( count, std::memory_order_relaxed ); }
+
+	/// the number of completed items and the total number of items
+	inline int count() const { return m_count.load( std::memory_order_relaxed ); }
+	inline int total() const { return m_total; }
+
+	/// pass the count to progress() if the report interval has passed since the last report (does nothing on other threads)
+	void report();
+
+private:
+
+	// the number of completed items and the total
+	std::atomic<int> m_count;
+	int m_total;
+
+	// the time between reports (in seconds), the time of the last report, and the count last reported
+	double m_reportInterval;
+	double m_reportTime;
+	int m_reportCount;
+
+	// the thread that reports progress, and the counter it was using before this one (restored by the destructor)
+	std::thread::id m_thread;
+	ProgressCounter *m_previous;
+
+	// disable copy constructor and assignment operator
+	ProgressCounter( const ProgressCounter &x );
+	ProgressCounter &operator=( const ProgressCounter &x );
+};
+
+
+//-------------------------------------------
+// PARALLEL LOOPS
+//-------------------------------------------
+
+
+/// call body( rangeBegin, rangeEnd ) for sub-ranges of [begin, end) on the worker threads; each sub-range starts at begin
+/// plus a multiple of grain and has at least grain items (except possibly the last); returns when all sub-ranges are done;
+/// if a cancel token is given (or the loop is started inside a loop or task group that has one), no more sub-ranges are
+/// started once the token is cancelled, in which case the function returns false
+template <typename F> bool parallelFor( int begin, int end, int grain, const F &body, const CancelToken *cancelToken = NULL );
+
+
+/// call body( xRangeBegin, xRangeEnd, yRangeBegin, yRangeEnd ) for tiles of [xBegin, xEnd) x [yBegin, yEnd) on the worker threads;
+/// tiles are split as in parallelFor (along the dimension with more grains); returns false if cancelled
+template <typename F> bool parallelFor2D( int xBegin, int xEnd, int yBegin, int yEnd, int xGrain, int yGrain, const F &body, const CancelToken *cancelToken = NULL );
+
+
+//-------------------------------------------
+// TASK GROUP CLASS
+//-------------------------------------------
+
+
+class TaskGroup;
+
+
+/// The ParallelTask class is the base class for work run by the scheduler (used internally by TaskGroup and parallelFor).
+class ParallelTask {
+public:
+
+	// basic constructor / destructor
+	ParallelTask() : group( NULL ) {}
+	virtual ~ParallelTask() {}
+
+	/// do the work
+	virtual void run() = 0;
+
+	/// the group that the task belongs to (set when added to the group)
+	TaskGroup *group;
+};
+
+
+/// The TaskGroup class runs a set of tasks on the worker threads.  Tasks may add more tasks to the group (or start loops
+/// or other groups); wait() runs queued tasks until all of the group's tasks are done.
+class TaskGroup {
+public:
+
+	/// create an empty group; tasks that haven't started are skipped once the cancel token (if any) is cancelled;
+	/// if no token is given, the group uses the token of the loop or task group that the current thread is working on
+	explicit TaskGroup( const CancelToken *cancelToken = NULL );
+
+	// wait for the tasks to finish
+	~TaskGroup();
+
+	/// add a task that calls (a copy of) the given function object
+	template <typename F> void run( const F &function );
+
+	/// wait until all tasks in the group are done; returns false if any tasks were skipped because the group was cancelled
+	bool wait();
+
+	/// skip the tasks that haven't started
+	void cancel();
+
+	/// true if the group has been cancelled (explicitly or by its cancel token)
+	bool cancelled() const;
+
+private:
+
+	// the number of tasks added but not yet done, the number waiting in task queues, and true while a thread is waiting for the group
+	std::atomic<int> m_pending;
+	std::atomic<int> m_queued;
+	std::atomic<bool> m_waiting;
+
+	// true if tasks should be skipped (also set when the cancel token is found to be cancelled)
+	const CancelToken *m_cancelToken;
+	mutable std::atomic<bool> m_cancelled;
+
+	// add a task to the group and queue it (the group takes ownership)
+	void add( ParallelTask *task );
+
+	// the scheduler adds, queues, and runs tasks
+	friend class ParallelRangeTask;
+	friend void queueTask( ParallelTask *task );
+	friend ParallelTask *takeTask( class TaskQueue &queue, bool fromBack, TaskGroup *group );
+	friend ParallelTask *findTask( TaskGroup *group );
+	friend void runParallelTask( ParallelTask *task );
+	friend bool taskCancelled();
+	friend bool parallelForInternal( int xBegin, int xEnd, int yBegin, int yEnd, int xGrain, int yGrain,
+									 void (*callback)( void *data, int xBegin, int xEnd, int yBegin, int yEnd ), void *data, const CancelToken *cancelToken );
+
+	// disable copy constructor and assignment operator
+	TaskGroup( const TaskGroup &x );
+	TaskGroup &operator=( const TaskGroup &x );
+};
+
+
+//-------------------------------------------
+// PARALLEL LOOP IMPLEMENTATION
+//-------------------------------------------
+
+
+// run callback( data, xRangeBegin, xRangeEnd, yRangeBegin, yRangeEnd ) for tiles of [xBegin, xEnd) x [yBegin, yEnd); returns false if cancelled
+bool parallelForInternal( int xBegin, int xEnd, int yBegin, int yEnd, int xGrain, int yGrain,
+						  void (*callback)( void *data, int xBegin, int xEnd, int yBegin, int yEnd ), void *data, const CancelToken *cancelToken );
+
+
+// adapts a 1D loop body object to the callback used by parallelForInternal
+template <typename F> void parallelForCallback( void *data, int begin, int end, int yBegin, int yEnd ) {
+	(*((const F *) data))( begin, end );
+}
+
+
+// adapts a 2D loop body object to the callback used by parallelForInternal
+template <typename F> void parallelFor2DCallback( void *data, int xBegin, int xEnd, int yBegin, int yEnd ) {
+	(*((const F *) data))( xBegin, xEnd, yBegin, yEnd );
+}
+
+
+/// call body( rangeBegin, rangeEnd ) for sub-ranges of [begin, end) on the worker threads
+template <typename F> bool parallelFor( int begin, int end, int grain, const F &body, const CancelToken *cancelToken ) {
+	return parallelForInternal( begin, end, 0, 1, grain, 1, parallelForCallback<F>, (void *) &body, cancelToken );
+}
+
+
+/// call body( xRangeBegin, xRangeEnd, yRangeBegin, yRangeEnd ) for tiles of [xBegin, xEnd) x [yBegin, yEnd) on the worker threads
+template <typename F> bool parallelFor2D( int xBegin, int xEnd, int yBegin, int yEnd, int xGrain, int yGrain, const F &body, const CancelToken *cancelToken ) {
+	return parallelForInternal( xBegin, xEnd, yBegin, yEnd, xGrain, yGrain, parallelFor2DCallback<F>, (void *) &body, cancelToken );
+}
+
+
+// a task that calls a copy of a function object
+template <typename F> class FunctionTask : public ParallelTask {
+public:
+	explicit FunctionTask( const F &function ) : m_function( function ) {}
+	void run() { m_function(); }
+private:
+	F m_function;
+};
+
+
+/// add a task that calls (a copy of) the given function object
+template <typename F> void TaskGroup::run( const F &function ) {
+	add( new FunctionTask<F>( function ) );
+}
+
+
+} // end namespace sbl
+#endif // _SBL_PARALLEL_H_
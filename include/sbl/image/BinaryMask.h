@@ -0,0 +1,153 @@
+#ifndef _SBL_BINARY_MASK_H_
+#define _SBL_BINARY_MASK_H_
+#include <sbl/core/Pointer.h>
+#include <sbl/math/Vector.h>
+#include <sbl/image/Image.h>
+#include <sbl/image/ImageView.h>
+namespace sbl {
+
+
+/*! \file BinaryMask.h
+	\brief The BinaryMask module provides a mask image with one bit per pixel (stored in 64-bit words),
+	with counting, bounds, logical operations, and morphological filters that process 64 pixels at a time,
+	along with BinaryMask versions of the mask functions in ImageUtil.h.
+*/
+
+
+// register commands, etc. defined in this module
+void initBinaryMask();
+
+
+//-------------------------------------------
+// BINARY MASK CLASS
+//-------------------------------------------
+
+
+/// The BinaryMask class holds one bit per pixel.  Each row is stored in (width + 63) / 64 words; pixel x of a row
+/// is bit x % 64 of word x / 64.  The bits after the last pixel of each row are always zero.
+class BinaryMask {
+public:
+
+	/// create a mask with all pixels cleared
+	BinaryMask( int width, int height );
+
+	/// the size of the mask
+	inline int width() const { return m_width; }
+	inline int height() const { return m_height; }
+
+	/// the number of words in each row
+	inline int wordsPerRow() const { return m_wordsPerRow; }
+
+	/// the words of a row (bits after the last pixel must be left as zero)
+	inline unsigned long long *row( int y ) { assertDebug( y >= 0 && y < m_height ); return m_words.dataPtr() + y * m_wordsPerRow; }
+	inline const unsigned long long *row( int y ) const { assertDebug( y >= 0 && y < m_height ); return m_words.dataPtr() + y * m_wordsPerRow; }
+
+	/// get/set a single pixel
+	inline bool data( int x, int y ) const { assertDebug( x >= 0 && x < m_width ); return ((row( y )[ x >> 6 ] >> (x & 63)) & 1) != 0; }
+	inline void set( int x, int y, bool value ) {
+		assertDebug( x >= 0 && x < m_width );
+		unsigned long long bit = 1ULL << (x & 63);
+		if (value)
+			row( y )[ x >> 6 ] |= bit;
+		else
+			row( y )[ x >> 6 ] &= ~bit;
+	}
+
+	/// set or clear every pixel
+	void clear( bool value );
+
+	/// the number of set pixels
+	int count() const;
+
+	/// the (inclusive) bounds of the set pixels; if no pixels are set, xMin = width, xMax = -1, yMin = height, and yMax = -1
+	void bounds( int &xMin, int &xMax, int &yMin, int &yMax ) const;
+
+	/// combine with another mask (of the same size)
+	void andWith( const BinaryMask &mask );
+	void orWith( const BinaryMask &mask );
+	void xorWith( const BinaryMask &mask );
+
+	/// set cleared pixels and clear set pixels
+	void invert();
+
+	/// true if the masks have the same size and pixels
+	bool operator==( const BinaryMask &mask ) const;
+	inline bool operator!=( const BinaryMask &mask ) const { return !operator==( mask ); }
+
+	/// the number of bytes used by the mask
+	inline int memUsed() const { return sizeof( BinaryMask ) + m_words.length() * sizeof( unsigned long long ); }
+
+private:
+
+	// the mask size
+	int m_width;
+	int m_height;
+	int m_wordsPerRow;
+
+	// the bits of all rows (m_wordsPerRow words per row)
+	Vector<unsigned long long> m_words;
+
+	// disable copy constructor and assignment operator
+	BinaryMask( const BinaryMask &x );
+	BinaryMask &operator=( const BinaryMask &x );
+};
+
+
+//-------------------------------------------
+// CONVERSION
+//-------------------------------------------
+
+
+/// create a mask that is set where the image values are at least thresh (by default, the non-zero pixels)
+aptr<BinaryMask> toBinaryMask( const ImageViewGrayU &input, int thresh = 1 );
+
+
+/// set each pixel of the output image (which must have the size of the mask) to 255 where the mask is set and 0 elsewhere
+void toImage( const BinaryMask &mask, ImageViewGrayU output );
+aptr<ImageGrayU> toImage( const BinaryMask &mask );
+
+
+//-------------------------------------------
+// MORPHOLOGY
+//-------------------------------------------
+
+
+/// dilate the mask with a (2 * xRadius + 1) by (2 * yRadius + 1) rectangle: a square if xRadius == yRadius,
+/// a horizontal line if yRadius == 0, or a vertical line if xRadius == 0; pixels outside the mask are treated as cleared
+aptr<BinaryMask> dilate( const BinaryMask &mask, int xRadius, int yRadius );
+
+
+/// erode the mask with a (2 * xRadius + 1) by (2 * yRadius + 1) rectangle (as with dilate);
+/// pixels outside the mask are treated as set, so the mask is not eroded from the image boundary
+aptr<BinaryMask> erode( const BinaryMask &mask, int xRadius, int yRadius );
+
+
+//-------------------------------------------
+// MASK UTILS
+//-------------------------------------------
+
+
+/// count the set pixels of the mask
+int maskCount( const BinaryMask &mask );
+
+
+/// compute the (inclusive) bounds of the set pixels (as with BinaryMask::bounds)
+void maskBounds( const BinaryMask &mask, int &xMin, int &xMax, int &yMin, int &yMax );
+
+
+/// returns true if specified line intersects set mask pixels;
+/// (assumes points are inside image bounds)
+bool lineIntersects( const BinaryMask &mask, float x1, float y1, float x2, float y2 );
+
+
+/// returns true if rectange intersects set mask pixels;
+/// (assumes points are inside image bounds)
+bool rectIntersects( const BinaryMask &mask, int x1, int y1, int x2, int y2 );
+
+
+/// draw the boundary of the mask on the given output image
+void drawMaskBoundary( ImageColorU &output, const BinaryMask &mask, int r, int g, int b, int xBorder = 0, int yBorder = 0 );
+
+
+} // end namespace sbl
+#endif // _SBL_BINARY_MASK_H_
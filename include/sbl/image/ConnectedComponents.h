@@ -0,0 +1,140 @@
+#ifndef _SBL_CONNECTED_COMPONENTS_H_
+#define _SBL_CONNECTED_COMPONENTS_H_
+#include <sbl/math/Vector.h>
+#include <sbl/image/Image.h>
+#include <sbl/image/ImageView.h>
+#include <sbl/image/ImageSeqUtil.h>
+namespace sbl {
+
+
+/*! \file ConnectedComponents.h
+	\brief The ConnectedComponents module provides multithreaded connected-component labelers
+	for images (union-find over strips of rows) and image sequences (union-find over slabs of
+	frames) that also compute the size, bounding box, and centroid of each component.
+*/
+
+
+// register commands, etc. defined in this module
+void initConnectedComponents();
+
+
+//-------------------------------------------
+// COMPONENT STATS CLASS
+//-------------------------------------------
+
+
+/// The ComponentStats class holds summary values for one connected component.
+class ComponentStats {
+public:
+
+	/// create empty stats
+	ComponentStats() { reset(); }
+
+	/// the number of pixels in the component
+	int area;
+
+	/// the bounding box of the component (inclusive)
+	int xMin;
+	int xMax;
+	int yMin;
+	int yMax;
+
+	/// the sums of the pixel coordinates
+	double xSum;
+	double ySum;
+
+	/// the mean pixel coordinates
+	inline float xCentroid() const { return area ? (float) (xSum / (double) area) : 0.0f; }
+	inline float yCentroid() const { return area ? (float) (ySum / (double) area) : 0.0f; }
+
+	/// add a pixel to the stats
+	inline void add( int x, int y ) {
+		area++;
+		if (x < xMin) xMin = x;
+		if (x > xMax) xMax = x;
+		if (y < yMin) yMin = y;
+		if (y > yMax) yMax = y;
+		xSum += x;
+		ySum += y;
+	}
+
+	/// clear the stats
+	void reset();
+
+	/// add stats from another part of the same component
+	void merge( const ComponentStats &stats );
+};
+
+
+/// The ComponentStats3D class holds summary values for one connected component of an image sequence.
+class ComponentStats3D {
+public:
+
+	/// create empty stats
+	ComponentStats3D() { reset(); }
+
+	/// the number of voxels in the component
+	int voxelCount;
+
+	/// the bounding box of the component (inclusive); zMin and zMax are the first and last frames that contain the component
+	int xMin;
+	int xMax;
+	int yMin;
+	int yMax;
+	int zMin;
+	int zMax;
+
+	/// the sums of the voxel coordinates
+	double xSum;
+	double ySum;
+	double zSum;
+
+	/// the mean voxel coordinates
+	inline float xCentroid() const { return voxelCount ? (float) (xSum / (double) voxelCount) : 0.0f; }
+	inline float yCentroid() const { return voxelCount ? (float) (ySum / (double) voxelCount) : 0.0f; }
+	inline float zCentroid() const { return voxelCount ? (float) (zSum / (double) voxelCount) : 0.0f; }
+
+	/// the number of frames spanned by the component
+	inline int frameSpan() const { return voxelCount ? zMax - zMin + 1 : 0; }
+
+	/// add a voxel to the stats
+	inline void add( int x, int y, int z ) {
+		voxelCount++;
+		if (x < xMin) xMin = x;
+		if (x > xMax) xMax = x;
+		if (y < yMin) yMin = y;
+		if (y > yMax) yMax = y;
+		if (z < zMin) zMin = z;
+		if (z > zMax) zMax = z;
+		xSum += x;
+		ySum += y;
+		zSum += z;
+	}
+
+	/// clear the stats
+	void reset();
+
+	/// add stats from another part of the same component
+	void merge( const ComponentStats3D &stats );
+};
+
+
+//-------------------------------------------
+// COMPONENT LABELING
+//-------------------------------------------
+
+
+/// label the connected components of pixels with values in [minValue, maxValue] (using 4 or 8 connectivity);
+/// the components are numbered from 1 in the (raster) order of their first pixels and other pixels are labeled 0;
+/// if stats is not NULL, it receives the stats of each component (stats[ label - 1 ]); returns the number of components
+int labelComponents( const ImageViewGrayU &input, int minValue, int maxValue, bool eightConnected, ImageGrayI &labels, Vector<ComponentStats> *stats = NULL );
+
+
+/// label the connected components of voxels with values in [minValue, maxValue] in an image sequence, using 6 connectivity
+/// or (if fullyConnected) 26 connectivity; numbering and stats are as in labelComponents (with raster order going through
+/// the frames in order); if labels is empty, it is allocated; otherwise it must have the size of the sequence
+int labelComponentsXYZ( const ImageGrayUSeq &seq, int minValue, int maxValue, bool fullyConnected, ImageGrayISeq &labels, Vector<ComponentStats3D> *stats = NULL );
+
+
+} // end namespace sbl
+#endif // _SBL_CONNECTED_COMPONENTS_H_
@@ -8,7 +8,9 @@ namespace sbl {
 
 /*! \file Filter.h
 	\brief The Filter module represents generalized image filters (with a uniform function
-	specification that allows run-time selection of filters).
+	specification that allows run-time selection of filters).  When applying a filter to a video,
+	frames are decoded on a separate thread and encoded in the background; stateless filters are applied
+	to several frames at once on worker threads, while other filters run on the thread running the command.
 */
 
 
@@ -21,10 +23,12 @@ typedef aptr<ImageColorU> (*ColorImageFilterCallback)( const ImageColorU &input,
 typedef aptr<ImageGrayU> (*GrayImageFilterCallback)( const ImageGrayU &input, Config &conf );
 
 
-/// register an image processing filter 
-#define registerFilter( filter ) registerFilterInternal( #filter, filter ) 
-void registerFilterInternal( const String &name, ColorImageFilterCallback callback );
-void registerFilterInternal( const String &name, GrayImageFilterCallback callback );
+/// register an image processing filter; use registerStatelessFilter if the filter keeps no state between frames
+/// and is thread-safe, so that it can be applied to several video frames at once (each call gets its own copy of the config)
+#define registerFilter( filter ) registerFilterInternal( #filter, filter, false ) 
+#define registerStatelessFilter( filter ) registerFilterInternal( #filter, filter, true ) 
+void registerFilterInternal( const String &name, ColorImageFilterCallback callback, bool stateless );
+void registerFilterInternal( const String &name, GrayImageFilterCallback callback, bool stateless );
 
 
 } // end namespace sbl
@@ -25,6 +25,10 @@ namespace sbl {
 #define B_CHANNEL 0
 
 
+// image rows start on multiples of this many bytes (a cache line; also suitable for SIMD loads)
+#define IMAGE_ROW_ALIGN 64
+
+
 //-------------------------------------------
 // IMAGE CLASS 
 //-------------------------------------------
@@ -35,38 +39,46 @@ template <typename T, int CHANNEL_COUNT > class Image {
 public:
 
 	/// basic constructor; does not initialize image
-	Image( int width, int height ) { alloc( width, height ); }
+	Image( int width, int height ) { alloc( width, height, 0 ); }
+
+	/// create an image with the given row stride in bytes (must be a multiple of the element size and at least width * pixel size);
+	/// if rowBytes is zero, uses defaultRowBytes( width ); does not initialize image
+	Image( int width, int height, int rowBytes ) { alloc( width, height, rowBytes ); }
+
+	/// create an Image object wrapping external pixel data (which is not copied or deallocated) with the given row stride in bytes
+	Image( T *data, int width, int height, int rowBytes );
 
 	// basic copy constructor
-	Image( const Image &img ) {	alloc( img.width(), img.height() );	memcpy( m_raw, img.rawConst(), m_rowBytes * m_height ); }
+	Image( const Image &img );
 
 	// basic destructor
 	~Image();
 
 	/// get/set pixel values for gray images (assumes CHANNEL_COUNT == 1)
-	inline T &data( int x, int y ) { assertStatic( CHANNEL_COUNT == 1 ); IMGCHK return m_ptr[ y ][ x ]; }
-	inline const T &data( int x, int y ) const { assertStatic( CHANNEL_COUNT == 1 ); IMGCHK return m_ptr[ y ][ x ]; }
+	inline T &data( int x, int y ) { assertStatic( CHANNEL_COUNT == 1 ); IMGCHK return row( y )[ x ]; }
+	inline const T &data( int x, int y ) const { assertStatic( CHANNEL_COUNT == 1 ); IMGCHK return row( y )[ x ]; }
 	float interp( float x, float y ) const;
 
 	/// get/set pixel values for multi-channel images
-	inline T &data( int x, int y, int c ) { IMGCHK return m_ptr[ y ][ x * CHANNEL_COUNT + c ]; }
-	inline const T &data( int x, int y, int c ) const { IMGCHK return m_ptr[ y ][ x * CHANNEL_COUNT + c ]; }
+	inline T &data( int x, int y, int c ) { IMGCHK return row( y )[ x * CHANNEL_COUNT + c ]; }
+	inline const T &data( int x, int y, int c ) const { IMGCHK return row( y )[ x * CHANNEL_COUNT + c ]; }
 	float interp( float x, float y, int c ) const;
 
 	/// get/set pixel values for RGB (actually BGR) color images (assumes CHANNEL_COUNT >= 3)
-	inline T b( int x, int y ) const { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK return m_ptr[ y ][ x * CHANNEL_COUNT + B_CHANNEL ]; }
-	inline T g( int x, int y ) const { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK return m_ptr[ y ][ x * CHANNEL_COUNT + G_CHANNEL ]; }
-	inline T r( int x, int y ) const { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK return m_ptr[ y ][ x * CHANNEL_COUNT + R_CHANNEL ]; }
-	inline void setRGB( int x, int y, T r, T g, T b ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK m_ptr[ y ][ x * CHANNEL_COUNT + B_CHANNEL ] = b; m_ptr[ y ][ x * CHANNEL_COUNT + G_CHANNEL ] = g; m_ptr[ y ][ x * CHANNEL_COUNT + R_CHANNEL ] = r; }
-	inline void setB( int x, int y, T v ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK m_ptr[ y ][ x * CHANNEL_COUNT + B_CHANNEL ] = v; }
-	inline void setG( int x, int y, T v ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK m_ptr[ y ][ x * CHANNEL_COUNT + G_CHANNEL ] = v; }
-	inline void setR( int x, int y, T v ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK m_ptr[ y ][ x * CHANNEL_COUNT + R_CHANNEL ] = v; }
+	inline T b( int x, int y ) const { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK return row( y )[ x * CHANNEL_COUNT + B_CHANNEL ]; }
+	inline T g( int x, int y ) const { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK return row( y )[ x * CHANNEL_COUNT + G_CHANNEL ]; }
+	inline T r( int x, int y ) const { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK return row( y )[ x * CHANNEL_COUNT + R_CHANNEL ]; }
+	inline void setRGB( int x, int y, T r, T g, T b ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK row( y )[ x * CHANNEL_COUNT + B_CHANNEL ] = b; row( y )[ x * CHANNEL_COUNT + G_CHANNEL ] = g; row( y )[ x * CHANNEL_COUNT + R_CHANNEL ] = r; }
+	inline void setB( int x, int y, T v ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK row( y )[ x * CHANNEL_COUNT + B_CHANNEL ] = v; }
+	inline void setG( int x, int y, T v ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK row( y )[ x * CHANNEL_COUNT + G_CHANNEL ] = v; }
+	inline void setR( int x, int y, T v ) { assertStatic( CHANNEL_COUNT >= 3 ); IMGCHK row( y )[ x * CHANNEL_COUNT + R_CHANNEL ] = v; }
 
 	// get image info
 	inline int width() const { return m_width; }
 	inline int height() const { return m_height; }
 	inline int rowBytes() const { return m_rowBytes; }
 	inline int memUsed() const { return sizeof( Image<T,CHANNEL_COUNT> ) + m_rowBytes * m_height; }
+	inline bool isContiguous() const { return m_rowBytes == m_width * (int) sizeof(T) * CHANNEL_COUNT; }
 	inline int depth() const { return sizeof(T) * 8; }
 	inline int channelCount() const { return CHANNEL_COUNT; }
 	inline bool isFloat() const { return typeid( T ) == typeid( float ); }
@@ -75,10 +87,15 @@ public:
 	inline bool inBounds( int x, int y ) const { return x >= 0 && x < m_width && y >= 0 && y < m_height; }
 	inline bool inBounds( float x, float y ) const { return x >= 0 && x < m_width - 1 && y >= 0 && y < m_height - 1; }
 
-	/// access image data via pointers
+	/// access image data via pointers; rows are rowBytes() apart (which may include padding after each row)
 	inline T *raw() { return m_raw; }
 	inline const T *rawConst() const { return m_raw; }
-	inline T **pointers() { return m_ptr; }
+	inline T *row( int y ) { return (T *) ((unsigned char *) m_raw + (size_t) y * m_rowBytes); }
+	inline const T *row( int y ) const { return (const T *) ((const unsigned char *) m_raw + (size_t) y * m_rowBytes); }
+
+	/// the row stride used for new images of the given width: the row size rounded up to a multiple of IMAGE_ROW_ALIGN,
+	/// plus IMAGE_ROW_ALIGN if the result is a multiple of 1024 bytes (so that walking down a column does not keep hitting the same cache sets)
+	static int defaultRowBytes( int width );
 
 	/// clear the image to the specified color
 	void clear( T r, T g, T b );
@@ -87,18 +104,15 @@ public:
 private:
 
 	// common constructor code
-	void alloc( int width, int height );
+	void alloc( int width, int height, int rowBytes );
 
-	// image data (top origin)
+	// image data (top origin); m_raw is aligned to IMAGE_ROW_ALIGN within the allocated block (if allocated by this object)
 	T *m_raw;
-	T **m_ptr;
+	unsigned char *m_alloc;
 	int m_width;
 	int m_height;
 	int m_rowBytes;
 
-	// indicates whether to delete m_raw
-	bool m_deleteRaw;
-
 	// disable assignment operator
 	Image &operator=( const Image &img );
 
@@ -140,37 +154,57 @@ private:
 //-------------------------------------------
 
 
+/// create an Image object wrapping external pixel data (which is not copied or deallocated) with the given row stride in bytes
+template<typename T, int CHANNEL_COUNT> Image<T, CHANNEL_COUNT>::Image( T *data, int width, int height, int rowBytes ) {
+	assertAlways( rowBytes >= width * (int) sizeof(T) * CHANNEL_COUNT && rowBytes % sizeof(T) == 0 );
+	m_width = width;
+	m_height = height;
+	m_rowBytes = rowBytes;
+	m_raw = data;
+	m_alloc = NULL;
+}
+
+
+// basic copy constructor
+template<typename T, int CHANNEL_COUNT> Image<T, CHANNEL_COUNT>::Image( const Image &img ) {
+	alloc( img.width(), img.height(), img.rowBytes() % IMAGE_ROW_ALIGN ? 0 : img.rowBytes() );
+	if (m_rowBytes == img.rowBytes()) {
+		memcpy( m_raw, img.rawConst(), (size_t) m_rowBytes * m_height );
+	} else {
+		for (int y = 0; y < m_height; y++)
+			memcpy( row( y ), img.row( y ), m_width * sizeof(T) * CHANNEL_COUNT );
+	}
+}
+
+
 // deallocate image data
 template<typename T, int CHANNEL_COUNT> Image<T, CHANNEL_COUNT>::~Image() {
-	if (m_deleteRaw)
-		delete [] m_raw;
-	delete [] m_ptr;
+	delete [] m_alloc;
+}
+
+
+/// the row stride used for new images of the given width
+template<typename T, int CHANNEL_COUNT> int Image<T, CHANNEL_COUNT>::defaultRowBytes( int width ) {
+	int rowBytes = width * sizeof(T) * CHANNEL_COUNT;
+	rowBytes = (rowBytes + IMAGE_ROW_ALIGN - 1) / IMAGE_ROW_ALIGN * IMAGE_ROW_ALIGN;
+	if (rowBytes && (rowBytes & 1023) == 0)
+		rowBytes += IMAGE_ROW_ALIGN;
+	return rowBytes;
 }
 
 
 // common constructor code
-template<typename T, int CHANNEL_COUNT> void Image<T, CHANNEL_COUNT>::alloc( int width, int height ) {
+template<typename T, int CHANNEL_COUNT> void Image<T, CHANNEL_COUNT>::alloc( int width, int height, int rowBytes ) {
 	m_width = width;
 	m_height = height;
-	m_rowBytes = m_width * sizeof(T) * CHANNEL_COUNT;
-	int rowWidth = m_rowBytes / sizeof( T );
-	assertDebug( rowWidth >= m_width );
-	int size = rowWidth * m_height; // total number of elements
-
-	// alloc pixel data
-	m_raw = new T[ size ];
-	if (m_raw == NULL) fatalError( "error allocating Image data" );
-	m_deleteRaw = true;
-
-	// check alignment
-	if (((long long int) m_raw) & 7)
-		fatalError("not quad-word aligned");
-
-	// create row pointers
-	m_ptr = new T*[ m_height ];
-	if (m_ptr == NULL) fatalError( "error allocating Image pointers" );
-	for (int i = 0; i < m_height; i++)
-		m_ptr[ i ] = m_raw + i * rowWidth;
+	m_rowBytes = rowBytes ? rowBytes : defaultRowBytes( width );
+	assertAlways( m_rowBytes >= m_width * (int) sizeof(T) * CHANNEL_COUNT && m_rowBytes % sizeof(T) == 0 );
+
+	// alloc pixel data, with extra space so that the first row can be aligned
+	m_alloc = new unsigned char[ (size_t) m_rowBytes * m_height + IMAGE_ROW_ALIGN ];
+	if (m_alloc == NULL) fatalError( "error allocating Image data" );
+	size_t offset = IMAGE_ROW_ALIGN - ((size_t) m_alloc % IMAGE_ROW_ALIGN);
+	m_raw = (T *) (m_alloc + (offset == IMAGE_ROW_ALIGN ? 0 : offset));
 }
 
 
@@ -186,10 +220,11 @@ template<typename T, int CHANNEL_COUNT> void Image<T, CHANNEL_COUNT>::clear( T r
 
 /// clear the image to the specified color
 template<typename T, int CHANNEL_COUNT> void Image<T, CHANNEL_COUNT>::clear( T v ) {
+	int rowLength = m_width * CHANNEL_COUNT;
 	for (int y = 0; y < m_height; y++) {
-		for (int x = 0; x < m_width; x++) {
-			m_ptr[ y ][ x ] = v;
-		}
+		T *ptr = row( y );
+		for (int i = 0; i < rowLength; i++)
+			ptr[ i ] = v;
 	}
 }
 
@@ -197,46 +232,38 @@ template<typename T, int CHANNEL_COUNT> void Image<T, CHANNEL_COUNT>::clear( T v
 /// performs bilinear interpolation at specified point
 template<typename T, int CHANNEL_COUNT> float Image<T, CHANNEL_COUNT>::interp( float x, float y ) const {
 	IMGCHK_INTERP
-    int xInt = (int) x; 
-    int yInt = (int) y; 
-	float val = 0;
+	int xInt = (int) x;
+	int yInt = (int) y;
 	assertDebug( xInt >= 0 && yInt >= 0 && xInt < m_width && yInt < m_height );
-	if (xInt == m_width - 1) { // fix(faster): make faster?
-		if (yInt == m_height - 1) {
-			val = (float) m_ptr[ yInt ][ xInt ];
-		} else {
-			float yFrac = y - yInt;
-			val = (1.0f - yFrac) * m_ptr[ yInt     ][ xInt ] + 
-						  yFrac  * m_ptr[ yInt + 1 ][ xInt ];
-		}
-	} else if (yInt == m_height - 1) {
-		float xFrac = x - xInt;
-		val = (1.0f - xFrac) * m_ptr[ yInt ][ xInt     ] + 
-					  xFrac  * m_ptr[ yInt ][ xInt + 1 ];
-	} else {
-		float xFrac = x - xInt;
-		float yFrac = y - yInt;
-		val = (1.0f - xFrac) * (1.0f - yFrac) * m_ptr[ yInt     ][ xInt     ] + 
-			  (1.0f - xFrac) *         yFrac  * m_ptr[ yInt + 1 ][ xInt     ] + 
-					  xFrac  * (1.0f - yFrac) * m_ptr[ yInt     ][ xInt + 1 ] + 
-					  xFrac  *         yFrac  * m_ptr[ yInt + 1 ][ xInt + 1 ];
-	}
-	return val;
+	float xFrac = x - xInt;
+	float yFrac = y - yInt;
+
+	// in the last column/row, the next column/row is the current one (so no branches are needed)
+	const T *row0 = row( yInt ) + xInt;
+	const T *row1 = (const T *) ((const unsigned char *) row0 + (yInt < m_height - 1 ? m_rowBytes : 0));
+	int xStep = xInt < m_width - 1 ? 1 : 0;
+	float top = row0[ 0 ] + xFrac * (float) (row0[ xStep ] - row0[ 0 ]);
+	float bottom = row1[ 0 ] + xFrac * (float) (row1[ xStep ] - row1[ 0 ]);
+	return top + yFrac * (bottom - top);
 }
 
 
 /// performs bilinear interpolation at specified point
 template<typename T, int CHANNEL_COUNT> float Image<T, CHANNEL_COUNT>::interp( float x, float y, int c ) const {
 	IMGCHK_INTERP
-    int xInt = (int) x; 
-    int yInt = (int) y; 
-    float xFrac = x - xInt;
-    float yFrac = y - yInt;
-    float val = (1.0f - xFrac) * (1.0f - yFrac) * m_ptr[ yInt     ][ (xInt    ) * CHANNEL_COUNT + c ] + 
-  	            (1.0f - xFrac) *         yFrac  * m_ptr[ yInt + 1 ][ (xInt    ) * CHANNEL_COUNT + c ] + 
-		                xFrac  * (1.0f - yFrac) * m_ptr[ yInt     ][ (xInt + 1) * CHANNEL_COUNT + c ] + 
-	                    xFrac  *         yFrac  * m_ptr[ yInt + 1 ][ (xInt + 1) * CHANNEL_COUNT + c ];
-	return val;
+	int xInt = (int) x;
+	int yInt = (int) y;
+	assertDebug( xInt >= 0 && yInt >= 0 && xInt < m_width && yInt < m_height );
+	float xFrac = x - xInt;
+	float yFrac = y - yInt;
+
+	// in the last column/row, the next column/row is the current one (so no branches are needed)
+	const T *row0 = row( yInt ) + xInt * CHANNEL_COUNT + c;
+	const T *row1 = (const T *) ((const unsigned char *) row0 + (yInt < m_height - 1 ? m_rowBytes : 0));
+	int xStep = xInt < m_width - 1 ? CHANNEL_COUNT : 0;
+	float top = row0[ 0 ] + xFrac * (float) (row0[ xStep ] - row0[ 0 ]);
+	float bottom = row1[ 0 ] + xFrac * (float) (row1[ xStep ] - row1[ 0 ]);
+	return top + yFrac * (bottom - top);
 }
 
 
@@ -249,25 +276,14 @@ template<typename T, int CHANNEL_COUNT> float Image<T, CHANNEL_COUNT>::interp( f
 /// create an Image object wrapping a CvMat object
 template<typename T, int CHANNEL_COUNT> Image<T, CHANNEL_COUNT>::Image(cv::Mat &mat) {
 	assertAlways(mat.channels() == CHANNEL_COUNT);
+	if (mat.depth() != cv::DataType<T>::depth)
+		fatalError("depth not supported");
 	m_width = mat.cols;
 	m_height = mat.rows;
-	int bytesPerElement = 0;
-	if (mat.depth() == CV_8U) {  // can we use mat.elemSize instead?
-		bytesPerElement = 1;
-	} else {
-		fatalError("depth not supported");
-	}
-	int rowWidth = mat.cols * bytesPerElement * mat.channels();  // this won't work if there is any per-row padding
-	m_rowBytes = rowWidth * sizeof(T);
+	m_rowBytes = (int) mat.step[ 0 ];  // the cv::Mat may have per-row padding (e.g. a region of another matrix)
 	m_raw = (T *) mat.data;
-	m_cvMat = mat;
-	m_deleteRaw = false;
-
-	// create row pointers
-	m_ptr = new T*[ m_height ];
-	if (m_ptr == NULL) fatalError( "error allocating Image pointers" );
-	for (int i = 0; i < m_height; i++)
-		m_ptr[ i ] = m_raw + i * rowWidth;
+	m_alloc = NULL;
+	m_cvMat = mat;  // keeps the matrix data allocated while this image exists
 }
 
 
@@ -280,7 +296,7 @@ template<typename T, int CHANNEL_COUNT> void Image<T, CHANNEL_COUNT>::createCvMa
 	int type = CV_MAKETYPE(cv::DataType<T>::type, CHANNEL_COUNT);
 
 	// create cv::Mat object
-	m_cvMat = cv::Mat(size, type, m_raw);
+	m_cvMat = cv::Mat(size, type, m_raw, m_rowBytes);
 }
 
 
@@ -0,0 +1,138 @@
+#ifndef _SBL_IMAGE_PYRAMID_H_
+#define _SBL_IMAGE_PYRAMID_H_
+#include <sbl/core/Array.h>
+#include <sbl/core/Pointer.h>
+#include <sbl/math/Vector.h>
+#include <sbl/image/Image.h>
+#include <mutex>
+namespace sbl {
+
+
+/*! \file ImagePyramid.h
+	\brief The ImagePyramid module provides Gaussian and Laplacian image pyramids whose levels
+	are computed on demand, along with a small cache (keyed by frame index) so that several
+	processing stages can share the pyramids of a video's frames.
+*/
+
+
+// register commands, etc. defined in this module
+void initImagePyramid();
+
+
+//-------------------------------------------
+// IMAGE PYRAMID CLASS
+//-------------------------------------------
+
+
+/// The ImagePyramid class holds a Gaussian pyramid of an image: level 0 is the image and each following level is blurred
+/// with the (1, 4, 6, 4, 1) / 16 kernel and decimated by two in one pass (level i + 1 is (width + 1) / 2 by (height + 1) / 2 of level i).
+/// Levels (and the corresponding Laplacian levels) are computed when first requested; requests may come from several threads.
+/// Implemented for ImageGrayU, ImageGrayF, and ImageColorU (see the typedefs below).
+template <typename T, int CHANNEL_COUNT> class ImagePyramid {
+public:
+
+	/// create a pyramid of a copy of the given image
+	explicit ImagePyramid( const Image<T, CHANNEL_COUNT> &image );
+
+	/// create a pyramid of the given image (taking ownership)
+	explicit ImagePyramid( aptr<Image<T, CHANNEL_COUNT> > image );
+
+	/// the number of levels available: levels are added until the width or height reaches 1
+	inline int levelCount() const { return m_levelCount; }
+
+	/// the size of a level (without computing it)
+	int width( int level ) const;
+	int height( int level ) const;
+
+	/// a level of the Gaussian pyramid (level 0 is the full-resolution image)
+	const Image<T, CHANNEL_COUNT> &level( int level );
+
+	/// a level of the Laplacian pyramid: the Gaussian level minus the expanded next level (the last level is the Gaussian level itself)
+	const Image<float, CHANNEL_COUNT> &laplacian( int level );
+
+private:
+
+	// set the level count and the first level
+	void init( Image<T, CHANNEL_COUNT> *image );
+
+	// the computed levels (in order, starting at level 0)
+	Array<Image<T, CHANNEL_COUNT> > m_levels;
+	Array<Image<float, CHANNEL_COUNT> > m_laplacians;
+	int m_levelCount;
+
+	// the size of level 0
+	int m_width;
+	int m_height;
+
+	// serializes the computation of levels
+	std::mutex m_mutex;
+
+	// disable copy constructor and assignment operator
+	ImagePyramid( const ImagePyramid &x );
+	ImagePyramid &operator=( const ImagePyramid &x );
+};
+
+
+// common pyramid types
+typedef ImagePyramid<unsigned char, 1> ImagePyramidGrayU;
+typedef ImagePyramid<float, 1> ImagePyramidGrayF;
+typedef ImagePyramid<unsigned char, 3> ImagePyramidColorU;
+
+
+//-------------------------------------------
+// IMAGE PYRAMID CACHE CLASS
+//-------------------------------------------
+
+
+/// The ImagePyramidCache class holds the pyramids of the most recently used frames of a sequence, so that several processing
+/// stages (e.g. registration and motion estimation) can share them.  A pyramid returned by the cache remains valid
+/// until capacity other frames have been added.
+template <typename T, int CHANNEL_COUNT> class ImagePyramidCache {
+public:
+
+	/// create a cache holding up to capacity pyramids
+	explicit ImagePyramidCache( int capacity );
+
+	/// the pyramid of the given frame, creating it (from a copy of the frame) if it is not in the cache
+	ImagePyramid<T, CHANNEL_COUNT> &pyramid( int frameIndex, const Image<T, CHANNEL_COUNT> &frame );
+
+	/// the pyramid of the given frame, or NULL if it is not in the cache
+	ImagePyramid<T, CHANNEL_COUNT> *find( int frameIndex );
+
+	/// remove all pyramids from the cache
+	void reset();
+
+	/// the number of lookups that found / did not find a pyramid
+	inline int hitCount() const { return m_hitCount; }
+	inline int missCount() const { return m_missCount; }
+
+private:
+
+	// the cached pyramids, their frame indices, and the time each was last used
+	Array<ImagePyramid<T, CHANNEL_COUNT> > m_pyramids;
+	VectorI m_frameIndex;
+	VectorI m_lastUse;
+	int m_capacity;
+	int m_useCount;
+
+	// cache statistics
+	int m_hitCount;
+	int m_missCount;
+
+	// serializes access to the cache
+	std::mutex m_mutex;
+
+	// disable copy constructor and assignment operator
+	ImagePyramidCache( const ImagePyramidCache &x );
+	ImagePyramidCache &operator=( const ImagePyramidCache &x );
+};
+
+
+// common pyramid cache types
+typedef ImagePyramidCache<unsigned char, 1> ImagePyramidCacheGrayU;
+typedef ImagePyramidCache<float, 1> ImagePyramidCacheGrayF;
+typedef ImagePyramidCache<unsigned char, 3> ImagePyramidCacheColorU;
+
+
+} // end namespace sbl
+#endif // _SBL_IMAGE_PYRAMID_H_
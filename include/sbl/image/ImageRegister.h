@@ -1,6 +1,9 @@
 #ifndef _SBL_IMAGE_REGISTER_H_
 #define _SBL_IMAGE_REGISTER_H_
 #include <sbl/image/ImageTransform.h>
+#include <sbl/image/ImageView.h>
+#include <sbl/image/ImagePyramid.h>
+#include <float.h>
 namespace sbl {
 
 
@@ -10,11 +13,30 @@ namespace sbl {
 */
 
 
+// register commands, etc. defined in this module
+void initImageRegister();
+
+
 /// computes the mean-abs image difference given an image transformation;
 /// a step value greater than one allows faster (less accurate) optimization by ignoring some pixels;
 /// the xBorder and yBorder specify areas to be ignored for the objective function;
-/// the offsetBound value specifies the largest allowed translation between the images
-double evalImageTransform( const ImageTransform &transform, const ImageGrayU &src, const ImageGrayU &dest, int step, int border, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL, bool interp = false, bool verbose = false );
+/// if the result is known to exceed abortValue before all pixels are visited, returns a lower bound on it (greater than abortValue)
+double evalImageTransform( const ImageTransform &transform, const ImageGrayU &src, const ImageGrayU &dest, int step, int xBorder, int yBorder, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL, bool interp = false, bool verbose = false, double abortValue = DBL_MAX );
+
+
+/// computes the mean-abs image difference given a transformation from source view coordinates to destination view coordinates;
+/// the masks (if any) must have the same sizes as the corresponding views; destination positions are rounded to the nearest pixel (unless interp);
+/// the rows are split across the worker threads
+double evalImageTransform( const ImageTransform &transform, const ImageViewGrayU &src, const ImageViewGrayU &dest, int step, const ImageViewGrayU *srcMask = NULL, const ImageViewGrayU *destMask = NULL, bool interp = false, bool verbose = false, double abortValue = DBL_MAX );
+
+
+/// computes the mutual information between the source view and the destination view (sampled at the nearest transformed positions),
+/// using a joint histogram with the given number of buckets (see JointHistogram); the masks (if any) must have the same sizes as the corresponding views
+double evalImageTransformMutualInfo( const ImageTransform &transform, const ImageViewGrayU &src, const ImageViewGrayU &dest, int step, int bucketCount, bool parzen, const ImageViewGrayU *srcMask = NULL, const ImageViewGrayU *destMask = NULL );
+
+
+/// computes the mutual information between a pair of images given an image transformation, ignoring the given border
+double evalImageTransformMutualInfo( const ImageTransform &transform, const ImageGrayU &src, const ImageGrayU &dest, int step, int bucketCount, bool parzen, int xBorder, int yBorder, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL );
 
 
 /// registers a pair of images using to minimize mean-abs difference;
@@ -24,5 +46,24 @@ double evalImageTransform( const ImageTransform &transform, const ImageGrayU &sr
 aptr<ImageTransform> registerUsingImageTransform( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, int step, int xBorder, int yBorder, float offsetBound, const ImageTransform *initTransform = NULL, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL, bool interp = false );
 
 
+/// registers a pair of images to maximize mutual information (for images whose intensities are related by an unknown, possibly non-monotonic, mapping);
+/// the parameters are as for registerUsingImageTransform, plus the joint histogram bucket count and binning; Parzen (soft) binning makes the objective less sensitive to bucket boundaries
+aptr<ImageTransform> registerUsingMutualInfo( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, int step, int xBorder, int yBorder, float offsetBound, int bucketCount, bool parzen, const ImageTransform *initTransform = NULL, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL );
+
+
+/// registers a pair of images using a coarse-to-fine search over Gaussian pyramids (each level half the size of the previous);
+/// the transformation is estimated at the coarsest level (steps.length() - 1) and then refined at each finer level, down to level 0 (full resolution);
+/// steps[ i ] and offsetBounds[ i ] give the step and the offset bound (in level i pixels) used at level i;
+/// the border sizes are given in full-resolution pixels; levels other than level 0 are always compared using interpolation;
+/// if the command is cancelled, the finer levels are skipped
+aptr<ImageTransform> registerUsingImageTransformPyramid( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, const VectorI &steps, const VectorF &offsetBounds, 
+														  int xBorder, int yBorder, const ImageTransform *initTransform = NULL, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL, bool interp = false );
+
+
+/// registers a pair of images using a coarse-to-fine search over existing pyramids (e.g. from an ImagePyramidCache); the pyramids must have at least steps.length() levels
+aptr<ImageTransform> registerUsingImageTransformPyramid( ImagePyramidGrayU &src, ImagePyramidGrayU &dest, int transformParamCount, const VectorI &steps, const VectorF &offsetBounds, 
+														  int xBorder, int yBorder, const ImageTransform *initTransform = NULL, const ImageGrayU *srcMask = NULL, const ImageGrayU *destMask = NULL, bool interp = false );
+
+
 } // end namespace sbl
 #endif // _SBL_IMAGE_REGISTER_H_
@@ -0,0 +1,37 @@
+#ifndef _SBL_IMAGE_REMAP_H_
+#define _SBL_IMAGE_REMAP_H_
+#include <sbl/image/ImageView.h>
+namespace sbl {
+
+
+/*! \file ImageRemap.h
+	\brief The ImageRemap module provides a multithreaded engine for resampling an image at
+	positions given by an affine transformation or by a dense displacement field (bilinear
+	interpolation).  It is used by the warping functions in the ImageTransform module and
+	by MotionField::mapBackward.
+*/
+
+
+// register commands, etc. defined in this module
+void initImageRemap();
+
+
+/// for each output pixel (x, y), sample the input at (p0 + p2 * x + p4 * y, p1 + p3 * x + p5 * y) (the ImageTransform parameter order);
+/// output pixels that sample outside the input are set to fillValue (if fill) or left unchanged;
+/// 8-bit values are rounded to nearest
+template <typename T, int CHANNEL_COUNT> void remapAffine( const ImageView<T, CHANNEL_COUNT> &input, ImageView<T, CHANNEL_COUNT> output,
+														   const double *params, bool fill, T fillValue );
+
+
+/// for each output pixel (x, y), sample the input at (x + frac * u( x, y ), y + frac * v( x, y )); the u and v views must match the output size;
+/// output pixels that sample outside the input are set to fillValue (if fill) or left unchanged
+template <typename T, int CHANNEL_COUNT> void remapField( const ImageView<T, CHANNEL_COUNT> &input, ImageView<T, CHANNEL_COUNT> output,
+														  const ImageView<float, 1> &u, const ImageView<float, 1> &v, float frac, bool fill, T fillValue );
+
+
+/// compute the parameters of the inverse of an affine transformation (in ImageTransform parameter order); returns false if not invertible
+bool invertAffine( const double *params, double *invParams );
+
+
+} // end namespace sbl
+#endif // _SBL_IMAGE_REMAP_H_
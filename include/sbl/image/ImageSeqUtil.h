@@ -55,7 +55,7 @@ void transposeYZ( const ImageGrayUSeq &inSeq, ImageGrayUSeq &outSeq );
 
 /// fills starting at the given point, all values within the given range;
 /// the fill value must *not* be within the fill range
-int floodFillXYZ( const ImageGrayUSeq &seq, int minRegionColor, int maxRegionColor, int fillValue, 
+int floodFillXYZ( ImageGrayUSeq &seq, int minRegionValue, int maxRegionValue, int fillValue, 
 				  int x, int y, int z,
 				  float *xCentRet = NULL, float *yCentRet = NULL, float *zCentRet = NULL, 
 				  int *xMinRet = NULL, int *xMaxRet = NULL, 
@@ -24,15 +24,15 @@ namespace sbl {
 template <typename ImageType> aptr<ImageType> crop( const ImageType &input, int xMin, int xMax, int yMin, int yMax );
 
 
-/// resize image
+/// resize image (if filter, uses area averaging when shrinking and bilinear interpolation when enlarging; otherwise uses nearest neighbor)
 template <typename ImageType> aptr<ImageType> resize( const ImageType &input, int newWidth, int newHeight, bool filter );
 
 
-/// translate and scale an image
+/// translate and scale an image (bilinear interpolation; pixels mapped from outside the input are set to white)
 template <typename ImageType> aptr<ImageType> shiftScale( const ImageType &input, float xOffset, float yOffset, float xScale, float yScale, int outputWidth, int outputHeight );
 
 
-/// apply linear transformation to image
+/// apply linear transformation to image (bilinear interpolation; pixels mapped from outside the input are set to fillColor)
 template <typename ImageType> aptr<ImageType> warpAffine( const ImageType &input, float xOffset, float yOffset, float x1, float y1, float x2, float y2, int outputWidth, int outputHeight, int fillColor );
 
 
@@ -74,7 +74,7 @@ class ImageTransform {
 public:
 
     /// create transformation from parameters (assumes correct number of parameters)
-    explicit ImageTransform( const VectorF &params ) : m_params( params ) {}
+    explicit ImageTransform( const VectorF &params );
 
     /// create a translation transformation
     ImageTransform( float xOffset, float yOffset );
@@ -98,16 +98,22 @@ public:
     /// get number of parameters
     inline int paramCount() const { return m_params.length(); }
 
+    /// get the transformation as 6 affine parameters: x' = p0 + p2 * x + p4 * y, y' = p1 + p3 * x + p5 * y
+    inline const double *affineParams() const { return m_affineParams; }
+
     /// get the translation components of the transformation
     inline float xOffset() const { return m_params[ 0 ]; }
     inline float yOffset() const { return m_params[ 1 ]; }
 
     /// set the translation components of the transformation
-    inline void setOffset( float xOffset, float yOffset ) { m_params[ 0 ] = xOffset; m_params[ 1 ] = yOffset; }
+    inline void setOffset( float xOffset, float yOffset ) { m_params[ 0 ] = xOffset; m_params[ 1 ] = yOffset; updateInverse(); }
 
     /// compute the inverse of the transformation
     aptr<ImageTransform> inverse() const;
 
+    /// compose transformations: the result applies the given transformation and then this transformation
+    aptr<ImageTransform> compose( const ImageTransform &first ) const;
+
     /// map an image forward according to the transformation
     aptr<ImageGrayU> mapForward( const ImageGrayU &img, int outputWidth, int outputHeight, int fillColor ) const;
     aptr<ImageColorU> mapForward( const ImageColorU &img, int outputWidth, int outputHeight, int fillColor ) const;
@@ -121,6 +127,14 @@ public:
     /// map a point backward according to the inverse transformation
     Point2 mapBackward( const Point2 &pt ) const;
 
+    /// map a set of points forward according to the transformation (see transformPoints for stats and target)
+    void mapForward( const PointSet2F &input, PointSet2F &output, PointSetStats *stats = NULL, const PointSet2F *target = NULL ) const;
+    void mapForward( const PointSet2D &input, PointSet2D &output, PointSetStats *stats = NULL, const PointSet2D *target = NULL ) const;
+
+    /// map a set of points backward according to the inverse transformation (see transformPoints for stats and target)
+    void mapBackward( const PointSet2F &input, PointSet2F &output, PointSetStats *stats = NULL, const PointSet2F *target = NULL ) const;
+    void mapBackward( const PointSet2D &input, PointSet2D &output, PointSetStats *stats = NULL, const PointSet2D *target = NULL ) const;
+
     /// display transformation parameters
     void display( int indent );
 
@@ -129,6 +143,14 @@ private:
     // the transformation parameters
     VectorF m_params;
 
+    // the forward and inverse transformations as 6 affine parameters (used for mapping points)
+    double m_affineParams[ 6 ];
+    double m_invParams[ 6 ];
+    bool m_invertible;
+
+    // update m_affineParams and m_invParams from m_params
+    void updateInverse();
+
     // disable copy constructor and assignment operator
     ImageTransform( const ImageTransform &x );
     ImageTransform &operator=( const ImageTransform &x );
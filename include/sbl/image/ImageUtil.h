@@ -3,6 +3,8 @@
 #include <sbl/core/Pointer.h>
 #include <sbl/other/TaggedFile.h>
 #include <sbl/image/Image.h>
+#include <sbl/image/ImageView.h>
+#include <sbl/image/IntegralImage.h>
 namespace sbl {
 
 
@@ -10,7 +12,8 @@ namespace sbl {
 	\brief The ImageUtil module provides various functions for working with image objects,
 	including filtering, converting, and loading/saving.  Most of these functions are
 	simple wrappers for OpenCV functions.  For spatial image transformations, see 
-	the ImageTransform module.
+	the ImageTransform module.  Functions that take ImageView arguments can operate on
+	a sub-region of an image (e.g. excluding a border, or one tile of a larger image).
 */
 
 
@@ -50,23 +53,24 @@ aptr<ImageColorU> toUChar( const ImageColorF &input, float scaleFactor );
 //-------------------------------------------
 
 
-/// blur using box filter
+/// blur using box filter (borders are reflected, as with OpenCV's default border mode)
 template <typename ImageType> aptr<ImageType> blurBox( const ImageType &input, int boxSize );
 
 
 /// blur using Gaussian filter
 template <typename ImageType> aptr<ImageType> blurGauss( const ImageType &input, float sigma );
+template <typename T, int CHANNEL_COUNT> void blurGauss( const ImageView<T, CHANNEL_COUNT> &input, ImageView<T, CHANNEL_COUNT> output, float sigma );
 
 
-/// apply median filter (set each pixel to median of neighbors)
+/// apply median filter (set each pixel to median of neighbors); apertureSize must be odd; borders are replicated
 template <typename ImageType> aptr<ImageType> median( const ImageType &input, int apertureSize );
 
 
-/// image x gradient
+/// image x gradient (Sobel filter; apertureSize may be 1, 3, 5, or 7)
 template <typename ImageType> aptr<ImageGrayF> xGrad( const ImageType &input, int apertureSize );
 
 
-/// image y gradient
+/// image y gradient (Sobel filter; apertureSize may be 1, 3, 5, or 7)
 template <typename ImageType> aptr<ImageGrayF> yGrad( const ImageType &input, int apertureSize );
 
 
@@ -74,15 +78,17 @@ template <typename ImageType> aptr<ImageGrayF> yGrad( const ImageType &input, in
 aptr<ImageGrayF> gradientMagnitude( const ImageGrayU &input, int apertureSize );
 
 
-/// apply threshold to image values
+/// apply threshold to image values: values above thresh become 255 and others become 0 (or the reverse, if invert)
 template <typename ImageType> aptr<ImageType> threshold( const ImageType &input, float thresh, bool invert );
+template <typename T> void threshold( const ImageView<T, 1> &input, ImageView<T, 1> output, float thresh, bool invert );
 
 
 /// invert a floating point image, assuming values in [0, 1]
 aptr<ImageGrayF> invert( const ImageGrayF &input );
 
 
-/// apply a box filter and then threshold
+/// apply a box filter and then threshold; the 8-bit version uses an integral image (so its cost does not depend on the box size)
+/// and averages only the part of each box inside the image
 aptr<ImageGrayU> blurBoxAndThreshold( const ImageGrayU &input, int boxSize, int thresh );
 aptr<ImageGrayU> blurBoxAndThreshold( const ImageGrayF &input, int boxSize, float thresh );
 
@@ -91,7 +97,8 @@ aptr<ImageGrayU> blurBoxAndThreshold( const ImageGrayF &input, int boxSize, floa
 void multiply( const ImageGrayF &input, float factor, ImageGrayF &output );
 
 
-/// perform local brightness normalization
+/// perform local brightness normalization: shift each pixel so that the mean brightness of the window around it becomes 128;
+/// uses an integral image (so its cost does not depend on the window size); windows are clipped to the image
 aptr<ImageColorU> normalizeLocalBrightness( const ImageColorU &input, int windowSize );
 aptr<ImageGrayU> normalizeLocalBrightness( const ImageGrayU &input, int windowSize );
 
@@ -102,38 +109,45 @@ aptr<ImageGrayU> normalizeLocalBrightness( const ImageGrayU &input, int windowSi
 
 
 /// compute mean pixel value
-float mean( const ImageGrayU &img );
-float mean( const ImageGrayF &img );
-float mean( const ImageColorU &img );
+float mean( const ImageViewGrayU &img );
+float mean( const ImageViewGrayF &img );
+float mean( const ImageViewColorU &img );
 
 
 /// compute mean pixel value of each color channel
-void channelMean( const ImageColorU &img, float &rMean, float &gMean, float &bMean );
+void channelMean( const ImageViewColorU &img, float &rMean, float &gMean, float &bMean );
 
 
 /// compute mean absolute difference between pixel values
-float meanAbsDiff( const ImageColorU &img1, const ImageColorU &img2 );
+float meanAbsDiff( const ImageViewColorU &img1, const ImageViewColorU &img2 );
+float meanAbsDiff( const ImageViewGrayU &img1, const ImageViewGrayU &img2 );
 float meanAbsDiff( const ImageGrayU &img1, const ImageGrayU &img2, int xBorder, int yBorder );
 
 
 /// compute mutual info between a pair of images
+float mutualInfo( const ImageViewGrayU &img1, const ImageViewGrayU &img2, int bucketCount );
 float mutualInfo( const ImageGrayU &img1, const ImageGrayU &img2, int xBorder, int yBorder, int bucketCount );
 
 
-/// compute bounds of the non-zero mask region
-void maskBounds( const ImageGrayU &mask, int &xMin, int &xMax, int &yMin, int &yMax );
+/// compute bounds of the non-zero mask region (in view coordinates)
+void maskBounds( const ImageViewGrayU &mask, int &xMin, int &xMax, int &yMin, int &yMax );
 
 
 /// count number of non-zero entries in mask
-int maskCount( const ImageGrayU &mask );
+int maskCount( const ImageViewGrayU &mask );
 
 
 /// compute min/mean/max pixel values
-void imageStats( const ImageGrayU &img, int &min, float &mean, int &max );
-void imageStats( const ImageGrayF &img, float &min, float &mean, float &max );
+void imageStats( const ImageViewGrayU &img, int &min, float &mean, int &max );
+void imageStats( const ImageViewGrayF &img, float &min, float &mean, float &max );
+
+
+/// compute min/mean/max pixel values and the histogram of pixel values (with 256 bins) in one pass
+void imageStats( const ImageViewGrayU &img, int &min, float &mean, int &max, VectorI &histogram );
 
 
 /// compute histogram of image pixel values
+VectorI imageHistogram( const ImageViewGrayU &image );
 VectorI imageHistogram( const ImageGrayU &image, int xMin, int xMax, int yMin, int yMax );
 
 
@@ -186,6 +200,11 @@ bool lineIntersects( const ImageGrayU &mask, float x1, float y1, float x2, float
 bool rectIntersects( const ImageGrayU &mask, int x1, int y1, int x2, int y2 );
 
 
+/// returns true if rectange intersects non-zero mask values, using an integral image of the mask (constant time for any rectangle);
+/// (assumes points are inside image bounds)
+bool rectIntersects( const IntegralImageGray &maskIntegral, int x1, int y1, int x2, int y2 );
+
+
 /// draw the an iso-contour of the mask on the given output image
 void drawMaskBoundary( ImageColorU &output, const ImageGrayU &mask, int thresh, int r, int g, int b, int xBorder = 0, int yBoder = 0 );
 
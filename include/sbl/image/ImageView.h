@@ -0,0 +1,155 @@
+#ifndef _SBL_IMAGE_VIEW_H_
+#define _SBL_IMAGE_VIEW_H_
+#include <sbl/image/Image.h>
+#include <string.h> // for memcpy
+namespace sbl {
+
+
+/*! \file ImageView.h
+	\brief The ImageView module provides a non-owning view of a rectangular region of pixels,
+	so that image functions can operate on sub-regions (e.g. tiles or areas inside a border)
+	without copying.
+*/
+
+
+//-------------------------------------------
+// IMAGE VIEW CLASS
+//-------------------------------------------
+
+
+/// The ImageView class refers to a rectangular region of pixels owned by another object (an Image, a MotionField channel, or external memory).
+/// A view must not outlive the pixel data it refers to.  As with a cv::Mat header, a view of a const image can be copied
+/// into a writable view, so functions that take a const view reference must not write through it.
+template <typename T, int CHANNEL_COUNT> class ImageView {
+public:
+
+	// note: this class uses default copy constructor and assignment operator
+
+	/// create a view of external pixel data with the given row stride in bytes
+	ImageView( T *data, int width, int height, int rowBytes ) : m_data( data ), m_width( width ), m_height( height ), m_rowBytes( rowBytes ) {}
+
+	/// create a view of an entire image
+	ImageView( const Image<T, CHANNEL_COUNT> &img )
+		: m_data( (T *) img.rawConst() ), m_width( img.width() ), m_height( img.height() ), m_rowBytes( img.rowBytes() ) {}
+
+	/// create a view of a region of an image
+	ImageView( const Image<T, CHANNEL_COUNT> &img, int xMin, int yMin, int width, int height );
+
+	/// create a view of a region of this view
+	ImageView sub( int xMin, int yMin, int width, int height ) const;
+
+	/// create a view that excludes the given number of pixels along each side of this view
+	inline ImageView inner( int xBorder, int yBorder ) const { return sub( xBorder, yBorder, m_width - 2 * xBorder, m_height - 2 * yBorder ); }
+
+	/// get/set pixel values for gray views (assumes CHANNEL_COUNT == 1)
+	inline T &data( int x, int y ) { assertStatic( CHANNEL_COUNT == 1 ); IMGCHK return row( y )[ x ]; }
+	inline const T &data( int x, int y ) const { assertStatic( CHANNEL_COUNT == 1 ); IMGCHK return row( y )[ x ]; }
+	float interp( float x, float y ) const;
+
+	/// get/set pixel values for multi-channel views
+	inline T &data( int x, int y, int c ) { IMGCHK return row( y )[ x * CHANNEL_COUNT + c ]; }
+	inline const T &data( int x, int y, int c ) const { IMGCHK return row( y )[ x * CHANNEL_COUNT + c ]; }
+
+	/// access the pixel data of a row
+	inline T *row( int y ) { return (T *) ((unsigned char *) m_data + (size_t) y * m_rowBytes); }
+	inline const T *row( int y ) const { return (const T *) ((const unsigned char *) m_data + (size_t) y * m_rowBytes); }
+
+	// get view info
+	inline int width() const { return m_width; }
+	inline int height() const { return m_height; }
+	inline int rowBytes() const { return m_rowBytes; }
+	inline int channelCount() const { return CHANNEL_COUNT; }
+
+	/// check whether position is in view bounds
+	inline bool inBounds( int x, int y ) const { return x >= 0 && x < m_width && y >= 0 && y < m_height; }
+	inline bool inBounds( float x, float y ) const { return x >= 0 && x < m_width - 1 && y >= 0 && y < m_height - 1; }
+
+	/// copy the pixels of this view to another view of the same size
+	void copyTo( ImageView output ) const;
+
+#ifdef USE_OPENCV
+
+	/// create a cv::Mat header referring to the same pixels (no copy)
+	inline cv::Mat cvMat() const { return cv::Mat( m_height, m_width, CV_MAKETYPE( cv::DataType<T>::type, CHANNEL_COUNT ), m_data, m_rowBytes ); }
+
+#endif // USE_OPENCV
+
+private:
+
+	// the pixel data (top origin)
+	T *m_data;
+	int m_width;
+	int m_height;
+	int m_rowBytes;
+};
+
+
+//-------------------------------------------
+// IMAGE VIEW CLASS IMPLEMENTATION
+//-------------------------------------------
+
+
+/// create a view of a region of an image
+template <typename T, int CHANNEL_COUNT> ImageView<T, CHANNEL_COUNT>::ImageView( const Image<T, CHANNEL_COUNT> &img, int xMin, int yMin, int width, int height ) {
+	assertAlways( xMin >= 0 && yMin >= 0 && width >= 0 && height >= 0 && xMin + width <= img.width() && yMin + height <= img.height() );
+	m_data = (T *) img.row( yMin ) + xMin * CHANNEL_COUNT;
+	m_width = width;
+	m_height = height;
+	m_rowBytes = img.rowBytes();
+}
+
+
+/// create a view of a region of this view
+template <typename T, int CHANNEL_COUNT> ImageView<T, CHANNEL_COUNT> ImageView<T, CHANNEL_COUNT>::sub( int xMin, int yMin, int width, int height ) const {
+	assertAlways( xMin >= 0 && yMin >= 0 && width >= 0 && height >= 0 && xMin + width <= m_width && yMin + height <= m_height );
+	return ImageView( (T *) row( yMin ) + xMin * CHANNEL_COUNT, width, height, m_rowBytes );
+}
+
+
+/// performs bilinear interpolation at specified point (same edge handling as Image::interp)
+template <typename T, int CHANNEL_COUNT> float ImageView<T, CHANNEL_COUNT>::interp( float x, float y ) const {
+	assertStatic( CHANNEL_COUNT == 1 );
+	int xInt = (int) x;
+	int yInt = (int) y;
+	assertDebug( xInt >= 0 && yInt >= 0 && xInt < m_width && yInt < m_height );
+	float xFrac = x - xInt;
+	float yFrac = y - yInt;
+	const T *row0 = row( yInt ) + xInt;
+	const T *row1 = (const T *) ((const unsigned char *) row0 + (yInt < m_height - 1 ? m_rowBytes : 0));
+	int xStep = xInt < m_width - 1 ? 1 : 0;
+	float top = row0[ 0 ] + xFrac * (float) (row0[ xStep ] - row0[ 0 ]);
+	float bottom = row1[ 0 ] + xFrac * (float) (row1[ xStep ] - row1[ 0 ]);
+	return top + yFrac * (bottom - top);
+}
+
+
+/// copy the pixels of this view to another view of the same size
+template <typename T, int CHANNEL_COUNT> void ImageView<T, CHANNEL_COUNT>::copyTo( ImageView output ) const {
+	assertAlways( output.width() == m_width && output.height() == m_height );
+	int rowBytes = m_width * CHANNEL_COUNT * sizeof(T);
+	for (int y = 0; y < m_height; y++)
+		memcpy( output.row( y ), row( y ), rowBytes );
+}
+
+
+/// create a view of an entire image (deducing the view type from the image type)
+template <typename T, int CHANNEL_COUNT> inline ImageView<T, CHANNEL_COUNT> imageView( const Image<T, CHANNEL_COUNT> &img ) {
+	return ImageView<T, CHANNEL_COUNT>( img );
+}
+
+
+//-------------------------------------------
+// IMAGE VIEW TYPEDEFS
+//-------------------------------------------
+
+
+/// common image view types
+typedef ImageView<unsigned char, 3> ImageViewColorU;
+typedef ImageView<float, 3> ImageViewColorF;
+typedef ImageView<unsigned char, 1> ImageViewGrayU;
+typedef ImageView<unsigned short, 1> ImageViewGrayS;
+typedef ImageView<float, 1> ImageViewGrayF;
+
+
+} // end namespace sbl
+#endif // _SBL_IMAGE_VIEW_H_
@@ -0,0 +1,101 @@
+#ifndef _SBL_INTEGRAL_IMAGE_H_
+#define _SBL_INTEGRAL_IMAGE_H_
+#include <sbl/math/Vector.h>
+#include <sbl/image/ImageView.h>
+namespace sbl {
+
+
+/*! \file IntegralImage.h
+	\brief The IntegralImage module provides summed-area tables of 8-bit images, so that the sum,
+	mean, or variance of any rectangle can be computed in constant time (regardless of its size).
+*/
+
+
+// register commands, etc. defined in this module
+void initIntegralImage();
+
+
+//-------------------------------------------
+// INTEGRAL IMAGE CLASS
+//-------------------------------------------
+
+
+/// The IntegralImage class holds, for each channel, the sum of the pixel values above and to the left of each position
+/// (and optionally the sum of the squared values).  The sums are stored modulo 2^32 (or 2^64 for squared values),
+/// so rectangle sums are exact as long as they fit in 32 bits (any rectangle of up to 16.8 million pixels).
+template <int CHANNEL_COUNT> class IntegralImage {
+public:
+
+	/// compute the sums (and the sums of squared values, if squared) of the given image
+	IntegralImage( const ImageView<unsigned char, CHANNEL_COUNT> &input, bool squared );
+
+	/// the size of the image
+	inline int width() const { return m_width; }
+	inline int height() const { return m_height; }
+
+	/// true if the sums of squared values are available
+	inline bool hasSquared() const { return m_squaredSums.length() > 0; }
+
+	/// the sum of the values of a channel within the given (inclusive) bounds (which must be inside the image)
+	inline unsigned int sum( int xMin, int yMin, int xMax, int yMax, int c = 0 ) const {
+		assertDebug( xMin >= 0 && yMin >= 0 && xMax < m_width && yMax < m_height && xMin <= xMax && yMin <= yMax );
+		const unsigned int *top = m_sums.dataPtr() + yMin * m_rowLength + c, *bottom = m_sums.dataPtr() + (yMax + 1) * m_rowLength + c;
+		return bottom[ (xMax + 1) * CHANNEL_COUNT ] - bottom[ xMin * CHANNEL_COUNT ] - top[ (xMax + 1) * CHANNEL_COUNT ] + top[ xMin * CHANNEL_COUNT ];
+	}
+
+	/// the sum of the squared values of a channel within the given (inclusive) bounds (requires hasSquared())
+	inline unsigned long long squaredSum( int xMin, int yMin, int xMax, int yMax, int c = 0 ) const {
+		assertDebug( hasSquared() );
+		assertDebug( xMin >= 0 && yMin >= 0 && xMax < m_width && yMax < m_height && xMin <= xMax && yMin <= yMax );
+		const unsigned long long *top = m_squaredSums.dataPtr() + yMin * m_rowLength + c, *bottom = m_squaredSums.dataPtr() + (yMax + 1) * m_rowLength + c;
+		return bottom[ (xMax + 1) * CHANNEL_COUNT ] - bottom[ xMin * CHANNEL_COUNT ] - top[ (xMax + 1) * CHANNEL_COUNT ] + top[ xMin * CHANNEL_COUNT ];
+	}
+
+	/// the mean value of a channel within the given (inclusive) bounds
+	inline float mean( int xMin, int yMin, int xMax, int yMax, int c = 0 ) const {
+		return (float) ((double) sum( xMin, yMin, xMax, yMax, c ) / (double) ((xMax - xMin + 1) * (yMax - yMin + 1)));
+	}
+
+	/// the variance of the values of a channel within the given (inclusive) bounds (requires hasSquared())
+	float variance( int xMin, int yMin, int xMax, int yMax, int c = 0 ) const;
+
+	/// the mean value of a channel within a boxSize by boxSize window around (x, y), clipped to the image;
+	/// as with blurBox, an even-sized window has one more pixel before the center than after it
+	inline float windowMean( int x, int y, int boxSize, int c = 0 ) const {
+		int before = boxSize / 2, after = boxSize - 1 - before;
+		int xMin = x - before, yMin = y - before, xMax = x + after, yMax = y + after;
+		if (xMin < 0) xMin = 0;
+		if (yMin < 0) yMin = 0;
+		if (xMax >= m_width) xMax = m_width - 1;
+		if (yMax >= m_height) yMax = m_height - 1;
+		return mean( xMin, yMin, xMax, yMax, c );
+	}
+
+	/// compute windowMean for every pixel and channel of row y (storing width * CHANNEL_COUNT values, interleaved as in the image);
+	/// the clipped windows must have fewer than 8 million pixels
+	void windowMeanRow( int y, int boxSize, float *out ) const;
+
+private:
+
+	// the image size and the number of values in each row of the tables ((width + 1) * CHANNEL_COUNT)
+	int m_width;
+	int m_height;
+	int m_rowLength;
+
+	// the tables: (width + 1) by (height + 1) positions, with the first row and column zero
+	Vector<unsigned int> m_sums;
+	Vector<unsigned long long> m_squaredSums;
+
+	// disable copy constructor and assignment operator
+	IntegralImage( const IntegralImage &x );
+	IntegralImage &operator=( const IntegralImage &x );
+};
+
+
+// common integral image types
+typedef IntegralImage<1> IntegralImageGray;
+typedef IntegralImage<3> IntegralImageColor;
+
+
+} // end namespace sbl
+#endif // _SBL_INTEGRAL_IMAGE_H_
@@ -2,9 +2,14 @@
 #define _SBL_MOTION_FIELD_H_
 #include <sbl/core/Pointer.h>
 #include <sbl/image/Image.h>
+#include <sbl/image/ImageView.h>
 namespace sbl {
 
 
+// used for motion fields that wrap memory-mapped files (defined in FileSystem.h)
+class MappedFile;
+
+
 /// The MotionField class represents a 2D correspondence field between a pair of images (e.g., optical flow).
 class MotionField {
 public:
@@ -12,6 +17,11 @@ public:
 	/// create an uninitialized motion field
 	MotionField( int width, int height );
 
+	/// create a motion field from the given images (which must have the same size; occMask may be NULL);
+	/// takes ownership of the images and of the mapping (if not NULL), which is deleted after the images
+	/// (so the images can wrap data in a memory-mapped file)
+	MotionField( ImageGrayF *u, ImageGrayF *v, ImageGrayU *occMask, MappedFile *mapping = NULL );
+
 	// basic copy constructor
 	MotionField( const MotionField &mf );
 
@@ -31,6 +41,8 @@ public:
 	inline ImageGrayF &vRef() { return *m_v; }
 	inline const ImageGrayF &uRef() const { return *m_u; }
 	inline const ImageGrayF &vRef() const { return *m_v; }
+	inline ImageViewGrayF uView( int xBorder = 0, int yBorder = 0 ) const { return ImageViewGrayF( *m_u ).inner( xBorder, yBorder ); }
+	inline ImageViewGrayF vView( int xBorder = 0, int yBorder = 0 ) const { return ImageViewGrayF( *m_v ).inner( xBorder, yBorder ); }
 	inline bool inBounds( int x, int y ) const { return m_u->inBounds( x, y ); }
 	inline bool inBounds( float x, float y ) const { return m_u->inBounds( x, y ); }
 
@@ -83,6 +95,9 @@ private:
 	ImageGrayF *m_v;
 	ImageGrayU *m_occMask;
 
+	// the memory-mapped file holding the motion data, if any
+	MappedFile *m_mapping;
+
 	// meta-data
 	float m_buildTime;
 	String m_algorithmName;
@@ -2,40 +2,137 @@
 #define _SBL_MOTION_FIELD_SEQ_H_
 #include <sbl/core/String.h>
 #include <sbl/core/Pointer.h>
+#include <sbl/core/Array.h>
+#include <sbl/math/Vector.h>
 #include <sbl/image/MotionField.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 namespace sbl {
 
 
+/*! \file MotionFieldSeq.h
+	\brief The MotionFieldSeq module provides access to a sequence of motion fields stored on disk,
+	with a cache of recently used fields, a background thread that loads the fields ahead of sequential
+	reads, and asynchronous writes.
+*/
+
+
+// register commands, etc. defined in this module
+void initMotionFieldSeq();
+
+
 //-------------------------------------------
 // MOTION FIELD SEQ CLASS
 //-------------------------------------------
 
 
 /// The MotionFieldSeq class provides access to motion fields estimated for an image sequence;
-/// the motion fields are stored on disk.
+/// the motion fields are stored on disk.  Recently used fields are kept in a cache (limited to a given number of bytes).
+/// When the fields are read in order (forward or backward), a background thread loads the next fields into the cache.
+/// Writes are queued and performed by the background thread; call flush() to wait for them (the destructor also does this).
 class MotionFieldSeq {
 public:
 
-	/// specify the path containing (or that will contain) the motion field files
-	MotionFieldSeq( const String &path );
-	
-	/// read a motion field from the sequence
+	/// specify the path containing (or that will contain) the motion field files, the cache size in bytes
+	/// (0 disables caching, prefetching, and asynchronous writes), and the number of fields to load ahead of sequential reads
+	explicit MotionFieldSeq( const String &path, int cacheBytes = 256 * 1024 * 1024, int prefetchCount = 2 );
+
+	// wait for writes and stop the background thread
+	~MotionFieldSeq();
+
+	/// read a motion field from the sequence; returns a copy of the cached field if available
 	aptr<MotionField> read( int index );
 
-	/// write a motion field into the sequence
+	/// write a motion field into the sequence; the field is copied and written by the background thread
 	void write( int index, MotionField &motionField );
 
+	/// wait until all writes have been completed
+	void flush();
+
 	/// the effective sequence length (may include gaps)
 	inline int count() const { return m_count; }
 
+	/// the number of reads that found / did not find the field in the cache (or in the write queue)
+	inline int hitCount() const { return m_hitCount; }
+	inline int missCount() const { return m_missCount; }
+
+	/// the number of fields loaded by the background thread
+	inline int prefetchCount() const { return m_prefetchLoadCount; }
+
+	/// the total time (in seconds) that reads have waited for the background thread to finish loading the requested field
+	inline float prefetchStallTime() const { return (float) m_prefetchStallTime; }
+
+	/// the total time (in seconds) that writes have waited for the write queue to have space
+	inline float writeStallTime() const { return (float) m_writeStallTime; }
+
+	/// the number of bytes used by cached fields
+	inline int cacheBytesUsed() const { return m_cacheBytesUsed; }
+
 private:
 
+	// the name of the file holding the given motion field
+	String fileName( int index ) const;
+
+	// the position of the field in the cache or the write queue, or -1 if not found (assumes m_mutex is held)
+	int cachePosition( int index ) const;
+	int writePosition( int index ) const;
+
+	// add a field to the cache (taking ownership), removing the least-recently used fields as needed (assumes m_mutex is held)
+	void addToCache( int index, MotionField *motionField );
+
+	// remove a field from the cache (assumes m_mutex is held)
+	void removeFromCache( int position );
+
+	// start the background thread if it isn't running (assumes m_mutex is held)
+	void startThread();
+
+	// the background thread loop: write queued fields, then load requested fields
+	void threadMain();
+
 	// the path containing (or that will contain) the motion field files
 	String m_path;
 
 	// the effective sequence length (may include gaps)
 	int m_count;
 
+	// cached fields, their sequence indices, and the time each was last used
+	PtrArray<MotionField> m_cacheFields;
+	VectorI m_cacheIndex;
+	VectorI m_cacheLastUse;
+	int m_cacheBytes;
+	int m_cacheBytesUsed;
+	int m_useCount;
+
+	// fields waiting to be written (owned by this object), their sequence indices, and the number currently being written
+	PtrArray<MotionField> m_writeFields;
+	VectorI m_writeIndex;
+	int m_writeBytes;
+	int m_writingCount;
+
+	// indices to be loaded by the background thread, and the index currently being loaded (-1 if none)
+	int m_prefetchCount;
+	VectorI m_prefetchIndex;
+	int m_loadingIndex;
+
+	// the last index read and the direction of sequential reads (+1 or -1; 0 if reads are not sequential)
+	int m_lastReadIndex;
+	int m_readDirection;
+
+	// statistics
+	int m_hitCount;
+	int m_missCount;
+	int m_prefetchLoadCount;
+	double m_prefetchStallTime;
+	double m_writeStallTime;
+
+	// the background thread and the state used to communicate with it
+	aptr<std::thread> m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_threadWake;
+	std::condition_variable m_threadDone;
+	bool m_stopThread;
+
 	// disable copy constructor and assignment operator
 	MotionFieldSeq( const MotionFieldSeq &x );
 	MotionFieldSeq &operator=( const MotionFieldSeq &x );
@@ -13,6 +13,10 @@ namespace sbl {
 */
 
 
+// register commands, etc. defined in this module
+void initMotionFieldUtil();
+
+
 //-------------------------------------------
 // MOTION FIELD STATISTICS
 //-------------------------------------------
@@ -48,16 +52,32 @@ void dispMotion( const MotionField &mf, const String &caption = "" );
 //-------------------------------------------
 
 
-/// load motion field from binary data file
+/// motion value encodings for binary motion field files
+enum class MotionFieldEncoding {
+	MOTION_FLOAT32, // exact
+	MOTION_FLOAT16, // half-precision floats: error at most |value| * 2^-11 (e.g. 1/4 pixel for 512-pixel motions); magnitudes above 65504 saturate
+	MOTION_FIXED16 // 16-bit multiples of a fixed step: error at most step / 2; magnitudes above 32767 * step saturate
+};
+
+
+/// load motion field from binary data file (in either the current planar format or the older interleaved format)
 aptr<MotionField> loadMotionField( const String &fileName );
 
 
+/// load motion field from binary data file by memory-mapping it; for uncompressed MOTION_FLOAT32 files
+/// (the default saveMotionField format), the motion field uses the mapped data without copying it;
+/// other files are loaded as with loadMotionField
+aptr<MotionField> mapMotionField( const String &fileName );
+
+
 /// load motion field from floating-point image file
 aptr<MotionField> loadMotionFieldImage( const String &fileName );
 
 
-/// save motion field to binary data file
-void saveMotionField( const MotionField &mf, const String &fileName );
+/// save motion field to binary data file, storing u, v, and the occlusion mask (if any) as separate aligned blocks;
+/// fixedStep is used with MOTION_FIXED16; if compress is true, the blocks are compressed with zlib (requires USE_ZLIB)
+void saveMotionField( const MotionField &mf, const String &fileName, MotionFieldEncoding encoding = MotionFieldEncoding::MOTION_FLOAT32,
+					  float fixedStep = 1.0f / 64.0f, bool compress = false );
 
 
 /// save motion field to floating-point image file
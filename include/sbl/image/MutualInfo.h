@@ -0,0 +1,92 @@
+#ifndef _SBL_MUTUAL_INFO_H_
+#define _SBL_MUTUAL_INFO_H_
+#include <sbl/math/Vector.h>
+#include <sbl/image/ImageView.h>
+namespace sbl {
+
+
+/*! \file MutualInfo.h
+	\brief The MutualInfo module provides joint histograms of pairs of 8-bit values (with
+	integer bins, filled in parallel) and the mutual information computed from them, using
+	either hard binning or Parzen-window (soft) binning.
+*/
+
+
+// register commands, etc. defined in this module
+void initMutualInfo();
+
+
+//-------------------------------------------
+// JOINT HISTOGRAM CLASS
+//-------------------------------------------
+
+
+/// The JointHistogram class counts pairs of 8-bit values in bucketCount by bucketCount bins (bucketCount must be between 2 and 256).
+/// A value v is placed at position v * (bucketCount - 1) / 255.  With hard binning, each pair adds one to the bin containing
+/// its (rounded down) position; with Parzen binning, each pair is split between the four nearest bins using linear weights
+/// (with 4 fractional bits per axis, so each pair adds 256).  The bins are 32-bit integers, so a histogram can hold
+/// up to 4 billion hard-binned pairs or 16 million Parzen-binned pairs.
+class JointHistogram {
+public:
+
+	/// create an empty histogram
+	JointHistogram( int bucketCount, bool parzen = false );
+
+	/// the number of buckets along each axis
+	inline int bucketCount() const { return m_bucketCount; }
+
+	/// true if using Parzen-window (soft) binning
+	inline bool parzen() const { return m_parzen; }
+
+	/// the number of pairs added to the histogram
+	inline long long sampleCount() const { return m_sampleCount; }
+
+	/// the value of a bin (in units of 1 / 256 of a pair if using Parzen binning)
+	inline unsigned int bin( int i, int j ) const { return m_bins[ i * m_bucketCount + j ]; }
+
+	/// remove all pairs from the histogram
+	void reset();
+
+	/// add the pairs (values1[ i ], values2[ i ]) for i in [0, count)
+	void add( const unsigned char *values1, const unsigned char *values2, int count );
+
+	/// add the corresponding pixels of a pair of images (with the rows split across the worker threads)
+	void add( const ImageViewGrayU &img1, const ImageViewGrayU &img2 );
+
+	/// add the bins of another histogram (with the same bucket count and binning)
+	void merge( const JointHistogram &histogram );
+
+	/// the mutual information (in nats) of the distribution given by the histogram
+	double mutualInfo() const;
+
+private:
+
+	// the number of buckets along each axis and the binning
+	int m_bucketCount;
+	bool m_parzen;
+
+	// the bins (m_bins[ i * m_bucketCount + j ] counts the pairs with the first value in bucket i and the second in bucket j)
+	Vector<unsigned int> m_bins;
+	long long m_sampleCount;
+
+	// for Parzen binning, the position of each value with 4 fractional bits
+	Vector<unsigned short> m_positions;
+
+	// disable copy constructor and assignment operator
+	JointHistogram( const JointHistogram &x );
+	JointHistogram &operator=( const JointHistogram &x );
+};
+
+
+//-------------------------------------------
+// MUTUAL INFORMATION
+//-------------------------------------------
+
+
+/// compute mutual info between a pair of images using Parzen-window (soft) binning; this varies smoothly as the images change,
+/// which makes it better suited to optimization than hard-binned mutual info (see also mutualInfo in ImageUtil.h)
+float mutualInfoParzen( const ImageViewGrayU &img1, const ImageViewGrayU &img2, int bucketCount );
+
+
+} // end namespace sbl
+#endif // _SBL_MUTUAL_INFO_H_
@@ -0,0 +1,97 @@
+#ifndef _SBL_SEPARABLE_FILTER_H_
+#define _SBL_SEPARABLE_FILTER_H_
+#include <sbl/math/Vector.h>
+#include <sbl/image/ImageView.h>
+namespace sbl {
+
+
+/*! \file SeparableFilter.h
+	\brief The SeparableFilter module provides a multithreaded engine for separable image filters
+	(Gaussian, box, and derivative kernels) and for resampling (area and bilinear resizing).
+	Most code should use the wrappers in the ImageUtil and ImageTransform modules.
+*/
+
+
+//-------------------------------------------
+// FILTER TAPS CLASS
+//-------------------------------------------
+
+
+/// The FilterTaps class describes one axis of a separable filter: for each output position,
+/// the input positions and weights that contribute to it.
+class FilterTaps {
+public:
+
+	/// create empty taps; call one of the set functions before use
+	FilterTaps() : m_type( TAPS_NONE ), m_inputLength( 0 ), m_outputLength( 0 ), m_tapCount( 0 ) {}
+
+	/// use a kernel (correlated with the input, centered on each position); borders are reflected
+	/// without repeating the edge value (as with OpenCV's default border mode)
+	void setKernel( const VectorF &kernel, int length );
+
+	/// use a normalized box kernel of the given size (computed with running sums, so the cost does not depend on size)
+	void setBox( int boxSize, int length );
+
+	/// resample from inputLength to outputLength using area averaging (if area and shrinking) or bilinear interpolation
+	void setResample( int inputLength, int outputLength, bool area );
+
+	/// blur with a kernel and keep every other position (output length (length + 1) / 2), in one pass; borders are reflected as with setKernel
+	void setDecimate( const VectorF &kernel, int length );
+
+	/// upsample by a factor of two (inverting setDecimate) using the Burt-Adelson expansion kernel (1, 4, 6, 4, 1) / 8;
+	/// inputLength must be (outputLength + 1) / 2
+	void setExpand( int inputLength, int outputLength );
+
+	/// the number of input and output positions
+	inline int inputLength() const { return m_inputLength; }
+	inline int outputLength() const { return m_outputLength; }
+
+	/// the number of input positions that contribute to each output position
+	inline int tapCount() const { return m_tapCount; }
+
+private:
+
+	// the kind of taps
+	enum TapType { TAPS_NONE, TAPS_KERNEL, TAPS_BOX, TAPS_RESAMPLE };
+	TapType m_type;
+
+	// the axis lengths
+	int m_inputLength;
+	int m_outputLength;
+	int m_tapCount;
+
+	// for kernel and box taps: the kernel weights and, for each position of the border-extended axis, the input position
+	VectorF m_kernel;
+	VectorI m_extendedIndex;
+
+	// for resampling taps: the input positions and weights for each output position (tapCount per output position)
+	VectorI m_index;
+	VectorF m_weight;
+
+	// the filter engine reads the taps directly
+	template <typename InT, typename OutT, int CHANNEL_COUNT> friend class SeparableFilterBand;
+};
+
+
+//-------------------------------------------
+// SEPARABLE FILTER
+//-------------------------------------------
+
+
+/// create a normalized Gaussian kernel; if size is zero, the size is computed from sigma (as in OpenCV: 3 sigma each side for 8-bit images, 4 sigma otherwise)
+VectorF gaussianKernel( float sigma, int size, bool forFloatImage );
+
+
+/// create the derivative and smoothing kernels of a Sobel filter with the given aperture size (1, 3, 5, or 7; 1 means no smoothing)
+void sobelKernels( int apertureSize, VectorF &derivKernel, VectorF &smoothKernel );
+
+
+/// apply a separable filter: the y taps are applied to the input rows, then the x taps to the result;
+/// the output size must match the taps' output lengths; values are rounded and saturated when the output type is 8-bit;
+/// the work is split into bands of rows across the worker threads
+template <typename InT, typename OutT, int CHANNEL_COUNT> void separableFilter( const ImageView<InT, CHANNEL_COUNT> &input, ImageView<OutT, CHANNEL_COUNT> output,
+																				const FilterTaps &xTaps, const FilterTaps &yTaps );
+
+
+} // end namespace sbl
+#endif // _SBL_SEPARABLE_FILTER_H_
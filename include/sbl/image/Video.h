@@ -2,21 +2,37 @@
 #define _SBL_VIDEO_H_
 #include <sbl/core/Pointer.h>
 #include <sbl/image/Image.h>
-struct CvCapture;
-struct CvVideoWriter;
 namespace sbl {
 
 
+/*! \file Video.h
+	\brief The Video module provides classes for reading frames from video files (or image sequences)
+	and writing frames to video files.  Input frames are decoded ahead of use by a background thread;
+	output frames are encoded by another background thread.
+*/
+
+
+// register commands, etc. defined in this module
+void initVideo();
+
+
+// internal classes used by InputVideo and OutputVideo (defined in Video.cc)
+class VideoFrameReader;
+class VideoFrameWriter;
+
+
 //-------------------------------------------
 // INPUT VIDEO CLASS
 //-------------------------------------------
 
 
 /// The InputVideo class provides an interface to an input video file (or image sequence).
+/// A background thread decodes the frames following the most recently requested frame (in the same step size),
+/// so that sequential access does not require seeking; the most recently used frames are kept for stepping backward.
 class InputVideo {
 public:
 
-	/// open a video file
+	/// open a video file; if the file doesn't report its length, the frames are counted by decoding the whole video
 	explicit InputVideo( const String &fileName = "" );
 	void open( const String &fileName );
 
@@ -35,14 +51,33 @@ public:
 	int height();
 
 	/// return true if successfully open input video
-	bool openSuccess() { return m_cvCapture || m_imageList.count(); }
+	bool openSuccess() { return m_reader != NULL; }
+
+	/// set the number of frames to decode ahead of each request (at most maxMegabytes of frames) and, for image sequences,
+	/// the number of images to load at once (0 for the number of threads used by parallel loops); call before requesting frames
+	void setReadAhead( int frameCount, int threadCount = 0, int maxMegabytes = 512 );
+
+	/// the number of frame requests that were / were not already decoded, and the number of times the decoder seeked
+	int hitCount() const;
+	int missCount() const;
+	int seekCount() const;
+
+	/// the total time (in seconds) that frame requests have waited for the decoder
+	float waitTime() const;
 
 private:
 
-	// internal data
-	CvCapture *m_cvCapture;
+	// get the frame size (from the first frame if not provided by the video file)
+	void initSize();
+
+	// the background decoder and frame cache (NULL if not open)
+	VideoFrameReader *m_reader;
+
+	// image sequence info (if reading a set of image files)
 	String m_imagePath;
 	Array<String> m_imageList;
+
+	// the video size
 	int m_width;
 	int m_height;
 	int m_length;
@@ -59,21 +94,31 @@ private:
 
 
 /// The OutputVideo class provides an interface to an output video file.
+/// Appended frames are placed in a queue and encoded by a background thread, so that the caller can continue
+/// with the next frame; when the queue is full, append waits for the encoder.
 class OutputVideo {
 public:
 
-	/// open the output video file
+	/// open the output video file; up to queueLength frames can wait to be encoded
 	OutputVideo();
-	OutputVideo( const String &fileName, int outputWidth, int outputHeight, double fps = 30 );
-	void open( const String &fileName, int outputWidth, int outputHeight, double fps = 30 );
+	OutputVideo( const String &fileName, int outputWidth, int outputHeight, double fps = 30, int queueLength = 8 );
+	void open( const String &fileName, int outputWidth, int outputHeight, double fps = 30, int queueLength = 8 );
 
-	/// close the output video file
+	/// finish encoding and close the output video file
 	~OutputVideo();
 
-	/// add a frame to the video
+	/// add a copy of a frame to the video (grayscale frames are converted to color by the background thread)
 	void append( const ImageColorU &img );
 	void append( const ImageGrayU &img );
 
+	/// add a frame to the video, taking ownership of the image (so that it doesn't need to be copied)
+	void append( aptr<ImageColorU> img );
+	void append( aptr<ImageGrayU> img );
+
+	/// wait for the queued frames to be encoded and close the output video file; 
+	/// returns false (and displays a warning) if any frames could not be written
+	bool close();
+
 	/// returns true if video file successfully created
 	bool openSuccess();
 
@@ -81,10 +126,17 @@ public:
 	inline int width() const { return m_width; }
 	inline int height() const { return m_height; }
 
+	/// the number of frames written, and the total time (in seconds) that append has waited for space in the queue
+	int frameCount() const;
+	float waitTime() const;
+
 private:
 
-	// an OpenCV video object
-	CvVideoWriter *m_videoWriter;
+	// the background encoder and frame queue (NULL if not open)
+	VideoFrameWriter *m_writer;
+
+	// the output file name (used in messages)
+	String m_fileName;
 
 	// video image size
 	int m_width;
@@ -0,0 +1,136 @@
+#ifndef _SBL_VOLUME_H_
+#define _SBL_VOLUME_H_
+#include <sbl/core/Pointer.h>
+#include <sbl/image/Image.h>
+#include <sbl/image/ImageView.h>
+#include <sbl/image/ImageSeqUtil.h>
+namespace sbl {
+
+
+/*! \file Volume.h
+	\brief The Volume module provides a 3D array type stored in a single aligned block of memory,
+	with z-axis filtering (computed a row at a time across frames), trilinear interpolation, frame views,
+	and conversions to and from image sequences.
+*/
+
+
+// register commands, etc. defined in this module
+void initVolume();
+
+
+//-------------------------------------------
+// VOLUME CLASS
+//-------------------------------------------
+
+
+/// The Volume class holds a width by height by length array of values (e.g. the frames of an image sequence) in one block
+/// of memory.  As in Image, rows are padded to multiples of IMAGE_ROW_ALIGN bytes, so each row and each frame starts at an
+/// aligned address; rowStride() and frameStride() give the number of values between consecutive rows and frames.
+template <typename T> class Volume {
+public:
+
+	/// create a volume; does not initialize the values
+	Volume( int width, int height, int length );
+
+	// basic destructor
+	~Volume();
+
+	/// the size of the volume
+	inline int width() const { return m_width; }
+	inline int height() const { return m_height; }
+	inline int length() const { return m_length; }
+
+	/// the number of values between the starts of consecutive rows and consecutive frames
+	inline int rowStride() const { return m_rowStride; }
+	inline size_t frameStride() const { return m_frameStride; }
+
+	/// get/set values
+	inline T &data( int x, int y, int z ) { assertDebug( inBounds( x, y, z ) ); return row( y, z )[ x ]; }
+	inline const T &data( int x, int y, int z ) const { assertDebug( inBounds( x, y, z ) ); return row( y, z )[ x ]; }
+
+	/// access the values of a row of a frame
+	inline T *row( int y, int z ) { return m_raw + z * m_frameStride + (size_t) y * m_rowStride; }
+	inline const T *row( int y, int z ) const { return m_raw + z * m_frameStride + (size_t) y * m_rowStride; }
+
+	/// true if the position is within the volume
+	inline bool inBounds( int x, int y, int z ) const { return x >= 0 && x < m_width && y >= 0 && y < m_height && z >= 0 && z < m_length; }
+
+	/// a view of a frame (sharing the values of the volume)
+	inline ImageView<T, 1> frame( int z ) const { return ImageView<T, 1>( (T *) row( 0, z ), m_width, m_height, m_rowStride * sizeof( T ) ); }
+
+	/// an Image object wrapping a frame (sharing the values of the volume, so it must not be used after the volume is deallocated)
+	inline aptr< Image<T, 1> > frameImage( int z ) const { return aptr< Image<T, 1> >( new Image<T, 1>( (T *) row( 0, z ), m_width, m_height, m_rowStride * sizeof( T ) ) ); }
+
+	/// set all values
+	void clear( T value );
+
+	/// perform trilinear interpolation (assumes the point is inside the volume)
+	float interp( float x, float y, float z ) const;
+
+	/// perform trilinear interpolation at each of the given points (assumes the points are inside the volume)
+	void interp( const float *x, const float *y, const float *z, int count, float *out ) const;
+
+	/// the number of bytes used by the volume
+	inline size_t memUsed() const { return sizeof( Volume<T> ) + m_frameStride * m_length * sizeof( T ); }
+
+private:
+
+	// the volume size and the strides (in values)
+	int m_width;
+	int m_height;
+	int m_length;
+	int m_rowStride;
+	size_t m_frameStride;
+
+	// the values; m_raw is aligned to IMAGE_ROW_ALIGN within the allocated block
+	T *m_raw;
+	unsigned char *m_alloc;
+
+	// disable copy constructor and assignment operator
+	Volume( const Volume &x );
+	Volume &operator=( const Volume &x );
+};
+
+
+// common volume types
+typedef Volume<unsigned char> VolumeU;
+typedef Volume<float> VolumeF;
+
+
+//-------------------------------------------
+// CONVERSION
+//-------------------------------------------
+
+
+/// create a volume holding a copy of an image sequence (the images must all have the same size)
+aptr<VolumeU> toVolume( const ImageGrayUSeq &seq );
+aptr<VolumeF> toVolume( const ImageGrayFSeq &seq );
+
+
+/// append a copy of each frame of a volume to an (empty) image sequence
+void toImageSeq( const VolumeU &volume, ImageGrayUSeq &seq );
+void toImageSeq( const VolumeF &volume, ImageGrayFSeq &seq );
+
+
+//-------------------------------------------
+// VOLUME FILTERS
+//-------------------------------------------
+
+
+/// blur along the z axis (with the same Gaussian kernel as blurGaussSeqZ)
+aptr<VolumeU> blurGaussZ( const VolumeU &input, float sigma );
+aptr<VolumeF> blurGaussZ( const VolumeF &input, float sigma );
+
+
+/// resize along the z axis (with linear interpolation, as in resizeSeqZ)
+aptr<VolumeU> resizeZ( const VolumeU &input, int newLength );
+aptr<VolumeF> resizeZ( const VolumeF &input, int newLength );
+
+
+/// transpose the Y and Z axes: output( x, z, y ) = input( x, y, z )
+aptr<VolumeU> transposeYZ( const VolumeU &input );
+aptr<VolumeF> transposeYZ( const VolumeF &input );
+
+
+} // end namespace sbl
+#endif // _SBL_VOLUME_H_
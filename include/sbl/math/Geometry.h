@@ -5,6 +5,10 @@
 namespace sbl {
 
 
+// register commands, etc. defined in this module
+void initGeometry();
+
+
 //-------------------------------------------
 // POINT 2 CLASS 
 //-------------------------------------------
@@ -220,6 +224,9 @@ public:
 
 	/// transform a point using the matrix
 	Point3 operator*( const Point3 &p ) const;
+
+	/// multiply two matrices
+	Matrix3 operator*( const Matrix3 &m ) const;
 };
 
 
@@ -269,9 +276,120 @@ public:
 
 	/// compute the inverse transformation
 	AffineTransform3 inverse() const;
+
+	/// compose transformations: the result applies t and then this transformation
+	AffineTransform3 operator*( const AffineTransform3 &t ) const;
 };
 
 
+//-------------------------------------------
+// POINT SET CLASSES
+//-------------------------------------------
+
+
+/// The PointSet2 class holds a set of 2D points as separate x and y vectors (structure-of-arrays), for batch operations.
+template <typename T> class PointSet2 {
+public:
+
+	/// create a set of zero-initialized points
+	explicit PointSet2( int count = 0 ) : x( count ), y( count ) { x.clear( 0 ); y.clear( 0 ); }
+
+	/// the point coordinates
+	Vector<T> x;
+	Vector<T> y;
+
+	/// the number of points
+	inline int count() const { return x.length(); }
+
+	/// change the number of points (does not preserve existing points)
+	inline void setCount( int count ) { x.setLength( count ); y.setLength( count ); }
+
+	/// get/set a single point
+	inline _Point2<T> point( int index ) const { return _Point2<T>( x[ index ], y[ index ] ); }
+	inline void setPoint( int index, const _Point2<T> &p ) { x[ index ] = p.x; y[ index ] = p.y; }
+};
+typedef PointSet2<float> PointSet2F;
+typedef PointSet2<double> PointSet2D;
+
+
+/// The PointSet3 class holds a set of 3D points as separate x, y, and z vectors (structure-of-arrays), for batch operations.
+template <typename T> class PointSet3 {
+public:
+
+	/// create a set of zero-initialized points
+	explicit PointSet3( int count = 0 ) : x( count ), y( count ), z( count ) { x.clear( 0 ); y.clear( 0 ); z.clear( 0 ); }
+
+	/// the point coordinates
+	Vector<T> x;
+	Vector<T> y;
+	Vector<T> z;
+
+	/// the number of points
+	inline int count() const { return x.length(); }
+
+	/// change the number of points (does not preserve existing points)
+	inline void setCount( int count ) { x.setLength( count ); y.setLength( count ); z.setLength( count ); }
+
+	/// get/set a single point
+	inline _Point3<T> point( int index ) const { return _Point3<T>( x[ index ], y[ index ], z[ index ] ); }
+	inline void setPoint( int index, const _Point3<T> &p ) { x[ index ] = p.x; y[ index ] = p.y; z[ index ] = p.z; }
+};
+typedef PointSet3<float> PointSet3F;
+typedef PointSet3<double> PointSet3D;
+
+
+/// The PointSetStats class holds summary values computed in the same pass as a batch point transformation.
+class PointSetStats {
+public:
+
+	/// create empty stats
+	PointSetStats() { reset(); }
+
+	/// bounding box of the transformed points (z is zero for 2D points)
+	Point3D minBound;
+	Point3D maxBound;
+
+	/// squared distances between the transformed points and the target points (if any)
+	double sumSqError;
+	double maxSqError;
+
+	/// the number of points included in the stats
+	int count;
+
+	/// root-mean-square distance between the transformed points and the target points
+	double rmsError() const;
+
+	/// clear the stats
+	void reset();
+
+	/// add stats from another set of points
+	void merge( const PointSetStats &stats );
+};
+
+
+//-------------------------------------------
+// BATCH POINT TRANSFORMS
+//-------------------------------------------
+
+
+/// apply a 3D transformation to each point of the input set, storing the results in the output set
+/// (which may be the same object as the input set); if stats is non-NULL it receives the bounding box of the results and
+/// (if target is non-NULL) the squared distances between each result and the corresponding target point
+void transformPoints( const AffineTransform3 &transform, const PointSet3F &input, PointSet3F &output, PointSetStats *stats = NULL, const PointSet3F *target = NULL );
+void transformPoints( const AffineTransform3 &transform, const PointSet3D &input, PointSet3D &output, PointSetStats *stats = NULL, const PointSet3D *target = NULL );
+
+
+/// apply a 2D affine transformation to each point of the input set; the six parameters have the same order as ImageTransform parameters:
+/// x' = p[ 0 ] + p[ 2 ] * x + p[ 4 ] * y, y' = p[ 1 ] + p[ 3 ] * x + p[ 5 ] * y; stats and target are handled as for 3D points
+void transformPoints( const double *params, const PointSet2F &input, PointSet2F &output, PointSetStats *stats = NULL, const PointSet2F *target = NULL );
+void transformPoints( const double *params, const PointSet2D &input, PointSet2D &output, PointSetStats *stats = NULL, const PointSet2D *target = NULL );
+
+
+//-------------------------------------------
+// TRANSFORM FILES
+//-------------------------------------------
+
+
 /// save 3D affine transformation parameters to text file
 void saveTransform( File &file, AffineTransform3 &transform );
 
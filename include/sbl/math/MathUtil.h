@@ -9,6 +9,10 @@ namespace sbl {
 */
 
 
+// register commands, etc. defined in this module
+void initMathUtil();
+
+
 /// basic min/max functions 
 // fix(clean): use templates; how do we name to avoid conflicts with c libraries
 #undef min
@@ -64,29 +68,104 @@ inline double gaussFactor( double sigma ) { return -0.5 / (sigma * sigma); }
 template <typename T> inline void swap( T &v1, T &v2 ) { T t = v2; v2 = v1; v1 = t; }
 
 
-/// returns a random float between 0.0 and 1.0;
-/// note: this isn't a very good random number
-float randomFloat();
+//-------------------------------------------
+// RANDOM NUMBERS
+//-------------------------------------------
+
+
+/// The RandomGenerator class is a fast, high-quality random number generator (xoshiro256**).
+/// Generators with the same seed and different stream indices produce independent sequences.
+class RandomGenerator {
+public:
+
+	/// create a generator for the given seed and stream
+	explicit RandomGenerator( unsigned long long seed = 0, unsigned long long streamIndex = 0 ) { setSeed( seed, streamIndex ); }
+
+	/// restart the generator with the given seed and stream
+	void setSeed( unsigned long long seed, unsigned long long streamIndex = 0 );
+
+	/// returns 64 random bits
+	inline unsigned long long next() {
+		unsigned long long result = rotateLeft( m_state[ 1 ] * 5, 7 ) * 9;
+		unsigned long long t = m_state[ 1 ] << 17;
+		m_state[ 2 ] ^= m_state[ 0 ];
+		m_state[ 3 ] ^= m_state[ 1 ];
+		m_state[ 1 ] ^= m_state[ 2 ];
+		m_state[ 0 ] ^= m_state[ 3 ];
+		m_state[ 2 ] ^= t;
+		m_state[ 3 ] = rotateLeft( m_state[ 3 ], 45 );
+		return result;
+	}
+
+	/// returns a float in [0, 1) with 24 bits of precision
+	inline float uniform() { return (float) (next() >> 40) * (1.0f / 16777216.0f); }
+
+	/// returns a double in [0, 1) with 53 bits of precision
+	inline double uniformDouble() { return (double) (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+	/// returns an integer in [min, max] (without modulo bias)
+	int uniformInt( int min, int max );
+
+	/// returns a sample from a normal distribution with zero mean and unit variance
+	float gaussian();
+
+	/// fill an array with values sampled uniformly between min and max (vectorized)
+	void fillUniform( float *data, int count, float min, float max );
+
+	/// fill an array with values sampled from a normal distribution
+	void fillGaussian( float *data, int count, float mean, float sdev );
+
+private:
 
+	// 64-bit bit rotation
+	static inline unsigned long long rotateLeft( unsigned long long x, int k ) { return (x << k) | (x >> (64 - k)); }
 
-/// returns a random float between the specified bounds;
-/// note: this isn't a very good random number
-float randomFloat( float min, float max );
+	// generator state (not all zero)
+	unsigned long long m_state[ 4 ];
 
+	// second value from the most recent pair of gaussian samples
+	float m_spareGaussian;
+	bool m_hasSpareGaussian;
+};
 
-/// returns a random integer within specified bounds;
-/// note: this isn't a very good random number
-int randomInt( int min, int max );
 
+/// the calling thread's random number generator; each thread uses a separate stream derived from the seed set by randomSeed()
+RandomGenerator &randomGenerator();
 
-/// returns 1 or -1;
-/// note: this isn't a very good random number
+
+/// returns a random float in [0.0, 1.0) using the calling thread's generator
+inline float randomFloat() { return randomGenerator().uniform(); }
+
+
+/// returns a random float between the specified bounds using the calling thread's generator
+inline float randomFloat( float min, float max ) { return min + randomGenerator().uniform() * (max - min); }
+
+
+/// returns a random integer within specified bounds (inclusive) using the calling thread's generator
+inline int randomInt( int min, int max ) { return randomGenerator().uniformInt( min, max ); }
+
+
+/// returns 1 or -1
 inline int randomSign() { return randomInt( 0, 1 ) ? 1 : -1; }
 
 
-/// set the random number generator seed
+/// returns a sample from a normal distribution using the calling thread's generator
+inline float randomGaussian( float mean, float sdev ) { return mean + sdev * randomGenerator().gaussian(); }
+
+
+/// set the random number generator seed; restarts the streams of all threads
+/// (the calling thread uses stream 0; other threads are assigned streams in order of first use after this call)
 void randomSeed( int seed );
 
 
+/// fill an array with values sampled uniformly between min and max; the array is split into fixed-size blocks, 
+/// each with its own stream, that are filled in parallel, so the result does not depend on the number of threads
+void randomFillUniform( float *data, int count, float min, float max );
+
+
+/// fill an array with values sampled from a normal distribution (in parallel, as with randomFillUniform)
+void randomFillGaussian( float *data, int count, float mean, float sdev );
+
+
 } // end namespace sbl
 #endif // _SBL_MATH_UTIL_H_
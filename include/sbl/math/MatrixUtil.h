@@ -140,6 +140,10 @@ aptr<MatrixF> toMatrixF( const Array<VectorF> &vectorArray );
 aptr<MatrixF> randomMatrixF( int rows, int cols, float min, float max );
 
 
+/// create a matrix of random values, sampled from a normal distribution
+aptr<MatrixF> randomGaussianMatrixF( int rows, int cols, float mean, float sdev );
+
+
 /// unroll the matrix into a vector (scanning across rows);
 /// returns aptr because vector may be large
 aptr<VectorF> toVector( MatrixF &m );
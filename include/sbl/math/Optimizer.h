@@ -3,6 +3,7 @@
 #include <sbl/core/String.h>
 #include <sbl/math/Vector.h>
 #include <sbl/math/Matrix.h>
+#include <float.h>
 namespace sbl {
 
 
@@ -23,6 +24,10 @@ public:
 	/// evaluate objective function at given point
 	virtual double eval( const VectorD &point ) = 0;
 
+	/// evaluate objective function at given point; once the value is known to be at least abortValue,
+	/// the evaluation may stop early and return any value that is at least abortValue
+	virtual double evalBounded( const VectorD &point, double abortValue ) { return eval( point ); }
+
 private:
 
 	// disable copy constructor and assignment operator
@@ -85,8 +90,9 @@ public:
 
 protected:
 
-	/// evaluate objective function at given point, applying a penality to out-of-bounds points
-	double evalWithPenalty( const VectorD &point );
+	/// evaluate objective function at given point, applying a penality to out-of-bounds points;
+	/// the evaluation may stop early if the value (including the penalty) is known to be at least abortValue
+	double evalWithPenalty( const VectorD &point, double abortValue = DBL_MAX );
 
 	// represents objective function being optimized
 	Objective &m_objective;
@@ -4,6 +4,7 @@
 #include <sbl/math/Vector.h>
 #include <sbl/math/Matrix.h>
 #include <sbl/core/Pointer.h>
+#include <sbl/core/Array.h>
 #include <sbl/image/Image.h>
 namespace sbl {
 
@@ -14,6 +15,10 @@ namespace sbl {
 */
 
 
+// register commands, etc. defined in this module
+void initTriangulation();
+
+
 // returns matrix of edges; each row is (x1, y1, x2, y2)
 aptr<MatrixF> triangulate( const MatrixF &points );
 
@@ -23,7 +28,12 @@ aptr<MatrixI> triangulateIndex( const MatrixF &points );
 
 
 // use triangulation to interpolate values across an image
-aptr<ImageGrayF> triangulationInterpolation( const MatrixF &points, VectorF &values, int width, int height );
+aptr<ImageGrayF> triangulationInterpolation( const MatrixF &points, const VectorF &values, int width, int height );
+
+
+// use triangulation to interpolate several values per point (one column of values per channel) across a set of images;
+// the images must be allocated by the caller, with one image per channel, all the same size (1 to 16 channels)
+void triangulationInterpolation( const MatrixF &points, const MatrixF &values, PtrArray<ImageGrayF> &images );
 
 
 } // end namespace sbl
@@ -142,6 +142,10 @@ VectorF stepSubset( const VectorF &v, int step );
 VectorF randomVectorF( int len, float min, float max );
 
 
+/// create a vector of random elements sampled from a normal distribution
+VectorF randomGaussianVectorF( int len, float mean, float sdev );
+
+
 /// create a random permutation of integers in [0, len - 1]
 VectorI randomPermutation( int len );
 
@@ -2,6 +2,7 @@
 #define _SBL_FILE_SYSTEM_H_
 #include <sbl/core/Array.h>
 #include <sbl/core/String.h>
+#include <stddef.h>
 namespace sbl {
 
 
@@ -74,6 +75,48 @@ bool isAbsoluteFileName( const String &fileName );
 int fileModificationTimestamp( const String &fileName );
 
 
+//-------------------------------------------
+// MAPPED FILE CLASS
+//-------------------------------------------
+
+
+/// The MappedFile class maps the contents of a file into memory.  The mapping is private (copy-on-write),
+/// so the data can be modified without changing the file.
+class MappedFile {
+public:
+
+	/// map the given file; check openSuccess() before using the data
+	explicit MappedFile( const String &fileName );
+
+	/// unmap the file
+	~MappedFile();
+
+	/// returns true if the file was mapped successfully
+	inline bool openSuccess() const { return m_data != NULL; }
+
+	/// the mapped data (page-aligned)
+	inline unsigned char *data() { return m_data; }
+	inline const unsigned char *data() const { return m_data; }
+
+	/// the number of bytes in the file
+	inline size_t size() const { return m_size; }
+
+private:
+
+	// the mapped data
+	unsigned char *m_data;
+	size_t m_size;
+
+	// the OS handles of the file and the mapping (used on Windows)
+	void *m_fileHandle;
+	void *m_mappingHandle;
+
+	// disable copy constructor and assignment operator
+	MappedFile( const MappedFile &x );
+	MappedFile &operator=( const MappedFile &x );
+};
+
+
 //-------------------------------------------
 // OPERATING SYSTEM UTILITIES
 //-------------------------------------------
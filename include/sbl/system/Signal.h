@@ -6,7 +6,9 @@ namespace sbl {
 /*! \file Signal.h
 	\brief The Signal module is used to capture CTRL-C keypresses.  
 	After initSignal() is called, a single CTRL-C will attempt to cancel the 
-	currently running command and a triple CTRL-C will terminate the program.
+	currently running command (by cancelling commandCancelToken(); long-running 
+	operations such as the video filter pipeline and pyramid image registration 
+	stop at the next frame or level) and a triple CTRL-C will terminate the program.
 */
 
 
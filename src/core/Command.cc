@@ -448,8 +448,8 @@ void runScript( const String &fileName ) {
 //-------------------------------------------
 
 
-// true if current command should halt itself
-bool g_cancelCommand = false;
+// set if current command should halt itself
+CancelToken g_commandCancelToken;
 
 
 // this callback will be called every time a long-running command calls checkCommandEvents
@@ -462,17 +462,33 @@ void setCommandEventCallback( void (*commandEventCallback)() ) {
 }
 
 
-/// check for events (e.g. update GUI) and return true if command cancel
+/// check for events (e.g. update GUI) and return true if command cancel;
+/// on parallel worker threads, this only checks for cancellation (events are handled by the thread running the command)
 bool checkCommandEvents() {
-	if (g_commandEventCallback)
+	if (g_commandEventCallback && workerThread() == false)
 		g_commandEventCallback();
-	return g_cancelCommand;
+	return g_commandCancelToken.cancelled();
 }
 
 
 /// indicate whether to cancel the currently running command (if any)
 void setCancelCommand( bool cancel ) {
-	g_cancelCommand = cancel;
+	if (cancel)
+		g_commandCancelToken.cancel();
+	else
+		g_commandCancelToken.reset();
+}
+
+
+/// true if the current command has been cancelled; unlike checkCommandEvents, this doesn't handle events, so it can be called from any thread
+bool commandCancelled() {
+	return g_commandCancelToken.cancelled();
+}
+
+
+/// the token set when the current command is cancelled (by setCancelCommand or CTRL-C)
+CancelToken &commandCancelToken() {
+	return g_commandCancelToken;
 }
 
 
@@ -302,6 +302,24 @@ void Config::updateFrom( const Config &conf ) {
 }
 
 
+/// replace the entries, settings, and command args (including the position of the next command arg) with those of another config
+void Config::copyFrom( const Config &conf ) {
+	m_configEntries.reset();
+	for (int i = 0; i < conf.m_configEntries.count(); i++)
+		m_configEntries.appendCopy( conf.m_configEntries[ i ] );
+	m_commandArgs.reset();
+	for (int i = 0; i < conf.m_commandArgs.count(); i++)
+		m_commandArgs.appendCopy( conf.m_commandArgs[ i ] );
+	m_commandArgPosition = conf.m_commandArgPosition;
+	m_allowNewEntries = conf.m_allowNewEntries;
+	m_allowDefault = conf.m_allowDefault;
+	m_dualPass = conf.m_dualPass;
+	m_initialPass = conf.m_initialPass;
+	m_checkedInitialPass = conf.m_checkedInitialPass;
+	m_missingValue = conf.m_missingValue;
+}
+
+
 /// set an array of command arguments, to be assigned to subsequent calls to read() functions
 void Config::setCommandArgs( const Array<String> &commandArgs ) {
 	for (int i = 0; i < commandArgs.count(); i++) {
@@ -1,4 +1,5 @@
 #include <sbl/core/Display.h>
+#include <sbl/core/Parallel.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -31,7 +32,7 @@ void dispStr( const char *str ) {
 		fprintf( g_dispFile1, "%s\n", str );
 	if (g_dispFile2)
 		fprintf( g_dispFile2, "%s\n", str );
-    if (g_dispCallback)
+    if (g_dispCallback && workerThread() == false)
         g_dispCallback( str );
 }
 
@@ -42,7 +43,7 @@ void dispErrorStr( const char *str ) {
 		fprintf( g_errorFile1, "%s\n", str );
 	if (g_errorFile2)
 		fprintf( g_errorFile2, "%s\n", str );
-    if (g_errorCallback)
+    if (g_errorCallback && workerThread() == false)
         g_errorCallback( str );
 }
 
@@ -87,9 +88,10 @@ void status( const char *str, ... ) {
 	va_start( argList, str );
 	vsprintf( displayBuf, str, argList ); 
 
-	// display the status message
+	// display the status message (status messages from worker threads are dropped if there is a status callback)
 	if (g_statusCallback) {
-        g_statusCallback( displayBuf );
+		if (workerThread() == false)
+	        g_statusCallback( displayBuf );
 	} else {
 		printf( "\r%s", displayBuf );
 	}
@@ -135,9 +137,10 @@ void fatalError( const char *str, ... ) {
 
 /// displays progress bar (assumes index in [0, count - 1]);
 /// closes progress bar when index == count - 1; 
-/// if count == -1, assumes unknown number if items
+/// if count == -1, assumes unknown number if items;
+/// ignored on parallel worker threads (use a ProgressCounter to report progress of parallel work)
 void progress( int index, int count ) {
-	if (g_progressCallback)
+	if (g_progressCallback && workerThread() == false)
 		g_progressCallback( index, count );
 }
 
@@ -49,7 +49,7 @@ void File::open( const String &fileName, FileOpenMode mode, FileOpenType type )
 		modeStr = type == FileOpenType::FILE_TEXT ? "r" : "rb";
 	m_file = fopen( fileName.c_str(), modeStr );
 #ifdef USE_ZLIB
-	if (type == FILE_GZIP_BINARY && m_file) {
+	if (type == FileOpenType::FILE_GZIP_BINARY && m_file) {
 		m_gzFile = gzopen( fileName.c_str(), modeStr ); // fix(clean): don't also open as m_file
 	}
 #else
@@ -62,8 +62,8 @@ void File::open( const String &fileName, FileOpenMode mode, FileOpenType type )
 void File::close() { 
 #ifdef USE_ZLIB
 	if (m_gzFile) {
-		gzclose( m_gzFile );
-		m_file = NULL;
+		gzclose( (gzFile) m_gzFile );
+		m_gzFile = NULL;
 	}
 #endif
 	if (m_file) {
@@ -77,7 +77,7 @@ void File::close() {
 void File::flush() { 
 	if (m_gzFile) {
 #ifdef USE_ZLIB
-		gzflush( m_gzFile, Z_FINISH ); // note: this flush should be used sparingly
+		gzflush( (gzFile) m_gzFile, Z_FINISH ); // note: this flush should be used sparingly
 #endif
 	} else {
 		fflush( m_file ); 
@@ -91,7 +91,7 @@ bool File::endOfFile() {
 	if (m_file != NULL) {
 		if (m_gzFile) {
 #ifdef USE_ZLIB
-			eof = gzeof( m_gzFile ) ? true : false;
+			eof = gzeof( (gzFile) m_gzFile ) ? true : false;
 #endif
 		} else {
 			eof = feof( m_file ) ? true : false;
@@ -105,7 +105,7 @@ bool File::endOfFile() {
 void File::seek( int offset, bool relative ) {
 	if (m_gzFile) {
 #ifdef USE_ZLIB
-		gzseek( m_gzFile, offset, relative ? SEEK_CUR : SEEK_SET ); 
+		gzseek( (gzFile) m_gzFile, offset, relative ? SEEK_CUR : SEEK_SET ); 
 #endif
 	} else {
 		fseek( m_file, offset, relative ? SEEK_CUR : SEEK_SET ); 
@@ -118,7 +118,7 @@ int File::tell() {
 	int pos = 0;
 	if (m_gzFile) {
 #ifdef USE_ZLIB
-		pos = gztell( m_gzFile ); 
+		pos = gztell( (gzFile) m_gzFile ); 
 #endif
 	} else {
 		pos = ftell( m_file ); 
@@ -202,7 +202,7 @@ String File::readString() {
 void File::writeBlock( const void *data, int byteCount ) { 
 	if (m_gzFile) {
 #ifdef USE_ZLIB
-		gzwrite( m_gzFile, data, byteCount );
+		gzwrite( (gzFile) m_gzFile, data, byteCount );
 #endif
 	} else {
 		fwrite( data, byteCount, 1, m_file ); 
@@ -214,7 +214,7 @@ void File::writeBlock( const void *data, int byteCount ) {
 void File::readBlock( void *data, int byteCount ) { 
 #ifdef USE_ZLIB
 	if (m_gzFile)
-		gzread( m_gzFile, data, byteCount );
+		gzread( (gzFile) m_gzFile, data, byteCount );
 	else
 #endif
 		CHECK_READ( fread( data, byteCount, 1, m_file ) );
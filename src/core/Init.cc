@@ -3,11 +3,29 @@
 #include <sbl/core/File.h>
 #include <sbl/core/StringUtil.h>
 #include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/math/Geometry.h>
 #include <sbl/math/VectorUtil.h>
 #include <sbl/math/OptimizerUtil.h>
 #include <sbl/system/Signal.h>
 #include <sbl/image/ImageUtil.h>
+#include <sbl/image/ImageRemap.h>
+#include <sbl/image/ImageRegister.h>
+#include <sbl/image/ImagePyramid.h>
+#include <sbl/image/IntegralImage.h>
+#include <sbl/image/ConnectedComponents.h>
+#include <sbl/image/MutualInfo.h>
+#include <sbl/image/BinaryMask.h>
+#include <sbl/image/Volume.h>
+#include <sbl/image/MotionFieldUtil.h>
+#include <sbl/image/MotionFieldSeq.h>
+#include <sbl/image/Video.h>
+#include <sbl/image/Filter.h>
 #include <sbl/other/CodeCheck.h>
+#ifdef USE_CDT
+	#include <sbl/math/Triangulation.h>
+#endif
 #ifdef USE_PYTHON
 	#include <sbl/other/Scripting.h>
 #endif
@@ -22,16 +40,34 @@ void initModules() {
 	initFile();
 	initStringUtil();
 	initUnitTest();
+	initParallel();
 
 	// math modules
+	initMathUtil();
+	initGeometry();
 	initVectorUtil();
 	initOptimizerUtil();
+#ifdef USE_CDT
+	initTriangulation();
+#endif
 
 	// system modules
 	initSignal();
 
 	// image modules
 	initImageUtil();
+	initImageRemap();
+	initImageRegister();
+	initImagePyramid();
+	initIntegralImage();
+	initConnectedComponents();
+	initMutualInfo();
+	initBinaryMask();
+	initVolume();
+	initMotionFieldUtil();
+	initMotionFieldSeq();
+	initVideo();
+	initFilter();
 
 	// other modules
 	initCodeCheck();
@@ -0,0 +1,782 @@
+#include <sbl/core/Parallel.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/Display.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/PathConfig.h>
+#include <sbl/system/FileSystem.h>
+#include <sbl/system/Timer.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <stdlib.h>
+#ifndef WIN32
+	#include <stdio.h>
+	#include <unistd.h>
+	#include <signal.h>
+	#include <sys/wait.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// TASK QUEUES
+//-------------------------------------------
+
+
+/// The TaskQueue class holds tasks waiting to be run; the owning thread adds and removes tasks at the back
+/// (so that it continues with the most recently split work), while other threads steal from the front (the largest pieces).
+class TaskQueue {
+public:
+	std::mutex mutex;
+	std::deque<ParallelTask *> tasks;
+};
+
+
+// the requested number of threads (including the calling thread); zero if not yet set
+int g_threadCount = 0;
+
+
+// if true, loops started inside parallel loops or tasks are split across the worker threads
+bool g_nestedParallel = false;
+
+
+// task queues: one per worker, plus one (the last) shared by threads that aren't workers;
+// valid while g_schedulerStarted is true (started and stopped while holding g_schedulerMutex)
+TaskQueue *g_queues = NULL;
+int g_queueCount = 0;
+std::thread **g_workers = NULL;
+int g_workerCount = 0;
+std::atomic<bool> g_schedulerStarted( false );
+std::mutex g_schedulerMutex;
+
+
+// the number of tasks in all queues, and the number of workers waiting for tasks
+std::atomic<int> g_queuedTaskCount( 0 );
+std::atomic<int> g_sleepingWorkerCount( 0 );
+
+
+// used to wait for tasks: workers wait on g_workerWake; threads waiting for task groups wait on g_waiterWake;
+// these are never destroyed, since a thread may still be waiting when the program exits (e.g. if a task calls exit())
+std::mutex &g_sleepMutex = *new std::mutex;
+std::condition_variable &g_workerWake = *new std::condition_variable;
+std::condition_variable &g_waiterWake = *new std::condition_variable;
+bool g_stopWorkers = false;
+
+
+// the index of the current thread's queue if it is a worker thread (otherwise -1),
+// and the number of tasks (or serial loops) the thread is currently running
+thread_local int t_workerIndex = -1;
+thread_local int t_taskDepth = 0;
+
+
+// true if the current thread has been marked as a (non-scheduler) worker thread
+thread_local bool t_markedWorker = false;
+
+
+// the group of the task (or cancellable serial loop) the current thread is running (NULL if none)
+thread_local TaskGroup *t_currentGroup = NULL;
+
+
+// the most recently created progress counter on the current thread (NULL if none)
+thread_local ProgressCounter *t_progressCounter = NULL;
+
+
+// add a task to the current thread's queue (assumes the task has been added to its group)
+void queueTask( ParallelTask *task ) {
+	TaskGroup *group = task->group;
+	group->m_queued++; // counted before the task is visible, so that the counts are never negative
+	g_queuedTaskCount++;
+	TaskQueue &queue = g_queues[ t_workerIndex >= 0 ? t_workerIndex : g_queueCount - 1 ];
+	{
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		queue.tasks.push_back( task );
+	}
+
+	// wake a worker and the thread waiting for the group (if any)
+	if (g_sleepingWorkerCount > 0 || group->m_waiting) {
+		std::lock_guard<std::mutex> lock( g_sleepMutex );
+		g_workerWake.notify_one();
+		if (group->m_waiting)
+			g_waiterWake.notify_all();
+	}
+}
+
+
+// remove the first task (searching from the back or the front) belonging to the given group (or any group if NULL); returns NULL if none
+ParallelTask *takeTask( TaskQueue &queue, bool fromBack, TaskGroup *group ) {
+	std::lock_guard<std::mutex> lock( queue.mutex );
+	int count = (int) queue.tasks.size();
+	for (int i = 0; i < count; i++) {
+		int position = fromBack ? count - 1 - i : i;
+		ParallelTask *task = queue.tasks[ position ];
+		if (group == NULL || task->group == group) {
+			queue.tasks.erase( queue.tasks.begin() + position );
+			task->group->m_queued--;
+			g_queuedTaskCount--;
+			return task;
+		}
+	}
+	return NULL;
+}
+
+
+// find a task to run, checking the current thread's queue first, then stealing from the other queues;
+// a thread waiting for a group only takes that group's tasks (so that it doesn't start unrelated work while the caller may hold locks)
+ParallelTask *findTask( TaskGroup *group ) {
+	if (group ? group->m_queued == 0 : g_queuedTaskCount == 0)
+		return NULL;
+	int ownIndex = t_workerIndex >= 0 ? t_workerIndex : g_queueCount - 1;
+	ParallelTask *task = takeTask( g_queues[ ownIndex ], true, group );
+	for (int i = 1; i < g_queueCount && task == NULL; i++)
+		task = takeTask( g_queues[ (ownIndex + i) % g_queueCount ], false, group );
+	return task;
+}
+
+
+// run a task (unless its group has been cancelled), delete it, and mark it done
+void runParallelTask( ParallelTask *task ) {
+	TaskGroup *group = task->group;
+	if (group->cancelled() == false) {
+		TaskGroup *savedGroup = t_currentGroup;
+		t_currentGroup = group;
+		t_taskDepth++;
+		task->run();
+		t_taskDepth--;
+		t_currentGroup = savedGroup;
+	}
+	delete task;
+
+	// the group may be deleted as soon as its pending count reaches zero, so this is done while holding the mutex used by wait()
+	std::lock_guard<std::mutex> lock( g_sleepMutex );
+	if (--group->m_pending == 0 && group->m_waiting)
+		g_waiterWake.notify_all();
+}
+
+
+//-------------------------------------------
+// WORKER THREADS
+//-------------------------------------------
+
+
+// main loop of each worker thread: run tasks from any queue, waiting when there are none
+void workerThreadMain( int workerIndex ) {
+	t_workerIndex = workerIndex;
+	while (true) {
+		ParallelTask *task = findTask( NULL );
+		if (task) {
+			runParallelTask( task );
+			continue;
+		}
+		std::unique_lock<std::mutex> lock( g_sleepMutex );
+		g_sleepingWorkerCount++;
+		while (g_stopWorkers == false && g_queuedTaskCount == 0)
+			g_workerWake.wait( lock );
+		g_sleepingWorkerCount--;
+		if (g_stopWorkers)
+			break;
+	}
+}
+
+
+// stop and deallocate the worker threads and task queues (if any); if called by a worker thread (when a task calls exit(),
+// e.g. via fatalError), that thread is detached rather than joined, and the queues are kept for threads still waiting for tasks
+void stopWorkerThreads() {
+	std::lock_guard<std::mutex> schedulerLock( g_schedulerMutex );
+	{
+		std::lock_guard<std::mutex> lock( g_sleepMutex );
+		g_stopWorkers = true;
+		g_workerWake.notify_all();
+	}
+	for (int i = 0; i < g_workerCount; i++) {
+		if (i == t_workerIndex)
+			g_workers[ i ]->detach();
+		else
+			g_workers[ i ]->join();
+		delete g_workers[ i ];
+	}
+	delete [] g_workers;
+	g_workers = NULL;
+	g_workerCount = 0;
+	if (t_workerIndex >= 0)
+		return;
+	delete [] g_queues;
+	g_queues = NULL;
+	g_queueCount = 0;
+	g_stopWorkers = false;
+	g_schedulerStarted = false;
+}
+
+
+// true once stopWorkerThreads has been registered to run at exit
+bool g_stopAtExit = false;
+
+
+// create the task queues and start threadCount() - 1 worker threads (if not already done)
+void startScheduler() {
+	if (g_schedulerStarted)
+		return;
+	std::lock_guard<std::mutex> schedulerLock( g_schedulerMutex );
+	if (g_schedulerStarted)
+		return;
+
+	// the workers must be stopped before the mutex and condition variables are destroyed at exit
+	// (including in programs that exit without running the clean-up functions)
+	if (g_stopAtExit == false) {
+		atexit( stopWorkerThreads );
+		g_stopAtExit = true;
+	}
+	int workerCount = threadCount() - 1;
+	g_queues = new TaskQueue[ workerCount + 1 ];
+	g_queueCount = workerCount + 1;
+	g_workers = new std::thread*[ workerCount ];
+	for (int i = 0; i < workerCount; i++)
+		g_workers[ i ] = new std::thread( workerThreadMain, i );
+	g_workerCount = workerCount;
+	g_schedulerStarted = true;
+}
+
+
+//-------------------------------------------
+// TASK GROUP CLASS
+//-------------------------------------------
+
+
+/// create an empty group; tasks that haven't started are skipped once the cancel token (if any) is cancelled;
+/// if no token is given, the group uses the token of the loop or task group that the current thread is working on
+TaskGroup::TaskGroup( const CancelToken *cancelToken ) : m_pending( 0 ), m_queued( 0 ), m_waiting( false ), m_cancelled( false ) {
+	m_cancelToken = cancelToken;
+	if (m_cancelToken == NULL && t_currentGroup)
+		m_cancelToken = t_currentGroup->m_cancelToken;
+}
+
+
+// wait for the tasks to finish
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+
+// add a task to the group and queue it (the group takes ownership)
+void TaskGroup::add( ParallelTask *task ) {
+	startScheduler();
+	task->group = this;
+	m_pending++;
+	queueTask( task );
+}
+
+
+/// wait until all tasks in the group are done (running the group's queued tasks on this thread);
+/// returns false if the group was cancelled
+bool TaskGroup::wait() {
+	while (m_pending > 0) {
+		ParallelTask *task = findTask( this );
+		if (task) {
+			runParallelTask( task );
+			if (t_progressCounter)
+				t_progressCounter->report();
+			continue;
+		}
+
+		// if this thread reports progress, wake up periodically to do so
+		{
+			std::unique_lock<std::mutex> lock( g_sleepMutex );
+			m_waiting = true;
+			while (m_pending > 0 && m_queued == 0) {
+				if (t_progressCounter) {
+					g_waiterWake.wait_for( lock, std::chrono::milliseconds( 50 ) );
+					break;
+				}
+				g_waiterWake.wait( lock );
+			}
+			m_waiting = false;
+		}
+		if (t_progressCounter)
+			t_progressCounter->report();
+	}
+
+	// make sure the thread that finished the last task is done using this object
+	std::lock_guard<std::mutex> lock( g_sleepMutex );
+	return m_cancelled == false;
+}
+
+
+/// skip the tasks that haven't started
+void TaskGroup::cancel() {
+	m_cancelled = true;
+}
+
+
+/// true if the group has been cancelled (explicitly or by its cancel token)
+bool TaskGroup::cancelled() const {
+	if (m_cancelToken && m_cancelToken->cancelled())
+		m_cancelled = true;
+	return m_cancelled;
+}
+
+
+//-------------------------------------------
+// CANCELLATION AND PROGRESS
+//-------------------------------------------
+
+
+/// true if the loop or task group that the current thread is working on has been cancelled (false if not in a loop or task)
+bool taskCancelled() {
+	return t_currentGroup && t_currentGroup->cancelled();
+}
+
+
+/// true if the current thread is one of the scheduler's worker threads or has been marked with markWorkerThread
+bool workerThread() {
+	return t_workerIndex >= 0 || t_markedWorker;
+}
+
+
+/// mark the current thread as a worker thread; called by background threads that the library creates outside the scheduler
+void markWorkerThread() {
+	t_markedWorker = true;
+}
+
+
+/// create a counter for the given number of items, reported at most every reportInterval seconds
+ProgressCounter::ProgressCounter( int total, double reportInterval ) : m_count( 0 ) {
+	m_total = total;
+	m_reportInterval = reportInterval;
+	m_reportTime = getPerfTime();
+	m_reportCount = -1;
+	m_thread = std::this_thread::get_id();
+	m_previous = t_progressCounter;
+	t_progressCounter = this;
+}
+
+
+// close the progress display
+ProgressCounter::~ProgressCounter() {
+	if (std::this_thread::get_id() == m_thread) {
+		if (m_reportCount >= 0)
+			progressDone();
+		t_progressCounter = m_previous;
+	}
+}
+
+
+/// pass the count to progress() if the report interval has passed since the last report (does nothing on other threads)
+void ProgressCounter::report() {
+	if (std::this_thread::get_id() != m_thread)
+		return;
+	double time = getPerfTime();
+	if (time - m_reportTime < m_reportInterval)
+		return;
+	m_reportTime = time;
+
+	// progress() closes the display when given the last index, so that is left to the destructor
+	int count = m_count.load( std::memory_order_relaxed );
+	if (count > m_reportCount && count > 0 && count < m_total) {
+		progress( count - 1, m_total );
+		m_reportCount = count;
+	}
+}
+
+
+//-------------------------------------------
+// PARALLEL LOOPS
+//-------------------------------------------
+
+
+/// The ParallelRangeTask class runs a loop body on a range, first splitting off pieces (at multiples of the grain,
+/// along the dimension with more grains) for other threads until the range is no larger than the leaf size.
+class ParallelRangeTask : public ParallelTask {
+public:
+
+	// create a task for the given range
+	ParallelRangeTask( void (*callback)( void *data, int xBegin, int xEnd, int yBegin, int yEnd ), void *data,
+					   int xBegin, int xEnd, int yBegin, int yEnd, int xGrain, int yGrain, long long leafSize )
+		: m_callback( callback ), m_data( data ), m_xBegin( xBegin ), m_xEnd( xEnd ), m_yBegin( yBegin ), m_yEnd( yEnd ),
+		  m_xGrain( xGrain ), m_yGrain( yGrain ), m_leafSize( leafSize ) {}
+
+	// split off pieces for other threads, then run the remaining range
+	void run() {
+		while ((long long) (m_xEnd - m_xBegin) * (m_yEnd - m_yBegin) > m_leafSize) {
+			int xGrains = (m_xEnd - m_xBegin + m_xGrain - 1) / m_xGrain;
+			int yGrains = (m_yEnd - m_yBegin + m_yGrain - 1) / m_yGrain;
+			if (xGrains < 2 && yGrains < 2)
+				break;
+			ParallelRangeTask *task = new ParallelRangeTask( *this );
+			if (xGrains >= yGrains) {
+				int xMid = m_xBegin + (xGrains / 2) * m_xGrain;
+				task->m_xBegin = xMid;
+				m_xEnd = xMid;
+			} else {
+				int yMid = m_yBegin + (yGrains / 2) * m_yGrain;
+				task->m_yBegin = yMid;
+				m_yEnd = yMid;
+			}
+			group->add( task );
+		}
+		if (group->cancelled() == false)
+			m_callback( m_data, m_xBegin, m_xEnd, m_yBegin, m_yEnd );
+	}
+
+private:
+
+	// the loop body, the range, and the splitting parameters
+	void (*m_callback)( void *data, int xBegin, int xEnd, int yBegin, int yEnd );
+	void *m_data;
+	int m_xBegin;
+	int m_xEnd;
+	int m_yBegin;
+	int m_yEnd;
+	int m_xGrain;
+	int m_yGrain;
+	long long m_leafSize;
+};
+
+
+/// the number of threads (including the calling thread) used by parallel loops; by default, this is given by
+/// the SBL_THREAD_COUNT environment variable, the threadCount entry of the path config, or the number of processor cores
+int threadCount() {
+	if (g_threadCount == 0) {
+		const char *envCount = getenv( "SBL_THREAD_COUNT" );
+		int count = envCount ? atoi( envCount ) : 0;
+		if (count < 1)
+			count = (int) std::thread::hardware_concurrency();
+		g_threadCount = count > 1 ? count : 1;
+	}
+	return g_threadCount;
+}
+
+
+/// set the number of threads used by parallel loops; 1 disables threading (call when no parallel work is running)
+void setThreadCount( int count ) {
+	if (count < 1)
+		count = 1;
+	if (count != threadCount()) {
+		stopWorkerThreads();
+		g_threadCount = count;
+	}
+}
+
+
+/// set whether loops started from inside a parallel loop or task are split across the worker threads (rather than run serially)
+void setNestedParallel( bool nestedParallel ) {
+	g_nestedParallel = nestedParallel;
+}
+
+
+// run callback( data, xRangeBegin, xRangeEnd, yRangeBegin, yRangeEnd ) for tiles of [xBegin, xEnd) x [yBegin, yEnd); returns false if cancelled
+bool parallelForInternal( int xBegin, int xEnd, int yBegin, int yEnd, int xGrain, int yGrain,
+						  void (*callback)( void *data, int xBegin, int xEnd, int yBegin, int yEnd ), void *data, const CancelToken *cancelToken ) {
+	int xCount = xEnd - xBegin, yCount = yEnd - yBegin;
+	if (xCount <= 0 || yCount <= 0)
+		return true;
+	if (xGrain < 1)
+		xGrain = 1;
+	if (yGrain < 1)
+		yGrain = 1;
+
+	// run serially if too small to split, if there are no worker threads, or if nested (unless allowed)
+	bool splittable = xCount > xGrain || yCount > yGrain;
+	if (splittable == false || threadCount() == 1 || (t_taskDepth && g_nestedParallel == false)) {
+
+		// a loop inside a task uses the task's group for cancellation, unless given its own token
+		if (cancelToken == NULL) {
+			if (t_currentGroup && t_currentGroup->cancelled())
+				return false;
+			t_taskDepth++;
+			callback( data, xBegin, xEnd, yBegin, yEnd );
+			t_taskDepth--;
+			return true;
+		}
+		if (cancelToken->cancelled())
+			return false;
+		TaskGroup group( cancelToken );
+		TaskGroup *savedGroup = t_currentGroup;
+		t_currentGroup = &group;
+		t_taskDepth++;
+		callback( data, xBegin, xEnd, yBegin, yEnd );
+		t_taskDepth--;
+		t_currentGroup = savedGroup;
+		return group.cancelled() == false;
+	}
+
+	// split into several pieces per thread (but no smaller than the grain) so that uneven work is balanced
+	long long leafSize = (long long) xCount * yCount / (threadCount() * 8);
+	if (leafSize < (long long) xGrain * yGrain)
+		leafSize = (long long) xGrain * yGrain;
+	TaskGroup group( cancelToken );
+	group.add( new ParallelRangeTask( callback, data, xBegin, xEnd, yBegin, yEnd, xGrain, yGrain, leafSize ) );
+	return group.wait();
+}
+
+
+//-------------------------------------------
+// TEST / BENCHMARK
+//-------------------------------------------
+
+
+// check that parallel loops cover each item once (with properly aligned sub-ranges), and check nesting, task groups, and cancellation
+bool testParallel() {
+	int savedThreadCount = threadCount();
+	setThreadCount( 4 );
+
+	// 1D and 2D loops with various sizes and grains
+	const int width = 77, height = 53;
+	int counts[ width * height ];
+	for (int grain = 1; grain <= 64; grain *= 4) {
+		for (int i = 0; i < width * height; i++)
+			counts[ i ] = 0;
+		std::atomic<int> badRangeCount( 0 );
+		parallelFor( 3, width * height, grain, [&]( int begin, int end ) {
+			if ((begin - 3) % grain || (end - begin < grain && end != width * height))
+				badRangeCount++;
+			for (int i = begin; i < end; i++)
+				counts[ i ]++;
+		} );
+		for (int i = 0; i < width * height; i++) {
+			unitAssert( counts[ i ] == (i < 3 ? 0 : 1) );
+		}
+		for (int i = 0; i < width * height; i++)
+			counts[ i ] = 0;
+		parallelFor2D( 0, width, 0, height, grain, 8, [&]( int xBegin, int xEnd, int yBegin, int yEnd ) {
+			if (xBegin % grain || yBegin % 8)
+				badRangeCount++;
+			for (int y = yBegin; y < yEnd; y++)
+				for (int x = xBegin; x < xEnd; x++)
+					counts[ y * width + x ]++;
+		} );
+		for (int i = 0; i < width * height; i++) {
+			unitAssert( counts[ i ] == 1 );
+		}
+		unitAssert( badRangeCount == 0 );
+	}
+
+	// nested loops, run serially or in parallel
+	for (int nested = 0; nested < 2; nested++) {
+		setNestedParallel( nested ? true : false );
+		std::atomic<int> total( 0 );
+		parallelFor( 0, 16, 1, [&]( int begin, int end ) {
+			for (int i = begin; i < end; i++) {
+				parallelFor( 0, 1000, 10, [&]( int innerBegin, int innerEnd ) {
+					total += innerEnd - innerBegin;
+				} );
+			}
+		} );
+		unitAssert( total == 16 * 1000 );
+	}
+	setNestedParallel( false );
+
+	// a task group in which tasks add more tasks
+	std::atomic<int> taskCount( 0 );
+	{
+		TaskGroup group;
+		for (int i = 0; i < 100; i++) {
+			group.run( [&]() {
+				taskCount++;
+				for (int j = 0; j < 10; j++)
+					group.run( [&]() { taskCount++; } );
+			} );
+		}
+		unitAssert( group.wait() );
+		unitAssert( taskCount == 100 * 11 );
+	}
+
+	// cancellation: loops and groups with a cancelled token don't start work; nested loops and groups inherit the token
+	setCancelCommand( true );
+	int runCount = 0;
+	bool completed = parallelFor( 0, 1000, 1, [&]( int begin, int end ) { runCount++; }, &commandCancelToken() );
+	unitAssert( completed == false && runCount == 0 );
+	{
+		TaskGroup group( &commandCancelToken() );
+		group.run( [&]() { runCount++; } );
+		unitAssert( group.wait() == false && runCount == 0 );
+	}
+	completed = parallelFor( 0, 1000, 1, [&]( int begin, int end ) { runCount++; } ); // no token
+	unitAssert( completed && runCount > 0 );
+	setCancelCommand( false );
+	completed = parallelFor( 0, 1000, 1, [&]( int begin, int end ) {}, &commandCancelToken() );
+	unitAssert( completed );
+	CancelToken token;
+	std::atomic<int> innerCount( 0 ), stopCount( 0 );
+	completed = parallelFor( 0, 64, 1, [&]( int begin, int end ) {
+		token.cancel();
+		if (taskCancelled())
+			stopCount++;
+		bool innerCompleted = parallelFor( 0, 100, 1, [&]( int innerBegin, int innerEnd ) { innerCount++; } );
+		TaskGroup group;
+		group.run( [&]() { innerCount++; } );
+		if (innerCompleted == false && group.wait() == false)
+			stopCount++;
+	}, &token );
+	unitAssert( completed == false && innerCount == 0 && stopCount >= 2 );
+	unitAssert( taskCancelled() == false );
+
+	// progress counters: items counted on the worker threads are reported on this thread (and closed by the destructor)
+	{
+		ProgressCounter counter( 1000, 0 );
+		parallelFor( 0, 1000, 10, [&]( int begin, int end ) {
+			counter.add( end - begin );
+			counter.report(); // ignored on worker threads
+		} );
+		unitAssert( counter.count() == 1000 && counter.total() == 1000 );
+	}
+	setThreadCount( savedThreadCount );
+	return true;
+}
+
+
+// check that a fatal error in a loop body running on a worker thread exits the program with status 1
+// (rather than aborting while the exit handlers stop the worker threads); runs the loop in a child process
+bool testParallelFatalError() {
+#ifndef WIN32
+	int savedThreadCount = threadCount();
+	setThreadCount( 1 ); // stop the workers so that the child process doesn't inherit a scheduler without threads
+	fflush( stdout );
+	fflush( stderr );
+	pid_t pid = fork();
+	unitAssert( pid >= 0 );
+	if (pid == 0) {
+		freopen( "/dev/null", "w", stdout );
+		freopen( "/dev/null", "w", stderr );
+		setThreadCount( 4 );
+		std::atomic<bool> failed( false );
+
+		// one worker fails; the other threads wait a little in each item so that the workers take some of the items
+		parallelFor( 0, 64, 1, [&]( int begin, int end ) {
+			if (workerThread() && failed.exchange( true ) == false)
+				fatalError( "test fatal error in parallel loop" );
+			double startTime = getPerfTime();
+			while (getPerfTime() - startTime < 0.005)
+				std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		} );
+		_exit( 2 ); // no worker took an item
+	}
+
+	// wait for the child (up to 10 seconds)
+	int status = 0;
+	bool exited = false;
+	for (int i = 0; i < 1000 && exited == false; i++) {
+		if (waitpid( pid, &status, WNOHANG ) == pid)
+			exited = true;
+		else
+			std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+	}
+	if (exited == false) {
+		kill( pid, SIGKILL );
+		waitpid( pid, &status, 0 );
+	}
+	setThreadCount( savedThreadCount );
+	unitAssert( exited && WIFEXITED( status ) && WEXITSTATUS( status ) == 1 );
+#endif
+	return true;
+}
+
+
+// time the overhead of starting loops and tasks, and the scaling of a loop over image rows with the number of threads
+void benchmarkParallel( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 20 );
+	int maxThreads = conf.readInt( "maxThreads", 8 );
+	if (conf.initialPass())
+		return;
+	int savedThreadCount = threadCount();
+	disp( 1, "threads: %d", savedThreadCount );
+
+	// overhead of an empty loop (split into one piece per grain) and of empty tasks
+	int loopCount = 10000, itemCount = threadCount() * 8;
+	Timer loopTimer( true );
+	for (int i = 0; i < loopCount; i++)
+		parallelFor( 0, itemCount, 1, [&]( int begin, int end ) {} );
+	disp( 1, "empty loop (%d items): %8.3f us/loop", itemCount, loopTimer.timeSum() * 1.0e6 / loopCount );
+	int taskCount = 100000;
+	Timer taskTimer( true );
+	{
+		TaskGroup group;
+		for (int i = 0; i < taskCount; i++)
+			group.run( []() {} );
+		group.wait();
+	}
+	disp( 1, "empty task: %8.3f us/task", taskTimer.timeSum() * 1.0e6 / taskCount );
+
+	// cost of polling for cancellation and counting progress inside a loop body (the poll results go to a volatile sink
+	// so that the loops aren't optimized away)
+	int pollCount = 10000000, stopCount = 0;
+	volatile int sink = 0;
+	Timer pollTimer( true );
+	for (int i = 0; i < pollCount; i++)
+		stopCount += commandCancelled() ? 1 : 0;
+	sink = stopCount;
+	disp( 1, "commandCancelled: %8.3f ns/call", pollTimer.timeSum() * 1.0e9 / pollCount );
+	parallelFor( 0, itemCount, 1, [&]( int begin, int end ) {
+		if (begin == 0) {
+			Timer timer( true );
+			int count = 0;
+			for (int i = 0; i < pollCount; i++)
+				count += taskCancelled() ? 1 : 0;
+			sink = count;
+			disp( 1, "taskCancelled: %8.3f ns/call", timer.timeSum() * 1.0e9 / pollCount );
+		}
+	} );
+	{
+		ProgressCounter counter( pollCount );
+		Timer timer( true );
+		for (int i = 0; i < pollCount; i++)
+			counter.add();
+		disp( 1, "ProgressCounter::add: %8.3f ns/call", timer.timeSum() * 1.0e9 / pollCount );
+	}
+
+	// a 5-tap horizontal blur over the rows of an image, with 1, 2, 4, ... threads
+	float *input = new float[ width * height ];
+	float *output = new float[ width * height ];
+	for (int i = 0; i < width * height; i++)
+		input[ i ] = (float) (i % 255);
+	auto blurRows = [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const float *in = input + y * width;
+			float *out = output + y * width;
+			out[ 0 ] = out[ 1 ] = out[ width - 2 ] = out[ width - 1 ] = 0;
+			for (int x = 2; x < width - 2; x++)
+				out[ x ] = 0.1f * in[ x - 2 ] + 0.2f * in[ x - 1 ] + 0.4f * in[ x ] + 0.2f * in[ x + 1 ] + 0.1f * in[ x + 2 ];
+		}
+	};
+	double serialTime = 0;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		setThreadCount( threads );
+		parallelFor( 0, height, 8, blurRows ); // start the workers and touch the output before timing
+		Timer timer( true );
+		for (int iteration = 0; iteration < iterations; iteration++)
+			parallelFor( 0, height, 8, blurRows );
+		double time = timer.timeSum() / iterations;
+		if (threads == 1)
+			serialTime = time;
+		disp( 1, "row loop, %d thread%s: %8.3f ms/image, speed-up: %5.2f", threads, threads == 1 ? " " : "s", time * 1000.0, serialTime / time );
+	}
+	delete [] input;
+	delete [] output;
+	setThreadCount( savedThreadCount );
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initParallel() {
+
+	// use the thread count from the path config (if it has one) unless given by the environment
+	if (getenv( "SBL_THREAD_COUNT" ) == NULL && fileExists( "path.conf" ) && pathConfig().entryExists( "threadCount" ))
+		setThreadCount( pathConfig().readInt( "threadCount" ) );
+	registerUnitTest( testParallel );
+	registerUnitTest( testParallelFatalError );
+	registerCommand( "benchparallel", benchmarkParallel );
+	registerCleanUp( stopWorkerThreads );
+}
+
+
+} // end namespace sbl
@@ -0,0 +1,703 @@
+#include <sbl/image/BinaryMask.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <sbl/image/ImageUtil.h> // for test and benchmark
+#include <string.h> // for memcpy
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// WORD UTILS
+//-------------------------------------------
+
+
+// the number of rows handed to a worker thread at a time
+#define MASK_GRAIN_ROWS 16
+
+
+// the number of set bits in a word
+inline int bitCount( unsigned long long v ) {
+#ifdef __POPCNT__
+	return (int) __builtin_popcountll( v );
+#else
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (int) ((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+// the position of the lowest set bit of a non-zero word
+inline int lowestBit( unsigned long long v ) {
+#ifdef __GNUC__
+	return __builtin_ctzll( v );
+#else
+	int bit = 0;
+	while ((v & 1) == 0) {
+		v >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+
+// the position of the highest set bit of a non-zero word
+inline int highestBit( unsigned long long v ) {
+#ifdef __GNUC__
+	return 63 - __builtin_clzll( v );
+#else
+	int bit = 63;
+	while ((v >> 63) == 0) {
+		v <<= 1;
+		bit--;
+	}
+	return bit;
+#endif
+}
+
+
+// the bits of the last word of each row that hold pixels
+inline unsigned long long lastWordBits( int width ) {
+	return (width & 63) ? (1ULL << (width & 63)) - 1 : ~0ULL;
+}
+
+
+// OR a shifted copy of a row into another row: out[ x ] |= in[ x - shift ] (so a positive shift moves pixels to higher x);
+// pixels shifted in from outside the row are cleared
+void orShiftedRow( const unsigned long long *in, unsigned long long *out, int wordCount, int shift ) {
+	int wordShift = (shift >= 0 ? shift : -shift) >> 6, bitShift = (shift >= 0 ? shift : -shift) & 63;
+	if (shift >= 0) {
+		for (int w = wordShift; w < wordCount; w++) {
+			unsigned long long v = in[ w - wordShift ] << bitShift;
+			if (bitShift && w > wordShift)
+				v |= in[ w - wordShift - 1 ] >> (64 - bitShift);
+			out[ w ] |= v;
+		}
+	} else {
+		for (int w = 0; w + wordShift < wordCount; w++) {
+			unsigned long long v = in[ w + wordShift ] >> bitShift;
+			if (bitShift && w + wordShift + 1 < wordCount)
+				v |= in[ w + wordShift + 1 ] << (64 - bitShift);
+			out[ w ] |= v;
+		}
+	}
+}
+
+
+// set out[ x ] to the OR of the window of the given length that starts (if forward) or ends at x: in[ x ... x + length - 1 ]
+// or in[ x - length + 1 ... x ]; the window doubles with each shifted OR, so this takes about log2( length ) steps;
+// pixels outside the row are treated as cleared (which is exact, since each step only reads away from the window start);
+// temp must hold wordCount words
+void windowRow( const unsigned long long *in, unsigned long long *out, unsigned long long *temp, int wordCount, int length, bool forward ) {
+	memcpy( out, in, wordCount * sizeof( unsigned long long ) );
+	for (int covered = 1; covered < length; ) {
+		int step = covered * 2 <= length ? covered : length - covered;
+		memcpy( temp, out, wordCount * sizeof( unsigned long long ) );
+		orShiftedRow( temp, out, wordCount, forward ? -step : step );
+		covered += step;
+	}
+}
+
+
+// apply windowRow along the columns of a mask, with whole rows as the words; alternates between the given masks
+// and returns the one that holds the result
+BinaryMask *windowRows( BinaryMask *mask, BinaryMask *temp, int length, bool forward ) {
+	int height = mask->height(), wordCount = mask->wordsPerRow();
+	for (int covered = 1; covered < length; ) {
+		int step = covered * 2 <= length ? covered : length - covered;
+		int offset = forward ? step : -step;
+		parallelFor( 0, height, MASK_GRAIN_ROWS, [&]( int begin, int end ) {
+			for (int y = begin; y < end; y++) {
+				const unsigned long long *in = mask->row( y );
+				unsigned long long *out = temp->row( y );
+				if (y + offset >= 0 && y + offset < height) {
+					const unsigned long long *other = mask->row( y + offset );
+					for (int w = 0; w < wordCount; w++)
+						out[ w ] = in[ w ] | other[ w ];
+				} else {
+					memcpy( out, in, wordCount * sizeof( unsigned long long ) );
+				}
+			}
+		} );
+		BinaryMask *swap = mask;
+		mask = temp;
+		temp = swap;
+		covered += step;
+	}
+	return mask;
+}
+
+
+//-------------------------------------------
+// BINARY MASK CLASS
+//-------------------------------------------
+
+
+/// create a mask with all pixels cleared
+BinaryMask::BinaryMask( int width, int height ) : m_words( ((width + 63) >> 6) * height ) {
+	assertAlways( width >= 0 && height >= 0 );
+	m_width = width;
+	m_height = height;
+	m_wordsPerRow = (width + 63) >> 6;
+	m_words.clear( 0 );
+}
+
+
+/// set or clear every pixel
+void BinaryMask::clear( bool value ) {
+	if (value) {
+		m_words.clear( ~0ULL );
+		unsigned long long lastBits = lastWordBits( m_width );
+		for (int y = 0; y < m_height && m_wordsPerRow; y++)
+			row( y )[ m_wordsPerRow - 1 ] = lastBits;
+	} else {
+		m_words.clear( 0 );
+	}
+}
+
+
+/// the number of set pixels
+int BinaryMask::count() const {
+	const unsigned long long *words = m_words.dataPtr();
+	int wordCount = m_words.length(), count = 0;
+	for (int i = 0; i < wordCount; i++)
+		count += bitCount( words[ i ] );
+	return count;
+}
+
+
+/// the (inclusive) bounds of the set pixels; if no pixels are set, xMin = width, xMax = -1, yMin = height, and yMax = -1
+void BinaryMask::bounds( int &xMin, int &xMax, int &yMin, int &yMax ) const {
+	xMin = m_width;
+	xMax = -1;
+	yMin = m_height;
+	yMax = -1;
+
+	// find the first and last rows with set pixels
+	for (int y = 0; y < m_height && yMin == m_height; y++) {
+		const unsigned long long *r = row( y );
+		for (int w = 0; w < m_wordsPerRow; w++) {
+			if (r[ w ]) {
+				yMin = y;
+				break;
+			}
+		}
+	}
+	if (yMin == m_height)
+		return;
+	for (int y = m_height - 1; y >= yMin && yMax == -1; y--) {
+		const unsigned long long *r = row( y );
+		for (int w = 0; w < m_wordsPerRow; w++) {
+			if (r[ w ]) {
+				yMax = y;
+				break;
+			}
+		}
+	}
+
+	// OR the rows together, so the columns are given by the first and last set bits
+	// (stopping early if the first and last columns are both set)
+	Vector<unsigned long long> columns( m_wordsPerRow );
+	columns.clear( 0 );
+	unsigned long long lastBit = 1ULL << ((m_width - 1) & 63);
+	for (int y = yMin; y <= yMax; y++) {
+		const unsigned long long *r = row( y );
+		for (int w = 0; w < m_wordsPerRow; w++)
+			columns[ w ] |= r[ w ];
+		if ((columns[ 0 ] & 1) && (columns[ m_wordsPerRow - 1 ] & lastBit))
+			break;
+	}
+	for (int w = 0; w < m_wordsPerRow; w++) {
+		if (columns[ w ]) {
+			xMin = w * 64 + lowestBit( columns[ w ] );
+			break;
+		}
+	}
+	for (int w = m_wordsPerRow - 1; w >= 0; w--) {
+		if (columns[ w ]) {
+			xMax = w * 64 + highestBit( columns[ w ] );
+			break;
+		}
+	}
+}
+
+
+/// combine with another mask (of the same size)
+void BinaryMask::andWith( const BinaryMask &mask ) {
+	assertAlways( mask.m_width == m_width && mask.m_height == m_height );
+	unsigned long long *words = m_words.dataPtr();
+	const unsigned long long *other = mask.m_words.dataPtr();
+	for (int i = 0; i < m_words.length(); i++)
+		words[ i ] &= other[ i ];
+}
+
+
+/// combine with another mask (of the same size)
+void BinaryMask::orWith( const BinaryMask &mask ) {
+	assertAlways( mask.m_width == m_width && mask.m_height == m_height );
+	unsigned long long *words = m_words.dataPtr();
+	const unsigned long long *other = mask.m_words.dataPtr();
+	for (int i = 0; i < m_words.length(); i++)
+		words[ i ] |= other[ i ];
+}
+
+
+/// combine with another mask (of the same size)
+void BinaryMask::xorWith( const BinaryMask &mask ) {
+	assertAlways( mask.m_width == m_width && mask.m_height == m_height );
+	unsigned long long *words = m_words.dataPtr();
+	const unsigned long long *other = mask.m_words.dataPtr();
+	for (int i = 0; i < m_words.length(); i++)
+		words[ i ] ^= other[ i ];
+}
+
+
+/// set cleared pixels and clear set pixels
+void BinaryMask::invert() {
+	unsigned long long *words = m_words.dataPtr();
+	for (int i = 0; i < m_words.length(); i++)
+		words[ i ] = ~words[ i ];
+
+	// keep the bits after the last pixel cleared
+	unsigned long long lastBits = lastWordBits( m_width );
+	for (int y = 0; y < m_height && m_wordsPerRow; y++)
+		row( y )[ m_wordsPerRow - 1 ] &= lastBits;
+}
+
+
+/// true if the masks have the same size and pixels
+bool BinaryMask::operator==( const BinaryMask &mask ) const {
+	if (mask.m_width != m_width || mask.m_height != m_height)
+		return false;
+	return m_words.length() == 0 || memcmp( m_words.dataPtr(), mask.m_words.dataPtr(), m_words.length() * sizeof( unsigned long long ) ) == 0;
+}
+
+
+//-------------------------------------------
+// CONVERSION
+//-------------------------------------------
+
+
+/// create a mask that is set where the image values are at least thresh (by default, the non-zero pixels)
+aptr<BinaryMask> toBinaryMask( const ImageViewGrayU &input, int thresh ) {
+	int width = input.width(), height = input.height();
+	aptr<BinaryMask> mask( new BinaryMask( width, height ) );
+	if (thresh <= 0) {
+		mask->clear( true );
+		return mask;
+	}
+	if (thresh > 255)
+		return mask;
+	parallelFor( 0, height, MASK_GRAIN_ROWS, [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const unsigned char *in = input.row( y );
+			unsigned long long *out = mask->row( y );
+			int x = 0;
+#ifdef __SSE2__
+
+			// v >= thresh exactly when max( v, thresh ) == v; movemask packs the comparison of 16 pixels into 16 bits
+			__m128i t = _mm_set1_epi8( (char) thresh );
+			for (; x + 64 <= width; x += 64) {
+				unsigned long long word = 0;
+				for (int i = 0; i < 4; i++) {
+					__m128i v = _mm_loadu_si128( (const __m128i *) (in + x + i * 16) );
+					unsigned int bits = (unsigned int) _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_max_epu8( v, t ), v ) );
+					word |= (unsigned long long) bits << (i * 16);
+				}
+				out[ x >> 6 ] = word;
+			}
+#endif
+			for (; x < width; x += 64) {
+				int count = width - x < 64 ? width - x : 64;
+				unsigned long long word = 0;
+				for (int i = 0; i < count; i++) {
+					if (in[ x + i ] >= thresh)
+						word |= 1ULL << i;
+				}
+				out[ x >> 6 ] = word;
+			}
+		}
+	} );
+	return mask;
+}
+
+
+/// set each pixel of the output image (which must have the size of the mask) to 255 where the mask is set and 0 elsewhere
+void toImage( const BinaryMask &mask, ImageViewGrayU output ) {
+	int width = mask.width(), height = mask.height();
+	assertAlways( output.width() == width && output.height() == height );
+	parallelFor( 0, height, MASK_GRAIN_ROWS, [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const unsigned long long *in = mask.row( y );
+			unsigned char *out = output.row( y );
+			int x = 0;
+#ifdef __SSE2__
+
+			// spread 8 bits across each 8 bytes, then select one bit per byte
+			__m128i select = _mm_set_epi8( -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1 );
+			for (; x + 16 <= width; x += 16) {
+				unsigned int bits = (unsigned int) (in[ x >> 6 ] >> (x & 63));
+				__m128i spread = _mm_unpacklo_epi64( _mm_set1_epi8( (char) (bits & 0xff) ), _mm_set1_epi8( (char) ((bits >> 8) & 0xff) ) );
+				_mm_storeu_si128( (__m128i *) (out + x), _mm_cmpeq_epi8( _mm_and_si128( spread, select ), select ) );
+			}
+#endif
+			for (; x < width; x++)
+				out[ x ] = ((in[ x >> 6 ] >> (x & 63)) & 1) ? 255 : 0;
+		}
+	} );
+}
+
+
+/// set each pixel of the output image (which must have the size of the mask) to 255 where the mask is set and 0 elsewhere
+aptr<ImageGrayU> toImage( const BinaryMask &mask ) {
+	aptr<ImageGrayU> image( new ImageGrayU( mask.width(), mask.height() ) );
+	toImage( mask, imageView( *image ) );
+	return image;
+}
+
+
+//-------------------------------------------
+// MORPHOLOGY
+//-------------------------------------------
+
+
+/// dilate the mask with a (2 * xRadius + 1) by (2 * yRadius + 1) rectangle: a square if xRadius == yRadius,
+/// a horizontal line if yRadius == 0, or a vertical line if xRadius == 0; pixels outside the mask are treated as cleared
+aptr<BinaryMask> dilate( const BinaryMask &mask, int xRadius, int yRadius ) {
+	assertAlways( xRadius >= 0 && yRadius >= 0 );
+	int width = mask.width(), height = mask.height(), wordCount = mask.wordsPerRow();
+	unsigned long long lastBits = lastWordBits( width );
+
+	// dilate each row horizontally: the OR of the windows that start and end at each pixel
+	aptr<BinaryMask> result( new BinaryMask( width, height ) );
+	parallelFor( 0, height, MASK_GRAIN_ROWS, [&]( int begin, int end ) {
+		Vector<unsigned long long> temp( wordCount ), backward( wordCount );
+		for (int y = begin; y < end; y++) {
+			unsigned long long *out = result->row( y );
+			windowRow( mask.row( y ), out, temp.dataPtr(), wordCount, xRadius + 1, true );
+			windowRow( mask.row( y ), backward.dataPtr(), temp.dataPtr(), wordCount, xRadius + 1, false );
+			for (int w = 0; w < wordCount; w++)
+				out[ w ] |= backward[ w ];
+			if (wordCount)
+				out[ wordCount - 1 ] &= lastBits;
+		}
+	} );
+
+	// dilate vertically in the same way, using whole rows
+	if (yRadius == 0)
+		return result;
+	aptr<BinaryMask> backward( new BinaryMask( width, height ) ), temp( new BinaryMask( width, height ) ), backwardTemp( new BinaryMask( width, height ) );
+	backward->orWith( *result );
+	BinaryMask *forwardResult = windowRows( result.get(), temp.get(), yRadius + 1, true );
+	BinaryMask *backwardResult = windowRows( backward.get(), backwardTemp.get(), yRadius + 1, false );
+	backwardResult->orWith( *forwardResult );
+	if (backwardResult == backwardTemp.get())
+		return backwardTemp;
+	return backward;
+}
+
+
+/// erode the mask with a (2 * xRadius + 1) by (2 * yRadius + 1) rectangle (as with dilate);
+/// pixels outside the mask are treated as set, so the mask is not eroded from the image boundary
+aptr<BinaryMask> erode( const BinaryMask &mask, int xRadius, int yRadius ) {
+
+	// erosion is the complement of dilating the complement (with the outside cleared in the complement, so set in the mask)
+	BinaryMask inverted( mask.width(), mask.height() );
+	inverted.orWith( mask );
+	inverted.invert();
+	aptr<BinaryMask> result = dilate( inverted, xRadius, yRadius );
+	result->invert();
+	return result;
+}
+
+
+//-------------------------------------------
+// MASK UTILS
+//-------------------------------------------
+
+
+/// count the set pixels of the mask
+int maskCount( const BinaryMask &mask ) {
+	return mask.count();
+}
+
+
+/// compute the (inclusive) bounds of the set pixels (as with BinaryMask::bounds)
+void maskBounds( const BinaryMask &mask, int &xMin, int &xMax, int &yMin, int &yMax ) {
+	mask.bounds( xMin, xMax, yMin, yMax );
+}
+
+
+/// returns true if specified line intersects set mask pixels;
+/// (assumes points are inside image bounds)
+bool lineIntersects( const BinaryMask &mask, float x1, float y1, float x2, float y2 ) {
+	float xDiff = x2 - x1;
+	float yDiff = y2 - y1;
+	float len = sqrtf( xDiff * xDiff + yDiff * yDiff );
+	float xStep = xDiff / len;
+	float yStep = yDiff / len;
+	for (float step = 0; step < len; step++) {
+		int x = round( x1 + step * xStep );
+		int y = round( y1 + step * yStep );
+		if (mask.data( x, y ))
+			return true;
+	}
+	return false;
+}
+
+
+/// returns true if rectange intersects set mask pixels;
+/// (assumes points are inside image bounds)
+bool rectIntersects( const BinaryMask &mask, int x1, int y1, int x2, int y2 ) {
+	assertAlways( x2 >= x1 && y2 >= y1 );
+	int wordBegin = x1 >> 6, wordEnd = x2 >> 6;
+	unsigned long long firstBits = ~0ULL << (x1 & 63), lastBits = ~0ULL >> (63 - (x2 & 63));
+	for (int y = y1; y <= y2; y++) {
+		const unsigned long long *r = mask.row( y );
+		if (wordBegin == wordEnd) {
+			if (r[ wordBegin ] & firstBits & lastBits)
+				return true;
+		} else {
+			if ((r[ wordBegin ] & firstBits) || (r[ wordEnd ] & lastBits))
+				return true;
+			for (int w = wordBegin + 1; w < wordEnd; w++) {
+				if (r[ w ])
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+/// draw the boundary of the mask on the given output image
+void drawMaskBoundary( ImageColorU &output, const BinaryMask &mask, int r, int g, int b, int xBorder, int yBorder ) {
+	int width = output.width(), height = output.height(), wordCount = mask.wordsPerRow();
+	assertAlways( mask.width() == width && mask.height() == height );
+	if (width - 1 - xBorder <= xBorder)
+		return;
+
+	// as in the ImageGrayU version, (x, y) is on the boundary if it differs from (x + 1, y) or (x, y + 1),
+	// for x in [xBorder, width - 1 - xBorder) and y in [yBorder, height - 1 - yBorder)
+	int xEnd = width - 1 - xBorder;
+	for (int y = yBorder; y < height - 1 - yBorder; y++) {
+		const unsigned long long *current = mask.row( y ), *next = mask.row( y + 1 );
+		for (int w = xBorder >> 6; w <= (xEnd - 1) >> 6; w++) {
+			unsigned long long right = (current[ w ] >> 1) | (w + 1 < wordCount ? current[ w + 1 ] << 63 : 0);
+			unsigned long long boundary = (current[ w ] ^ right) | (current[ w ] ^ next[ w ]);
+
+			// limit to the columns within the borders
+			if (w == (xBorder >> 6))
+				boundary &= ~0ULL << (xBorder & 63);
+			if (w == ((xEnd - 1) >> 6))
+				boundary &= ~0ULL >> (63 - ((xEnd - 1) & 63));
+			while (boundary) {
+				int x = w * 64 + lowestBit( boundary );
+				boundary &= boundary - 1;
+				output.setRGB( x, y, r, g, b );
+				output.setRGB( x, y + 1, r, g, b );
+				output.setRGB( x + 1, y, r, g, b );
+				output.setRGB( x + 1, y + 1, r, g, b );
+			}
+		}
+	}
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// create a random mask image with blobs of various sizes (blurred noise, thresholded)
+aptr<ImageGrayU> binaryMaskTestImage( int width, int height, int threshold ) {
+	ImageGrayU noise( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			noise.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+	return blurBoxAndThreshold( noise, 5, threshold );
+}
+
+
+// a direct (per-pixel) version of dilate/erode, used for testing
+bool morphologyDirect( const ImageGrayU &image, int x, int y, int xRadius, int yRadius, bool dilation ) {
+	int width = image.width(), height = image.height();
+	for (int yWin = y - yRadius; yWin <= y + yRadius; yWin++) {
+		for (int xWin = x - xRadius; xWin <= x + xRadius; xWin++) {
+			if (xWin >= 0 && xWin < width && yWin >= 0 && yWin < height) {
+				bool set = image.data( xWin, yWin ) != 0;
+				if (set == dilation)
+					return dilation;
+			}
+		}
+	}
+	return !dilation;
+}
+
+
+// check binary mask conversions, counts, logic, morphology, and mask utils against per-pixel computations on ImageGrayU masks
+bool testBinaryMask() {
+	int savedThreadCount = threadCount();
+	setThreadCount( 4 );
+	for (int i = 0; i < 6; i++) {
+		int width = randomInt( 1, 200 ), height = randomInt( 1, 60 );
+		if (i == 0)
+			width = 128;
+		aptr<ImageGrayU> image = binaryMaskTestImage( width, height, randomInt( 110, 150 ) );
+		aptr<ImageGrayU> image2 = binaryMaskTestImage( width, height, 128 );
+		aptr<BinaryMask> mask = toBinaryMask( imageView( *image ) );
+		aptr<BinaryMask> mask2 = toBinaryMask( imageView( *image2 ) );
+
+		// conversion
+		aptr<ImageGrayU> restored = toImage( *mask );
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				unitAssert( mask->data( x, y ) == (image->data( x, y ) != 0) && restored->data( x, y ) == image->data( x, y ) );
+			}
+		}
+		aptr<BinaryMask> threshMask = toBinaryMask( imageView( *image2 ), 256 );
+		unitAssert( threshMask->count() == 0 );
+		threshMask = toBinaryMask( imageView( *image2 ), 0 );
+		unitAssert( threshMask->count() == width * height );
+
+		// counts and bounds
+		unitAssert( maskCount( *mask ) == maskCount( imageView( *image ) ) );
+		int xMin = 0, xMax = 0, yMin = 0, yMax = 0, xMinImage = 0, xMaxImage = 0, yMinImage = 0, yMaxImage = 0;
+		maskBounds( *mask, xMin, xMax, yMin, yMax );
+		maskBounds( imageView( *image ), xMinImage, xMaxImage, yMinImage, yMaxImage );
+		unitAssert( xMin == xMinImage && xMax == xMaxImage && yMin == yMinImage && yMax == yMaxImage );
+		BinaryMask empty( width, height );
+		maskBounds( empty, xMin, xMax, yMin, yMax );
+		unitAssert( maskCount( empty ) == 0 && xMin == width && xMax == -1 && yMin == height && yMax == -1 );
+
+		// logic
+		BinaryMask andMask( width, height ), orMask( width, height ), xorMask( width, height ), notMask( width, height );
+		andMask.orWith( *mask );
+		andMask.andWith( *mask2 );
+		orMask.orWith( *mask );
+		orMask.orWith( *mask2 );
+		xorMask.orWith( *mask );
+		xorMask.xorWith( *mask2 );
+		notMask.orWith( *mask );
+		notMask.invert();
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				bool v1 = mask->data( x, y ), v2 = mask2->data( x, y );
+				unitAssert( andMask.data( x, y ) == (v1 && v2) && orMask.data( x, y ) == (v1 || v2) && xorMask.data( x, y ) == (v1 != v2) && notMask.data( x, y ) == !v1 );
+			}
+		}
+		unitAssert( notMask.count() == width * height - mask->count() );
+		notMask.invert();
+		unitAssert( notMask == *mask && notMask != *mask2 );
+
+		// morphology (including radii that span several words)
+		int radii[][ 2 ] = { { 0, 0 }, { 1, 1 }, { 3, 2 }, { 0, 5 }, { 7, 0 }, { 70, 1 }, { 2, 20 } };
+		for (int j = 0; j < 7; j++) {
+			int xRadius = radii[ j ][ 0 ], yRadius = radii[ j ][ 1 ];
+			aptr<BinaryMask> dilated = dilate( *mask, xRadius, yRadius );
+			aptr<BinaryMask> eroded = erode( *mask, xRadius, yRadius );
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					unitAssert( dilated->data( x, y ) == morphologyDirect( *image, x, y, xRadius, yRadius, true ) );
+					unitAssert( eroded->data( x, y ) == morphologyDirect( *image, x, y, xRadius, yRadius, false ) );
+				}
+			}
+			unitAssert( dilated->count() == maskCount( imageView( *toImage( *dilated ) ) ) );
+		}
+
+		// rectangles and lines
+		for (int j = 0; j < 50; j++) {
+			int x1 = randomInt( 0, width - 1 ), x2 = randomInt( x1, width - 1 ), y1 = randomInt( 0, height - 1 ), y2 = randomInt( y1, height - 1 );
+			unitAssert( rectIntersects( *mask, x1, y1, x2, y2 ) == rectIntersects( *image, x1, y1, x2, y2 ) );
+			if (x1 != x2 || y1 != y2) {
+				unitAssert( lineIntersects( *mask, (float) x1, (float) y1, (float) x2, (float) y2 ) == lineIntersects( *image, (float) x1, (float) y1, (float) x2, (float) y2 ) );
+			}
+		}
+
+		// boundary drawing
+		int xBorder = randomInt( 0, 3 ), yBorder = randomInt( 0, 3 );
+		ImageColorU drawn( width, height ), drawnImage( width, height );
+		drawn.clear( 0, 0, 0 );
+		drawnImage.clear( 0, 0, 0 );
+		drawMaskBoundary( drawn, *mask, 255, 0, 0, xBorder, yBorder );
+		drawMaskBoundary( drawnImage, *image, 128, 255, 0, 0, xBorder, yBorder );
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				unitAssert( drawn.r( x, y ) == drawnImage.r( x, y ) );
+			}
+		}
+	}
+	setThreadCount( savedThreadCount );
+	return true;
+}
+
+
+// time binary mask operations (and the corresponding ImageGrayU operations, where available)
+void benchmarkBinaryMask( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 20 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "mask: %d x %d, threads: %d", width, height, threadCount() );
+
+	// create a noisy mask
+	aptr<ImageGrayU> image = binaryMaskTestImage( width, height, 128 );
+	aptr<BinaryMask> mask = toBinaryMask( imageView( *image ) );
+	aptr<BinaryMask> mask2 = toBinaryMask( imageView( *binaryMaskTestImage( width, height, 128 ) ) );
+	disp( 1, "memory: %d bytes as ImageGrayU, %d bytes as BinaryMask", image->memUsed(), mask->memUsed() );
+
+	// time each operation
+	const char *names[] = { "toBinaryMask", "toImage", "maskCount (ImageGrayU)", "maskCount", "maskBounds (ImageGrayU)", "maskBounds",
+							"andWith", "dilate (3x3)", "dilate (11x11)", "erode (11x11)", "dilate (31x1 line)", "dilate (1x31 line)" };
+	int xMin = 0, xMax = 0, yMin = 0, yMax = 0, count = 0;
+	for (int i = 0; i < 12; i++) {
+		Timer timer( true );
+		for (int j = 0; j < iterations; j++) {
+			switch (i) {
+			case 0: mask = toBinaryMask( imageView( *image ) ); break;
+			case 1: toImage( *mask, imageView( *image ) ); break;
+			case 2: count = maskCount( imageView( *image ) ); break;
+			case 3: count = maskCount( *mask ); break;
+			case 4: maskBounds( imageView( *image ), xMin, xMax, yMin, yMax ); break;
+			case 5: maskBounds( *mask, xMin, xMax, yMin, yMax ); break;
+			case 6: mask->andWith( *mask2 ); break;
+			case 7: dilate( *mask, 1, 1 ); break;
+			case 8: dilate( *mask, 5, 5 ); break;
+			case 9: erode( *mask, 5, 5 ); break;
+			case 10: dilate( *mask, 15, 0 ); break;
+			case 11: dilate( *mask, 0, 15 ); break;
+			}
+		}
+		timer.stop();
+		disp( 1, "%-28s %8.3f ms", names[ i ], timer.timeSum() * 1000.0 / iterations );
+	}
+	disp( 2, "count: %d, bounds: %d, %d, %d, %d", count, xMin, xMax, yMin, yMax );
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initBinaryMask() {
+	registerUnitTest( testBinaryMask );
+	registerCommand( "benchbinarymask", benchmarkBinaryMask );
+}
+
+
+} // end namespace sbl
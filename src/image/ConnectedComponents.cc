@@ -0,0 +1,792 @@
+#include <sbl/image/ConnectedComponents.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <sbl/image/ImageUtil.h> // for test and benchmark
+namespace sbl {
+
+
+//-------------------------------------------
+// COMPONENT STATS CLASS
+//-------------------------------------------
+
+
+/// clear the stats
+void ComponentStats::reset() {
+	area = 0;
+	xMin = 1 << 30;
+	xMax = -(1 << 30);
+	yMin = 1 << 30;
+	yMax = -(1 << 30);
+	xSum = 0;
+	ySum = 0;
+}
+
+
+/// add stats from another part of the same component
+void ComponentStats::merge( const ComponentStats &stats ) {
+	area += stats.area;
+	if (stats.xMin < xMin) xMin = stats.xMin;
+	if (stats.xMax > xMax) xMax = stats.xMax;
+	if (stats.yMin < yMin) yMin = stats.yMin;
+	if (stats.yMax > yMax) yMax = stats.yMax;
+	xSum += stats.xSum;
+	ySum += stats.ySum;
+}
+
+
+/// clear the stats
+void ComponentStats3D::reset() {
+	voxelCount = 0;
+	xMin = 1 << 30;
+	xMax = -(1 << 30);
+	yMin = 1 << 30;
+	yMax = -(1 << 30);
+	zMin = 1 << 30;
+	zMax = -(1 << 30);
+	xSum = 0;
+	ySum = 0;
+	zSum = 0;
+}
+
+
+/// add stats from another part of the same component
+void ComponentStats3D::merge( const ComponentStats3D &stats ) {
+	voxelCount += stats.voxelCount;
+	if (stats.xMin < xMin) xMin = stats.xMin;
+	if (stats.xMax > xMax) xMax = stats.xMax;
+	if (stats.yMin < yMin) yMin = stats.yMin;
+	if (stats.yMax > yMax) yMax = stats.yMax;
+	if (stats.zMin < zMin) zMin = stats.zMin;
+	if (stats.zMax > zMax) zMax = stats.zMax;
+	xSum += stats.xSum;
+	ySum += stats.ySum;
+	zSum += stats.zSum;
+}
+
+
+//-------------------------------------------
+// LABEL FOREST
+//-------------------------------------------
+
+
+/// The LabelForest class is a union-find structure over provisional labels.  A label's parent always has a smaller index,
+/// so the root of each set is its first-created label.  Disjoint ranges of labels can be created and joined on different threads.
+class LabelForest {
+public:
+
+	// allocate labels 1 to labelCount (label 0 is the background)
+	explicit LabelForest( int labelCount ) : m_parent( labelCount + 1 ) { m_parent[ 0 ] = 0; }
+
+	// start a new set containing only the given label
+	inline void create( int label ) { m_parent[ label ] = label; }
+
+	// add a label (after the current last label) in a new set; returns the new label
+	inline int append() { m_parent.append( m_parent.length() ); return m_parent.length() - 1; }
+
+	// the number of labels (not including the background)
+	inline int labelCount() const { return m_parent.length() - 1; }
+
+	// find the root of a label's set (halving the path to it)
+	inline int find( int label ) {
+		int *parent = m_parent.dataPtr();
+		while (parent[ label ] != label) {
+			parent[ label ] = parent[ parent[ label ] ];
+			label = parent[ label ];
+		}
+		return label;
+	}
+
+	// merge the sets containing two labels; returns the root of the merged set
+	inline int join( int label1, int label2 ) {
+		int root1 = find( label1 ), root2 = find( label2 );
+		if (root1 < root2) {
+			m_parent[ root2 ] = root1;
+			return root1;
+		}
+		m_parent[ root1 ] = root2;
+		return root2;
+	}
+
+	// replace the labels in [begin, end) with consecutive final labels (in index order), continuing from finalCount;
+	// must be called for increasing, non-overlapping ranges; afterwards, finalLabel() gives the result
+	int flatten( int begin, int end, int finalCount ) {
+		int *parent = m_parent.dataPtr();
+		for (int label = begin; label < end; label++) {
+
+			// the parent (with a smaller index) has already been replaced by its final label
+			if (parent[ label ] == label)
+				parent[ label ] = ++finalCount;
+			else
+				parent[ label ] = parent[ parent[ label ] ];
+		}
+		return finalCount;
+	}
+
+	// the final label of a provisional label (after flatten)
+	inline int finalLabel( int label ) const { return m_parent[ label ]; }
+
+private:
+
+	// the parent of each label
+	VectorI m_parent;
+};
+
+
+//-------------------------------------------
+// COMPONENT LABELING
+//-------------------------------------------
+
+
+// label the pixels of rows [yBegin, yEnd) with provisional labels (joining labels that touch within these rows);
+// new labels start at firstLabel; returns the number of labels created
+int labelStrip( const ImageViewGrayU &input, int minValue, int maxValue, bool eightConnected, ImageGrayI &labels,
+				LabelForest &forest, int yBegin, int yEnd, int firstLabel ) {
+	int width = input.width();
+	int nextLabel = firstLabel;
+	for (int y = yBegin; y < yEnd; y++) {
+		const unsigned char *in = input.row( y );
+		int *out = labels.row( y );
+		const int *above = y > yBegin ? labels.row( y - 1 ) : NULL;
+		for (int x = 0; x < width; x++) {
+			if (in[ x ] < minValue || in[ x ] > maxValue) {
+				out[ x ] = 0;
+				continue;
+			}
+
+			// join the neighbors that have already been visited (within this strip); a neighbor that is adjacent to the left pixel's
+			// own visited neighbors has already been joined with it, so most pixels need at most one join
+			int label = x ? out[ x - 1 ] : 0;
+			if (above) {
+				int up = above[ x ];
+				int upLeft = x ? above[ x - 1 ] : 0;
+				if (eightConnected) {
+					if (up) {
+						if (label == 0)
+							label = up;
+					} else {
+						int upRight = x + 1 < width ? above[ x + 1 ] : 0;
+						if (label == 0 && upLeft)
+							label = upLeft;
+						if (upRight)
+							label = label ? forest.join( label, upRight ) : upRight;
+					}
+				} else if (up) {
+					if (label == 0)
+						label = up;
+					else if (upLeft == 0)
+						label = forest.join( label, up );
+				}
+			}
+
+			// start a new component
+			if (label == 0) {
+				label = nextLabel++;
+				forest.create( label );
+			}
+			out[ x ] = label;
+		}
+	}
+	return nextLabel - firstLabel;
+}
+
+
+/// label the connected components of pixels with values in [minValue, maxValue] (using 4 or 8 connectivity)
+int labelComponents( const ImageViewGrayU &input, int minValue, int maxValue, bool eightConnected, ImageGrayI &labels, Vector<ComponentStats> *stats ) {
+	int width = input.width(), height = input.height();
+	assertAlways( labels.width() == width && labels.height() == height );
+
+	// split the rows into strips; a row can start at most (width + 1) / 2 components, which bounds the labels used by each strip
+	int stripCount = bound( threadCount(), 1, max( height / 16, 1 ) );
+	VectorI stripBegin( stripCount + 1 ), stripLabelCount( stripCount );
+	for (int i = 0; i <= stripCount; i++)
+		stripBegin[ i ] = (int) ((long long) height * i / stripCount);
+	int rowLabels = (width + 1) / 2;
+	LabelForest forest( height * rowLabels );
+
+	// label each strip
+	parallelFor( 0, stripCount, 1, [&]( int begin, int end ) {
+		for (int i = begin; i < end; i++)
+			stripLabelCount[ i ] = labelStrip( input, minValue, maxValue, eightConnected, labels, forest, stripBegin[ i ], stripBegin[ i + 1 ], 1 + stripBegin[ i ] * rowLabels );
+	} );
+
+	// join components that touch across strip boundaries
+	for (int i = 1; i < stripCount; i++) {
+		int y = stripBegin[ i ];
+		const int *row = labels.row( y ), *above = labels.row( y - 1 );
+		for (int x = 0; x < width; x++) {
+			if (row[ x ]) {
+				if (above[ x ])
+					forest.join( row[ x ], above[ x ] );
+				if (eightConnected) {
+					if (x && above[ x - 1 ])
+						forest.join( row[ x ], above[ x - 1 ] );
+					if (x + 1 < width && above[ x + 1 ])
+						forest.join( row[ x ], above[ x + 1 ] );
+				}
+			}
+		}
+	}
+
+	// assign final labels (in order of first pixel, since each set's root is its first label)
+	int componentCount = 0;
+	for (int i = 0; i < stripCount; i++) {
+		int firstLabel = 1 + stripBegin[ i ] * rowLabels;
+		componentCount = forest.flatten( firstLabel, firstLabel + stripLabelCount[ i ], componentCount );
+	}
+
+	// compute the stats of each strip's provisional labels (which lie in the strip's own label range, so each strip's
+	// stats are only as large as its number of labels) and relabel the pixels
+	Array<Vector<ComponentStats> > stripStats;
+	if (stats) {
+		for (int i = 0; i < stripCount; i++)
+			stripStats.append( new Vector<ComponentStats>( stripLabelCount[ i ] ) );
+	}
+	parallelFor( 0, stripCount, 1, [&]( int begin, int end ) {
+		for (int i = begin; i < end; i++) {
+			int firstLabel = 1 + stripBegin[ i ] * rowLabels;
+			ComponentStats *componentStats = stats ? stripStats[ i ].dataPtr() : NULL;
+			for (int y = stripBegin[ i ]; y < stripBegin[ i + 1 ]; y++) {
+				int *row = labels.row( y );
+				for (int x = 0; x < width; x++) {
+					if (row[ x ]) {
+						if (componentStats)
+							componentStats[ row[ x ] - firstLabel ].add( x, y );
+						row[ x ] = forest.finalLabel( row[ x ] );
+					}
+				}
+			}
+		}
+	} );
+
+	// combine the stats of the provisional labels of each component
+	if (stats) {
+		stats->setLength( componentCount );
+		for (int j = 0; j < componentCount; j++)
+			(*stats)[ j ].reset();
+		for (int i = 0; i < stripCount; i++) {
+			int firstLabel = 1 + stripBegin[ i ] * rowLabels;
+			for (int j = 0; j < stripLabelCount[ i ]; j++)
+				(*stats)[ forest.finalLabel( firstLabel + j ) - 1 ].merge( stripStats[ i ][ j ] );
+		}
+	}
+	return componentCount;
+}
+
+
+// label the voxels of frames [zBegin, zEnd) with slab-local labels (numbered from 1 in raster order within the slab)
+// and compute the stats of each local label; returns the number of local labels
+int labelSlab( const ImageGrayUSeq &seq, int minValue, int maxValue, bool fullyConnected, ImageGrayISeq &labels,
+			   int zBegin, int zEnd, Vector<ComponentStats3D> &slabStats ) {
+	int width = seq[ 0 ].width(), height = seq[ 0 ].height();
+
+	// assign provisional labels; the forest only lives as long as the slab is being labeled
+	LabelForest forest( 0 );
+	const int *neighbors[ 4 ] = { NULL, NULL, NULL, NULL };
+	for (int z = zBegin; z < zEnd; z++) {
+		for (int y = 0; y < height; y++) {
+			const unsigned char *in = seq[ z ].row( y );
+			int *out = labels[ z ].row( y );
+
+			// the visited rows that neighbor this row: the row above and (if the previous frame is in this slab) the previous frame's rows
+			int neighborCount = 0;
+			if (y)
+				neighbors[ neighborCount++ ] = labels[ z ].row( y - 1 );
+			if (z > zBegin) {
+				for (int dy = fullyConnected ? -1 : 0; dy <= (fullyConnected ? 1 : 0); dy++)
+					if (y + dy >= 0 && y + dy < height)
+						neighbors[ neighborCount++ ] = labels[ z - 1 ].row( y + dy );
+			}
+			for (int x = 0; x < width; x++) {
+				if (in[ x ] < minValue || in[ x ] > maxValue) {
+					out[ x ] = 0;
+					continue;
+				}
+
+				// join the visited neighbors; if the left voxel is set, it has already been joined with the neighbors it shares
+				// with this voxel (and, for 6 connectivity, with neighbors adjacent to its own), so those can be skipped
+				int left = x ? out[ x - 1 ] : 0, label = left;
+				for (int i = 0; i < neighborCount; i++) {
+					const int *row = neighbors[ i ];
+					if (fullyConnected) {
+						for (int nx = left ? x + 1 : max( x - 1, 0 ); nx <= min( x + 1, width - 1 ); nx++) {
+							int n = row[ nx ];
+							if (n && n != label)
+								label = label ? forest.join( label, n ) : n;
+						}
+					} else {
+						int n = row[ x ];
+						if (n && n != label && (left == 0 || row[ x - 1 ] == 0))
+							label = label ? forest.join( label, n ) : n;
+					}
+				}
+
+				// start a new component
+				if (label == 0)
+					label = forest.append();
+				out[ x ] = label;
+			}
+		}
+	}
+
+	// replace the provisional labels with local labels and compute stats
+	int labelCount = forest.flatten( 1, forest.labelCount() + 1, 0 );
+	slabStats.setLength( labelCount );
+	for (int z = zBegin; z < zEnd; z++) {
+		for (int y = 0; y < height; y++) {
+			int *row = labels[ z ].row( y );
+			for (int x = 0; x < width; x++) {
+				if (row[ x ]) {
+					int label = forest.finalLabel( row[ x ] );
+					row[ x ] = label;
+					slabStats[ label - 1 ].add( x, y, z );
+				}
+			}
+		}
+	}
+	return labelCount;
+}
+
+
+/// label the connected components of voxels with values in [minValue, maxValue] in an image sequence (using 6 or 26 connectivity)
+int labelComponentsXYZ( const ImageGrayUSeq &seq, int minValue, int maxValue, bool fullyConnected, ImageGrayISeq &labels, Vector<ComponentStats3D> *stats ) {
+	int length = seq.count();
+	if (length == 0) {
+		if (stats)
+			stats->setLength( 0 );
+		return 0;
+	}
+	int width = seq[ 0 ].width(), height = seq[ 0 ].height();
+	if (labels.count() == 0)
+		initImageSeq( labels, width, height, length, false, 0 );
+	assertAlways( labels.count() == length && labels[ 0 ].width() == width && labels[ 0 ].height() == height );
+
+	// split the frames into slabs that are labeled independently; using short slabs (rather than one per thread)
+	// bounds the memory used for provisional labels, since each slab's labels are reduced to its components before the next slab starts
+	int slabLength = bound( (length + threadCount() - 1) / threadCount(), 1, 16 );
+	int slabCount = (length + slabLength - 1) / slabLength;
+	Array<Vector<ComponentStats3D> > slabStats;
+	for (int i = 0; i < slabCount; i++)
+		slabStats.append( new Vector<ComponentStats3D>() );
+	VectorI slabLabelCount( slabCount );
+	parallelFor( 0, slabCount, 1, [&]( int begin, int end ) {
+		for (int i = begin; i < end; i++)
+			slabLabelCount[ i ] = labelSlab( seq, minValue, maxValue, fullyConnected, labels, i * slabLength, min( (i + 1) * slabLength, length ), slabStats[ i ] );
+	} );
+
+	// each slab's local labels map to a range of global labels
+	VectorI slabOffset( slabCount );
+	int slabLabelTotal = 0;
+	for (int i = 0; i < slabCount; i++) {
+		slabOffset[ i ] = slabLabelTotal;
+		slabLabelTotal += slabLabelCount[ i ];
+	}
+	LabelForest forest( slabLabelTotal );
+	for (int label = 1; label <= slabLabelTotal; label++)
+		forest.create( label );
+
+	// join components that touch across slab boundaries (the first frame of each slab and the last frame of the previous slab)
+	for (int i = 1; i < slabCount; i++) {
+		int z = i * slabLength;
+		int offset = slabOffset[ i ], prevOffset = slabOffset[ i - 1 ];
+		for (int y = 0; y < height; y++) {
+			const int *row = labels[ z ].row( y );
+			for (int dy = fullyConnected ? -1 : 0; dy <= (fullyConnected ? 1 : 0); dy++) {
+				if (y + dy < 0 || y + dy >= height)
+					continue;
+				const int *prevRow = labels[ z - 1 ].row( y + dy );
+				for (int x = 0; x < width; x++) {
+					if (row[ x ] == 0)
+						continue;
+					if (fullyConnected) {
+						for (int nx = max( x - 1, 0 ); nx <= min( x + 1, width - 1 ); nx++)
+							if (prevRow[ nx ])
+								forest.join( offset + row[ x ], prevOffset + prevRow[ nx ] );
+					} else if (prevRow[ x ]) {
+						forest.join( offset + row[ x ], prevOffset + prevRow[ x ] );
+					}
+				}
+			}
+		}
+	}
+
+	// assign final labels (in order of first voxel) and relabel the voxels
+	int componentCount = forest.flatten( 1, slabLabelTotal + 1, 0 );
+	if (slabCount > 1) {
+		parallelFor( 0, length, 1, [&]( int begin, int end ) {
+			for (int z = begin; z < end; z++) {
+				int offset = slabOffset[ z / slabLength ];
+				for (int y = 0; y < height; y++) {
+					int *row = labels[ z ].row( y );
+					for (int x = 0; x < width; x++)
+						if (row[ x ])
+							row[ x ] = forest.finalLabel( offset + row[ x ] );
+				}
+			}
+		} );
+	}
+
+	// combine the stats of the slabs
+	if (stats) {
+		stats->setLength( componentCount );
+		for (int i = 0; i < componentCount; i++)
+			(*stats)[ i ].reset();
+		for (int i = 0; i < slabCount; i++)
+			for (int j = 0; j < slabLabelCount[ i ]; j++)
+				(*stats)[ forest.finalLabel( slabOffset[ i ] + j + 1 ) - 1 ].merge( slabStats[ i ][ j ] );
+	}
+	return componentCount;
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// a direct (breadth-first fill) version of labelComponents, used for testing
+int labelComponentsDirect( const ImageGrayU &input, int minValue, int maxValue, bool eightConnected, ImageGrayI &labels ) {
+	int width = input.width(), height = input.height();
+	labels.clear( 0 );
+	VectorI queue( width * height );
+	int componentCount = 0;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int v = input.data( x, y );
+			if (v < minValue || v > maxValue || labels.data( x, y ))
+				continue;
+			componentCount++;
+			labels.data( x, y ) = componentCount;
+			queue[ 0 ] = y * width + x;
+			int queueBegin = 0, queueEnd = 1;
+			while (queueBegin < queueEnd) {
+				int index = queue[ queueBegin++ ];
+				int cx = index % width, cy = index / width;
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						int nx = cx + dx, ny = cy + dy;
+						if ((dx || dy) && (eightConnected || dx == 0 || dy == 0) && nx >= 0 && nx < width && ny >= 0 && ny < height) {
+							int nv = input.data( nx, ny );
+							if (nv >= minValue && nv <= maxValue && labels.data( nx, ny ) == 0) {
+								labels.data( nx, ny ) = componentCount;
+								queue[ queueEnd++ ] = ny * width + nx;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	return componentCount;
+}
+
+
+// the previous (flood fill) implementation of filterMaskComponents, used for testing and benchmarking
+void filterMaskComponentsDirect( ImageGrayU &mask, int minSize, int maxSize ) {
+	int width = mask.width(), height = mask.height();
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			if (mask.data( x, y ) == 255) {
+				int count = floodFill( mask, 255, 255, 200, x, y );
+				if (count < minSize || count > maxSize)
+					floodFill( mask, 200, 200, 0, x, y );
+			}
+		}
+	}
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			if (mask.data( x, y ) == 200)
+				mask.data( x, y ) = 255;
+}
+
+
+// the previous (flood fill) implementation of fillMaskHoles, used for testing and benchmarking
+void fillMaskHolesDirect( ImageGrayU &mask, int maxSize ) {
+	int width = mask.width(), height = mask.height();
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			if (mask.data( x, y ) == 0) {
+				int count = floodFill( mask, 0, 0, 100, x, y );
+				if (count < maxSize)
+					floodFill( mask, 100, 100, 255, x, y );
+			}
+		}
+	}
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			if (mask.data( x, y ) == 100)
+				mask.data( x, y ) = 0;
+}
+
+
+// create a random 0/255 mask with blobs of various sizes (a blurred noise image thresholded at the given level)
+aptr<ImageGrayU> componentTestMask( int width, int height, int threshold ) {
+	ImageGrayU noise( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			noise.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+	return blurBoxAndThreshold( noise, 3, threshold );
+}
+
+
+// check labels and stats against a direct fill-based implementation
+bool testConnectedComponents() {
+	int savedThreadCount = threadCount();
+	setThreadCount( 4 );
+	for (int i = 0; i < 12; i++) {
+		int width = randomInt( 1, 90 ), height = randomInt( 1, 130 );
+		bool eightConnected = (i & 1) == 1;
+		aptr<ImageGrayU> mask = componentTestMask( width, height, randomInt( 110, 145 ) );
+		ImageGrayI labels( width, height ), directLabels( width, height );
+		Vector<ComponentStats> stats;
+		int count = labelComponents( imageView( *mask ), 255, 255, eightConnected, labels, &stats );
+		int directCount = labelComponentsDirect( *mask, 255, 255, eightConnected, directLabels );
+		unitAssert( count == directCount && stats.length() == count );
+
+		// both number components in raster order, so the labels should match exactly
+		Vector<ComponentStats> directStats( count );
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				unitAssert( labels.data( x, y ) == directLabels.data( x, y ) );
+				if (directLabels.data( x, y ))
+					directStats[ directLabels.data( x, y ) - 1 ].add( x, y );
+			}
+		}
+		for (int j = 0; j < count; j++) {
+			const ComponentStats &s = stats[ j ], &d = directStats[ j ];
+			unitAssert( s.area == d.area && s.xMin == d.xMin && s.xMax == d.xMax && s.yMin == d.yMin && s.yMax == d.yMax );
+			unitAssert( fabs( s.xCentroid() - d.xCentroid() ) < 1e-4 && fabs( s.yCentroid() - d.yCentroid() ) < 1e-4 );
+		}
+
+		// the mask filters should match the previous implementations
+		ImageGrayU filtered( *mask ), directFiltered( *mask );
+		filterMaskComponents( filtered, 3, 40 );
+		filterMaskComponentsDirect( directFiltered, 3, 40 );
+		fillMaskHoles( filtered, 10 );
+		fillMaskHolesDirect( directFiltered, 10 );
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				unitAssert( filtered.data( x, y ) == directFiltered.data( x, y ) );
+			}
+		}
+	}
+	setThreadCount( savedThreadCount );
+	return true;
+}
+
+
+// a direct (breadth-first fill) version of labelComponentsXYZ, used for testing
+int labelComponentsDirectXYZ( const ImageGrayUSeq &seq, int minValue, int maxValue, bool fullyConnected, ImageGrayISeq &labels ) {
+	int width = seq[ 0 ].width(), height = seq[ 0 ].height(), length = seq.count();
+	for (int z = 0; z < length; z++)
+		labels[ z ].clear( 0 );
+	VectorI queue( width * height * length );
+	int componentCount = 0;
+	for (int z = 0; z < length; z++) {
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				int v = seq[ z ].data( x, y );
+				if (v < minValue || v > maxValue || labels[ z ].data( x, y ))
+					continue;
+				componentCount++;
+				labels[ z ].data( x, y ) = componentCount;
+				queue[ 0 ] = (z * height + y) * width + x;
+				int queueBegin = 0, queueEnd = 1;
+				while (queueBegin < queueEnd) {
+					int index = queue[ queueBegin++ ];
+					int cx = index % width, cy = (index / width) % height, cz = index / (width * height);
+					for (int dz = -1; dz <= 1; dz++) {
+						for (int dy = -1; dy <= 1; dy++) {
+							for (int dx = -1; dx <= 1; dx++) {
+								int nx = cx + dx, ny = cy + dy, nz = cz + dz;
+								int offsetCount = abs( dx ) + abs( dy ) + abs( dz );
+								if (offsetCount && (fullyConnected || offsetCount == 1) && nx >= 0 && nx < width && ny >= 0 && ny < height && nz >= 0 && nz < length) {
+									int nv = seq[ nz ].data( nx, ny );
+									if (nv >= minValue && nv <= maxValue && labels[ nz ].data( nx, ny ) == 0) {
+										labels[ nz ].data( nx, ny ) = componentCount;
+										queue[ queueEnd++ ] = (nz * height + ny) * width + nx;
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	return componentCount;
+}
+
+
+// create a random 0/255 image sequence with blobs of various sizes (noise averaged over 3 frames, then blurred and thresholded)
+void componentTestSeq( int width, int height, int length, int threshold, ImageGrayUSeq &seq ) {
+	ImageGrayUSeq noise;
+	initImageSeq( noise, width, height, length + 2, false, 0 );
+	for (int z = 0; z < length + 2; z++)
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				noise[ z ].data( x, y ) = (unsigned char) randomInt( 0, 255 );
+	for (int z = 0; z < length; z++) {
+		ImageGrayU average( width, height );
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				average.data( x, y ) = (unsigned char) ((noise[ z ].data( x, y ) + noise[ z + 1 ].data( x, y ) + noise[ z + 2 ].data( x, y )) / 3);
+		seq.append( blurBoxAndThreshold( average, 3, threshold ).release() );
+	}
+}
+
+
+// check image sequence labels and stats against a direct fill-based implementation
+bool testConnectedComponentsXYZ() {
+	int savedThreadCount = threadCount();
+	setThreadCount( 4 );
+	for (int i = 0; i < 8; i++) {
+		int width = randomInt( 1, 40 ), height = randomInt( 1, 30 ), length = randomInt( 1, 25 );
+		bool fullyConnected = (i & 1) == 1;
+		ImageGrayUSeq seq;
+		componentTestSeq( width, height, length, randomInt( 120, 136 ), seq );
+		ImageGrayISeq labels, directLabels;
+		initImageSeq( directLabels, width, height, length, false, 0 );
+		Vector<ComponentStats3D> stats;
+		int count = labelComponentsXYZ( seq, 255, 255, fullyConnected, labels, &stats );
+		int directCount = labelComponentsDirectXYZ( seq, 255, 255, fullyConnected, directLabels );
+		unitAssert( count == directCount && stats.length() == count );
+
+		// both number components in raster order, so the labels should match exactly
+		Vector<ComponentStats3D> directStats( count );
+		for (int z = 0; z < length; z++) {
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					int label = directLabels[ z ].data( x, y );
+					unitAssert( labels[ z ].data( x, y ) == label );
+					if (label)
+						directStats[ label - 1 ].add( x, y, z );
+				}
+			}
+		}
+		for (int j = 0; j < count; j++) {
+			const ComponentStats3D &s = stats[ j ], &d = directStats[ j ];
+			unitAssert( s.voxelCount == d.voxelCount && s.xMin == d.xMin && s.xMax == d.xMax && s.yMin == d.yMin && s.yMax == d.yMax );
+			unitAssert( s.zMin == d.zMin && s.zMax == d.zMax && s.frameSpan() == d.frameSpan() );
+			unitAssert( fabs( s.xCentroid() - d.xCentroid() ) < 1e-4 && fabs( s.yCentroid() - d.yCentroid() ) < 1e-4 && fabs( s.zCentroid() - d.zCentroid() ) < 1e-4 );
+		}
+	}
+	setThreadCount( savedThreadCount );
+	return true;
+}
+
+
+// time component labeling and mask filtering
+void benchmarkConnectedComponents( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 10 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, threads: %d", width, height, threadCount() );
+
+	// create a noisy mask
+	aptr<ImageGrayU> mask = componentTestMask( width, height, 128 );
+	ImageGrayI labels( width, height );
+	Vector<ComponentStats> stats;
+
+	// time each operation
+	for (int i = 0; i < 6; i++) {
+		Timer timer;
+		int count = 0;
+		for (int j = 0; j < iterations; j++) {
+			ImageGrayU work( *mask );
+			timer.start();
+			switch (i) {
+			case 0: count = labelComponents( imageView( work ), 255, 255, false, labels ); break;
+			case 1: count = labelComponents( imageView( work ), 255, 255, false, labels, &stats ); break;
+			case 2: count = labelComponents( imageView( work ), 255, 255, true, labels, &stats ); break;
+			case 3: filterMaskComponentsDirect( work, 10, 1000 ); break;
+			case 4: filterMaskComponents( work, 10, 1000 ); break;
+			case 5: fillMaskHoles( work, 10 ); break;
+			}
+			timer.stop();
+		}
+		const char *names[] = { "labelComponents (4-conn.)", "labelComponents + stats (4-conn.)", "labelComponents + stats (8-conn.)",
+								"filterMaskComponents (flood fill)", "filterMaskComponents", "fillMaskHoles" };
+		if (i < 3)
+			disp( 1, "%-38s %7.2f ms (%d components)", names[ i ], timer.timeSum() * 1000.0 / iterations, count );
+		else
+			disp( 1, "%-38s %7.2f ms", names[ i ], timer.timeSum() * 1000.0 / iterations );
+	}
+}
+
+
+// time image sequence component labeling
+void benchmarkConnectedComponentsXYZ( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 320 );
+	int height = conf.readInt( "height", 240 );
+	int length = conf.readInt( "length", 100 );
+	int threads = conf.readInt( "threads", threadCount() );
+	bool compareFloodFill = conf.readBool( "compareFloodFill", true );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "sequence: %d x %d x %d, threads: %d", width, height, length, threadCount() );
+
+	// create a noisy sequence
+	ImageGrayUSeq seq;
+	componentTestSeq( width, height, length, 128, seq );
+	ImageGrayISeq labels;
+	Vector<ComponentStats3D> stats;
+
+	// label using each connectivity
+	for (int i = 0; i < 2; i++) {
+		Timer timer( true );
+		int count = labelComponentsXYZ( seq, 255, 255, i == 1, labels, &stats );
+		timer.stop();
+		disp( 1, "labelComponentsXYZ + stats (%d-conn.)     %8.2f ms (%d components)", i ? 26 : 6, timer.timeSum() * 1000.0, count );
+	}
+
+	// label by flood filling from each unlabeled voxel (the previous approach)
+	if (compareFloodFill) {
+		ImageGrayUSeq work;
+		for (int z = 0; z < length; z++)
+			work.append( new ImageGrayU( seq[ z ] ) );
+		Timer timer( true );
+		int count = 0;
+		for (int z = 0; z < length; z++) {
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					if (work[ z ].data( x, y ) == 255) {
+						float xCent = 0, yCent = 0, zCent = 0;
+						floodFillXYZ( work, 255, 255, 100, x, y, z, &xCent, &yCent, &zCent );
+						count++;
+					}
+				}
+			}
+		}
+		timer.stop();
+		disp( 1, "floodFillXYZ (6-conn.)                   %8.2f ms (%d components)", timer.timeSum() * 1000.0, count );
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initConnectedComponents() {
+	registerUnitTest( testConnectedComponents );
+	registerUnitTest( testConnectedComponentsXYZ );
+	registerCommand( "benchcomponents", benchmarkConnectedComponents );
+	registerCommand( "benchcomponentsxyz", benchmarkConnectedComponentsXYZ );
+}
+
+
+} // end namespace sbl
@@ -1,8 +1,15 @@
 #include <sbl/image/Filter.h>
 #include <sbl/core/PathConfig.h>
 #include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
 #include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h>
 #include <sbl/image/Video.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 namespace sbl {
 
 
@@ -10,6 +17,7 @@ namespace sbl {
 struct ColorImageFilter {
 	String name;
 	ColorImageFilterCallback callback;
+	bool stateless;
 };
 
 
@@ -17,6 +25,7 @@ struct ColorImageFilter {
 struct GrayImageFilter {
 	String name;
 	GrayImageFilterCallback callback;
+	bool stateless;
 };
 
 
@@ -41,23 +50,388 @@ Array<GrayImageFilter> &grayFilters() {
 
 
 /// register a generalized filter for color images
-void registerFilterInternal( const String &name, ColorImageFilterCallback callback ) {
+void registerFilterInternal( const String &name, ColorImageFilterCallback callback, bool stateless ) {
 	ColorImageFilter *filter = new ColorImageFilter();
 	filter->name = name;
 	filter->callback = callback;
+	filter->stateless = stateless;
 	colorFilters().append( filter );
 }
 
 
 /// register a generalized filters for masks / grayscale images
-void registerFilterInternal( const String &name, GrayImageFilterCallback callback ) {
+void registerFilterInternal( const String &name, GrayImageFilterCallback callback, bool stateless ) {
 	GrayImageFilter *filter = new GrayImageFilter();
 	filter->name = name;
 	filter->callback = callback;
+	filter->stateless = stateless;
 	grayFilters().append( filter );
 }
 
 
+//-------------------------------------------
+// FILTER PIPELINE
+//-------------------------------------------
+
+
+/// The FilterPipelineIO class provides the frames read and written by FilterPipeline.
+template <typename ImageType> class FilterPipelineIO {
+public:
+
+	// basic destructor
+	virtual ~FilterPipelineIO() {}
+
+	/// the number of frames
+	virtual int count() const = 0;
+
+	/// read the frame at the given position in the sequence (NULL if it can't be read); called by the decode thread, in order
+	virtual aptr<ImageType> read( int position ) = 0;
+
+	/// write the next frame (taking ownership of the image); called by the thread running the pipeline, in order
+	virtual void write( aptr<ImageType> image ) = 0;
+};
+
+
+/// The FilterPipelineFrame class holds a frame (NULL if it could not be read or filtered) and its position in the sequence.
+template <typename ImageType> class FilterPipelineFrame {
+public:
+	FilterPipelineFrame( int framePosition ) : position( framePosition ) {}
+	int position;
+	aptr<ImageType> image;
+};
+
+
+/// The FilterPipeline class applies a filter to a sequence of frames with separate decode, filter, and encode stages.
+/// A decode thread reads frames into a queue (holding up to queueLength frames); filter threads take frames from the queue 
+/// and place the results in a reorder buffer (holding up to queueLength frames following the next frame to write);
+/// the thread running the pipeline writes the results in order.  A stateless filter is applied by several threads at once
+/// (each call gets its own copy of the config); otherwise the thread running the pipeline applies the filter (with the original
+/// config) before writing each frame.  The decode and filter threads are worker threads (see workerThread), so filters that display
+/// messages or check for events don't call the GUI callbacks from them.  If the current command is cancelled, the pipeline stops
+/// before writing the next frame (a frame filtered while the command was being cancelled is not written).  The time each stage spends working (busy) and waiting for other stages (idle) is recorded.
+template <typename ImageType> class FilterPipeline {
+public:
+
+	// the filter function
+	typedef aptr<ImageType> (*Callback)( const ImageType &input, Config &conf );
+
+	// create a pipeline for the given filter; if threadCount is 0, stateless filters use the number of threads used by parallel loops
+	FilterPipeline( Callback callback, bool stateless, int threadCount, int queueLength );
+
+	// read, filter, and write each frame
+	void run( FilterPipelineIO<ImageType> &io, Config &conf );
+
+	// the number of filter threads
+	inline int threadCount() const { return m_threadCount; }
+
+	// the number of frames that could not be read or filtered (and were not written)
+	inline int failCount() const { return m_failCount; }
+
+	// true if the pipeline was stopped because the command was cancelled
+	inline bool cancelled() const { return m_stop; }
+
+	// the time (in seconds) each stage spent working and waiting for the other stages (summed over the filter threads)
+	inline double decodeBusy() const { return m_decodeBusy; }
+	inline double decodeIdle() const { return m_decodeIdle; }
+	inline double filterBusy() const { return m_filterBusy; }
+	inline double filterIdle() const { return m_filterIdle; }
+	inline double encodeBusy() const { return m_encodeBusy; }
+	inline double encodeIdle() const { return m_encodeIdle; }
+
+	// display the time spent by each stage
+	void report() const;
+
+private:
+
+	// the decode thread: read each frame, waiting for space in the queue
+	void decodeMain( FilterPipelineIO<ImageType> *io );
+
+	// a filter thread: filter frames from the queue and add them to the reorder buffer
+	void filterMain( Config *conf );
+
+	// take the next decoded frame from the queue, waiting for the decode thread if needed; returns NULL if there are no more frames
+	FilterPipelineFrame<ImageType> *takeDecoded();
+
+	// tell the other stages to stop
+	void stop();
+
+	// the filter and the pipeline size
+	Callback m_callback;
+	bool m_stateless;
+	int m_threadCount;
+	int m_queueLength;
+
+	// decoded frames (in order), filtered frames (in any order), the number of frames, 
+	// the number of frames taken by the filter threads, and the position of the next frame to write
+	PtrArray<FilterPipelineFrame<ImageType> > m_decoded;
+	PtrArray<FilterPipelineFrame<ImageType> > m_filtered;
+	int m_count;
+	int m_takenCount;
+	int m_writePosition;
+	bool m_stop;
+
+	// statistics
+	int m_failCount;
+	double m_decodeBusy;
+	double m_decodeIdle;
+	double m_filterBusy;
+	double m_filterIdle;
+	double m_encodeBusy;
+	double m_encodeIdle;
+
+	// the state used to communicate between the stages
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+
+	// disable copy constructor and assignment operator
+	FilterPipeline( const FilterPipeline &x );
+	FilterPipeline &operator=( const FilterPipeline &x );
+};
+
+
+// create a pipeline for the given filter; if threadCount is 0, stateless filters use the number of threads used by parallel loops
+template <typename ImageType> FilterPipeline<ImageType>::FilterPipeline( Callback callback, bool stateless, int threadCount, int queueLength ) {
+	m_callback = callback;
+	m_stateless = stateless;
+	m_threadCount = stateless ? (threadCount > 0 ? threadCount : sbl::threadCount()) : 1;
+	m_queueLength = queueLength > 0 ? queueLength : 2 * m_threadCount;
+	m_count = 0;
+	m_takenCount = 0;
+	m_writePosition = 0;
+	m_stop = false;
+	m_failCount = 0;
+	m_decodeBusy = 0;
+	m_decodeIdle = 0;
+	m_filterBusy = 0;
+	m_filterIdle = 0;
+	m_encodeBusy = 0;
+	m_encodeIdle = 0;
+}
+
+
+// read, filter, and write each frame
+template <typename ImageType> void FilterPipeline<ImageType>::run( FilterPipelineIO<ImageType> &io, Config &conf ) {
+	m_count = io.count();
+	m_takenCount = 0;
+	m_writePosition = 0;
+	m_stop = false;
+	std::thread decodeThread( &FilterPipeline<ImageType>::decodeMain, this, &io );
+	Array<std::thread> filterThreads;
+	if (m_stateless) {
+		for (int i = 0; i < m_threadCount; i++)
+			filterThreads.append( new std::thread( &FilterPipeline<ImageType>::filterMain, this, &conf ) );
+	}
+
+	// write the filtered frames in order (filtering them first if the filter isn't stateless), reporting progress from this thread
+	ProgressCounter counter( m_count );
+	for (int position = 0; position < m_count; position++) {
+		if (checkCommandEvents()) {
+			stop();
+			break;
+		}
+		FilterPipelineFrame<ImageType> *frame = NULL;
+		if (m_stateless) {
+			std::unique_lock<std::mutex> lock( m_mutex );
+			Timer idleTimer( true );
+			while (frame == NULL) {
+				for (int i = 0; i < m_filtered.count() && frame == NULL; i++) {
+					if (m_filtered[ i ].position == position) {
+						frame = &m_filtered[ i ];
+						m_filtered.remove( i );
+					}
+				}
+				if (frame == NULL)
+					m_changed.wait( lock );
+			}
+			m_encodeIdle += idleTimer.timeSum();
+			m_writePosition = position + 1;
+			m_changed.notify_all();
+		} else {
+			frame = takeDecoded();
+			if (frame == NULL)
+				break;
+			Timer filterTimer( true );
+			if (frame->image.get())
+				frame->image = m_callback( *frame->image, conf );
+			m_filterBusy += filterTimer.timeSum();
+		}
+
+		// the filter may have stopped part way if the command was cancelled while it was running, so we drop the frame
+		if (commandCancelled()) {
+			delete frame;
+			stop();
+			break;
+		}
+		Timer busyTimer( true );
+		if (frame->image.get())
+			io.write( frame->image );
+		else
+			m_failCount++;
+		delete frame;
+		m_encodeBusy += busyTimer.timeSum();
+		counter.add();
+		counter.report();
+	}
+	decodeThread.join();
+	for (int i = 0; i < filterThreads.count(); i++)
+		filterThreads[ i ].join();
+
+	// if stopped, delete the frames that weren't written
+	for (int i = 0; i < m_decoded.count(); i++)
+		delete &m_decoded[ i ];
+	for (int i = 0; i < m_filtered.count(); i++)
+		delete &m_filtered[ i ];
+	m_decoded.reset();
+	m_filtered.reset();
+}
+
+
+// display the time spent by each stage
+template <typename ImageType> void FilterPipeline<ImageType>::report() const {
+	disp( 1, "decode: busy %7.3f s, idle %7.3f s", m_decodeBusy, m_decodeIdle );
+	disp( 1, "filter: busy %7.3f s, idle %7.3f s (total for %d thread%s)", m_filterBusy, m_filterIdle, m_threadCount, m_threadCount == 1 ? "" : "s" );
+	disp( 1, "encode: busy %7.3f s, idle %7.3f s", m_encodeBusy, m_encodeIdle );
+	if (m_failCount)
+		warning( "unable to read or filter %d frames", m_failCount );
+}
+
+
+// the decode thread: read each frame, waiting for space in the queue
+template <typename ImageType> void FilterPipeline<ImageType>::decodeMain( FilterPipelineIO<ImageType> *io ) {
+	markWorkerThread();
+	for (int position = 0; position < m_count; position++) {
+		Timer busyTimer( true );
+		FilterPipelineFrame<ImageType> *frame = new FilterPipelineFrame<ImageType>( position );
+		frame->image = io->read( position );
+		double busy = busyTimer.timeSum();
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_decodeBusy += busy;
+		Timer idleTimer( true );
+		while (m_decoded.count() >= m_queueLength && m_stop == false)
+			m_changed.wait( lock );
+		m_decodeIdle += idleTimer.timeSum();
+		if (m_stop) {
+			delete frame;
+			break;
+		}
+		m_decoded.append( frame );
+		m_changed.notify_all();
+	}
+}
+
+
+// a filter thread: filter frames from the queue and add them to the reorder buffer
+template <typename ImageType> void FilterPipeline<ImageType>::filterMain( Config *conf ) {
+	markWorkerThread();
+	Config frameConf;
+	while (true) {
+		FilterPipelineFrame<ImageType> *frame = takeDecoded();
+		if (frame == NULL)
+			break;
+
+		// apply the filter (with a copy of the config, since other threads are also using it)
+		Timer busyTimer( true );
+		if (frame->image.get()) {
+			frameConf.copyFrom( *conf );
+			frame->image = m_callback( *frame->image, frameConf );
+		}
+		double busy = busyTimer.timeSum();
+
+		// add to the reorder buffer once it is within queueLength frames of the next frame to write
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_filterBusy += busy;
+		Timer writeTimer( true );
+		while (frame->position - m_writePosition >= m_queueLength && m_stop == false)
+			m_changed.wait( lock );
+		m_filterIdle += writeTimer.timeSum();
+		if (m_stop) {
+			delete frame;
+			break;
+		}
+		m_filtered.append( frame );
+		m_changed.notify_all();
+	}
+}
+
+
+// take the next decoded frame from the queue, waiting for the decode thread if needed; returns NULL if there are no more frames
+template <typename ImageType> FilterPipelineFrame<ImageType> *FilterPipeline<ImageType>::takeDecoded() {
+	std::unique_lock<std::mutex> lock( m_mutex );
+	Timer idleTimer( true );
+	while (m_decoded.count() == 0 && m_takenCount < m_count && m_stop == false)
+		m_changed.wait( lock );
+	m_filterIdle += idleTimer.timeSum();
+	if (m_decoded.count() == 0 || m_stop)
+		return NULL;
+	FilterPipelineFrame<ImageType> *frame = &m_decoded[ 0 ];
+	m_decoded.remove( 0 );
+	m_takenCount++;
+	m_changed.notify_all();
+	return frame;
+}
+
+
+// tell the other stages to stop
+template <typename ImageType> void FilterPipeline<ImageType>::stop() {
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_stop = true;
+	m_changed.notify_all();
+}
+
+
+// read frames from an input video
+inline void readVideoFrame( InputVideo &inputVideo, int frameIndex, aptr<ImageColorU> &image ) { image = inputVideo.frame( frameIndex ); }
+inline void readVideoFrame( InputVideo &inputVideo, int frameIndex, aptr<ImageGrayU> &image ) { image = inputVideo.frameGray( frameIndex ); }
+
+
+/// The VideoFilterIO class reads frames from an input video (with a given range and step) and writes them to an output video.
+template <typename ImageType> class VideoFilterIO : public FilterPipelineIO<ImageType> {
+public:
+
+	// use the given videos and frame range
+	VideoFilterIO( InputVideo &inputVideo, OutputVideo &outputVideo, int startFrameIndex, int endFrameIndex, int frameStep ) 
+		: m_inputVideo( inputVideo ), m_outputVideo( outputVideo ), m_startFrameIndex( startFrameIndex ), m_endFrameIndex( endFrameIndex ), m_frameStep( frameStep ) {}
+
+	// the number of frames in the range
+	int count() const { return m_endFrameIndex >= m_startFrameIndex ? (m_endFrameIndex - m_startFrameIndex) / m_frameStep + 1 : 0; }
+
+	// read a frame from the input video
+	aptr<ImageType> read( int position ) {
+		aptr<ImageType> image;
+		readVideoFrame( m_inputVideo, m_startFrameIndex + position * m_frameStep, image );
+		return image;
+	}
+
+	// add a frame to the output video (without copying)
+	void write( aptr<ImageType> image ) { m_outputVideo.append( image ); }
+
+private:
+
+	// the videos and the frame range
+	InputVideo &m_inputVideo;
+	OutputVideo &m_outputVideo;
+	int m_startFrameIndex;
+	int m_endFrameIndex;
+	int m_frameStep;
+};
+
+
+// apply a filter to a range of video frames, then display the time spent by each pipeline stage
+template <typename ImageType> void runFilterPipeline( aptr<ImageType> (*callback)( const ImageType &input, Config &conf ), bool stateless, 
+													  InputVideo &inputVideo, OutputVideo &outputVideo, int startFrameIndex, int endFrameIndex, int frameStep, 
+													  int threadCount, int queueLength, Config &conf ) {
+	VideoFilterIO<ImageType> io( inputVideo, outputVideo, startFrameIndex, endFrameIndex, frameStep );
+	FilterPipeline<ImageType> pipeline( callback, stateless, threadCount, queueLength );
+	Timer timer( true );
+	pipeline.run( io, conf );
+	outputVideo.close();
+	if (pipeline.cancelled())
+		warning( "filter cancelled after %d of %d frames", outputVideo.frameCount(), io.count() );
+	disp( 1, "filtered %d frames in %.3f s (%d filter thread%s)", io.count(), timer.timeSum(), pipeline.threadCount(), pipeline.threadCount() == 1 ? "" : "s" );
+	pipeline.report();
+}
+
+
 //-------------------------------------------
 // COMMANDS
 //-------------------------------------------
@@ -73,6 +447,8 @@ void filterVideo( Config &conf, bool gray ) {
 	int startFrameIndex = conf.readInt( "startFrameIndex", 0 );
 	int endFrameIndex = conf.readInt( "endFrameIndex", 1000000000 );
 	int frameStep = conf.readInt( "frameStep", 1 );
+	int threadCount = conf.readInt( "threadCount", 0 );
+	int queueLength = conf.readInt( "queueLength", 0 );
 	if (conf.initialPass())
 		return;
 
@@ -83,6 +459,8 @@ void filterVideo( Config &conf, bool gray ) {
 	disp( 1, "startFrameIndex: %d", startFrameIndex );
 	disp( 1, "endFrameIndex: %d", endFrameIndex );
 	disp( 1, "frameStep: %d", frameStep );
+	disp( 1, "threadCount: %d", threadCount );
+	disp( 1, "queueLength: %d", queueLength );
 
 	// open input video
 	InputVideo inputVideo( inputFileName );
@@ -105,10 +483,13 @@ void filterVideo( Config &conf, bool gray ) {
 	// get filter by filter name
 	ColorImageFilterCallback colorFilterCallback = NULL;
 	GrayImageFilterCallback grayFilterCallback = NULL;
+	bool stateless = false;
 	if (gray) {
 		for (int i = 0; i < grayFilters().count(); i++) {
-			if (grayFilters()[ i ].name == filterName)
+			if (grayFilters()[ i ].name == filterName) {
 				grayFilterCallback = grayFilters()[ i ].callback;
+				stateless = grayFilters()[ i ].stateless;
+			}
 		}
 		if (grayFilterCallback == NULL) {
 			warning( "unable to find grayscale image filter: %s", filterName.c_str() );
@@ -116,8 +497,10 @@ void filterVideo( Config &conf, bool gray ) {
 		}
 	} else {
 		for (int i = 0; i < colorFilters().count(); i++) {
-			if (colorFilters()[ i ].name == filterName)
+			if (colorFilters()[ i ].name == filterName) {
 				colorFilterCallback = colorFilters()[ i ].callback;
+				stateless = colorFilters()[ i ].stateless;
+			}
 		}
 		if (colorFilterCallback == NULL) {
 			warning( "unable to find color image filter: %s", filterName.c_str() );
@@ -125,18 +508,11 @@ void filterVideo( Config &conf, bool gray ) {
 		}
 	}
 
-	// loop over input video
-	for (int frameIndex = startFrameIndex; frameIndex <= endFrameIndex; frameIndex += frameStep) {
-		if (gray) {
-			aptr<ImageGrayU> image = inputVideo.frameGray( frameIndex );
-			image = grayFilterCallback( *image, conf );
-			outputVideo.append( *image );
-		} else {
-			aptr<ImageColorU> image = inputVideo.frame( frameIndex );
-			image = colorFilterCallback( *image, conf );
-			outputVideo.append( *image );
-		}
-	}
+	// decode, filter, and encode the frames
+	if (gray)
+		runFilterPipeline( grayFilterCallback, stateless, inputVideo, outputVideo, startFrameIndex, endFrameIndex, frameStep, threadCount, queueLength, conf );
+	else
+		runFilterPipeline( colorFilterCallback, stateless, inputVideo, outputVideo, startFrameIndex, endFrameIndex, frameStep, threadCount, queueLength, conf );
 }
 
 
@@ -152,6 +528,223 @@ void filterGrayVideo( Config &conf ) {
 }
 
 
+//-------------------------------------------
+// TEST / BENCHMARK
+//-------------------------------------------
+
+
+// wait for the given number of milliseconds (without sleeping, to simulate computation)
+void filterBusyWait( double milliseconds ) {
+	double startTime = getPerfTime();
+	while ((getPerfTime() - startTime) * 1000.0 < milliseconds) {}
+}
+
+
+/// The SyntheticFilterIO class generates frames (each filled with its position) and records the values of the frames written
+/// (and the number of frames that weren't filled with a single value); reading and writing each frame take the given times 
+/// (simulating decoding and encoding).
+class SyntheticFilterIO : public FilterPipelineIO<ImageGrayU> {
+public:
+
+	// create a sequence of the given length; reading failPosition fails (for testing)
+	SyntheticFilterIO( int count, int failPosition = -1, double readMs = 0, double writeMs = 0 ) 
+		: m_count( count ), m_failPosition( failPosition ), m_readMs( readMs ), m_writeMs( writeMs ), m_mixedCount( 0 ) {}
+
+	// the number of frames
+	int count() const { return m_count; }
+
+	// generate a frame
+	aptr<ImageGrayU> read( int position ) {
+		filterBusyWait( m_readMs );
+		aptr<ImageGrayU> image;
+		if (position != m_failPosition) {
+			image.reset( new ImageGrayU( 16, 8 ) );
+			image->clear( (unsigned char) position );
+		}
+		return image;
+	}
+
+	// record the value of a frame
+	void write( aptr<ImageGrayU> image ) {
+		filterBusyWait( m_writeMs );
+		m_written.append( image->data( 0, 0 ) );
+		for (int y = 0; y < image->height(); y++) {
+			for (int x = 0; x < image->width(); x++) {
+				if (image->data( x, y ) != image->data( 0, 0 )) {
+					m_mixedCount++;
+					return;
+				}
+			}
+		}
+	}
+
+	// the values of the frames written
+	inline const VectorI &written() const { return m_written; }
+
+	// the number of frames written that weren't filled with a single value
+	inline int mixedCount() const { return m_mixedCount; }
+
+private:
+
+	// the sequence length, the frame to fail, and the simulated times
+	int m_count;
+	int m_failPosition;
+	double m_readMs;
+	double m_writeMs;
+
+	// the values of the frames written, and the number that weren't filled with a single value
+	VectorI m_written;
+	int m_mixedCount;
+};
+
+
+// the number of test filter calls running at once, the maximum, and the number of calls made on a worker thread
+static std::mutex s_testFilterMutex;
+static int s_testFilterActive = 0;
+static int s_testFilterMaxActive = 0;
+static int s_testFilterWorkerCount = 0;
+
+
+// the frame value at which the test filter cancels the current command (-1 for none)
+static int s_testFilterCancelValue = -1;
+
+
+// a filter that adds a config value (for testing), taking a variable time to run (so that frames finish out of order);
+// if the command has been cancelled, only the top half of the frame is filtered (as a filter built on cancellable loops might do)
+aptr<ImageGrayU> testPipelineFilter( const ImageGrayU &input, Config &conf ) {
+	int offset = conf.readInt( "offset", 0 );
+	{
+		std::lock_guard<std::mutex> lock( s_testFilterMutex );
+		s_testFilterActive++;
+		if (s_testFilterActive > s_testFilterMaxActive)
+			s_testFilterMaxActive = s_testFilterActive;
+		if (workerThread())
+			s_testFilterWorkerCount++;
+	}
+	if (input.data( 0, 0 ) == s_testFilterCancelValue)
+		setCancelCommand( true );
+	std::this_thread::sleep_for( std::chrono::microseconds( 200 + 700 * ((input.data( 0, 0 ) * 7) % 3) ) );
+	aptr<ImageGrayU> output( new ImageGrayU( input ) );
+	output->clear( (unsigned char) (input.data( 0, 0 ) + offset) );
+	if (commandCancelled()) {
+		for (int y = output->height() / 2; y < output->height(); y++)
+			for (int x = 0; x < output->width(); x++)
+				output->data( x, y ) = input.data( x, y );
+	}
+	{
+		std::lock_guard<std::mutex> lock( s_testFilterMutex );
+		s_testFilterActive--;
+	}
+	return output;
+}
+
+
+// a filter that keeps state between frames (for testing): outputs the previous frame's value
+aptr<ImageGrayU> testPipelineStateFilter( const ImageGrayU &input, Config &conf ) {
+	static int s_previousValue = 0;
+	aptr<ImageGrayU> output = testPipelineFilter( input, conf );
+	int value = output->data( 0, 0 );
+	output->clear( (unsigned char) s_previousValue );
+	s_previousValue = value;
+	return output;
+}
+
+
+// check that the filter pipeline writes the frames in order, applying stateless filters to several frames at once
+bool testFilterPipeline() {
+	int count = 40, failPosition = 23, offset = 10;
+	Config conf;
+	conf.writeInt( "offset", offset );
+	for (int pass = 0; pass < 2; pass++) {
+		bool stateless = pass == 0;
+		s_testFilterMaxActive = 0;
+		s_testFilterWorkerCount = 0;
+		SyntheticFilterIO io( count, failPosition );
+		FilterPipeline<ImageGrayU> pipeline( stateless ? testPipelineFilter : testPipelineStateFilter, stateless, 4, 3 );
+		pipeline.run( io, conf );
+		unitAssert( pipeline.threadCount() == (stateless ? 4 : 1) );
+		unitAssert( pipeline.failCount() == 1 );
+		unitAssert( io.written().length() == count - 1 );
+		int previousValue = 0;
+		for (int i = 0, position = 0; i < io.written().length(); i++, position++) {
+			if (position == failPosition)
+				position++;
+			int value = position + offset;
+			unitAssert( io.written()[ i ] == (stateless ? value : previousValue) );
+			previousValue = value;
+		}
+		if (stateless) {
+			unitAssert( s_testFilterMaxActive > 1 && s_testFilterWorkerCount == count - 1 );
+		} else {
+			unitAssert( s_testFilterMaxActive == 1 && s_testFilterWorkerCount == 0 ); // run on this thread
+		}
+		unitAssert( pipeline.filterBusy() > 0 && pipeline.cancelled() == false );
+	}
+
+	// cancelling the command stops the pipeline at a frame boundary (frames before the cancellation are written in order,
+	// and the frames being filtered when the command is cancelled are dropped)
+	for (int pass = 0; pass < 2; pass++) {
+		bool stateless = pass == 0;
+		int cancelPosition = 15;
+		s_testFilterCancelValue = cancelPosition;
+		SyntheticFilterIO io( count );
+		FilterPipeline<ImageGrayU> pipeline( testPipelineFilter, stateless, 4, 3 );
+		pipeline.run( io, conf );
+		bool cancelled = commandCancelled();
+		setCancelCommand( false );
+		s_testFilterCancelValue = -1;
+		unitAssert( cancelled && pipeline.cancelled() );
+		unitAssert( io.written().length() <= cancelPosition && io.mixedCount() == 0 );
+		for (int i = 0; i < io.written().length(); i++)
+			unitAssert( io.written()[ i ] == i + offset );
+	}
+	return true;
+}
+
+
+// a filter that takes a given time (for benchmarking)
+aptr<ImageGrayU> benchmarkPipelineFilter( const ImageGrayU &input, Config &conf ) {
+	filterBusyWait( conf.readFloat( "filterMs", 0 ) );
+	return aptr<ImageGrayU>( new ImageGrayU( input ) );
+}
+
+
+// time the filter pipeline with various numbers of filter threads, for simulated decoding, filtering, and encoding
+void benchmarkFilterPipeline( Config &conf ) {
+
+	// get command parameters
+	int length = conf.readInt( "length", 200 );
+	float decodeMs = conf.readFloat( "decodeMs", 2.0f );
+	float filterMs = conf.readFloat( "filterMs", 8.0f );
+	float encodeMs = conf.readFloat( "encodeMs", 2.0f );
+	int maxThreads = conf.readInt( "maxThreads", 8 );
+	if (conf.initialPass())
+		return;
+	disp( 1, "frames: %d, decode: %4.2f ms, filter: %4.2f ms, encode: %4.2f ms", length, decodeMs, filterMs, encodeMs );
+	conf.writeFloat( "filterMs", filterMs ); // so that the filter reads the value even if it was given as a command argument
+
+	// run each stage in turn on one thread (as done previously)
+	SyntheticFilterIO serialIO( length, -1, decodeMs, encodeMs );
+	Timer serialTimer( true );
+	for (int i = 0; i < length; i++) {
+		aptr<ImageGrayU> image = serialIO.read( i );
+		image = benchmarkPipelineFilter( *image, conf );
+		serialIO.write( image );
+	}
+	disp( 1, "serial:             %8.3f ms/frame", serialTimer.timeSum() * 1000.0 / length );
+
+	// run the pipeline with 1, 2, 4, ... filter threads
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		SyntheticFilterIO io( length, -1, decodeMs, encodeMs );
+		FilterPipeline<ImageGrayU> pipeline( benchmarkPipelineFilter, true, threads, 0 );
+		Timer timer( true );
+		pipeline.run( io, conf );
+		disp( 1, "pipeline, %d thread%s: %8.3f ms/frame", threads, threads == 1 ? " " : "s", timer.timeSum() * 1000.0 / length );
+		pipeline.report();
+	}
+}
+
+
 //-------------------------------------------
 // INIT / CLEAN-UP
 //-------------------------------------------
@@ -159,8 +752,10 @@ void filterGrayVideo( Config &conf ) {
 
 // register commands, etc. defined in this module
 void initFilter() {
+	registerUnitTest( testFilterPipeline );
 	registerCommand( "vfiltcolor", filterColorVideo );
-	registerCommand( "vfiltgray", filterColorVideo );
+	registerCommand( "vfiltgray", filterGrayVideo );
+	registerCommand( "benchfilter", benchmarkFilterPipeline );
 }
 
 
@@ -0,0 +1,375 @@
+#include <sbl/image/ImagePyramid.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/image/ImageView.h>
+#include <sbl/image/SeparableFilter.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <sbl/image/ImageUtil.h> // for test and benchmark
+#include <sbl/image/ImageTransform.h> // for benchmark
+#include <math.h>
+namespace sbl {
+
+
+//-------------------------------------------
+// PYRAMID FILTERS
+//-------------------------------------------
+
+
+// the (1, 4, 6, 4, 1) / 16 kernel used to blur each level before decimating it
+VectorF pyramidKernel() {
+	VectorF kernel( 5 );
+	kernel[ 0 ] = 1.0f / 16.0f;
+	kernel[ 1 ] = 4.0f / 16.0f;
+	kernel[ 2 ] = 6.0f / 16.0f;
+	kernel[ 3 ] = 4.0f / 16.0f;
+	kernel[ 4 ] = 1.0f / 16.0f;
+	return kernel;
+}
+
+
+// blur and decimate an image in one pass
+template <typename T, int CHANNEL_COUNT> aptr<Image<T, CHANNEL_COUNT> > pyramidDown( const Image<T, CHANNEL_COUNT> &input ) {
+	VectorF kernel = pyramidKernel();
+	FilterTaps xTaps, yTaps;
+	xTaps.setDecimate( kernel, input.width() );
+	yTaps.setDecimate( kernel, input.height() );
+	aptr<Image<T, CHANNEL_COUNT> > output( new Image<T, CHANNEL_COUNT>( xTaps.outputLength(), yTaps.outputLength() ) );
+	separableFilter( ImageView<T, CHANNEL_COUNT>( input ), ImageView<T, CHANNEL_COUNT>( *output ), xTaps, yTaps );
+	return output;
+}
+
+
+// compute a Laplacian level: the difference between a Gaussian level and the expanded next level
+template <typename T, int CHANNEL_COUNT> aptr<Image<float, CHANNEL_COUNT> > pyramidDifference( const Image<T, CHANNEL_COUNT> &fine, const Image<T, CHANNEL_COUNT> &coarse ) {
+	int width = fine.width(), height = fine.height();
+	FilterTaps xTaps, yTaps;
+	xTaps.setExpand( coarse.width(), width );
+	yTaps.setExpand( coarse.height(), height );
+	aptr<Image<float, CHANNEL_COUNT> > output( new Image<float, CHANNEL_COUNT>( width, height ) );
+	ImageView<float, CHANNEL_COUNT> outputView( *output );
+	separableFilter( ImageView<T, CHANNEL_COUNT>( coarse ), outputView, xTaps, yTaps );
+	int rowLength = width * CHANNEL_COUNT;
+	parallelFor( 0, height, 16, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			const T *fineRow = fine.row( y );
+			float *outRow = outputView.row( y );
+			for (int i = 0; i < rowLength; i++)
+				outRow[ i ] = (float) fineRow[ i ] - outRow[ i ];
+		}
+	} );
+	return output;
+}
+
+
+// convert a level to float (for the last Laplacian level)
+template <typename T, int CHANNEL_COUNT> aptr<Image<float, CHANNEL_COUNT> > pyramidToFloat( const Image<T, CHANNEL_COUNT> &input ) {
+	aptr<Image<float, CHANNEL_COUNT> > output( new Image<float, CHANNEL_COUNT>( input.width(), input.height() ) );
+	int rowLength = input.width() * CHANNEL_COUNT;
+	for (int y = 0; y < input.height(); y++) {
+		const T *inRow = input.row( y );
+		float *outRow = output->row( y );
+		for (int i = 0; i < rowLength; i++)
+			outRow[ i ] = (float) inRow[ i ];
+	}
+	return output;
+}
+
+
+//-------------------------------------------
+// IMAGE PYRAMID CLASS
+//-------------------------------------------
+
+
+/// create a pyramid of a copy of the given image
+template <typename T, int CHANNEL_COUNT> ImagePyramid<T, CHANNEL_COUNT>::ImagePyramid( const Image<T, CHANNEL_COUNT> &image ) {
+	init( new Image<T, CHANNEL_COUNT>( image ) );
+}
+
+
+/// create a pyramid of the given image (taking ownership)
+template <typename T, int CHANNEL_COUNT> ImagePyramid<T, CHANNEL_COUNT>::ImagePyramid( aptr<Image<T, CHANNEL_COUNT> > image ) {
+	init( image.release() );
+}
+
+
+// set the level count and the first level
+template <typename T, int CHANNEL_COUNT> void ImagePyramid<T, CHANNEL_COUNT>::init( Image<T, CHANNEL_COUNT> *image ) {
+	assertAlways( image && image->width() > 0 && image->height() > 0 );
+	m_levels.append( image );
+	m_width = image->width();
+	m_height = image->height();
+	m_levelCount = 1;
+	while (width( m_levelCount - 1 ) > 1 && height( m_levelCount - 1 ) > 1)
+		m_levelCount++;
+}
+
+
+/// the size of a level (without computing it)
+template <typename T, int CHANNEL_COUNT> int ImagePyramid<T, CHANNEL_COUNT>::width( int level ) const {
+	int width = m_width;
+	for (int i = 0; i < level; i++)
+		width = (width + 1) / 2;
+	return width;
+}
+template <typename T, int CHANNEL_COUNT> int ImagePyramid<T, CHANNEL_COUNT>::height( int level ) const {
+	int height = m_height;
+	for (int i = 0; i < level; i++)
+		height = (height + 1) / 2;
+	return height;
+}
+
+
+/// a level of the Gaussian pyramid (level 0 is the full-resolution image)
+template <typename T, int CHANNEL_COUNT> const Image<T, CHANNEL_COUNT> &ImagePyramid<T, CHANNEL_COUNT>::level( int level ) {
+	assertAlways( level >= 0 && level < m_levelCount );
+	std::lock_guard<std::mutex> lock( m_mutex );
+	while (m_levels.count() <= level)
+		m_levels.append( pyramidDown( m_levels[ m_levels.count() - 1 ] ).release() );
+	return m_levels[ level ];
+}
+
+
+/// a level of the Laplacian pyramid: the Gaussian level minus the expanded next level
+template <typename T, int CHANNEL_COUNT> const Image<float, CHANNEL_COUNT> &ImagePyramid<T, CHANNEL_COUNT>::laplacian( int level ) {
+	assertAlways( level >= 0 && level < m_levelCount );
+
+	// make sure the Gaussian levels are available (without holding the lock, since level() takes it)
+	this->level( level + 1 < m_levelCount ? level + 1 : level );
+	std::lock_guard<std::mutex> lock( m_mutex );
+	while (m_laplacians.count() <= level) {
+		int i = m_laplacians.count();
+		if (i + 1 < m_levelCount)
+			m_laplacians.append( pyramidDifference( m_levels[ i ], m_levels[ i + 1 ] ).release() );
+		else
+			m_laplacians.append( pyramidToFloat( m_levels[ i ] ).release() );
+	}
+	return m_laplacians[ level ];
+}
+
+
+template class ImagePyramid<unsigned char, 1>;
+template class ImagePyramid<float, 1>;
+template class ImagePyramid<unsigned char, 3>;
+
+
+//-------------------------------------------
+// IMAGE PYRAMID CACHE CLASS
+//-------------------------------------------
+
+
+/// create a cache holding up to capacity pyramids
+template <typename T, int CHANNEL_COUNT> ImagePyramidCache<T, CHANNEL_COUNT>::ImagePyramidCache( int capacity ) {
+	assertAlways( capacity > 0 );
+	m_capacity = capacity;
+	m_useCount = 0;
+	m_hitCount = 0;
+	m_missCount = 0;
+}
+
+
+/// the pyramid of the given frame, creating it (from a copy of the frame) if it is not in the cache
+template <typename T, int CHANNEL_COUNT> ImagePyramid<T, CHANNEL_COUNT> &ImagePyramidCache<T, CHANNEL_COUNT>::pyramid( int frameIndex, const Image<T, CHANNEL_COUNT> &frame ) {
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_useCount++;
+	for (int i = 0; i < m_frameIndex.length(); i++) {
+		if (m_frameIndex[ i ] == frameIndex) {
+			m_lastUse[ i ] = m_useCount;
+			m_hitCount++;
+			return m_pyramids[ i ];
+		}
+	}
+	m_missCount++;
+
+	// add a new entry or replace the least-recently used one
+	ImagePyramid<T, CHANNEL_COUNT> *pyramid = new ImagePyramid<T, CHANNEL_COUNT>( frame );
+	if (m_frameIndex.length() < m_capacity) {
+		m_pyramids.append( pyramid );
+		m_frameIndex.append( frameIndex );
+		m_lastUse.append( m_useCount );
+	} else {
+		int replace = 0;
+		for (int i = 1; i < m_lastUse.length(); i++)
+			if (m_lastUse[ i ] < m_lastUse[ replace ])
+				replace = i;
+		m_pyramids.set( replace, pyramid );
+		m_frameIndex[ replace ] = frameIndex;
+		m_lastUse[ replace ] = m_useCount;
+	}
+	return *pyramid;
+}
+
+
+/// the pyramid of the given frame, or NULL if it is not in the cache
+template <typename T, int CHANNEL_COUNT> ImagePyramid<T, CHANNEL_COUNT> *ImagePyramidCache<T, CHANNEL_COUNT>::find( int frameIndex ) {
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_useCount++;
+	for (int i = 0; i < m_frameIndex.length(); i++) {
+		if (m_frameIndex[ i ] == frameIndex) {
+			m_lastUse[ i ] = m_useCount;
+			m_hitCount++;
+			return &m_pyramids[ i ];
+		}
+	}
+	m_missCount++;
+	return NULL;
+}
+
+
+/// remove all pyramids from the cache
+template <typename T, int CHANNEL_COUNT> void ImagePyramidCache<T, CHANNEL_COUNT>::reset() {
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_pyramids.reset();
+	m_frameIndex.setLength( 0 );
+	m_lastUse.setLength( 0 );
+}
+
+
+template class ImagePyramidCache<unsigned char, 1>;
+template class ImagePyramidCache<float, 1>;
+template class ImagePyramidCache<unsigned char, 3>;
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// check pyramid levels against separate blurring and decimation, and check that the Laplacian pyramid reconstructs the image
+bool testImagePyramid() {
+	int width = 45, height = 30;
+	ImageGrayF image( width, height );
+	ImageColorU color( width, height );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			image.data( x, y ) = randomFloat( 0, 255 );
+			for (int c = 0; c < 3; c++)
+				color.data( x, y, c ) = (unsigned char) randomInt( 0, 255 );
+		}
+	}
+	ImagePyramidGrayF pyramid( image );
+	unitAssert( pyramid.levelCount() == 6 );
+	unitAssert( pyramid.width( 5 ) == 2 && pyramid.height( 5 ) == 1 );
+
+	// the fused filter should match blurring with the same kernel and then keeping the even pixels
+	FilterTaps xTaps, yTaps;
+	xTaps.setKernel( pyramidKernel(), width );
+	yTaps.setKernel( pyramidKernel(), height );
+	ImageGrayF blurred( width, height );
+	separableFilter( ImageViewGrayF( image ), ImageViewGrayF( blurred ), xTaps, yTaps );
+	const ImageGrayF &level1 = pyramid.level( 1 );
+	unitAssert( level1.width() == 23 && level1.height() == 15 );
+	for (int y = 0; y < level1.height(); y++) {
+		for (int x = 0; x < level1.width(); x++) {
+			unitAssert( fAbs( level1.data( x, y ) - blurred.data( x * 2, y * 2 ) ) < 0.01f );
+		}
+	}
+
+	// adding each Laplacian level to the expanded next Gaussian level should give back the Gaussian level
+	for (int level = 0; level + 1 < pyramid.levelCount(); level++) {
+		const ImageGrayF &fine = pyramid.level( level ), &coarse = pyramid.level( level + 1 );
+		const ImageGrayF &laplacian = pyramid.laplacian( level );
+		FilterTaps xExpand, yExpand;
+		xExpand.setExpand( coarse.width(), fine.width() );
+		yExpand.setExpand( coarse.height(), fine.height() );
+		ImageGrayF expanded( fine.width(), fine.height() );
+		separableFilter( ImageViewGrayF( coarse ), ImageViewGrayF( expanded ), xExpand, yExpand );
+		for (int y = 0; y < fine.height(); y++) {
+			for (int x = 0; x < fine.width(); x++) {
+				unitAssert( fAbs( expanded.data( x, y ) + laplacian.data( x, y ) - fine.data( x, y ) ) < 0.01f );
+			}
+		}
+	}
+	const ImageGrayF &top = pyramid.laplacian( pyramid.levelCount() - 1 );
+	unitAssert( top.data( 1, 0 ) == pyramid.level( pyramid.levelCount() - 1 ).data( 1, 0 ) );
+
+	// color levels should match the gray levels of each channel (within rounding)
+	ImagePyramidColorU colorPyramid( color );
+	aptr<ImageGrayU> green( new ImageGrayU( width, height ) );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			green->data( x, y ) = color.data( x, y, 1 );
+	ImagePyramidGrayU greenPyramid( green );
+	for (int level = 0; level < colorPyramid.levelCount(); level++) {
+		const ImageColorU &colorLevel = colorPyramid.level( level );
+		const ImageGrayU &greenLevel = greenPyramid.level( level );
+		unitAssert( colorLevel.width() == greenLevel.width() && colorLevel.height() == greenLevel.height() );
+		for (int y = 0; y < greenLevel.height(); y++) {
+			for (int x = 0; x < greenLevel.width(); x++) {
+				unitAssert( colorLevel.data( x, y, 1 ) == greenLevel.data( x, y ) );
+			}
+		}
+	}
+
+	// the cache should keep the most recently used pyramids
+	ImagePyramidCacheGrayF cache( 2 );
+	ImagePyramidGrayF &first = cache.pyramid( 0, image );
+	cache.pyramid( 1, image );
+	unitAssert( &cache.pyramid( 0, image ) == &first );
+	cache.pyramid( 2, image );
+	unitAssert( cache.find( 1 ) == NULL );
+	unitAssert( cache.find( 0 ) == &first );
+	unitAssert( cache.hitCount() == 2 && cache.missCount() == 4 );
+	return true;
+}
+
+
+// time building pyramids with the fused filter and with separate blurring and resizing
+void benchmarkPyramid( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int levelCount = conf.readInt( "levelCount", 4 );
+	int iterations = conf.readInt( "iterations", 10 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, levels: %d, threads: %d", width, height, levelCount, threadCount() );
+
+	// create a test image
+	ImageGrayU image( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			image.data( x, y ) = (unsigned char) ((x * 7 + y * 13 + randomInt( 0, 40 )) & 255);
+
+	// time the fused filter
+	Timer timer;
+	timer.start();
+	for (int i = 0; i < iterations; i++) {
+		ImagePyramidGrayU pyramid( image );
+		pyramid.level( levelCount - 1 );
+	}
+	timer.stop();
+	disp( 1, "fused:    %7.2f ms per pyramid", timer.timeSum() * 1000.0 / iterations );
+
+	// time separate blurring and resizing (as used by registration and motion estimation before the pyramid class)
+	Timer separateTimer;
+	separateTimer.start();
+	for (int i = 0; i < iterations; i++) {
+		aptr<ImageGrayU> level( new ImageGrayU( image ) );
+		for (int j = 1; j < levelCount; j++) {
+			aptr<ImageGrayU> blurred = blurGauss( *level, 1.0f );
+			level = resize( *blurred, (level->width() + 1) / 2, (level->height() + 1) / 2, false );
+		}
+	}
+	separateTimer.stop();
+	disp( 1, "separate: %7.2f ms per pyramid", separateTimer.timeSum() * 1000.0 / iterations );
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initImagePyramid() {
+	registerUnitTest( testImagePyramid );
+	registerCommand( "benchpyramid", benchmarkPyramid );
+}
+
+
+} // end namespace sbl
@@ -3,47 +3,337 @@
 #include <sbl/math/Optimizer.h>
 #include <sbl/math/MathUtil.h>
 #include <sbl/image/ImageUtil.h>
+#include <sbl/image/MutualInfo.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <atomic>
+#include <mutex>
+#include <stdlib.h>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 namespace sbl {
 
 
-/// computes the mean-abs image difference given an image transformation;
-/// a step value greater than one allows faster (less accurate) optimization by ignoring some pixels;
-/// the xBorder and yBorder specify areas to be ignored for the objective function;
-/// the offsetBound value specifies the largest allowed translation between the images
-double evalImageTransform( const ImageTransform &transform, const ImageGrayU &src, const ImageGrayU &dest, int step, int xBorder, int yBorder, const ImageGrayU *srcMask, const ImageGrayU *destMask, bool interp, bool verbose ) {
-	int xDestMin = xBorder; // note that we're using border on both source and dest
-	int xDestMax = dest.width() - 1 - xBorder;
-	int yDestMin = yBorder;
-	int yDestMax = dest.height() - 1 - yBorder;
-	float sumDiff = 0;
-	int count = 0;
-	int width = src.width(), height = src.height();
-	for (int y = yBorder; y < height - yBorder; y += step) {
-		for (int x = xBorder; x < width - xBorder; x += step) {
-			if (srcMask == NULL || srcMask->data( x, y )) {
-				float xSrc = (float) x;
-				float ySrc = (float) y;
-				float xDest = transform.xTransform( xSrc, ySrc );
-				float yDest = transform.yTransform( xSrc, ySrc );
-				int xDestInt = round( xDest );
-				int yDestInt = round( yDest );
-				if (xDestInt >= xDestMin && xDestInt <= xDestMax && yDestInt >= yDestMin && yDestInt <= yDestMax && (destMask == NULL || destMask->data( xDestInt, yDestInt ) )) {
-					int vDest = interp ? (int) dest.interp( xDest, yDest ) : dest.data( xDestInt, yDestInt );
-					int diff = src.data( x, y ) - vDest;
-					if (diff < 0)
-						diff = -diff;
-					sumDiff += (float) diff;
-					count++;
-				}
+//-------------------------------------------
+// EVALUATION KERNEL
+//-------------------------------------------
+
+
+// the number of samples compared together by the SIMD loop
+#define REGISTER_CHUNK 16
+
+
+// compute out[ i ] = floor( start + step * i + 0.5 ), the nearest integer position of each sample;
+// integer steps (e.g. for translations) are applied exactly
+void nearestPositions( float start, float step, int *out, int count ) {
+	float base = start + 0.5f;
+	int i = 0;
+	if (step == 0 || step == 1) {
+		int first = (int) floorf( base );
+		int intStep = (int) step;
+		for (; i < count; i++)
+			out[ i ] = first + intStep * i;
+		return;
+	}
+#ifdef __SSE2__
+	__m128 baseVec = _mm_set1_ps( base ), stepVec = _mm_set1_ps( step ), index = _mm_set_ps( 3, 2, 1, 0 ), four = _mm_set1_ps( 4 );
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_add_ps( baseVec, _mm_mul_ps( stepVec, index ) );
+		__m128i t = _mm_cvttps_epi32( v );
+		t = _mm_add_epi32( t, _mm_castps_si128( _mm_cmpgt_ps( _mm_cvtepi32_ps( t ), v ) ) ); // truncation rounds negative values up
+		_mm_storeu_si128( (__m128i *) (out + i), t );
+		index = _mm_add_ps( index, four );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = (int) floorf( base + step * (float) i );
+}
+
+
+/// The RegistrationKernel class computes the sum of absolute differences between a source view and
+/// a destination view (sampled at transformed positions), one sampled source row at a time.
+class RegistrationKernel {
+public:
+
+	// prepare to evaluate the given transformation (from source view coordinates to destination view coordinates)
+	RegistrationKernel( const double *params, const ImageViewGrayU &src, const ImageViewGrayU &dest, int step,
+						const ImageViewGrayU *srcMask, const ImageViewGrayU *destMask, bool interp )
+						: m_params( params ), m_src( src ), m_dest( dest ), m_step( step ), m_srcMask( srcMask ), m_destMask( destMask ), m_interp( interp ) {
+		m_sampleWidth = (src.width() + step - 1) / step;
+		m_sampleHeight = (src.height() + step - 1) / step;
+		if (interp)
+			assertAlways( dest.width() >= 2 && dest.height() >= 2 );
+	}
+
+	// the number of sampled columns and rows of the source view
+	inline int sampleWidth() const { return m_sampleWidth; }
+	inline int sampleHeight() const { return m_sampleHeight; }
+
+	// the value of one unit of the sums computed by evalRow (interpolated differences have fractional bits)
+	inline double sumScale() const { return m_interp ? 1.0 / 65536.0 : 1.0; }
+
+	// add the absolute differences and the number of valid samples for the given sampled row;
+	// xInt and yInt are buffers with room for sampleWidth() values
+	void evalRow( int sampleRow, int *xInt, int *yInt, long long &sum, long long &count ) const;
+
+	// store the source values and (nearest) destination values of the valid samples of the given sampled row;
+	// all buffers have room for sampleWidth() values; returns the number of values stored
+	int gatherRow( int sampleRow, int *xInt, int *yInt, unsigned char *srcValues, unsigned char *destValues ) const;
+
+private:
+
+	// the range of samples of a row that map inside the destination view (a single range since the transformation is affine)
+	void validRange( const int *xInt, const int *yInt, int &begin, int &end ) const;
+
+	// the mask value (true to use the sample) for sample i of the row, at the given destination position
+	inline bool maskValue( const unsigned char *srcMaskRow, int i, int xDest, int yDest ) const {
+		return (srcMaskRow == NULL || srcMaskRow[ i * m_step ]) && (m_destMask == NULL || m_destMask->data( xDest, yDest ));
+	}
+
+	// the evaluation parameters
+	const double *m_params;
+	const ImageViewGrayU &m_src;
+	const ImageViewGrayU &m_dest;
+	int m_step;
+	const ImageViewGrayU *m_srcMask;
+	const ImageViewGrayU *m_destMask;
+	bool m_interp;
+	int m_sampleWidth;
+	int m_sampleHeight;
+};
+
+
+// the range of samples of a row that map inside the destination view
+void RegistrationKernel::validRange( const int *xInt, const int *yInt, int &begin, int &end ) const {
+	int xMax = m_dest.width() - 1, yMax = m_dest.height() - 1;
+	begin = 0;
+	end = m_sampleWidth;
+	while (begin < end && (xInt[ begin ] < 0 || xInt[ begin ] > xMax || yInt[ begin ] < 0 || yInt[ begin ] > yMax))
+		begin++;
+	while (end > begin && (xInt[ end - 1 ] < 0 || xInt[ end - 1 ] > xMax || yInt[ end - 1 ] < 0 || yInt[ end - 1 ] > yMax))
+		end--;
+}
+
+
+// add the absolute differences and the number of valid samples for the given sampled row
+void RegistrationKernel::evalRow( int sampleRow, int *xInt, int *yInt, long long &sum, long long &count ) const {
+	const double *p = m_params;
+	int y = sampleRow * m_step;
+
+	// compute nearest destination positions (stepping along the row)
+	float xStart = (float) (p[ 0 ] + p[ 4 ] * y), yStart = (float) (p[ 1 ] + p[ 5 ] * y);
+	float xStep = (float) (p[ 2 ] * m_step), yStep = (float) (p[ 3 ] * m_step);
+	nearestPositions( xStart, xStep, xInt, m_sampleWidth );
+	nearestPositions( yStart, yStep, yInt, m_sampleWidth );
+	int begin = 0, end = 0;
+	validRange( xInt, yInt, begin, end );
+	const unsigned char *srcRow = m_src.row( y );
+	const unsigned char *srcMaskRow = m_srcMask ? m_srcMask->row( y ) : NULL;
+	bool masked = m_srcMask || m_destMask;
+
+	// if interpolating, compare samples one at a time, using bilinear interpolation with 8-bit fixed-point weights
+	// (positions are clamped to the destination, since a position that rounds to a valid pixel may be up to half a pixel outside);
+	// the differences have 16 fractional bits
+	if (m_interp) {
+		const unsigned char *destData = m_dest.row( 0 );
+		int destRowBytes = m_dest.rowBytes();
+		int xIntMax = m_dest.width() - 2, yIntMax = m_dest.height() - 2;
+		float xLimit = (float) (m_dest.width() - 1), yLimit = (float) (m_dest.height() - 1);
+		for (int i = begin; i < end; i++) {
+			if (masked == false || maskValue( srcMaskRow, i, xInt[ i ], yInt[ i ] )) {
+				float x = bound( xStart + xStep * (float) i, 0.0f, xLimit ), y = bound( yStart + yStep * (float) i, 0.0f, yLimit );
+				int xFloor = min( (int) x, xIntMax ), yFloor = min( (int) y, yIntMax );
+				int xWeight = (int) ((x - xFloor) * 256.0f + 0.5f), yWeight = (int) ((y - yFloor) * 256.0f + 0.5f);
+				const unsigned char *p0 = destData + yFloor * destRowBytes + xFloor, *p1 = p0 + destRowBytes;
+				int top = (p0[ 0 ] << 8) + (p0[ 1 ] - p0[ 0 ]) * xWeight;
+				int bottom = (p1[ 0 ] << 8) + (p1[ 1 ] - p1[ 0 ]) * xWeight;
+				sum += abs( (srcRow[ i * m_step ] << 16) - ((top << 8) + (bottom - top) * yWeight) );
+				count++;
 			}
 		}
+		return;
+	}
+
+	// compare chunks of samples; if the destination positions are a contiguous span (e.g. for translations), they are read directly
+	int i = begin;
+#ifdef __SSE2__
+	bool contiguous = (xStep == 1 && yStep == 0);
+	unsigned char srcBuf[ REGISTER_CHUNK ], destBuf[ REGISTER_CHUNK ], maskBuf[ REGISTER_CHUNK ];
+	__m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8( 1 );
+	__m128i sumVec = zero, countVec = zero;
+	for (; i + REGISTER_CHUNK <= end; i += REGISTER_CHUNK) {
+		const unsigned char *srcPtr = srcRow + i;
+		if (m_step > 1) {
+			for (int j = 0; j < REGISTER_CHUNK; j++)
+				srcBuf[ j ] = srcRow[ (i + j) * m_step ];
+			srcPtr = srcBuf;
+		}
+		const unsigned char *destPtr = m_dest.row( yInt[ i ] ) + xInt[ i ];
+		if (contiguous == false) {
+			for (int j = 0; j < REGISTER_CHUNK; j++)
+				destBuf[ j ] = m_dest.row( yInt[ i + j ] )[ xInt[ i + j ] ];
+			destPtr = destBuf;
+		}
+		__m128i a = _mm_loadu_si128( (const __m128i *) srcPtr ), b = _mm_loadu_si128( (const __m128i *) destPtr );
+		__m128i diff = _mm_or_si128( _mm_subs_epu8( a, b ), _mm_subs_epu8( b, a ) );
+		if (masked) {
+			for (int j = 0; j < REGISTER_CHUNK; j++)
+				maskBuf[ j ] = maskValue( srcMaskRow, i + j, xInt[ i + j ], yInt[ i + j ] ) ? 255 : 0;
+			__m128i mask = _mm_loadu_si128( (const __m128i *) maskBuf );
+			diff = _mm_and_si128( diff, mask );
+			countVec = _mm_add_epi64( countVec, _mm_sad_epu8( _mm_and_si128( mask, one ), zero ) );
+		} else {
+			count += REGISTER_CHUNK;
+		}
+		sumVec = _mm_add_epi64( sumVec, _mm_sad_epu8( diff, zero ) );
+	}
+	sumVec = _mm_add_epi64( sumVec, _mm_srli_si128( sumVec, 8 ) );
+	countVec = _mm_add_epi64( countVec, _mm_srli_si128( countVec, 8 ) );
+	sum += _mm_cvtsi128_si32( sumVec );
+	count += _mm_cvtsi128_si32( countVec );
+#endif
+
+	// compare remaining samples
+	for (; i < end; i++) {
+		if (masked == false || maskValue( srcMaskRow, i, xInt[ i ], yInt[ i ] )) {
+			sum += abs( srcRow[ i * m_step ] - m_dest.data( xInt[ i ], yInt[ i ] ) );
+			count++;
+		}
+	}
+}
+
+
+// store the source values and (nearest) destination values of the valid samples of the given sampled row
+int RegistrationKernel::gatherRow( int sampleRow, int *xInt, int *yInt, unsigned char *srcValues, unsigned char *destValues ) const {
+	const double *p = m_params;
+	int y = sampleRow * m_step;
+	nearestPositions( (float) (p[ 0 ] + p[ 4 ] * y), (float) (p[ 2 ] * m_step), xInt, m_sampleWidth );
+	nearestPositions( (float) (p[ 1 ] + p[ 5 ] * y), (float) (p[ 3 ] * m_step), yInt, m_sampleWidth );
+	int begin = 0, end = 0;
+	validRange( xInt, yInt, begin, end );
+	const unsigned char *srcRow = m_src.row( y );
+	const unsigned char *srcMaskRow = m_srcMask ? m_srcMask->row( y ) : NULL;
+	bool masked = m_srcMask || m_destMask;
+	int count = 0;
+	for (int i = begin; i < end; i++) {
+		if (masked == false || maskValue( srcMaskRow, i, xInt[ i ], yInt[ i ] )) {
+			srcValues[ count ] = srcRow[ i * m_step ];
+			destValues[ count ] = m_dest.data( xInt[ i ], yInt[ i ] );
+			count++;
+		}
 	}
+	return count;
+}
+
+
+//-------------------------------------------
+// TRANSFORM EVALUATION
+//-------------------------------------------
+
+
+// convert a transformation of full images to a transformation of the views inside the given border (of both images)
+aptr<ImageTransform> innerTransform( const ImageTransform &transform, int xBorder, int yBorder ) {
+	VectorF params( transform.paramCount() );
+	for (int i = 0; i < params.length(); i++)
+		params[ i ] = transform.param( i );
+	if (params.length() == 6) {
+		params[ 0 ] += params[ 2 ] * xBorder + params[ 4 ] * yBorder - xBorder;
+		params[ 1 ] += params[ 3 ] * xBorder + params[ 5 ] * yBorder - yBorder;
+	}
+	return aptr<ImageTransform>( new ImageTransform( params ) );
+}
+
+
+/// computes the mean-abs image difference given an image transformation;
+/// a step value greater than one allows faster (less accurate) optimization by ignoring some pixels;
+/// the xBorder and yBorder specify areas to be ignored for the objective function
+double evalImageTransform( const ImageTransform &transform, const ImageGrayU &src, const ImageGrayU &dest, int step, int xBorder, int yBorder, const ImageGrayU *srcMask, const ImageGrayU *destMask, bool interp, bool verbose, double abortValue ) {
+
+	// the transform maps full-image coordinates; convert it to map inner-view coordinates (note that we're using border on both source and dest)
+	aptr<ImageTransform> inner = innerTransform( transform, xBorder, yBorder );
+
+	// evaluate on views inside the border
+	ImageViewGrayU srcView = imageView( src ).inner( xBorder, yBorder );
+	ImageViewGrayU destView = imageView( dest ).inner( xBorder, yBorder );
+	if (srcMask == NULL && destMask == NULL)
+		return evalImageTransform( *inner, srcView, destView, step, NULL, NULL, interp, verbose, abortValue );
+	ImageViewGrayU srcMaskView = imageView( srcMask ? *srcMask : src ).inner( xBorder, yBorder );
+	ImageViewGrayU destMaskView = imageView( destMask ? *destMask : dest ).inner( xBorder, yBorder );
+	return evalImageTransform( *inner, srcView, destView, step, srcMask ? &srcMaskView : NULL, destMask ? &destMaskView : NULL, interp, verbose, abortValue );
+}
+
+
+/// computes the mean-abs image difference given a transformation from source view coordinates to destination view coordinates
+double evalImageTransform( const ImageTransform &transform, const ImageViewGrayU &src, const ImageViewGrayU &dest, int step, const ImageViewGrayU *srcMask, const ImageViewGrayU *destMask, bool interp, bool verbose, double abortValue ) {
+	assertAlways( step >= 1 );
+	RegistrationKernel kernel( transform.affineParams(), src, dest, step, srcMask, destMask, interp );
+
+	// the mean can't be less than the sum divided by the number of samples, so we can stop once the sum exceeds this limit
+	double maxCount = (double) kernel.sampleWidth() * (double) kernel.sampleHeight();
+	double sumLimit = abortValue * maxCount / kernel.sumScale();
+	std::atomic<long long> sumDiff( 0 ), count( 0 );
+	std::atomic<bool> aborted( false );
+	parallelFor( 0, kernel.sampleHeight(), 4, [&]( int rowBegin, int rowEnd ) {
+		VectorI xInt( kernel.sampleWidth() ), yInt( kernel.sampleWidth() );
+		for (int row = rowBegin; row < rowEnd && aborted.load( std::memory_order_relaxed ) == false; row++) {
+			long long rowSum = 0, rowCount = 0;
+			kernel.evalRow( row, xInt.dataPtr(), yInt.dataPtr(), rowSum, rowCount );
+			count += rowCount;
+			if ((double) (sumDiff += rowSum) > sumLimit)
+				aborted = true;
+		}
+	} );
+	double sum = (double) sumDiff * kernel.sumScale();
 	if (verbose)
-		disp( 1, "count: %d, sumDiff: %f", count, sumDiff );
-	return count ? sumDiff / count : 1000;
+		disp( 1, "count: %lld, sumDiff: %f%s", count.load(), sum, aborted ? " (aborted)" : "" );
+	if (aborted)
+		return max( sum / maxCount, abortValue );
+	return count ? sum / (double) count : 1000;
+}
+
+
+/// computes the mutual information between the source view and the destination view (sampled at the nearest transformed positions);
+/// the rows are split across the worker threads, each filling its own joint histogram
+double evalImageTransformMutualInfo( const ImageTransform &transform, const ImageViewGrayU &src, const ImageViewGrayU &dest, int step, int bucketCount, bool parzen, const ImageViewGrayU *srcMask, const ImageViewGrayU *destMask ) {
+	assertAlways( step >= 1 );
+	RegistrationKernel kernel( transform.affineParams(), src, dest, step, srcMask, destMask, false );
+	JointHistogram histogram( bucketCount, parzen );
+	std::mutex mergeMutex;
+	parallelFor( 0, kernel.sampleHeight(), 4, [&]( int rowBegin, int rowEnd ) {
+		int sampleWidth = kernel.sampleWidth();
+		VectorI xInt( sampleWidth ), yInt( sampleWidth );
+		VectorU srcValues( sampleWidth ), destValues( sampleWidth );
+		JointHistogram rangeHistogram( bucketCount, parzen );
+		for (int row = rowBegin; row < rowEnd; row++) {
+			int count = kernel.gatherRow( row, xInt.dataPtr(), yInt.dataPtr(), srcValues.dataPtr(), destValues.dataPtr() );
+			rangeHistogram.add( srcValues.dataPtr(), destValues.dataPtr(), count );
+		}
+		std::lock_guard<std::mutex> lock( mergeMutex );
+		histogram.merge( rangeHistogram );
+	} );
+	return histogram.mutualInfo();
 }
 
 
+/// computes the mutual information between the images given an image transformation, ignoring the given border
+double evalImageTransformMutualInfo( const ImageTransform &transform, const ImageGrayU &src, const ImageGrayU &dest, int step, int bucketCount, bool parzen, int xBorder, int yBorder, const ImageGrayU *srcMask, const ImageGrayU *destMask ) {
+	aptr<ImageTransform> inner = innerTransform( transform, xBorder, yBorder );
+	ImageViewGrayU srcView = imageView( src ).inner( xBorder, yBorder );
+	ImageViewGrayU destView = imageView( dest ).inner( xBorder, yBorder );
+	ImageViewGrayU srcMaskView = imageView( srcMask ? *srcMask : src ).inner( xBorder, yBorder );
+	ImageViewGrayU destMaskView = imageView( destMask ? *destMask : dest ).inner( xBorder, yBorder );
+	return evalImageTransformMutualInfo( *inner, srcView, destView, step, bucketCount, parzen, srcMask ? &srcMaskView : NULL, destMask ? &destMaskView : NULL );
+}
+
+
+//-------------------------------------------
+// IMAGE REGISTRATION
+//-------------------------------------------
+
+
 /// The RegistrationObjective class represents an image registration objective function.
 class RegistrationObjective : public Objective {
 public:
@@ -71,6 +361,13 @@ public:
 		return evalImageTransform( transform, m_src, m_dest, m_step, m_xBorder, m_yBorder, m_srcMask, m_destMask, m_interp, m_verbose );
 	}
 
+	/// evaluate objective function at given point, stopping early once the value is known to be at least abortValue
+	double evalBounded( const VectorD &point, double abortValue ) {
+		VectorF transformParams = toFloat( point );
+		ImageTransform transform( transformParams );
+		return evalImageTransform( transform, m_src, m_dest, m_step, m_xBorder, m_yBorder, m_srcMask, m_destMask, m_interp, m_verbose, abortValue );
+	}
+
 	// enable diagnostic display
 	inline void setVerbose() { m_verbose = true; }
 
@@ -89,15 +386,48 @@ private:
 };
 
 
-/// registers a pair of images using to minimize mean-abs difference;
-/// a step value greater than one allows faster (less accurate) optimization by ignoring some pixels;
-/// the xBorder and yBorder specify areas to be ignored for the objective function;
-/// the offsetBound value specifies the largest allowed translation between the images
-aptr<ImageTransform> registerUsingImageTransform( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, int step, int xBorder, int yBorder, float offsetBound, const ImageTransform *initTransform, const ImageGrayU *srcMask, const ImageGrayU *destMask, bool interp ) {
-	assertAlways( transformParamCount == 2 || transformParamCount == 6 );
+/// The MutualInfoObjective class represents an image registration objective function that maximizes mutual information.
+class MutualInfoObjective : public Objective {
+public:
 
-	// prepare objective function
-	RegistrationObjective obj( src, dest, step, xBorder, yBorder, srcMask, destMask, interp );
+	// basic constructor
+	MutualInfoObjective( const ImageGrayU &src, const ImageGrayU &dest, int step, int bucketCount, bool parzen, int xBorder, int yBorder, const ImageGrayU *srcMask, const ImageGrayU *destMask ) 
+				: m_src( src ), m_dest( dest ) {
+		m_step = step;
+		m_bucketCount = bucketCount;
+		m_parzen = parzen;
+		m_xBorder = xBorder;
+		m_yBorder = yBorder;
+		m_srcMask = srcMask;
+		m_destMask = destMask;
+	}
+
+	/// evaluate objective function at given point; the optimizer minimizes and uses a relative tolerance, so we return
+	/// the (non-negative) difference between the largest possible mutual info (the log of the bucket count) and the mutual info
+	double eval( const VectorD &point ) {
+		VectorF transformParams = toFloat( point );
+		ImageTransform transform( transformParams );
+		return log( (double) m_bucketCount ) - evalImageTransformMutualInfo( transform, m_src, m_dest, m_step, m_bucketCount, m_parzen, m_xBorder, m_yBorder, m_srcMask, m_destMask );
+	}
+
+private:
+
+	// internal data
+	const ImageGrayU &m_src;
+	const ImageGrayU &m_dest;
+	int m_step;
+	int m_bucketCount;
+	bool m_parzen;
+	int m_xBorder;
+	int m_yBorder;
+	const ImageGrayU *m_srcMask;
+	const ImageGrayU *m_destMask;
+};
+
+
+// find the transformation that minimizes the objective, starting from the initial transform (or the identity)
+aptr<ImageTransform> optimizeTransform( Objective &obj, int transformParamCount, float offsetBound, const ImageTransform *initTransform ) {
+	assertAlways( transformParamCount == 2 || transformParamCount == 6 );
 
 	// determine starting point
 	VectorD start( transformParamCount );
@@ -145,4 +475,333 @@ aptr<ImageTransform> registerUsingImageTransform( const ImageGrayU &src, const I
 }
 
 
+/// registers a pair of images using to minimize mean-abs difference;
+/// a step value greater than one allows faster (less accurate) optimization by ignoring some pixels;
+/// the xBorder and yBorder specify areas to be ignored for the objective function;
+/// the offsetBound value specifies the largest allowed translation between the images
+aptr<ImageTransform> registerUsingImageTransform( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, int step, int xBorder, int yBorder, float offsetBound, const ImageTransform *initTransform, const ImageGrayU *srcMask, const ImageGrayU *destMask, bool interp ) {
+	RegistrationObjective obj( src, dest, step, xBorder, yBorder, srcMask, destMask, interp );
+	return optimizeTransform( obj, transformParamCount, offsetBound, initTransform );
+}
+
+
+/// registers a pair of images to maximize mutual information (which allows the images to have different intensity mappings)
+aptr<ImageTransform> registerUsingMutualInfo( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, int step, int xBorder, int yBorder, float offsetBound, int bucketCount, bool parzen, const ImageTransform *initTransform, const ImageGrayU *srcMask, const ImageGrayU *destMask ) {
+	MutualInfoObjective obj( src, dest, step, bucketCount, parzen, xBorder, yBorder, srcMask, destMask );
+	return optimizeTransform( obj, transformParamCount, offsetBound, initTransform );
+}
+
+
+// subsample a mask by a factor of two, keeping the even rows and columns
+aptr<ImageGrayU> decimateMask( const ImageGrayU &input ) {
+	int width = (input.width() + 1) / 2, height = (input.height() + 1) / 2;
+	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
+	for (int y = 0; y < height; y++) {
+		const unsigned char *in = input.row( y * 2 );
+		unsigned char *out = output->row( y );
+		for (int x = 0; x < width; x++)
+			out[ x ] = in[ x * 2 ];
+	}
+	return output;
+}
+
+
+// convert a transformation between pyramid levels, where a level pixel (x, y) is at (x * scale, y * scale) in the other level
+aptr<ImageTransform> scaleTransform( const ImageTransform &transform, float scale ) {
+	VectorF params( transform.paramCount() );
+	for (int i = 0; i < params.length(); i++)
+		params[ i ] = transform.param( i );
+	params[ 0 ] /= scale;
+	params[ 1 ] /= scale;
+	return aptr<ImageTransform>( new ImageTransform( params ) );
+}
+
+
+/// registers a pair of images using a coarse-to-fine search over Gaussian pyramids (each level half the size of the previous);
+/// the transformation is estimated at the coarsest level (steps.length() - 1) and then refined at each finer level, down to level 0 (full resolution);
+/// steps[ i ] and offsetBounds[ i ] give the step and the offset bound (in level i pixels) used at level i;
+/// the border sizes are given in full-resolution pixels; levels other than level 0 are always compared using interpolation;
+/// if the command is cancelled, the finer levels are skipped
+aptr<ImageTransform> registerUsingImageTransformPyramid( const ImageGrayU &src, const ImageGrayU &dest, int transformParamCount, const VectorI &steps, const VectorF &offsetBounds, 
+														  int xBorder, int yBorder, const ImageTransform *initTransform, const ImageGrayU *srcMask, const ImageGrayU *destMask, bool interp ) {
+	ImagePyramidGrayU srcPyramid( src ), destPyramid( dest );
+	return registerUsingImageTransformPyramid( srcPyramid, destPyramid, transformParamCount, steps, offsetBounds, xBorder, yBorder, initTransform, srcMask, destMask, interp );
+}
+
+
+/// registers a pair of images using a coarse-to-fine search over existing pyramids (e.g. from an ImagePyramidCache)
+aptr<ImageTransform> registerUsingImageTransformPyramid( ImagePyramidGrayU &src, ImagePyramidGrayU &dest, int transformParamCount, const VectorI &steps, const VectorF &offsetBounds, 
+														  int xBorder, int yBorder, const ImageTransform *initTransform, const ImageGrayU *srcMask, const ImageGrayU *destMask, bool interp ) {
+	int levelCount = steps.length();
+	assertAlways( levelCount >= 1 && offsetBounds.length() == levelCount );
+	assertAlways( levelCount <= src.levelCount() && levelCount <= dest.levelCount() );
+
+	// subsample the masks (without blurring, so that masked pixels stay masked)
+	Array<ImageGrayU> srcMaskLevels, destMaskLevels;
+	for (int level = 1; level < levelCount; level++) {
+		if (srcMask)
+			srcMaskLevels.append( decimateMask( level > 1 ? srcMaskLevels[ level - 2 ] : *srcMask ).release() );
+		if (destMask)
+			destMaskLevels.append( decimateMask( level > 1 ? destMaskLevels[ level - 2 ] : *destMask ).release() );
+	}
+
+	// start with the initial transform or the identity transform (in full-resolution coordinates)
+	aptr<ImageTransform> transform;
+	if (initTransform) {
+		assertAlways( initTransform->paramCount() == transformParamCount );
+		transform = scaleTransform( *initTransform, 1 );
+	} else {
+		VectorF params( transformParamCount );
+		params.clear( 0 );
+		if (transformParamCount == 6) {
+			params[ 2 ] = 1;
+			params[ 5 ] = 1;
+		}
+		transform.reset( new ImageTransform( params ) );
+	}
+
+	// solve at each level, starting with the coarsest; the coarser levels are compared using interpolation,
+	// so that refinements smaller than a pixel change the objective; if the command is cancelled, we return the estimate from the last level solved
+	for (int level = levelCount - 1; level >= 0 && commandCancelled() == false; level--) {
+		float scale = (float) (1 << level);
+		const ImageGrayU &levelSrc = src.level( level );
+		const ImageGrayU &levelDest = dest.level( level );
+		const ImageGrayU *levelSrcMask = srcMask ? (level ? &srcMaskLevels[ level - 1 ] : srcMask) : NULL;
+		const ImageGrayU *levelDestMask = destMask ? (level ? &destMaskLevels[ level - 1 ] : destMask) : NULL;
+		int levelXBorder = (xBorder + (1 << level) - 1) >> level;
+		int levelYBorder = (yBorder + (1 << level) - 1) >> level;
+		aptr<ImageTransform> levelInit = scaleTransform( *transform, scale );
+		aptr<ImageTransform> levelTransform = registerUsingImageTransform( levelSrc, levelDest, transformParamCount, steps[ level ], levelXBorder, levelYBorder, offsetBounds[ level ],
+																		   levelInit.get(), levelSrcMask, levelDestMask, level ? true : interp );
+		transform = scaleTransform( *levelTransform, 1.0f / scale );
+	}
+	return transform;
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// a direct (per-pixel) version of the evaluation kernel, used for testing and benchmarking
+double evalImageTransformDirect( const ImageTransform &transform, const ImageViewGrayU &src, const ImageViewGrayU &dest, int step, const ImageViewGrayU *srcMask, const ImageViewGrayU *destMask, bool interp ) {
+	int xDestMax = dest.width() - 1;
+	int yDestMax = dest.height() - 1;
+	double sumDiff = 0;
+	long long count = 0;
+	for (int y = 0; y < src.height(); y += step) {
+		for (int x = 0; x < src.width(); x += step) {
+			if (srcMask == NULL || srcMask->data( x, y )) {
+				float xDest = transform.xTransform( (float) x, (float) y );
+				float yDest = transform.yTransform( (float) x, (float) y );
+				int xDestInt = (int) floorf( xDest + 0.5f );
+				int yDestInt = (int) floorf( yDest + 0.5f );
+				if (xDestInt >= 0 && xDestInt <= xDestMax && yDestInt >= 0 && yDestInt <= yDestMax && (destMask == NULL || destMask->data( xDestInt, yDestInt ))) {
+					if (interp)
+						sumDiff += fabs( src.data( x, y ) - dest.interp( bound( xDest, 0.0f, (float) xDestMax ), bound( yDest, 0.0f, (float) yDestMax ) ) );
+					else
+						sumDiff += abs( src.data( x, y ) - dest.data( xDestInt, yDestInt ) );
+					count++;
+				}
+			}
+		}
+	}
+	return count ? sumDiff / (double) count : 1000;
+}
+
+
+// create a random test image with structure at several scales
+aptr<ImageGrayU> registrationTestImage( int width, int height ) {
+	ImageGrayF sum( width, height );
+	sum.clear( 0 );
+	for (int scale = 2; scale <= 64; scale *= 2) {
+		ImageGrayF noise( width / scale + 2, height / scale + 2 );
+		for (int y = 0; y < noise.height(); y++)
+			for (int x = 0; x < noise.width(); x++)
+				noise.data( x, y ) = randomFloat( -1, 1 );
+		aptr<ImageGrayF> smooth = resize( noise, width, height, true );
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				sum.data( x, y ) += smooth->data( x, y );
+	}
+	aptr<ImageGrayU> img( new ImageGrayU( width, height ) );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			img->data( x, y ) = (unsigned char) bound( 128.0f + 40.0f * sum.data( x, y ), 0.0f, 255.0f );
+	return img;
+}
+
+
+// check the evaluation kernel against the direct version
+bool testImageRegister() {
+	int width = 67, height = 41;
+	aptr<ImageGrayU> src = registrationTestImage( width, height );
+	aptr<ImageGrayU> dest = registrationTestImage( width, height );
+	ImageGrayU srcMask( width, height ), destMask( width, height );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			srcMask.data( x, y ) = (x + y) % 3 ? 255 : 0;
+			destMask.data( x, y ) = (x * y) % 5 ? 1 : 0;
+		}
+	}
+	ImageViewGrayU srcView = imageView( *src ), destView = imageView( *dest );
+	ImageViewGrayU srcMaskView = imageView( srcMask ), destMaskView = imageView( destMask );
+
+	// use parameters that are exact in single precision, so that the kernel and direct versions round positions the same way
+	VectorF affine( 6 );
+	affine[ 0 ] = 3.25f;
+	affine[ 1 ] = -2.5f;
+	affine[ 2 ] = 1.125f;
+	affine[ 3 ] = 0.0625f;
+	affine[ 4 ] = -0.0625f;
+	affine[ 5 ] = 0.875f;
+	ImageTransform translation( 4.75f, -3.5f ), affineTransform( affine );
+	for (int t = 0; t < 2; t++) {
+		const ImageTransform &transform = t ? affineTransform : translation;
+		for (int step = 1; step <= 3; step++) {
+			for (int masks = 0; masks < 4; masks++) {
+				const ImageViewGrayU *sm = (masks & 1) ? &srcMaskView : NULL;
+				const ImageViewGrayU *dm = (masks & 2) ? &destMaskView : NULL;
+				double value = evalImageTransform( transform, srcView, destView, step, sm, dm );
+				unitAssert( value == evalImageTransformDirect( transform, srcView, destView, step, sm, dm, false ) );
+				double interpValue = evalImageTransform( transform, srcView, destView, step, sm, dm, true );
+				unitAssert( fabs( interpValue - evalImageTransformDirect( transform, srcView, destView, step, sm, dm, true ) ) < 0.05 );
+
+				// stopping early gives a value that is at least the abort value; otherwise the result is unchanged
+				unitAssert( evalImageTransform( transform, srcView, destView, step, sm, dm, false, false, value * 0.5 ) >= value * 0.5 );
+				unitAssert( evalImageTransform( transform, srcView, destView, step, sm, dm, false, false, value * 2.0 ) == value );
+			}
+		}
+	}
+
+	// a transformation that maps everything outside the destination
+	ImageTransform outside( 1000, 0 );
+	unitAssert( evalImageTransform( outside, srcView, destView, 1 ) == 1000 );
+
+	// coarse-to-fine registration of a shifted image
+	aptr<ImageGrayU> large = registrationTestImage( 240, 160 );
+	ImageTransform shift( 7.3f, -5.6f );
+	aptr<ImageGrayU> shifted = shift.mapForward( *large, 240, 160, 0 );
+	VectorI steps( 3 );
+	steps.clear( 1 );
+	VectorF offsetBounds( 3 );
+	offsetBounds.clear( 1.5f );
+	offsetBounds[ 2 ] = 4.0f;
+	aptr<ImageTransform> result = registerUsingImageTransformPyramid( *large, *shifted, 2, steps, offsetBounds, 16, 16 );
+	unitAssert( fabs( result->xOffset() - 7.3f ) < 0.5f && fabs( result->yOffset() + 5.6f ) < 0.5f );
+
+	// mutual info of the identity transformation should match mutualInfo
+	ImageTransform identity( 0.0f, 0.0f );
+	unitAssert( fabs( evalImageTransformMutualInfo( identity, srcView, destView, 1, 32, false ) - mutualInfo( srcView, destView, 32 ) ) < 1e-5 );
+
+	// mutual info registration of a shifted image with inverted intensities
+	aptr<ImageGrayU> inverted( new ImageGrayU( 240, 160 ) );
+	for (int y = 0; y < 160; y++)
+		for (int x = 0; x < 240; x++)
+			inverted->data( x, y ) = 255 - shifted->data( x, y );
+	result = registerUsingMutualInfo( *large, *inverted, 2, 1, 16, 16, 10.0f, 32, true );
+	unitAssert( fabs( result->xOffset() - 7.3f ) < 1.0f && fabs( result->yOffset() + 5.6f ) < 1.0f );
+	return true;
+}
+
+
+// time the evaluation kernel (and the direct version) on a pair of frames
+void benchmarkRegister( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 20 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, threads: %d", width, height, threadCount() );
+
+	// create a test image and a shifted copy
+	aptr<ImageGrayU> src = registrationTestImage( width, height );
+	ImageTransform shift( 3.3f, -2.2f );
+	aptr<ImageGrayU> dest = shift.mapForward( *src, width, height, 0 );
+	VectorF affine( 6 );
+	affine[ 0 ] = 3.3f;
+	affine[ 1 ] = -2.2f;
+	affine[ 2 ] = 1.01f;
+	affine[ 3 ] = 0.02f;
+	affine[ 4 ] = -0.02f;
+	affine[ 5 ] = 0.99f;
+	ImageTransform affineTransform( affine );
+	ImageViewGrayU srcView = imageView( *src ).inner( 10, 10 ), destView = imageView( *dest ).inner( 10, 10 );
+
+	// time evaluations
+	for (int i = 0; i < 8; i++) {
+		const ImageTransform &transform = (i & 1) ? affineTransform : shift;
+		int step = (i & 2) ? 2 : 1;
+		bool direct = (i & 4) ? true : false;
+		Timer timer;
+		timer.start();
+		double value = 0;
+		for (int j = 0; j < iterations; j++) {
+			if (direct)
+				value += evalImageTransformDirect( transform, srcView, destView, step, NULL, NULL, false );
+			else
+				value += evalImageTransform( transform, srcView, destView, step );
+		}
+		timer.stop();
+		disp( 1, "%-6s %d params, step %d: %8.1f evals/sec (mean diff: %.3f)", direct ? "direct" : "kernel", transform.paramCount(), step, iterations / timer.timeSum(), value / iterations );
+	}
+
+	// time mutual info evaluations
+	for (int parzen = 0; parzen < 2; parzen++) {
+		Timer timer( true );
+		double value = 0;
+		for (int j = 0; j < iterations; j++)
+			value += evalImageTransformMutualInfo( affineTransform, srcView, destView, 2, 32, parzen ? true : false );
+		timer.stop();
+		disp( 1, "mutual info (%s), 6 params, step 2: %8.1f evals/sec (mutual info: %.3f)", parzen ? "Parzen" : "hard", iterations / timer.timeSum(), value / iterations );
+	}
+
+	// compare single-level and coarse-to-fine registration on synthetic shifts
+	int border = 50;
+	VectorI steps( 4 );
+	steps.clear( 1 );
+	steps[ 0 ] = 2;
+	steps[ 1 ] = 2;
+	VectorF offsetBounds( 4 );
+	offsetBounds.clear( 1.5f );
+	offsetBounds[ 3 ] = (float) border / 8.0f;
+	float shifts[][ 2 ] = { { 3.3f, -2.2f }, { 17.6f, -11.4f }, { -36.2f, 24.8f }, { 45.5f, 41.7f } };
+	for (int i = 0; i < 4; i++) {
+		ImageTransform shiftTransform( shifts[ i ][ 0 ], shifts[ i ][ 1 ] );
+		aptr<ImageGrayU> shifted = shiftTransform.mapForward( *src, width, height, 0 );
+		for (int mode = 0; mode < 3; mode++) {
+			Timer timer;
+			timer.start();
+			aptr<ImageTransform> result;
+			if (mode == 2)
+				result = registerUsingImageTransformPyramid( *src, *shifted, 2, steps, offsetBounds, border, border );
+			else
+				result = registerUsingImageTransform( *src, *shifted, 2, 2, border, border, (float) border, NULL, NULL, NULL, mode == 1 );
+			timer.stop();
+			float xError = result->xOffset() - shifts[ i ][ 0 ], yError = result->yOffset() - shifts[ i ][ 1 ];
+			float error = sqrtf( xError * xError + yError * yError );
+			disp( 1, "shift (%5.1f, %5.1f) %-13s %7.3f sec, result (%6.2f, %6.2f), error %.2f", shifts[ i ][ 0 ], shifts[ i ][ 1 ], 
+				  mode == 2 ? "pyramid:" : (mode == 1 ? "interp:" : "nearest:"), timer.timeSum(), result->xOffset(), result->yOffset(), error );
+		}
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initImageRegister() {
+	registerUnitTest( testImageRegister );
+	registerCommand( "benchregister", benchmarkRegister );
+}
+
+
 } // end namespace sbl
@@ -0,0 +1,472 @@
+#include <sbl/image/ImageRemap.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <sbl/image/ImageUtil.h> // for test and benchmark
+#include <sbl/image/ImageTransform.h> // for test and benchmark
+#include <sbl/image/MotionField.h> // for test and benchmark
+#include <math.h>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// SAMPLE POSITIONS
+//-------------------------------------------
+
+
+// the size of the output tiles processed by each worker thread
+#define REMAP_TILE_WIDTH 256
+#define REMAP_TILE_HEIGHT 16
+
+
+// compute out[ i ] = start + step * i
+void linearPositions( float start, float step, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 v = _mm_add_ps( _mm_set1_ps( start ), _mm_mul_ps( _mm_set1_ps( step ), _mm_set_ps( 3, 2, 1, 0 ) ) );
+	__m128 step4 = _mm_set1_ps( step * 4 );
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps( out + i, v );
+		v = _mm_add_ps( v, step4 );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = start + step * i;
+}
+
+
+// compute out[ i ] = start + step * i + frac * offset[ i ]
+void displacedPositions( float start, float step, const float *offset, float frac, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 v = _mm_add_ps( _mm_set1_ps( start ), _mm_mul_ps( _mm_set1_ps( step ), _mm_set_ps( 3, 2, 1, 0 ) ) );
+	__m128 step4 = _mm_set1_ps( step * 4 ), f = _mm_set1_ps( frac );
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps( out + i, _mm_add_ps( v, _mm_mul_ps( f, _mm_loadu_ps( offset + i ) ) ) );
+		v = _mm_add_ps( v, step4 );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = start + step * i + frac * offset[ i ];
+}
+
+
+/// The RemapCoords class holds the sample positions of one span (one row of an output tile), split into the integer
+/// position of the top-left neighbor and the fractional offset from it; the values are only meaningful for interior positions.
+class RemapCoords {
+public:
+
+	// split positions; the integer part is clamped to [0, xMax] and [0, yMax] (the last interior column and row)
+	void split( const float *xs, const float *ys, int count, int xMax, int yMax ) {
+		int i = 0;
+#ifdef __SSE2__
+		__m128 xMaxF = _mm_set1_ps( (float) xMax ), yMaxF = _mm_set1_ps( (float) yMax ), zero = _mm_setzero_ps(), one = _mm_set1_ps( 1.0f );
+		__m128 scale = _mm_set1_ps( 2048.0f );
+		for (; i + 4 <= count; i += 4) {
+			__m128 x = _mm_loadu_ps( xs + i ), y = _mm_loadu_ps( ys + i );
+			__m128i xInt = _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( x, zero ), xMaxF ) );
+			__m128i yInt = _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( y, zero ), yMaxF ) );
+			__m128 xFrac = _mm_min_ps( _mm_max_ps( _mm_sub_ps( x, _mm_cvtepi32_ps( xInt ) ), zero ), one );
+			__m128 yFrac = _mm_min_ps( _mm_max_ps( _mm_sub_ps( y, _mm_cvtepi32_ps( yInt ) ), zero ), one );
+			_mm_storeu_si128( (__m128i *) (m_xInt + i), xInt );
+			_mm_storeu_si128( (__m128i *) (m_yInt + i), yInt );
+			_mm_storeu_ps( m_xFrac + i, xFrac );
+			_mm_storeu_ps( m_yFrac + i, yFrac );
+			_mm_storeu_si128( (__m128i *) (m_xWeight + i), _mm_cvtps_epi32( _mm_mul_ps( xFrac, scale ) ) );
+			_mm_storeu_si128( (__m128i *) (m_yWeight + i), _mm_cvtps_epi32( _mm_mul_ps( yFrac, scale ) ) );
+		}
+#endif
+		for (; i < count; i++) {
+			m_xInt[ i ] = (int) bound( xs[ i ], 0.0f, (float) xMax );
+			m_yInt[ i ] = (int) bound( ys[ i ], 0.0f, (float) yMax );
+			m_xFrac[ i ] = bound( xs[ i ] - m_xInt[ i ], 0.0f, 1.0f );
+			m_yFrac[ i ] = bound( ys[ i ] - m_yInt[ i ], 0.0f, 1.0f );
+			m_xWeight[ i ] = (int) (m_xFrac[ i ] * 2048.0f + 0.5f);
+			m_yWeight[ i ] = (int) (m_yFrac[ i ] * 2048.0f + 0.5f);
+		}
+	}
+
+	// the integer positions
+	int m_xInt[ REMAP_TILE_WIDTH ];
+	int m_yInt[ REMAP_TILE_WIDTH ];
+
+	// the fractional offsets, as floats and as 11-bit fixed-point weights (so that weighted sums of 8-bit values fit in 32 bits)
+	float m_xFrac[ REMAP_TILE_WIDTH ];
+	float m_yFrac[ REMAP_TILE_WIDTH ];
+	int m_xWeight[ REMAP_TILE_WIDTH ];
+	int m_yWeight[ REMAP_TILE_WIDTH ];
+};
+
+
+//-------------------------------------------
+// BILINEAR SAMPLING
+//-------------------------------------------
+
+
+// convert an interpolated value to a pixel value
+inline void fromFloat( float v, float &out ) { out = v; }
+inline void fromFloat( float v, unsigned char &out ) { out = (unsigned char) (v + 0.5f); }
+inline void fromFloat( float v, unsigned short &out ) { out = (unsigned short) (v + 0.5f); }
+inline void fromFloat( float v, int &out ) { out = (int) floorf( v + 0.5f ); }
+
+
+/// The BilinearSampler class interpolates pixel values at interior positions (given by a RemapCoords object).
+template <typename T, int CHANNEL_COUNT> class BilinearSampler {
+public:
+
+	// sample position i of the coordinates
+	static inline void sample( const unsigned char *data, int rowBytes, const RemapCoords &coords, int i, T *out ) {
+		const T *p0 = (const T *) (data + (size_t) coords.m_yInt[ i ] * rowBytes) + coords.m_xInt[ i ] * CHANNEL_COUNT;
+		const T *p1 = (const T *) ((const unsigned char *) p0 + rowBytes);
+		float xFrac = coords.m_xFrac[ i ], yFrac = coords.m_yFrac[ i ];
+		for (int c = 0; c < CHANNEL_COUNT; c++) {
+			float top = p0[ c ] + xFrac * (float) (p0[ c + CHANNEL_COUNT ] - p0[ c ]);
+			float bottom = p1[ c ] + xFrac * (float) (p1[ c + CHANNEL_COUNT ] - p1[ c ]);
+			fromFloat( top + yFrac * (bottom - top), out[ c ] );
+		}
+	}
+};
+
+
+/// 8-bit images are interpolated using fixed-point weights.
+template <int CHANNEL_COUNT> class BilinearSampler<unsigned char, CHANNEL_COUNT> {
+public:
+
+	// sample position i of the coordinates
+	static inline void sample( const unsigned char *data, int rowBytes, const RemapCoords &coords, int i, unsigned char *out ) {
+		const unsigned char *p0 = data + (size_t) coords.m_yInt[ i ] * rowBytes + coords.m_xInt[ i ] * CHANNEL_COUNT;
+		const unsigned char *p1 = p0 + rowBytes;
+		int xWeight = coords.m_xWeight[ i ], yWeight = coords.m_yWeight[ i ];
+		for (int c = 0; c < CHANNEL_COUNT; c++) {
+			int top = (p0[ c ] << 11) + (p0[ c + CHANNEL_COUNT ] - p0[ c ]) * xWeight;
+			int bottom = (p1[ c ] << 11) + (p1[ c + CHANNEL_COUNT ] - p1[ c ]) * xWeight;
+			out[ c ] = (unsigned char) (((top << 11) + (bottom - top) * yWeight + (1 << 21)) >> 22);
+		}
+	}
+};
+
+
+// sample at (x, y), assuming 0 <= x <= width - 1 and 0 <= y <= height - 1 (handles the last row and column)
+template <typename T, int CHANNEL_COUNT> void sampleBorder( const ImageView<T, CHANNEL_COUNT> &input, float x, float y, T *out ) {
+	int xInt = (int) x, yInt = (int) y;
+	int xNext = min( xInt + 1, input.width() - 1 ), yNext = min( yInt + 1, input.height() - 1 );
+	float xFrac = x - xInt, yFrac = y - yInt;
+	const T *row0 = input.row( yInt ), *row1 = input.row( yNext );
+	for (int c = 0; c < CHANNEL_COUNT; c++) {
+		float top = row0[ xInt * CHANNEL_COUNT + c ] + xFrac * (float) (row0[ xNext * CHANNEL_COUNT + c ] - row0[ xInt * CHANNEL_COUNT + c ]);
+		float bottom = row1[ xInt * CHANNEL_COUNT + c ] + xFrac * (float) (row1[ xNext * CHANNEL_COUNT + c ] - row1[ xInt * CHANNEL_COUNT + c ]);
+		fromFloat( top + yFrac * (bottom - top), out[ c ] );
+	}
+}
+
+
+//-------------------------------------------
+// REMAP ENGINE
+//-------------------------------------------
+
+
+/// The RemapSpan class samples the input at a set of positions (one row of an output tile).
+template <typename T, int CHANNEL_COUNT> class RemapSpan {
+public:
+
+	// prepare to sample the given input
+	RemapSpan( const ImageView<T, CHANNEL_COUNT> &input, bool fill, T fillValue )
+		: m_input( input ), m_xMax( (float) (input.width() - 1) ), m_yMax( (float) (input.height() - 1) ), m_fill( fill ), m_fillValue( fillValue ) {}
+
+	// true if the position can be sampled without handling the last row or column
+	inline bool interior( float x, float y ) const { return x >= 0 && y >= 0 && x < m_xMax && y < m_yMax; }
+
+	// true if the position is within the input (including the last row and column)
+	inline bool inside( float x, float y ) const { return x >= 0 && y >= 0 && x <= m_xMax && y <= m_yMax; }
+
+	// sample a position that is not in the interior
+	inline void sampleExterior( float x, float y, T *out ) const {
+		if (inside( x, y )) {
+			sampleBorder( m_input, x, y, out );
+		} else if (m_fill) {
+			for (int c = 0; c < CHANNEL_COUNT; c++)
+				out[ c ] = m_fillValue;
+		}
+	}
+
+	// sample at positions (xs[ i ], ys[ i ]); if convex (as for affine maps), the interior positions are assumed to be a contiguous range,
+	// which is processed without checks
+	void run( const float *xs, const float *ys, int count, bool convex, T *out ) const {
+		RemapCoords coords;
+		coords.split( xs, ys, count, m_input.width() - 2, m_input.height() - 2 );
+
+		// local copies, so the compiler knows that writing the output does not change them
+		const unsigned char *data = (const unsigned char *) m_input.row( 0 );
+		int rowBytes = m_input.rowBytes();
+		int begin = 0, end = count;
+		if (convex) {
+			while (begin < end && interior( xs[ begin ], ys[ begin ] ) == false) {
+				sampleExterior( xs[ begin ], ys[ begin ], out + begin * CHANNEL_COUNT );
+				begin++;
+			}
+			while (end > begin && interior( xs[ end - 1 ], ys[ end - 1 ] ) == false) {
+				end--;
+				sampleExterior( xs[ end ], ys[ end ], out + end * CHANNEL_COUNT );
+			}
+			for (int i = begin; i < end; i++)
+				BilinearSampler<T, CHANNEL_COUNT>::sample( data, rowBytes, coords, i, out + i * CHANNEL_COUNT );
+		} else {
+			for (int i = 0; i < count; i++) {
+				if (interior( xs[ i ], ys[ i ] ))
+					BilinearSampler<T, CHANNEL_COUNT>::sample( data, rowBytes, coords, i, out + i * CHANNEL_COUNT );
+				else
+					sampleExterior( xs[ i ], ys[ i ], out + i * CHANNEL_COUNT );
+			}
+		}
+	}
+
+private:
+
+	// the input image and sampling parameters
+	ImageView<T, CHANNEL_COUNT> m_input;
+	float m_xMax;
+	float m_yMax;
+	bool m_fill;
+	T m_fillValue;
+};
+
+
+// call body( xMin, xEnd, y ) for each row of each output tile, on the worker threads
+template <typename F> void forEachTileRow( int width, int height, const F &body ) {
+	int xTileCount = (width + REMAP_TILE_WIDTH - 1) / REMAP_TILE_WIDTH;
+	int yTileCount = (height + REMAP_TILE_HEIGHT - 1) / REMAP_TILE_HEIGHT;
+	parallelFor( 0, xTileCount * yTileCount, 1, [&]( int tileBegin, int tileEnd ) {
+		for (int tile = tileBegin; tile < tileEnd; tile++) {
+			int xMin = (tile % xTileCount) * REMAP_TILE_WIDTH, yMin = (tile / xTileCount) * REMAP_TILE_HEIGHT;
+			int xEnd = min( xMin + REMAP_TILE_WIDTH, width ), yEnd = min( yMin + REMAP_TILE_HEIGHT, height );
+			for (int y = yMin; y < yEnd; y++)
+				body( xMin, xEnd, y );
+		}
+	} );
+}
+
+
+/// for each output pixel (x, y), sample the input at (p0 + p2 * x + p4 * y, p1 + p3 * x + p5 * y)
+template <typename T, int CHANNEL_COUNT> void remapAffine( const ImageView<T, CHANNEL_COUNT> &input, ImageView<T, CHANNEL_COUNT> output,
+														   const double *params, bool fill, T fillValue ) {
+	RemapSpan<T, CHANNEL_COUNT> span( input, fill, fillValue );
+	forEachTileRow( output.width(), output.height(), [&]( int xMin, int xEnd, int y ) {
+		float xs[ REMAP_TILE_WIDTH ], ys[ REMAP_TILE_WIDTH ];
+		linearPositions( (float) (params[ 0 ] + params[ 2 ] * xMin + params[ 4 ] * y), (float) params[ 2 ], xs, xEnd - xMin );
+		linearPositions( (float) (params[ 1 ] + params[ 3 ] * xMin + params[ 5 ] * y), (float) params[ 3 ], ys, xEnd - xMin );
+		span.run( xs, ys, xEnd - xMin, true, output.row( y ) + xMin * CHANNEL_COUNT );
+	} );
+}
+template void remapAffine( const ImageViewGrayU &input, ImageViewGrayU output, const double *params, bool fill, unsigned char fillValue );
+template void remapAffine( const ImageViewGrayS &input, ImageViewGrayS output, const double *params, bool fill, unsigned short fillValue );
+template void remapAffine( const ImageViewGrayF &input, ImageViewGrayF output, const double *params, bool fill, float fillValue );
+template void remapAffine( const ImageViewColorU &input, ImageViewColorU output, const double *params, bool fill, unsigned char fillValue );
+template void remapAffine( const ImageViewColorF &input, ImageViewColorF output, const double *params, bool fill, float fillValue );
+
+
+/// for each output pixel (x, y), sample the input at (x + frac * u( x, y ), y + frac * v( x, y ))
+template <typename T, int CHANNEL_COUNT> void remapField( const ImageView<T, CHANNEL_COUNT> &input, ImageView<T, CHANNEL_COUNT> output,
+														  const ImageView<float, 1> &u, const ImageView<float, 1> &v, float frac, bool fill, T fillValue ) {
+	assertAlways( u.width() == output.width() && u.height() == output.height() );
+	assertAlways( v.width() == output.width() && v.height() == output.height() );
+	RemapSpan<T, CHANNEL_COUNT> span( input, fill, fillValue );
+	forEachTileRow( output.width(), output.height(), [&]( int xMin, int xEnd, int y ) {
+		float xs[ REMAP_TILE_WIDTH ], ys[ REMAP_TILE_WIDTH ];
+		displacedPositions( (float) xMin, 1, u.row( y ) + xMin, frac, xs, xEnd - xMin );
+		displacedPositions( (float) y, 0, v.row( y ) + xMin, frac, ys, xEnd - xMin );
+		span.run( xs, ys, xEnd - xMin, false, output.row( y ) + xMin * CHANNEL_COUNT );
+	} );
+}
+template void remapField( const ImageViewGrayU &input, ImageViewGrayU output, const ImageViewGrayF &u, const ImageViewGrayF &v, float frac, bool fill, unsigned char fillValue );
+template void remapField( const ImageViewGrayS &input, ImageViewGrayS output, const ImageViewGrayF &u, const ImageViewGrayF &v, float frac, bool fill, unsigned short fillValue );
+template void remapField( const ImageViewGrayF &input, ImageViewGrayF output, const ImageViewGrayF &u, const ImageViewGrayF &v, float frac, bool fill, float fillValue );
+template void remapField( const ImageViewColorU &input, ImageViewColorU output, const ImageViewGrayF &u, const ImageViewGrayF &v, float frac, bool fill, unsigned char fillValue );
+template void remapField( const ImageViewColorF &input, ImageViewColorF output, const ImageViewGrayF &u, const ImageViewGrayF &v, float frac, bool fill, float fillValue );
+
+
+/// compute the parameters of the inverse of an affine transformation; returns false if not invertible
+bool invertAffine( const double *params, double *invParams ) {
+	double a = params[ 2 ], b = params[ 4 ], c = params[ 3 ], d = params[ 5 ];
+	double det = a * d - b * c;
+	if (det == 0)
+		return false;
+	double factor = 1.0 / det;
+	invParams[ 2 ] = d * factor;
+	invParams[ 4 ] = -b * factor;
+	invParams[ 3 ] = -c * factor;
+	invParams[ 5 ] = a * factor;
+	invParams[ 0 ] = -(invParams[ 2 ] * params[ 0 ] + invParams[ 4 ] * params[ 1 ]);
+	invParams[ 1 ] = -(invParams[ 3 ] * params[ 0 ] + invParams[ 5 ] * params[ 1 ]);
+	return true;
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// check the remap engine against direct interpolation and against the warping functions built on it
+bool testImageRemap() {
+	int width = 37, height = 23;
+	ImageColorU color( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < 3; c++)
+				color.data( x, y, c ) = (unsigned char) randomInt( 0, 255 );
+	aptr<ImageGrayU> gray = toGray( color );
+
+	// the identity map reproduces the image (including the last row and column)
+	double identity[ 6 ] = { 0, 0, 1, 0, 0, 1 };
+	ImageGrayU same( width, height );
+	remapAffine( imageView( *gray ), imageView( same ), identity, true, (unsigned char) 0 );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			unitAssert( same.data( x, y ) == gray->data( x, y ) );
+
+	// a half-pixel shift averages neighbors (rounded); the last column samples outside the image
+	double halfShift[ 6 ] = { 0.5, 0, 1, 0, 0, 1 };
+	ImageGrayU shifted( width, height );
+	remapAffine( imageView( *gray ), imageView( shifted ), halfShift, true, (unsigned char) 7 );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width - 1; x++)
+			unitAssert( shifted.data( x, y ) == (gray->data( x, y ) + gray->data( x + 1, y ) + 1) / 2 );
+		unitAssert( shifted.data( width - 1, y ) == 7 );
+	}
+
+	// a constant motion field matches the equivalent affine map
+	MotionField mf( width, height );
+	mf.uRef().clear( 1.5f );
+	mf.vRef().clear( -0.25f );
+	double translate[ 6 ] = { 1.5, -0.25, 1, 0, 0, 1 };
+	ImageColorU fieldMapped( width, height ), affineMapped( width, height );
+	remapField( imageView( color ), imageView( fieldMapped ), mf.uView(), mf.vView(), 1.0f, true, (unsigned char) 0 );
+	remapAffine( imageView( color ), imageView( affineMapped ), translate, true, (unsigned char) 0 );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < 3; c++)
+				unitAssert( fieldMapped.data( x, y, c ) == affineMapped.data( x, y, c ) );
+
+	// MotionField::mapBackward uses the same engine
+	aptr<ImageColorU> mapped = mf.mapBackward( color, 0, 1.0f );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < 3; c++)
+				unitAssert( mapped->data( x, y, c ) == affineMapped.data( x, y, c ) );
+
+	// float images match Image::interp; pixels mapped from outside are left unchanged if not filling
+	aptr<ImageGrayF> grayF = toFloat( *gray, 1.0f );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			mf.setU( x, y, randomFloat( -3, 3 ) );
+			mf.setV( x, y, randomFloat( -3, 3 ) );
+		}
+	}
+	ImageGrayF fieldMappedF( width, height );
+	fieldMappedF.clear( -1 );
+	remapField( imageView( *grayF ), imageView( fieldMappedF ), mf.uView(), mf.vView(), 0.5f, false, 0.0f );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float xSrc = x + 0.5f * mf.u( x, y ), ySrc = y + 0.5f * mf.v( x, y );
+			if (xSrc >= 0 && ySrc >= 0 && xSrc <= width - 1 && ySrc <= height - 1) {
+				unitAssert( fabs( fieldMappedF.data( x, y ) - grayF->interp( xSrc, ySrc ) ) < 0.001f );
+			} else {
+				unitAssert( fieldMappedF.data( x, y ) == -1 );
+			}
+		}
+	}
+
+	// warpAffine maps the input forward
+	aptr<ImageGrayU> warped = warpAffine( *gray, 2, 1, 1, 0, 0, 1, width, height, 0 );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			unitAssert( warped->data( x, y ) == (x >= 2 && y >= 1 ? gray->data( x - 2, y - 1 ) : 0) );
+
+	// the inverse of the inverse is the original map
+	double params[ 6 ] = { 3, -2, 0.9, 0.2, -0.3, 1.1 }, invParams[ 6 ], params2[ 6 ];
+	unitAssert( invertAffine( params, invParams ) );
+	unitAssert( invertAffine( invParams, params2 ) );
+	for (int i = 0; i < 6; i++)
+		unitAssert( fabs( params[ i ] - params2[ i ] ) < 1e-9 );
+	return true;
+}
+
+
+// time the remap engine on a dense motion field and on a rotation (and a per-pixel interpolation loop for comparison)
+void benchmarkRemap( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 3840 );
+	int height = conf.readInt( "height", 2160 );
+	int iterations = conf.readInt( "iterations", 5 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, threads: %d", width, height, threadCount() );
+
+	// create a random test image and a smooth motion field
+	ImageColorU color( width, height );
+	for (int y = 0; y < height; y++) {
+		unsigned char *row = color.row( y );
+		for (int i = 0; i < width * 3; i++)
+			row[ i ] = (unsigned char) randomInt( 0, 255 );
+	}
+	aptr<ImageGrayU> gray = toGray( color );
+	MotionField mf( width, height );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			mf.setU( x, y, 5.0f * sinf( (float) y * 0.01f ) + 2.0f * cosf( (float) x * 0.013f ) );
+			mf.setV( x, y, 3.0f * cosf( (float) x * 0.007f ) );
+		}
+	}
+
+	// time each warp
+	Timer timer;
+	for (int i = 0; i < 4; i++) {
+		const char *name = "";
+		timer.reset();
+		timer.start();
+		for (int j = 0; j < iterations; j++) {
+			switch (i) {
+			case 0: name = "mapBackward (gray)"; mf.mapBackward( *gray, 0, 1.0f ); break;
+			case 1: name = "mapBackward (color)"; mf.mapBackward( color, 0, 1.0f ); break;
+			case 2: name = "rotate 10 degrees (color)"; rotate( color, 10.0f, 0 ); break;
+			case 3: {
+				name = "per-pixel interp (gray)";
+				ImageGrayU mapped( width, height );
+				for (int y = 0; y < height; y++) {
+					for (int x = 0; x < width; x++) {
+						float xSrc = x + mf.u( x, y ), ySrc = y + mf.v( x, y );
+						mapped.data( x, y ) = gray->inBounds( xSrc, ySrc ) ? (int) gray->interp( xSrc, ySrc ) : 0;
+					}
+				}
+				break;
+			}
+			}
+		}
+		timer.stop();
+		double time = timer.timeSum() * 1000.0 / iterations;
+		disp( 1, "%-28s %8.2f ms %8.1f frames/sec", name, time, 1000.0 / time );
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initImageRemap() {
+	registerUnitTest( testImageRemap );
+	registerCommand( "benchremap", benchmarkRemap );
+}
+
+
+} // end namespace sbl
@@ -1,5 +1,9 @@
 #include <sbl/image/ImageTransform.h>
 #include <sbl/math/MathUtil.h>
+#include <sbl/image/ImageView.h>
+#include <sbl/image/SeparableFilter.h>
+#include <sbl/image/ImageRemap.h>
+#include <sbl/core/Parallel.h>
 #ifdef USE_OPENCV
 	#include <opencv2/imgproc.hpp>
 #endif
@@ -12,23 +16,13 @@ namespace sbl {
 
 
 /// extract sub-image
-// fix(faster): use memcpy
 template <typename ImageType> aptr<ImageType> crop( const ImageType &input, int xMin, int xMax, int yMin, int yMax ) {
 	assertDebug( xMin >= 0 && xMax < input.width() );
 	assertDebug( yMin >= 0 && yMax < input.height() );
-	#ifdef USE_OPENCV
-	cv::Mat img = input.cvMat();
-	cv::Mat croppedImg = img( cv::Rect( xMin, yMin, xMax - xMin + 1, yMax - yMin + 1 ) );
-	aptr<ImageType> output( new ImageType( croppedImg ) );
-	#else
 	int newWidth = xMax - xMin + 1;
 	int newHeight = yMax - yMin + 1;
 	aptr<ImageType> output( new ImageType( newWidth, newHeight ) );
-	for (int y = yMin; y <= yMax; y++) 
-		for (int x = xMin; x <= xMax; x++)
-			for (int c = 0; c < input.channelCount(); c++)
-				output->data( x - xMin, y - yMin, c ) = input.data( x, y, c );
-	#endif
+	imageView( input ).sub( xMin, yMin, newWidth, newHeight ).copyTo( *output );
 	return output;
 }
 template aptr<ImageGrayU> crop( const ImageGrayU &input, int xMin, int xMax, int yMin, int yMax );
@@ -36,16 +30,42 @@ template aptr<ImageGrayF> crop( const ImageGrayF &input, int xMin, int xMax, int
 template aptr<ImageColorU> crop( const ImageColorU &input, int xMin, int xMax, int yMin, int yMax );
 
 
+// resize image using nearest neighbor sampling
+template <typename T, int CHANNEL_COUNT> void resizeNearest( const Image<T, CHANNEL_COUNT> &input, Image<T, CHANNEL_COUNT> &output ) {
+	int width = input.width(), height = input.height();
+	int newWidth = output.width(), newHeight = output.height();
+	float xScale = (float) width / (float) newWidth, yScale = (float) height / (float) newHeight;
+	VectorI xSource( newWidth );
+	for (int x = 0; x < newWidth; x++)
+		xSource[ x ] = min( (int) floorf( x * xScale ), width - 1 ) * CHANNEL_COUNT;
+	parallelFor( 0, newHeight, 16, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			const T *in = input.row( min( (int) floorf( y * yScale ), height - 1 ) );
+			T *out = output.row( y );
+			for (int x = 0; x < newWidth; x++)
+				for (int c = 0; c < CHANNEL_COUNT; c++)
+					*out++ = in[ xSource[ x ] + c ];
+		}
+	} );
+}
+
+
 /// shrink or zoom image
 template <typename ImageType> aptr<ImageType> resize( const ImageType &input, int newWidth, int newHeight, bool filter ) {
 	aptr<ImageType> output( new ImageType( newWidth, newHeight ) );
-#ifdef USE_OPENCV
-	int width = input.width();
-	int interp = filter ? (newWidth > width ? cv::INTER_LINEAR : cv::INTER_AREA) : cv::INTER_NEAREST;
-	cv::resize(input.cvMat(), output->cvMat(), cv::Size(newWidth, newHeight), 0, 0, interp);
-#else
-	fatalError( "not implemented" );
-#endif
+	int width = input.width(), height = input.height();
+	assertAlways( width && height );
+
+	// filtered: area averaging when shrinking, bilinear interpolation when enlarging (chosen by width, as with OpenCV)
+	if (filter) {
+		FilterTaps xTaps, yTaps;
+		bool area = newWidth <= width;
+		xTaps.setResample( width, newWidth, area );
+		yTaps.setResample( height, newHeight, area );
+		separableFilter( imageView( input ), imageView( *output ), xTaps, yTaps );
+	} else {
+		resizeNearest( input, *output );
+	}
 	return output;
 }
 template aptr<ImageGrayU>  resize( const ImageGrayU  &input, int newWidth, int newHeight, bool filter );
@@ -53,34 +73,32 @@ template aptr<ImageGrayF>  resize( const ImageGrayF  &input, int newWidth, int n
 template aptr<ImageColorU> resize( const ImageColorU &input, int newWidth, int newHeight, bool filter );
 
 
-/// translate and scale an image
-template <typename ImageType> aptr<ImageType> shiftScale( const ImageType &input, float xOffset, float yOffset, float xScale, float yScale, int outputWidth, int outputHeight ) {
-	aptr<ImageType> output( new ImageType( outputWidth, outputHeight ) );
-#ifdef USE_OPENCV
-	float transform[2][3] = {{xScale, 0, xOffset}, {0, yScale, yOffset}};
-	cv::Mat map = cv::Mat(2, 3, CV_32FC1, transform);
-	cv::warpAffine(input.cvMat(), output->cvMat(), map, cv::Size(outputWidth, outputHeight), cv::INTER_CUBIC + cv::WARP_FILL_OUTLIERS, cv::BORDER_TRANSPARENT, cv::Scalar(255));
-#else
-	fatalError("warpAffine not implemented");
-#endif
+// map an image forward using an affine transformation (in ImageTransform parameter order); output pixels that map from outside the input are set to fillColor
+template <typename T, int CHANNEL_COUNT> aptr< Image<T, CHANNEL_COUNT> > mapAffineForward( const Image<T, CHANNEL_COUNT> &input, const double *params,
+																					   int outputWidth, int outputHeight, int fillColor ) {
+	double invParams[ 6 ];
+	if (invertAffine( params, invParams ) == false)
+		fatalError( "mapAffineForward: transformation is not invertible" );
+	aptr< Image<T, CHANNEL_COUNT> > output( new Image<T, CHANNEL_COUNT>( outputWidth, outputHeight ) );
+	remapAffine( imageView( input ), imageView( *output ), invParams, true, (T) fillColor );
 	return output;
 }
+
+
+/// translate and scale an image (bilinear interpolation; pixels mapped from outside the input are set to white)
+template <typename ImageType> aptr<ImageType> shiftScale( const ImageType &input, float xOffset, float yOffset, float xScale, float yScale, int outputWidth, int outputHeight ) {
+	double params[ 6 ] = { xOffset, yOffset, xScale, 0, 0, yScale };
+	return mapAffineForward( input, params, outputWidth, outputHeight, 255 );
+}
 template aptr<ImageGrayU>  shiftScale( const ImageGrayU  &input, float xOffset, float yOffset, float xScale, float yScale, int outputWidth, int outputHeight );
 template aptr<ImageGrayF>  shiftScale( const ImageGrayF  &input, float xOffset, float yOffset, float xScale, float yScale, int outputWidth, int outputHeight );
 template aptr<ImageColorU> shiftScale( const ImageColorU &input, float xOffset, float yOffset, float xScale, float yScale, int outputWidth, int outputHeight );
 
 
-/// apply linear transformation to image
+/// apply linear transformation to image (bilinear interpolation; pixels mapped from outside the input are set to fillColor)
 template <typename ImageType> aptr<ImageType> warpAffine( const ImageType &input, float xOffset, float yOffset, float x1, float y1, float x2, float y2, int outputWidth, int outputHeight, int fillColor ) {
-	aptr<ImageType> output( new ImageType( outputWidth, outputHeight ) );
-#ifdef USE_OPENCV
-	float transform[2][3] = {{x1, x2, xOffset}, {y1, y2, yOffset}};
-	cv::Mat map = cv::Mat(2, 3, CV_32FC1, transform);
-	cv::warpAffine(input.cvMat(), output->cvMat(), map, cv::Size(outputWidth, outputHeight), cv::INTER_CUBIC + cv::WARP_FILL_OUTLIERS, cv::BORDER_TRANSPARENT, cv::Scalar(fillColor));
-#else
-	fatalError("warpAffine not implemented");
-#endif
-	return output;
+	double params[ 6 ] = { xOffset, yOffset, x1, y1, x2, y2 };
+	return mapAffineForward( input, params, outputWidth, outputHeight, fillColor );
 }
 template aptr<ImageGrayU>  warpAffine( const ImageGrayU  &input, float xOffset, float yOffset, float x1, float y1, float x2, float y2, int outputWidth, int outputHeight, int fillColor );
 template aptr<ImageGrayF>  warpAffine( const ImageGrayF  &input, float xOffset, float yOffset, float x1, float y1, float x2, float y2, int outputWidth, int outputHeight, int fillColor );
@@ -223,11 +241,18 @@ template aptr<ImageColorU> rotate( const ImageColorU &input, float angleDegrees,
 //-------------------------------------------
 
 
+/// create transformation from parameters (assumes correct number of parameters)
+ImageTransform::ImageTransform( const VectorF &params ) : m_params( params ) {
+	updateInverse();
+}
+
+
 /// create a translation transformation
 ImageTransform::ImageTransform( float xOffset, float yOffset ) { 
 	m_params.setLength( 2 ); 
 	m_params[ 0 ] = xOffset; 
 	m_params[ 1 ] = yOffset; 
+	updateInverse();
 }
 
 
@@ -240,12 +265,14 @@ ImageTransform::ImageTransform( float xOffset, float yOffset, float xScale, floa
 	m_params[ 3 ] = 0; 
 	m_params[ 4 ] = 0; 
 	m_params[ 5 ] = yScale; 
+	updateInverse();
 }
 
 
 /// load transformation parameters from file
 ImageTransform::ImageTransform( File &file ) {
 	m_params = file.readVector<float>();
+	updateInverse();
 }
 
 
@@ -284,42 +311,86 @@ aptr<ImageTransform> ImageTransform::inverse() const {
 }
 
 
+/// compose transformations: the result applies the given transformation and then this transformation
+aptr<ImageTransform> ImageTransform::compose( const ImageTransform &first ) const {
+	aptr<ImageTransform> result;
+	if (m_params.length() == 2 && first.m_params.length() == 2) {
+		result.reset( new ImageTransform( m_params[ 0 ] + first.m_params[ 0 ], m_params[ 1 ] + first.m_params[ 1 ] ) );
+	} else {
+		assertAlways( (m_params.length() == 2 || m_params.length() == 6) && (first.m_params.length() == 2 || first.m_params.length() == 6) );
+		const double *a = m_affineParams;
+		const double *b = first.m_affineParams;
+		VectorF params( 6 );
+		params[ 0 ] = (float) (a[ 0 ] + a[ 2 ] * b[ 0 ] + a[ 4 ] * b[ 1 ]);
+		params[ 1 ] = (float) (a[ 1 ] + a[ 3 ] * b[ 0 ] + a[ 5 ] * b[ 1 ]);
+		params[ 2 ] = (float) (a[ 2 ] * b[ 2 ] + a[ 4 ] * b[ 3 ]);
+		params[ 3 ] = (float) (a[ 3 ] * b[ 2 ] + a[ 5 ] * b[ 3 ]);
+		params[ 4 ] = (float) (a[ 2 ] * b[ 4 ] + a[ 4 ] * b[ 5 ]);
+		params[ 5 ] = (float) (a[ 3 ] * b[ 4 ] + a[ 5 ] * b[ 5 ]);
+		result.reset( new ImageTransform( params ) );
+	}
+	return result;
+}
+
+
 /// map an image forward according to the transformation
 aptr<ImageGrayU> ImageTransform::mapForward( const ImageGrayU &img, int outputWidth, int outputHeight, int fillColor ) const {
-	if (m_params.length() == 6)
-		return warpAffine( img, m_params[ 0 ], m_params[ 1 ], m_params[ 2 ], m_params[ 3 ], m_params[ 4 ], m_params[ 5 ], outputWidth, outputHeight, fillColor );    
-	assertAlways( m_params.length() == 2)
-	return shiftScale( img, m_params[ 0 ], m_params[ 1 ], 1, 1, outputWidth, outputHeight );
+	assertAlways( m_params.length() == 2 || m_params.length() == 6 );
+	return mapAffineForward( img, m_affineParams, outputWidth, outputHeight, fillColor );
 }
 
 
 /// map an image forward according to the transformation
 aptr<ImageColorU> ImageTransform::mapForward( const ImageColorU &img, int outputWidth, int outputHeight, int fillColor ) const {
-	if (m_params.length() == 6)
-		return warpAffine( img, m_params[ 0 ], m_params[ 1 ], m_params[ 2 ], m_params[ 3 ], m_params[ 4 ], m_params[ 5 ], outputWidth, outputHeight, fillColor );    
-	assertAlways( m_params.length() == 2)
-	return shiftScale( img, m_params[ 0 ], m_params[ 1 ], 1, 1, outputWidth, outputHeight );
+	assertAlways( m_params.length() == 2 || m_params.length() == 6 );
+	return mapAffineForward( img, m_affineParams, outputWidth, outputHeight, fillColor );
 }
 
 
 /// map an image back using the inverse transformation
 aptr<ImageGrayU> ImageTransform::mapBackward( const ImageGrayU &img, int outputWidth, int outputHeight, int fillColor ) const {
-	aptr<ImageTransform> inverseTransform = inverse();
-	return inverseTransform->mapForward( img, outputWidth, outputHeight, fillColor );
+	assertAlways( m_params.length() == 2 || m_params.length() == 6 );
+	aptr<ImageGrayU> output( new ImageGrayU( outputWidth, outputHeight ) );
+	remapAffine( imageView( img ), imageView( *output ), m_affineParams, true, (unsigned char) fillColor );
+	return output;
 }
 
 
 /// map a point forward according to the transformation
 Point2 ImageTransform::mapForward( const Point2 &pt ) const {
-	assertAlways( m_params.length() == 2 ); // fix(soon): handle affine xforms
-	return Point2( pt.x + m_params[ 0 ], pt.y + m_params[ 1 ] );
+	assertAlways( m_params.length() == 2 || m_params.length() == 6 );
+	const double *p = m_affineParams;
+	return Point2( p[ 0 ] + (pt.x * p[ 2 ] + pt.y * p[ 4 ]), p[ 1 ] + (pt.x * p[ 3 ] + pt.y * p[ 5 ]) );
 }
 
 
 /// map a point backward according to the inverse transformation
 Point2 ImageTransform::mapBackward( const Point2 &pt ) const {
-	assertAlways( m_params.length() == 2 ); // fix(soon): handle affine xforms
-	return Point2( pt.x - m_params[ 0 ], pt.y - m_params[ 1 ] );
+	assertAlways( m_invertible );
+	const double *p = m_invParams;
+	return Point2( p[ 0 ] + (pt.x * p[ 2 ] + pt.y * p[ 4 ]), p[ 1 ] + (pt.x * p[ 3 ] + pt.y * p[ 5 ]) );
+}
+
+
+/// map a set of points forward according to the transformation
+void ImageTransform::mapForward( const PointSet2F &input, PointSet2F &output, PointSetStats *stats, const PointSet2F *target ) const {
+	assertAlways( m_params.length() == 2 || m_params.length() == 6 );
+	transformPoints( m_affineParams, input, output, stats, target );
+}
+void ImageTransform::mapForward( const PointSet2D &input, PointSet2D &output, PointSetStats *stats, const PointSet2D *target ) const {
+	assertAlways( m_params.length() == 2 || m_params.length() == 6 );
+	transformPoints( m_affineParams, input, output, stats, target );
+}
+
+
+/// map a set of points backward according to the inverse transformation
+void ImageTransform::mapBackward( const PointSet2F &input, PointSet2F &output, PointSetStats *stats, const PointSet2F *target ) const {
+	assertAlways( m_invertible );
+	transformPoints( m_invParams, input, output, stats, target );
+}
+void ImageTransform::mapBackward( const PointSet2D &input, PointSet2D &output, PointSetStats *stats, const PointSet2D *target ) const {
+	assertAlways( m_invertible );
+	transformPoints( m_invParams, input, output, stats, target );
 }
 
 
@@ -335,5 +406,37 @@ void ImageTransform::display( int indent ) {
 }
 
 
+// update m_affineParams and m_invParams from m_params
+void ImageTransform::updateInverse() {
+	m_invertible = false;
+	for (int i = 0; i < 6; i++) {
+		m_affineParams[ i ] = (i == 2 || i == 5) ? 1 : 0;
+		m_invParams[ i ] = m_affineParams[ i ];
+	}
+	if (m_params.length() == 2) {
+		m_affineParams[ 0 ] = m_params[ 0 ];
+		m_affineParams[ 1 ] = m_params[ 1 ];
+		m_invParams[ 0 ] = -m_affineParams[ 0 ];
+		m_invParams[ 1 ] = -m_affineParams[ 1 ];
+		m_invertible = true;
+	} else if (m_params.length() == 6) {
+		for (int i = 0; i < 6; i++)
+			m_affineParams[ i ] = m_params[ i ];
+		const double *p = m_affineParams;
+		double det = p[ 2 ] * p[ 5 ] - p[ 4 ] * p[ 3 ];
+		if (fabs( det ) > 1e-12) {
+			double factor = 1.0 / det;
+			m_invParams[ 2 ] = p[ 5 ] * factor;
+			m_invParams[ 4 ] = -p[ 4 ] * factor;
+			m_invParams[ 3 ] = -p[ 3 ] * factor;
+			m_invParams[ 5 ] = p[ 2 ] * factor;
+			m_invParams[ 0 ] = -(m_invParams[ 2 ] * p[ 0 ] + m_invParams[ 4 ] * p[ 1 ]);
+			m_invParams[ 1 ] = -(m_invParams[ 3 ] * p[ 0 ] + m_invParams[ 5 ] * p[ 1 ]);
+			m_invertible = true;
+		}
+	}
+}
+
+
 } // end namespace sbl
 
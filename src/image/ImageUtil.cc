@@ -1,8 +1,22 @@
 #include <sbl/image/ImageUtil.h>
 #include <sbl/core/Command.h> // for filter registry
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/system/Timer.h> // for benchmark
 #include <sbl/math/MathUtil.h>
-#include <sbl/math/MatrixUtil.h> // for mutual info
+#include <sbl/image/MutualInfo.h> // for mutual info
 #include <sbl/image/Filter.h> // for filter registry
+#include <sbl/image/ImageTransform.h> // for crop test
+#include <sbl/image/SeparableFilter.h>
+#include <sbl/image/ConnectedComponents.h> // for mask filtering
+#include <string.h>
+#include <math.h>
+#include <limits>
+#include <algorithm>
+#include <mutex>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 #ifdef USE_OPENCV
 	#include <opencv2/imgcodecs.hpp>
 	#include <opencv2/imgproc.hpp>
@@ -13,6 +27,143 @@
 namespace sbl {
 
 
+//-------------------------------------------
+// ROW KERNELS
+//-------------------------------------------
+
+
+// the number of rows per parallel band for per-pixel operations
+#define IMAGE_BAND_ROWS 16
+
+
+// convert 8-bit values to scaled float values
+void toFloatRow( const unsigned char *in, float scaleFactor, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128();
+	__m128 scale = _mm_set1_ps( scaleFactor );
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128( (const __m128i *) (in + i) );
+		__m128i lo = _mm_unpacklo_epi8( v, zero ), hi = _mm_unpackhi_epi8( v, zero );
+		_mm_storeu_ps( out + i, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ), scale ) );
+		_mm_storeu_ps( out + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ), scale ) );
+		_mm_storeu_ps( out + i + 8, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ), scale ) );
+		_mm_storeu_ps( out + i + 12, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ), scale ) );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = (float) in[ i ] * scaleFactor;
+}
+
+
+// convert float values to 8-bit values: (in + offset) * scaleFactor, rounded to nearest and saturated
+void toUCharRow( const float *in, float offset, float scaleFactor, unsigned char *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 off = _mm_set1_ps( offset ), scale = _mm_set1_ps( scaleFactor );
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_cvtps_epi32( _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( in + i ), off ), scale ) );
+		__m128i b = _mm_cvtps_epi32( _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( in + i + 4 ), off ), scale ) );
+		__m128i c = _mm_cvtps_epi32( _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( in + i + 8 ), off ), scale ) );
+		__m128i d = _mm_cvtps_epi32( _mm_mul_ps( _mm_add_ps( _mm_loadu_ps( in + i + 12 ), off ), scale ) );
+		_mm_storeu_si128( (__m128i *) (out + i), _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) ) );
+	}
+	for (; i < count; i++) {
+		int v = _mm_cvtss_si32( _mm_set_ss( (in[ i ] + offset) * scaleFactor ) );
+		out[ i ] = (unsigned char) bound( v, 0, 255 );
+	}
+#else
+	for (; i < count; i++)
+		out[ i ] = (unsigned char) bound( round( (in[ i ] + offset) * scaleFactor ), 0, 255 );
+#endif
+}
+
+
+// find the minimum and maximum of a set of float values
+void minMaxRow( const float *in, int count, float &min, float &max ) {
+	int i = 0;
+	float rowMin = in[ 0 ], rowMax = in[ 0 ];
+#ifdef __SSE2__
+	if (count >= 4) {
+		__m128 vMin = _mm_loadu_ps( in ), vMax = vMin;
+		for (i = 4; i + 4 <= count; i += 4) {
+			__m128 v = _mm_loadu_ps( in + i );
+			vMin = _mm_min_ps( vMin, v );
+			vMax = _mm_max_ps( vMax, v );
+		}
+		float mins[ 4 ], maxs[ 4 ];
+		_mm_storeu_ps( mins, vMin );
+		_mm_storeu_ps( maxs, vMax );
+		for (int j = 0; j < 4; j++) {
+			if (mins[ j ] < rowMin)
+				rowMin = mins[ j ];
+			if (maxs[ j ] > rowMax)
+				rowMax = maxs[ j ];
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		if (in[ i ] < rowMin)
+			rowMin = in[ i ];
+		if (in[ i ] > rowMax)
+			rowMax = in[ i ];
+	}
+	min = rowMin;
+	max = rowMax;
+}
+
+
+// set out to high where in > thresh and to low elsewhere
+void thresholdRow( const unsigned char *in, float thresh, unsigned char high, unsigned char low, unsigned char *out, int count ) {
+
+	// for integer values, v > thresh is the same as v > floor( thresh )
+	int threshInt = (int) floorf( bound( thresh, -1.0f, 255.0f ) );
+	int i = 0;
+#ifdef __SSE2__
+	if (threshInt >= 0 && threshInt < 255) {
+
+		// SSE2 has no unsigned byte comparison, so flip the sign bits and use a signed comparison
+		__m128i sign = _mm_set1_epi8( (char) 0x80 );
+		__m128i t = _mm_set1_epi8( (char) (threshInt ^ 0x80) );
+		__m128i vHigh = _mm_set1_epi8( (char) high ), vLow = _mm_set1_epi8( (char) low );
+		for (; i + 16 <= count; i += 16) {
+			__m128i v = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (in + i) ), sign );
+			__m128i mask = _mm_cmpgt_epi8( v, t );
+			_mm_storeu_si128( (__m128i *) (out + i), _mm_or_si128( _mm_and_si128( mask, vHigh ), _mm_andnot_si128( mask, vLow ) ) );
+		}
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = in[ i ] > threshInt ? high : low;
+}
+void thresholdRow( const float *in, float thresh, float high, float low, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 t = _mm_set1_ps( thresh ), vHigh = _mm_set1_ps( high ), vLow = _mm_set1_ps( low );
+	for (; i + 4 <= count; i += 4) {
+		__m128 mask = _mm_cmpgt_ps( _mm_loadu_ps( in + i ), t );
+		_mm_storeu_ps( out + i, _mm_or_ps( _mm_and_ps( mask, vHigh ), _mm_andnot_ps( mask, vLow ) ) );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = in[ i ] > thresh ? high : low;
+}
+
+
+// compute sqrt( x * x + y * y ) for each pair of values
+void magnitudeRow( const float *x, const float *y, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx = _mm_loadu_ps( x + i ), vy = _mm_loadu_ps( y + i );
+		_mm_storeu_ps( out + i, _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( vx, vx ), _mm_mul_ps( vy, vy ) ) ) );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = sqrtf( x[ i ] * x[ i ] + y[ i ] * y[ i ] );
+}
+
+
 //-------------------------------------------
 // IMAGE CONVERSION
 //-------------------------------------------
@@ -22,9 +173,17 @@ namespace sbl {
 aptr<ImageGrayU> toGray( const ImageColorU &input ) {
 	int width = input.width(), height = input.height();
 	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
-#ifdef USE_OPENCV
-    cv::cvtColor(input.cvMat(), output->cvMat(), cv::COLOR_BGR2GRAY);
-#endif
+	ImageGrayU &out = *output;
+
+	// fixed-point weights (summing to 1 << 14) matching OpenCV's BGR to gray conversion
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			const unsigned char *in = input.row( y );
+			unsigned char *outRow = out.row( y );
+			for (int x = 0; x < width; x++, in += 3)
+				outRow[ x ] = (unsigned char) ((in[ B_CHANNEL ] * 1868 + in[ G_CHANNEL ] * 9617 + in[ R_CHANNEL ] * 4899 + 8192) >> 14);
+		}
+	} );
 	return output;
 }
 
@@ -33,85 +192,383 @@ aptr<ImageGrayU> toGray( const ImageColorU &input ) {
 aptr<ImageColorU> toColor( const ImageGrayU &input ) {
 	int width = input.width(), height = input.height();
 	aptr<ImageColorU> output( new ImageColorU( width, height ) );
-#ifdef USE_OPENCV
-    cv::cvtColor(input.cvMat(), output->cvMat(), cv::COLOR_GRAY2BGR);
-#endif
+	ImageColorU &out = *output;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			const unsigned char *in = input.row( y );
+			unsigned char *outRow = out.row( y );
+			for (int x = 0; x < width; x++, outRow += 3)
+				outRow[ 0 ] = outRow[ 1 ] = outRow[ 2 ] = in[ x ];
+		}
+	} );
 	return output;
 }
 
 
-/// convert 8-bit image to float image
-// fix(faster): use opencv?
-aptr<ImageGrayF> toFloat( const ImageGrayU &input, float scaleFactor ) {
+// convert 8-bit image to float image
+template <int CHANNEL_COUNT> aptr< Image<float, CHANNEL_COUNT> > convertToFloat( const Image<unsigned char, CHANNEL_COUNT> &input, float scaleFactor ) {
 	int width = input.width(), height = input.height();
-	aptr<ImageGrayF> output( new ImageGrayF( width, height ) );
-	for (int y = 0; y < height; y++) 
-		for (int x = 0; x < width; x++) 
-			output->data( x, y ) = (float) input.data( x, y ) * scaleFactor;
+	aptr< Image<float, CHANNEL_COUNT> > output( new Image<float, CHANNEL_COUNT>( width, height ) );
+	Image<float, CHANNEL_COUNT> &out = *output;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++)
+			toFloatRow( input.row( y ), scaleFactor, out.row( y ), width * CHANNEL_COUNT );
+	} );
 	return output;
 }
 
 
 /// convert 8-bit image to float image
-// fix(faster): use opencv?
+aptr<ImageGrayF> toFloat( const ImageGrayU &input, float scaleFactor ) {
+	return convertToFloat<1>( input, scaleFactor );
+}
+
+
+/// convert 8-bit image to float image
 aptr<ImageColorF> toFloat( const ImageColorU &input, float scaleFactor ) {
+	return convertToFloat<3>( input, scaleFactor );
+}
+
+
+// convert float image to 8-bit image, using the given offset and scale factor
+template <int CHANNEL_COUNT> aptr< Image<unsigned char, CHANNEL_COUNT> > convertToUChar( const Image<float, CHANNEL_COUNT> &input, float offset, float scaleFactor ) {
 	int width = input.width(), height = input.height();
-	aptr<ImageColorF> output( new ImageColorF( width, height ) );
-	for (int y = 0; y < height; y++) 
-		for (int x = 0; x < width; x++) 
-			for (int c = 0; c < 3; c++) 
-				output->data( x, y, c ) = (float) input.data( x, y, c ) * scaleFactor;
+	assertAlways( width && height );
+	aptr< Image<unsigned char, CHANNEL_COUNT> > output( new Image<unsigned char, CHANNEL_COUNT>( width, height ) );
+	Image<unsigned char, CHANNEL_COUNT> &out = *output;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++)
+			toUCharRow( input.row( y ), offset, scaleFactor, out.row( y ), width * CHANNEL_COUNT );
+	} );
 	return output;
 }
 
 
-/// convert float image to 8-bit image, automatically scaling values 
+/// convert float image to 8-bit image, automatically scaling values
 aptr<ImageGrayU> toUChar( const ImageGrayF &input ) {
 	int width = input.width(), height = input.height();
 	assertAlways( width && height );
-	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
-	float min = input.data( 0, 0 );
-	float max = input.data( 0, 0 );
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			float v = input.data( x, y );
-			if (v < min)
-				min = v;
-			if (v > max)
-				max = v;
+
+	// find the range of each row, then of the whole image
+	VectorF rowMin( height ), rowMax( height );
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++)
+			minMaxRow( input.row( y ), width, rowMin[ y ], rowMax[ y ] );
+	} );
+	float min = rowMin.min(), max = rowMax.max();
+	return convertToUChar<1>( input, -min, 255.0f / (max - min) );
+}
+
+
+/// convert float image to 8-bit image, using a fixed scale factor
+aptr<ImageGrayU> toUChar( const ImageGrayF &input, float scaleFactor ) {
+	return convertToUChar<1>( input, 0, scaleFactor );
+}
+
+
+/// convert float image to 8-bit image, using a fixed scale factor
+aptr<ImageColorU> toUChar( const ImageColorF &input, float scaleFactor ) {
+	return convertToUChar<3>( input, 0, scaleFactor );
+}
+
+
+//-------------------------------------------
+// MEDIAN FILTER
+//-------------------------------------------
+
+
+/// The ScalarMedianOps class provides single-value operations for the median sorting network.
+template <typename T> class ScalarMedianOps {
+public:
+	typedef T V;
+	enum { LANES = 1 };
+	static inline V load( const T *p ) { return *p; }
+	static inline void store( T *p, V v ) { *p = v; }
+	static inline V min( V a, V b ) { return a < b ? a : b; }
+	static inline V max( V a, V b ) { return a < b ? b : a; }
+};
+
+
+#ifdef __SSE2__
+
+
+/// The ByteMedianOps class provides 16-lane 8-bit operations for the median sorting network.
+class ByteMedianOps {
+public:
+	typedef __m128i V;
+	enum { LANES = 16 };
+	static inline V load( const unsigned char *p ) { return _mm_loadu_si128( (const __m128i *) p ); }
+	static inline void store( unsigned char *p, V v ) { _mm_storeu_si128( (__m128i *) p, v ); }
+	static inline V min( V a, V b ) { return _mm_min_epu8( a, b ); }
+	static inline V max( V a, V b ) { return _mm_max_epu8( a, b ); }
+};
+
+
+/// The FloatMedianOps class provides 4-lane float operations for the median sorting network.
+class FloatMedianOps {
+public:
+	typedef __m128 V;
+	enum { LANES = 4 };
+	static inline V load( const float *p ) { return _mm_loadu_ps( p ); }
+	static inline void store( float *p, V v ) { _mm_storeu_ps( p, v ); }
+	static inline V min( V a, V b ) { return _mm_min_ps( a, b ); }
+	static inline V max( V a, V b ) { return _mm_max_ps( a, b ); }
+};
+
+
+// the vector operations for each pixel type
+template <typename T> class SimdMedianOps { public: typedef ScalarMedianOps<T> Ops; };
+template <> class SimdMedianOps<unsigned char> { public: typedef ByteMedianOps Ops; };
+template <> class SimdMedianOps<float> { public: typedef FloatMedianOps Ops; };
+
+
+#else
+template <typename T> class SimdMedianOps { public: typedef ScalarMedianOps<T> Ops; };
+#endif // __SSE2__
+
+
+// order a pair of values
+template <typename Ops> inline void sortPair( typename Ops::V &a, typename Ops::V &b ) {
+	typename Ops::V t = Ops::min( a, b );
+	b = Ops::max( a, b );
+	a = t;
+}
+
+
+// compute the median of 3x3 neighborhoods for elements [begin, end) of a row (or the largest multiple of the lane count);
+// each row pointer refers to the padded row (one pixel left of the first pixel); returns the end of the elements processed
+template <typename Ops, typename T> int median3x3Span( const T **rows, int step, T *out, int begin, int end ) {
+	int i = begin;
+	for (; i + (int) Ops::LANES <= end; i += Ops::LANES) {
+
+		// sorting network for the median of 9 values (Paeth)
+		typename Ops::V p[ 9 ];
+		for (int r = 0; r < 3; r++)
+			for (int k = 0; k < 3; k++)
+				p[ r * 3 + k ] = Ops::load( rows[ r ] + i + k * step );
+		sortPair<Ops>( p[ 1 ], p[ 2 ] ); sortPair<Ops>( p[ 4 ], p[ 5 ] ); sortPair<Ops>( p[ 7 ], p[ 8 ] );
+		sortPair<Ops>( p[ 0 ], p[ 1 ] ); sortPair<Ops>( p[ 3 ], p[ 4 ] ); sortPair<Ops>( p[ 6 ], p[ 7 ] );
+		sortPair<Ops>( p[ 1 ], p[ 2 ] ); sortPair<Ops>( p[ 4 ], p[ 5 ] ); sortPair<Ops>( p[ 7 ], p[ 8 ] );
+		sortPair<Ops>( p[ 0 ], p[ 3 ] ); sortPair<Ops>( p[ 5 ], p[ 8 ] ); sortPair<Ops>( p[ 4 ], p[ 7 ] );
+		sortPair<Ops>( p[ 3 ], p[ 6 ] ); sortPair<Ops>( p[ 1 ], p[ 4 ] ); sortPair<Ops>( p[ 2 ], p[ 5 ] );
+		sortPair<Ops>( p[ 4 ], p[ 7 ] ); sortPair<Ops>( p[ 4 ], p[ 2 ] ); sortPair<Ops>( p[ 6 ], p[ 4 ] );
+		sortPair<Ops>( p[ 4 ], p[ 2 ] );
+		Ops::store( out + i, p[ 4 ] );
+	}
+	return i;
+}
+
+
+// create a list of comparators (pairs of positions) that sorts a set of values (Batcher's odd-even merge sort),
+// then remove comparators that do not affect the middle position; each comparator is stored as (a, b, needMin, needMax)
+VectorI medianNetwork( int count ) {
+	VectorI network;
+	for (int p = 1; p < count; p += p) {
+		for (int k = p; k >= 1; k /= 2) {
+			for (int j = k % p; j + k < count; j += 2 * k) {
+				for (int i = 0; i < k && i + j + k < count; i++) {
+					if ((i + j) / (p * 2) == (i + j + k) / (p * 2)) {
+						network.append( i + j );
+						network.append( i + j + k );
+					}
+				}
+			}
 		}
 	}
-	float factor = 255.0f / (max - min);
-	for (int y = 0; y < height; y++) 
-		for (int x = 0; x < width; x++) 
-			output->data( x, y ) = bound( round( (input.data( x, y ) - min) * factor ), 0, 255 );
-	return output;
+
+	// work backward from the middle position, keeping only the comparator outputs that are needed
+	VectorI needed( count ), pruned;
+	needed.clear( 0 );
+	needed[ count / 2 ] = 1;
+	for (int i = network.length() - 2; i >= 0; i -= 2) {
+		int a = network[ i ], b = network[ i + 1 ];
+		int needMin = needed[ a ], needMax = needed[ b ];
+		if (needMin || needMax) {
+			pruned.append( a );
+			pruned.append( b );
+			pruned.append( needMin );
+			pruned.append( needMax );
+			needed[ a ] = needed[ b ] = 1;
+		}
+	}
+
+	// restore the forward order
+	VectorI forward;
+	for (int i = pruned.length() - 4; i >= 0; i -= 4)
+		for (int j = 0; j < 4; j++)
+			forward.append( pruned[ i + j ] );
+	return forward;
 }
 
 
-/// convert float image to 8-bit image, automatically scaling values 
-aptr<ImageGrayU> toUChar( const ImageGrayF &input, float scaleFactor ) {
+// compute the median of square neighborhoods for elements [begin, end) of a row using a sorting network
+template <typename Ops, typename T> int medianNetworkSpan( const T **rows, int apertureSize, int step, const VectorI &network, T *out, int begin, int end ) {
+	typename Ops::V p[ 49 ];
+	int count = apertureSize * apertureSize;
+	int i = begin;
+	for (; i + (int) Ops::LANES <= end; i += Ops::LANES) {
+		for (int r = 0; r < apertureSize; r++)
+			for (int k = 0; k < apertureSize; k++)
+				p[ r * apertureSize + k ] = Ops::load( rows[ r ] + i + k * step );
+		for (int j = 0; j < network.length(); j += 4) {
+			typename Ops::V &a = p[ network[ j ] ], &b = p[ network[ j + 1 ] ];
+			typename Ops::V t = a;
+			if (network[ j + 2 ])
+				a = Ops::min( t, b );
+			if (network[ j + 3 ])
+				b = Ops::max( t, b );
+		}
+		Ops::store( out + i, p[ count / 2 ] );
+	}
+	return i;
+}
+
+
+// median filter for small apertures (3 or 5) with replicated borders, using sorting networks
+template <typename T, int CHANNEL_COUNT> void medianSmall( const Image<T, CHANNEL_COUNT> &input, Image<T, CHANNEL_COUNT> &output, int apertureSize ) {
 	int width = input.width(), height = input.height();
-	assertAlways( width && height );
-	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
-	for (int y = 0; y < height; y++) 
-		for (int x = 0; x < width; x++) 
-			output->data( x, y ) = bound( round( input.data( x, y ) * scaleFactor ), 0, 255 );
-	return output;
+	int radius = apertureSize / 2;
+	int rowLength = width * CHANNEL_COUNT;
+	int padLength = radius * CHANNEL_COUNT;
+	int paddedLength = rowLength + 2 * padLength;
+	VectorI network;
+	if (apertureSize > 3)
+		network = medianNetwork( apertureSize * apertureSize );
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+
+		// the most recent input rows, each padded with replicated pixels at each end
+		Vector<T> padded( apertureSize * paddedLength );
+		VectorI paddedRow( apertureSize );
+		paddedRow.clear( -1 );
+		const T *rows[ 7 ];
+		for (int y = yBegin; y < yEnd; y++) {
+			for (int r = 0; r < apertureSize; r++) {
+				int yIn = bound( y + r - radius, 0, height - 1 );
+				int slot = yIn % apertureSize;
+				T *p = padded.dataPtr() + slot * paddedLength;
+				if (paddedRow[ slot ] != yIn) {
+					const T *in = input.row( yIn );
+					memcpy( p + padLength, in, rowLength * sizeof(T) );
+					for (int i = 0; i < padLength; i++) {
+						p[ i ] = in[ i % CHANNEL_COUNT ];
+						p[ padLength + rowLength + i ] = in[ rowLength - CHANNEL_COUNT + i % CHANNEL_COUNT ];
+					}
+					paddedRow[ slot ] = yIn;
+				}
+				rows[ r ] = p;
+			}
+			T *out = output.row( y );
+			if (apertureSize == 3) {
+				int i = median3x3Span<typename SimdMedianOps<T>::Ops>( rows, CHANNEL_COUNT, out, 0, rowLength );
+				median3x3Span< ScalarMedianOps<T> >( rows, CHANNEL_COUNT, out, i, rowLength );
+			} else {
+				int i = medianNetworkSpan<typename SimdMedianOps<T>::Ops>( rows, apertureSize, CHANNEL_COUNT, network, out, 0, rowLength );
+				medianNetworkSpan< ScalarMedianOps<T> >( rows, apertureSize, CHANNEL_COUNT, network, out, i, rowLength );
+			}
+		}
+	} );
 }
 
 
-/// convert float image to 8-bit image, automatically scaling values 
-aptr<ImageColorU> toUChar( const ImageColorF &input, float scaleFactor ) {
+// median filter for larger apertures (with replicated borders): sliding histograms for 8-bit images
+template <int CHANNEL_COUNT> void medianLarge( const Image<unsigned char, CHANNEL_COUNT> &input, Image<unsigned char, CHANNEL_COUNT> &output, int apertureSize ) {
 	int width = input.width(), height = input.height();
-	assertAlways( width && height );
-	aptr<ImageColorU> output( new ImageColorU( width, height ) );
-	for (int y = 0; y < height; y++) 
-		for (int x = 0; x < width; x++) 
-			for (int c = 0; c < 3; c++) 
-				output->data( x, y, c ) = bound( round( input.data( x, y, c ) * scaleFactor ), 0, 255 );
+	int radius = apertureSize / 2;
+	int half = apertureSize * apertureSize / 2;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		VectorI rowIndex( apertureSize );
+		for (int y = yBegin; y < yEnd; y++) {
+			for (int k = 0; k < apertureSize; k++)
+				rowIndex[ k ] = bound( y + k - radius, 0, height - 1 );
+			unsigned char *out = output.row( y );
+			for (int c = 0; c < CHANNEL_COUNT; c++) {
+
+				// histogram of the window at x = 0
+				int hist[ 256 ];
+				memset( hist, 0, sizeof(hist) );
+				for (int k = 0; k < apertureSize; k++) {
+					const unsigned char *in = input.row( rowIndex[ k ] );
+					for (int j = -radius; j <= radius; j++)
+						hist[ in[ bound( j, 0, width - 1 ) * CHANNEL_COUNT + c ] ]++;
+				}
+
+				// the median and the number of window values below it (updated incrementally as the window moves)
+				int median = 0, countBelow = 0;
+				for (int x = 0; x < width; x++) {
+					if (x) {
+						int xOut = bound( x - radius - 1, 0, width - 1 ) * CHANNEL_COUNT + c;
+						int xIn = bound( x + radius, 0, width - 1 ) * CHANNEL_COUNT + c;
+						for (int k = 0; k < apertureSize; k++) {
+							const unsigned char *in = input.row( rowIndex[ k ] );
+							int vOut = in[ xOut ], vIn = in[ xIn ];
+							hist[ vOut ]--;
+							if (vOut < median)
+								countBelow--;
+							hist[ vIn ]++;
+							if (vIn < median)
+								countBelow++;
+						}
+					}
+					while (countBelow > half) {
+						median--;
+						countBelow -= hist[ median ];
+					}
+					while (countBelow + hist[ median ] <= half) {
+						countBelow += hist[ median ];
+						median++;
+					}
+					out[ x * CHANNEL_COUNT + c ] = (unsigned char) median;
+				}
+			}
+		}
+	} );
+}
+
+
+// median filter for larger apertures (with replicated borders): partial sorting for float images
+template <int CHANNEL_COUNT> void medianLarge( const Image<float, CHANNEL_COUNT> &input, Image<float, CHANNEL_COUNT> &output, int apertureSize ) {
+	int width = input.width(), height = input.height();
+	int radius = apertureSize / 2;
+	int half = apertureSize * apertureSize / 2;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		VectorF window( apertureSize * apertureSize );
+		float *w = window.dataPtr();
+		for (int y = yBegin; y < yEnd; y++) {
+			float *out = output.row( y );
+			for (int x = 0; x < width; x++) {
+				for (int c = 0; c < CHANNEL_COUNT; c++) {
+					int i = 0;
+					for (int k = -radius; k <= radius; k++) {
+						const float *in = input.row( bound( y + k, 0, height - 1 ) );
+						for (int j = -radius; j <= radius; j++)
+							w[ i++ ] = in[ bound( x + j, 0, width - 1 ) * CHANNEL_COUNT + c ];
+					}
+					std::nth_element( w, w + half, w + i );
+					out[ x * CHANNEL_COUNT + c ] = w[ half ];
+				}
+			}
+		}
+	} );
+}
+
+
+/// apply median filter (set each pixel to median of neighbors)
+template <typename ImageType> aptr<ImageType> median( const ImageType &input, int apertureSize ) {
+	assertAlways( apertureSize > 0 && apertureSize % 2 == 1 );
+	int width = input.width(), height = input.height();
+	aptr<ImageType> output( new ImageType( width, height ) );
+	if (apertureSize == 1)
+		imageView( input ).copyTo( imageView( *output ) );
+	else if (apertureSize <= 5)
+		medianSmall( input, *output, apertureSize );
+	else
+		medianLarge( input, *output, apertureSize );
 	return output;
 }
+template aptr<ImageGrayU> median( const ImageGrayU &input, int apertureSize );
+template aptr<ImageGrayF> median( const ImageGrayF &input, int apertureSize );
+template aptr<ImageColorU> median( const ImageColorU &input, int apertureSize );
+template aptr<ImageColorF> median( const ImageColorF &input, int apertureSize );
 
 
 //-------------------------------------------
@@ -123,11 +580,10 @@ aptr<ImageColorU> toUChar( const ImageColorF &input, float scaleFactor ) {
 template <typename ImageType> aptr<ImageType> blurBox( const ImageType &input, int boxSize ) {
 	int width = input.width(), height = input.height();
 	aptr<ImageType> output( new ImageType( width, height ) );
-#ifdef USE_OPENCV
-	cv::blur(input.cvMat(), output->cvMat(), cv::Size(3, 3));
-#else
-	fatalError("blurBox not implemented");
-#endif
+	FilterTaps xTaps, yTaps;
+	xTaps.setBox( boxSize, width );
+	yTaps.setBox( boxSize, height );
+	separableFilter( imageView( input ), imageView( *output ), xTaps, yTaps );
 	return output;
 }
 template aptr<ImageGrayU> blurBox( const ImageGrayU &input, int boxSize );
@@ -138,14 +594,8 @@ template aptr<ImageColorF> blurBox( const ImageColorF &input, int boxSize );
 
 /// blur using Gaussian filter
 template <typename ImageType> aptr<ImageType> blurGauss( const ImageType &input, float sigma ) {
-	assertAlways( sigma > 0 );
-	int width = input.width(), height = input.height();
-	aptr<ImageType> output( new ImageType( width, height ) );
-#ifdef USE_OPENCV
-	cv::GaussianBlur(input.cvMat(), output->cvMat(), cv::Size(0, 0), sigma);  // compute kernel size from sigma
-#else
-	fatalError("blurGauss not implemented");
-#endif
+	aptr<ImageType> output( new ImageType( input.width(), input.height() ) );
+	blurGauss( imageView( input ), imageView( *output ), sigma );
 	return output;
 }
 template aptr<ImageGrayU> blurGauss( const ImageGrayU &input, float sigma );
@@ -154,33 +604,39 @@ template aptr<ImageColorU> blurGauss( const ImageColorU &input, float sigma );
 template aptr<ImageColorF> blurGauss( const ImageColorF &input, float sigma );
 
 
-/// apply median filter (set each pixel to median of neighbors)
-template <typename ImageType> aptr<ImageType> median( const ImageType &input, int apertureSize ) {
+/// blur using Gaussian filter
+template <typename T, int CHANNEL_COUNT> void blurGauss( const ImageView<T, CHANNEL_COUNT> &input, ImageView<T, CHANNEL_COUNT> output, float sigma ) {
+	assertAlways( sigma > 0 );
+	assertAlways( output.width() == input.width() && output.height() == input.height() );
+	VectorF kernel = gaussianKernel( sigma, 0, std::numeric_limits<T>::is_integer == false );
+	FilterTaps xTaps, yTaps;
+	xTaps.setKernel( kernel, input.width() );
+	yTaps.setKernel( kernel, input.height() );
+	separableFilter( input, output, xTaps, yTaps );
+}
+template void blurGauss( const ImageViewGrayU &input, ImageViewGrayU output, float sigma );
+template void blurGauss( const ImageViewGrayF &input, ImageViewGrayF output, float sigma );
+template void blurGauss( const ImageViewColorU &input, ImageViewColorU output, float sigma );
+template void blurGauss( const ImageViewColorF &input, ImageViewColorF output, float sigma );
+
+
+// compute Sobel derivative (as with OpenCV's Sobel function; the result is not normalized)
+template <typename ImageType> aptr<ImageGrayF> sobel( const ImageType &input, int apertureSize, bool xDeriv ) {
 	int width = input.width(), height = input.height();
-	aptr<ImageType> output( new ImageType( width, height ) );
-#ifdef USE_OPENCV
-	fatalError("median not implemented");
-	// cvSmooth(input.iplImage(), output->iplImage(), CV_MEDIAN, apertureSize, apertureSize);
-#endif
+	aptr<ImageGrayF> output( new ImageGrayF( width, height ) );
+	VectorF derivKernel, smoothKernel;
+	sobelKernels( apertureSize, derivKernel, smoothKernel );
+	FilterTaps xTaps, yTaps;
+	xTaps.setKernel( xDeriv ? derivKernel : smoothKernel, width );
+	yTaps.setKernel( xDeriv ? smoothKernel : derivKernel, height );
+	separableFilter( imageView( input ), imageView( *output ), xTaps, yTaps );
 	return output;
 }
-template aptr<ImageGrayU> median( const ImageGrayU &input, int apertureSize );
-template aptr<ImageGrayF> median( const ImageGrayF &input, int apertureSize );
-template aptr<ImageColorU> median( const ImageColorU &input, int apertureSize );
-template aptr<ImageColorF> median( const ImageColorF &input, int apertureSize );
 
 
 /// image x gradient
 template <typename ImageType> aptr<ImageGrayF> xGrad( const ImageType &input, int apertureSize ) {
-	int width = input.width(), height = input.height();
-	aptr<ImageGrayF> output( new ImageGrayF( width, height ) );
-#ifdef USE_OPENCV
-	fatalError("xGrad not implemented");
-	// cvSobel(input.iplImage(), output->iplImage(), 1, 0, apertureSize);
-#else
-	fatalError("xGrad not implemented");
-#endif
-	return output;
+	return sobel( input, apertureSize, true );
 }
 template aptr<ImageGrayF> xGrad( const ImageGrayU &input, int apertureSize );
 template aptr<ImageGrayF> xGrad( const ImageGrayF &input, int apertureSize );
@@ -188,13 +644,7 @@ template aptr<ImageGrayF> xGrad( const ImageGrayF &input, int apertureSize );
 
 /// image y gradient
 template <typename ImageType> aptr<ImageGrayF> yGrad( const ImageType &input, int apertureSize ) {
-	int width = input.width(), height = input.height();
-	aptr<ImageGrayF> output( new ImageGrayF( width, height ) );
-#ifdef USE_OPENCV
-	fatalError("yGrad not implemented");
-	// cvSobel(input.iplImage(), output->iplImage(), 0, 1, apertureSize);
-#endif
-	return output;
+	return sobel( input, apertureSize, false );
 }
 template aptr<ImageGrayF> yGrad( const ImageGrayU &input, int apertureSize );
 template aptr<ImageGrayF> yGrad( const ImageGrayF &input, int apertureSize );
@@ -205,33 +655,41 @@ aptr<ImageGrayF> gradientMagnitude( const ImageGrayU &input, int apertureSize )
 	int width = input.width(), height = input.height();
 	aptr<ImageGrayF> gx = xGrad( input, apertureSize );
 	aptr<ImageGrayF> gy = yGrad( input, apertureSize );
-	aptr<ImageGrayF> mag( new ImageGrayF( width, height ) );
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			float gxi = gx->data( x, y );
-			float gyi = gy->data( x, y );
-			mag->data( x, y ) = sqrtf( gxi * gxi + gyi * gyi ); 
-		}
-	}
-	return mag;
+
+	// store the result in the x gradient image (avoiding another large allocation)
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++)
+			magnitudeRow( gx->row( y ), gy->row( y ), gx->row( y ), width );
+	} );
+	return gx;
 }
 
 
 /// apply threshold to image values
 template <typename ImageType> aptr<ImageType> threshold( const ImageType &input, float thresh, bool invert ) {
-	int width = input.width(), height = input.height();
-	aptr<ImageType> output( new ImageType( width, height ) );
-#ifdef USE_OPENCV
-	cv::threshold(input.cvMat(), output->cvMat(), thresh, 255, invert ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY);
-#else
-	fatalError("threshold not implemented");
-#endif
+	aptr<ImageType> output( new ImageType( input.width(), input.height() ) );
+	threshold( imageView( input ), imageView( *output ), thresh, invert );
 	return output;
 }
 template aptr<ImageGrayU> threshold( const ImageGrayU &input, float thresh, bool invert );
 template aptr<ImageGrayF> threshold( const ImageGrayF &input, float thresh, bool invert );
 
 
+/// apply threshold to image values
+template <typename T> void threshold( const ImageView<T, 1> &input, ImageView<T, 1> output, float thresh, bool invert ) {
+	int width = input.width(), height = input.height();
+	assertAlways( output.width() == width && output.height() == height );
+	T high = invert ? 0 : 255;
+	T low = invert ? 255 : 0;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++)
+			thresholdRow( input.row( y ), thresh, high, low, output.row( y ), width );
+	} );
+}
+template void threshold( const ImageViewGrayU &input, ImageViewGrayU output, float thresh, bool invert );
+template void threshold( const ImageViewGrayF &input, ImageViewGrayF output, float thresh, bool invert );
+
+
 /// invert a floating point image, assuming values in [0, 1]
 // fix(faster): use openCV
 aptr<ImageGrayF> invert( const ImageGrayF &input ) {
@@ -247,13 +705,31 @@ aptr<ImageGrayF> invert( const ImageGrayF &input ) {
 /// apply a box filter and then threshold
 aptr<ImageGrayU> blurBoxAndThreshold( const ImageGrayU &input, int boxSize, int thresh ) {
 	int width = input.width(), height = input.height();
-	aptr<ImageGrayU> output(new ImageGrayU(width, height));
-#ifdef USE_OPENCV
-	cv::blur(input.cvMat(), output->cvMat(), cv::Size(boxSize, boxSize));
-	cv::threshold(output->cvMat(), output->cvMat(), thresh, 255, cv::THRESH_BINARY);
-#else
-	fatalError("blurBoxAndThreshold not implemented");
+	IntegralImageGray integral( imageView( input ), false );
+	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		VectorF means( width );
+		for (int y = yBegin; y < yEnd; y++) {
+			integral.windowMeanRow( y, boxSize, means.dataPtr() );
+			unsigned char *out = output->row( y );
+
+			// compare the rounded mean (as with an 8-bit blurred image): round( mean ) > thresh is the same as mean >= thresh + 0.5
+			float meanThresh = (float) thresh + 0.5f;
+			const float *mean = means.dataPtr();
+			int x = 0;
+#ifdef __SSE2__
+			__m128 t = _mm_set1_ps( meanThresh );
+			for (; x + 8 <= width; x += 8) {
+				__m128i lo = _mm_castps_si128( _mm_cmpge_ps( _mm_loadu_ps( mean + x ), t ) );
+				__m128i hi = _mm_castps_si128( _mm_cmpge_ps( _mm_loadu_ps( mean + x + 4 ), t ) );
+				__m128i v = _mm_packs_epi32( lo, hi );
+				_mm_storel_epi64( (__m128i *) (out + x), _mm_packs_epi16( v, v ) );
+			}
 #endif
+			for (; x < width; x++)
+				out[ x ] = mean[ x ] >= meanThresh ? 255 : 0;
+		}
+	} );
 	return output;
 }
 
@@ -261,15 +737,16 @@ aptr<ImageGrayU> blurBoxAndThreshold( const ImageGrayU &input, int boxSize, int
 /// apply a box filter and then threshold
 aptr<ImageGrayU> blurBoxAndThreshold( const ImageGrayF &input, int boxSize, float thresh ) {
 	int width = input.width(), height = input.height();
-	ImageGrayF smooth( width, height );
+	aptr<ImageGrayF> smooth = blurBox( input, boxSize );
 	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
-#ifdef USE_OPENCV
-	fatalError("blurBoxAndThreshold not implemented");
-	// cvSmooth( input.iplImage(), smooth.iplImage(), CV_BLUR, boxSize, boxSize);
-	// cvThreshold( smooth.iplImage(), output->iplImage(), thresh, 255, CV_THRESH_BINARY);
-#else
-	fatalError("blurBoxAndThreshold not implemented");
-#endif
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			const float *in = smooth->row( y );
+			unsigned char *out = output->row( y );
+			for (int x = 0; x < width; x++)
+				out[ x ] = in[ x ] > thresh ? 255 : 0;
+		}
+	} );
 	return output;
 }
 
@@ -284,45 +761,78 @@ void multiply( const ImageGrayF &input, float factor, ImageGrayF &output ) {
 }
 
 
+// shift the values of a row by 128 minus the (rounded) window means, saturating to [0, 255];
+// offsets is a buffer of width * channelCount values
+void normalizeBrightnessRow( const unsigned char *in, const float *means, int channelCount, short *offsets, unsigned char *out, int width ) {
+
+	// compute the offset for each value
+	int x = 0;
+#ifdef __SSE2__
+	if (channelCount == 1) {
+		__m128 half = _mm_set1_ps( 0.5f );
+		__m128i center = _mm_set1_epi16( 128 );
+		for (; x + 8 <= width; x += 8) {
+			__m128i meanLo = _mm_cvttps_epi32( _mm_add_ps( _mm_loadu_ps( means + x ), half ) );
+			__m128i meanHi = _mm_cvttps_epi32( _mm_add_ps( _mm_loadu_ps( means + x + 4 ), half ) );
+			_mm_storeu_si128( (__m128i *) (offsets + x), _mm_sub_epi16( center, _mm_packs_epi32( meanLo, meanHi ) ) );
+		}
+	}
+#endif
+	for (; x < width; x++) {
+		short offset = (short) (128 - (int) (means[ x ] + 0.5f));
+		for (int c = 0; c < channelCount; c++)
+			offsets[ x * channelCount + c ] = offset;
+	}
+
+	// add the offsets
+	int count = width * channelCount, i = 0;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128( (const __m128i *) (in + i) );
+		__m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( v, zero ), _mm_loadu_si128( (const __m128i *) (offsets + i) ) );
+		__m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( v, zero ), _mm_loadu_si128( (const __m128i *) (offsets + i + 8) ) );
+		_mm_storeu_si128( (__m128i *) (out + i), _mm_packus_epi16( lo, hi ) );
+	}
+#endif
+	for (; i < count; i++) {
+		int val = in[ i ] + offsets[ i ];
+		out[ i ] = (unsigned char) (val < 0 ? 0 : (val > 255 ? 255 : val));
+	}
+}
+
+
 /// perform local brightness normalization
 aptr<ImageColorU> normalizeLocalBrightness( const ImageColorU &input, int windowSize ) {
 	aptr<ImageGrayU> gray = toGray( input );
-	aptr<ImageGrayU> blur = blurBox( *gray, windowSize );
 	int width = input.width(), height = input.height();
+	IntegralImageGray integral( imageView( *gray ), false );
 	aptr<ImageColorU> output( new ImageColorU( width, height ) );
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			int offset = 128 - blur->data( x, y );
-			for (int c = 0; c < 3; c++) {
-				int val = input.data( x, y, c ) + offset;
-				if (val < 0)
-					val = 0;
-				if (val > 255)
-					val = 255;
-				output->data( x, y, c ) = val;
-			}
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		VectorF means( width );
+		Vector<short> offsets( width * 3 );
+		for (int y = yBegin; y < yEnd; y++) {
+			integral.windowMeanRow( y, windowSize, means.dataPtr() );
+			normalizeBrightnessRow( input.row( y ), means.dataPtr(), 3, offsets.dataPtr(), output->row( y ), width );
 		}
-	}
+	} );
 	return output;
 }
 
 
 /// perform local brightness normalization
 aptr<ImageGrayU> normalizeLocalBrightness( const ImageGrayU &input, int windowSize ) {
-	aptr<ImageGrayU> blur = blurBox( input, windowSize );
 	int width = input.width(), height = input.height();
+	IntegralImageGray integral( imageView( input ), false );
 	aptr<ImageGrayU> output( new ImageGrayU( width, height ) );
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			int offset = 128 - blur->data( x, y );
-			int val = input.data( x, y ) + offset;
-			if (val < 0)
-				val = 0;
-			if (val > 255)
-				val = 255;
-			output->data( x, y ) = val;
+	parallelFor( 0, height, IMAGE_BAND_ROWS, [&]( int yBegin, int yEnd ) {
+		VectorF means( width );
+		Vector<short> offsets( width );
+		for (int y = yBegin; y < yEnd; y++) {
+			integral.windowMeanRow( y, windowSize, means.dataPtr() );
+			normalizeBrightnessRow( input.row( y ), means.dataPtr(), 1, offsets.dataPtr(), output->row( y ), width );
 		}
-	}
+	} );
 	return output;
 }
 
@@ -332,56 +842,289 @@ aptr<ImageGrayU> normalizeLocalBrightness( const ImageGrayU &input, int windowSi
 //-------------------------------------------
 
 
+// the number of rows per parallel band for reductions (each band computes a partial result)
+#define REDUCE_BAND_ROWS 32
+
+
+// compute partial results for bands of REDUCE_BAND_ROWS rows on the worker threads (each starting as a copy of result),
+// using body( rowBegin, rowEnd, partial ), and combine them into result in band order using combine( result, partial );
+// the bands and the order don't depend on the scheduling, so floating-point results are the same for any number of threads
+template <typename T, typename F, typename C> void reduceRows( int height, T &result, const F &body, const C &combine ) {
+	int bandCount = (height + REDUCE_BAND_ROWS - 1) / REDUCE_BAND_ROWS;
+	Array<T> partials;
+	for (int i = 0; i < bandCount; i++)
+		partials.append( new T( result ) );
+	parallelFor( 0, height, REDUCE_BAND_ROWS, [&]( int begin, int end ) {
+		for (int bandBegin = begin; bandBegin < end; bandBegin += REDUCE_BAND_ROWS) {
+			int bandEnd = bandBegin + REDUCE_BAND_ROWS < end ? bandBegin + REDUCE_BAND_ROWS : end;
+			body( bandBegin, bandEnd, partials[ bandBegin / REDUCE_BAND_ROWS ] );
+		}
+	} );
+	for (int i = 0; i < bandCount; i++)
+		combine( result, partials[ i ] );
+}
+
+
+// the sum of a row of 8-bit values
+inline unsigned long long sumRow( const unsigned char *row, int count ) {
+	unsigned long long sum = 0;
+	int i = 0;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128(), sumVec = zero;
+	for (; i + 16 <= count; i += 16)
+		sumVec = _mm_add_epi64( sumVec, _mm_sad_epu8( _mm_loadu_si128( (const __m128i *) (row + i) ), zero ) );
+	sumVec = _mm_add_epi64( sumVec, _mm_srli_si128( sumVec, 8 ) );
+	sum = (unsigned int) _mm_cvtsi128_si32( sumVec );
+#endif
+	for (; i < count; i++)
+		sum += row[ i ];
+	return sum;
+}
+
+
+// the sum of absolute differences between two rows of 8-bit values
+inline unsigned long long absDiffRow( const unsigned char *row1, const unsigned char *row2, int count ) {
+	unsigned long long sum = 0;
+	int i = 0;
+#ifdef __SSE2__
+	__m128i sumVec = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+		sumVec = _mm_add_epi64( sumVec, _mm_sad_epu8( _mm_loadu_si128( (const __m128i *) (row1 + i) ), _mm_loadu_si128( (const __m128i *) (row2 + i) ) ) );
+	sumVec = _mm_add_epi64( sumVec, _mm_srli_si128( sumVec, 8 ) );
+	sum = (unsigned int) _mm_cvtsi128_si32( sumVec );
+#endif
+	for (; i < count; i++)
+		sum += abs( row1[ i ] - row2[ i ] );
+	return sum;
+}
+
+
+// the number of non-zero values in a row
+inline int nonZeroCountRow( const unsigned char *row, int count ) {
+	int zeroCount = 0, i = 0;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8( 1 ), countVec = zero;
+	for (; i + 16 <= count; i += 16) {
+		__m128i isZero = _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) (row + i) ), zero );
+		countVec = _mm_add_epi64( countVec, _mm_sad_epu8( _mm_and_si128( isZero, one ), zero ) );
+	}
+	countVec = _mm_add_epi64( countVec, _mm_srli_si128( countVec, 8 ) );
+	zeroCount = _mm_cvtsi128_si32( countVec );
+#endif
+	for (; i < count; i++)
+		if (row[ i ] == 0)
+			zeroCount++;
+	return count - zeroCount;
+}
+
+
+// find the first and last non-zero values in a row; returns false if there are none
+inline bool nonZeroRangeRow( const unsigned char *row, int count, int &first, int &last ) {
+	first = 0;
+	last = count - 1;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128();
+	while (first + 16 <= count && _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) (row + first) ), zero ) ) == 0xffff)
+		first += 16;
+#endif
+	while (first < count && row[ first ] == 0)
+		first++;
+	if (first == count)
+		return false;
+#ifdef __SSE2__
+	while (last - 15 > first && _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i *) (row + last - 15) ), zero ) ) == 0xffff)
+		last -= 16;
+#endif
+	while (row[ last ] == 0)
+		last--;
+	return true;
+}
+
+
+// add the sums of each channel of a row of interleaved 3-channel values
+inline void channelSumRow( const unsigned char *row, int width, unsigned long long *sums ) {
+	int x = 0;
+#ifdef __SSE2__
+
+	// 16 pixels are 3 vectors; byte j of vector k belongs to channel (16 * k + j) % 3, so we sum each channel using masks
+	__m128i zero = _mm_setzero_si128(), masks[ 3 ][ 3 ], sumVec[ 3 ] = { zero, zero, zero };
+	for (int k = 0; k < 3; k++) {
+		for (int c = 0; c < 3; c++) {
+			unsigned char bytes[ 16 ];
+			for (int j = 0; j < 16; j++)
+				bytes[ j ] = (16 * k + j) % 3 == c ? 255 : 0;
+			masks[ k ][ c ] = _mm_loadu_si128( (const __m128i *) bytes );
+		}
+	}
+	for (; x + 16 <= width; x += 16) {
+		for (int k = 0; k < 3; k++) {
+			__m128i v = _mm_loadu_si128( (const __m128i *) (row + x * 3 + k * 16) );
+			for (int c = 0; c < 3; c++)
+				sumVec[ c ] = _mm_add_epi64( sumVec[ c ], _mm_sad_epu8( _mm_and_si128( v, masks[ k ][ c ] ), zero ) );
+		}
+	}
+	for (int c = 0; c < 3; c++)
+		sums[ c ] += (unsigned int) _mm_cvtsi128_si32( _mm_add_epi64( sumVec[ c ], _mm_srli_si128( sumVec[ c ], 8 ) ) );
+#endif
+	for (; x < width; x++) {
+		sums[ 0 ] += row[ x * 3 ];
+		sums[ 1 ] += row[ x * 3 + 1 ];
+		sums[ 2 ] += row[ x * 3 + 2 ];
+	}
+}
+
+
+// update the min and max of a row of 8-bit values
+inline void minMaxRow( const unsigned char *row, int count, int &min, int &max ) {
+	int i = 0;
+#ifdef __SSE2__
+	if (count >= 16) {
+		__m128i minVec = _mm_loadu_si128( (const __m128i *) row ), maxVec = minVec;
+		for (i = 16; i + 16 <= count; i += 16) {
+			__m128i v = _mm_loadu_si128( (const __m128i *) (row + i) );
+			minVec = _mm_min_epu8( minVec, v );
+			maxVec = _mm_max_epu8( maxVec, v );
+		}
+		unsigned char mins[ 16 ], maxs[ 16 ];
+		_mm_storeu_si128( (__m128i *) mins, minVec );
+		_mm_storeu_si128( (__m128i *) maxs, maxVec );
+		for (int j = 0; j < 16; j++) {
+			if (mins[ j ] < min) min = mins[ j ];
+			if (maxs[ j ] > max) max = maxs[ j ];
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		int v = row[ i ];
+		if (v < min) min = v;
+		if (v > max) max = v;
+	}
+}
+
+
+// add the sum (in double precision) of a row of float values and update their min and max
+inline void floatStatsRow( const float *row, int count, double &sum, float &min, float &max ) {
+	int i = 0;
+#ifdef __SSE2__
+	if (count >= 4) {
+		__m128 first = _mm_loadu_ps( row ), minVec = first, maxVec = first;
+		__m128d sumLow = _mm_setzero_pd(), sumHigh = sumLow;
+		for (; i + 4 <= count; i += 4) {
+			__m128 v = _mm_loadu_ps( row + i );
+			minVec = _mm_min_ps( minVec, v );
+			maxVec = _mm_max_ps( maxVec, v );
+			sumLow = _mm_add_pd( sumLow, _mm_cvtps_pd( v ) );
+			sumHigh = _mm_add_pd( sumHigh, _mm_cvtps_pd( _mm_movehl_ps( v, v ) ) );
+		}
+		float mins[ 4 ], maxs[ 4 ];
+		double sums[ 2 ];
+		_mm_storeu_ps( mins, minVec );
+		_mm_storeu_ps( maxs, maxVec );
+		_mm_storeu_pd( sums, _mm_add_pd( sumLow, sumHigh ) );
+		sum += sums[ 0 ] + sums[ 1 ];
+		for (int j = 0; j < 4; j++) {
+			if (mins[ j ] < min) min = mins[ j ];
+			if (maxs[ j ] > max) max = maxs[ j ];
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		float v = row[ i ];
+		sum += v;
+		if (v < min) min = v;
+		if (v > max) max = v;
+	}
+}
+
+
+// add the values of a row to a 256-bin histogram; uses four sub-histograms (each with 256 bins) so that
+// runs of equal values do not wait on each other's updates
+inline void histogramRow( const unsigned char *row, int count, unsigned int *subHistograms ) {
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		subHistograms[ row[ i ] ]++;
+		subHistograms[ 256 + row[ i + 1 ] ]++;
+		subHistograms[ 512 + row[ i + 2 ] ]++;
+		subHistograms[ 768 + row[ i + 3 ] ]++;
+	}
+	for (; i < count; i++)
+		subHistograms[ row[ i ] ]++;
+}
+
+
+// compute a histogram of the pixel values, using per-band histograms on the worker threads
+void histogram256( const ImageViewGrayU &img, int *hist ) {
+	int width = img.width();
+	for (int i = 0; i < 256; i++)
+		hist[ i ] = 0;
+	std::mutex combineMutex;
+	parallelFor( 0, img.height(), REDUCE_BAND_ROWS, [&]( int begin, int end ) {
+		Vector<unsigned int> subHistograms( 1024 );
+		subHistograms.clear( 0 );
+		for (int y = begin; y < end; y++)
+			histogramRow( img.row( y ), width, subHistograms.dataPtr() );
+		std::lock_guard<std::mutex> lock( combineMutex );
+		for (int i = 0; i < 256; i++)
+			hist[ i ] += subHistograms[ i ] + subHistograms[ 256 + i ] + subHistograms[ 512 + i ] + subHistograms[ 768 + i ];
+	} );
+}
+
+
 /// compute mean pixel value
-float mean( const ImageGrayU &img ) {
-	int width = img.width(), height = img.height();
-	double sum = 0;
-	for (int y = 0; y < height; y++)
-		for (int x = 0; x < width; x++)
-			sum += (double) img.data( x, y );
-	return (float) (sum / (double) (width * height));
+float mean( const ImageViewGrayU &img ) {
+	int width = img.width();
+	unsigned long long sum = 0;
+	reduceRows( img.height(), sum, [&]( int begin, int end, unsigned long long &partial ) {
+		for (int y = begin; y < end; y++)
+			partial += sumRow( img.row( y ), width );
+	}, []( unsigned long long &result, unsigned long long partial ) { result += partial; } );
+	return (float) ((double) sum / (double) (width * img.height()));
 }
 
 
 /// compute mean pixel value
-float mean( const ImageGrayF &img ) {
-	int width = img.width(), height = img.height();
-	double sum = 0;
-	for (int y = 0; y < height; y++)
-		for (int x = 0; x < width; x++)
-			sum += img.data( x, y );
-	return (float) (sum / (double) (width * height));
+float mean( const ImageViewGrayF &img ) {
+	float min = 0, max = 0, meanValue = 0;
+	imageStats( img, min, meanValue, max );
+	return meanValue;
 }
 
 
 /// compute mean pixel value
-float mean( const ImageColorU &img ) {
-	int width = img.width(), height = img.height();
-	int sum = 0;
-	for (int y = 0; y < height; y++) 
-		for (int x = 0; x < width; x++)
-			for (int c = 0; c < 3; c++) 
-				sum += img.data( x, y, c );
-	return (float) ((double) sum / (double) (width * height * 3));
+float mean( const ImageViewColorU &img ) {
+	int width = img.width();
+	unsigned long long sum = 0;
+	reduceRows( img.height(), sum, [&]( int begin, int end, unsigned long long &partial ) {
+		for (int y = begin; y < end; y++)
+			partial += sumRow( img.row( y ), width * 3 );
+	}, []( unsigned long long &result, unsigned long long partial ) { result += partial; } );
+	return (float) ((double) sum / (double) (width * img.height() * 3));
 }
 
 
+// sums of each channel, used by channelMean
+struct ChannelSums {
+	unsigned long long sums[ 3 ];
+	ChannelSums() { sums[ 0 ] = sums[ 1 ] = sums[ 2 ] = 0; }
+};
+
+
 /// compute mean pixel value of each color channel
-void channelMean( const ImageColorU &img, float &rMean, float &gMean, float &bMean ) {
+void channelMean( const ImageViewColorU &img, float &rMean, float &gMean, float &bMean ) {
 	int width = img.width(), height = img.height();
-	int rSum = 0, gSum = 0, bSum = 0; // fix(later): could overflow
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			rSum += img.r( x, y );
-			gSum += img.g( x, y );
-			bSum += img.b( x, y );
-		}
-	}
+	ChannelSums sums;
+	reduceRows( height, sums, [&]( int begin, int end, ChannelSums &partial ) {
+		for (int y = begin; y < end; y++)
+			channelSumRow( img.row( y ), width, partial.sums );
+	}, []( ChannelSums &result, const ChannelSums &partial ) {
+		for (int c = 0; c < 3; c++)
+			result.sums[ c ] += partial.sums[ c ];
+	} );
 	int size = width * height;
 	if (size) {
-		rMean = (float) (rSum / size);
-		gMean = (float) (gSum / size);
-		bMean = (float) (bSum / size);
+		rMean = (float) ((double) sums.sums[ R_CHANNEL ] / size);
+		gMean = (float) ((double) sums.sums[ G_CHANNEL ] / size);
+		bMean = (float) ((double) sums.sums[ B_CHANNEL ] / size);
 	} else {
 		rMean = 0;
 		gMean = 0;
@@ -391,177 +1134,200 @@ void channelMean( const ImageColorU &img, float &rMean, float &gMean, float &bMe
 
 
 /// compute mean absolute difference between pixel values
-// fix(faster): add OpenCV version
-float meanAbsDiff( const ImageColorU &img1, const ImageColorU &img2 ) {
+float meanAbsDiff( const ImageViewColorU &img1, const ImageViewColorU &img2 ) {
 	int width = img1.width(), height = img1.height();
 	assertAlways( img2.width() == width && img2.height() == height );
-	int sum = 0;
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			for (int c = 0; c < 3; c++) {
-				int diff = img1.data( x, y, c ) - img2.data( x, y, c );
-				if (diff < 0)
-					diff = -diff;
-				sum += diff;
-			}
-		}
-	}
-	return (float) ((double) sum / (double) width * height * 3);
+	unsigned long long sum = 0;
+	reduceRows( height, sum, [&]( int begin, int end, unsigned long long &partial ) {
+		for (int y = begin; y < end; y++)
+			partial += absDiffRow( img1.row( y ), img2.row( y ), width * 3 );
+	}, []( unsigned long long &result, unsigned long long partial ) { result += partial; } );
+	return (float) ((double) sum / (double) (width * height * 3));
 }
 
 
 /// compute mean absolute difference between pixel values
-// fix(faster): add OpenCV version
-float meanAbsDiff( const ImageGrayU &img1, const ImageGrayU &img2, int xBorder, int yBorder ) {
+float meanAbsDiff( const ImageViewGrayU &img1, const ImageViewGrayU &img2 ) {
 	int width = img1.width(), height = img1.height();
 	assertAlways( img2.width() == width && img2.height() == height );
-	double sum = 0;
-	for (int y = yBorder; y < height - yBorder; y++) {
-		for (int x = xBorder; x < width - xBorder; x++) {
-			int diff = img1.data( x, y ) - img2.data( x, y );
-			if (diff < 0)
-				diff = -diff;
-			sum += diff;
-		}
-	}
-	int size = (width - 2 * xBorder) * (height - 2 * yBorder);
-	return (float) ((double) sum / (double) size);
+	unsigned long long sum = 0;
+	reduceRows( height, sum, [&]( int begin, int end, unsigned long long &partial ) {
+		for (int y = begin; y < end; y++)
+			partial += absDiffRow( img1.row( y ), img2.row( y ), width );
+	}, []( unsigned long long &result, unsigned long long partial ) { result += partial; } );
+	return (float) ((double) sum / (double) (width * height));
 }
 
 
-/// compute mutual info between a pair of images
-float mutualInfo( const ImageGrayU &img1, const ImageGrayU &img2, int xBorder, int yBorder, int bucketCount ) {
-	int width = img1.width(), height = img1.height();
-	assertAlways( img2.width() == width && img2.height() == height );
-
-	// build histogram
-	MatrixD histogram( bucketCount, bucketCount );
-	histogram.clear( 0 );
-	for (int y = yBorder; y < height - yBorder; y++) {
-		for (int x = xBorder; x < width - xBorder; x++) {
-			int i = bound( img1.data( x, y ) * (bucketCount - 1) / 255, 0, bucketCount - 1 );
-			int j = bound( img2.data( x, y ) * (bucketCount - 1) / 255, 0, bucketCount - 1 );
-			histogram.data( i, j )++;
-		}
-	}
+/// compute mean absolute difference between pixel values, ignoring the given border
+float meanAbsDiff( const ImageGrayU &img1, const ImageGrayU &img2, int xBorder, int yBorder ) {
+	return meanAbsDiff( imageView( img1 ).inner( xBorder, yBorder ), imageView( img2 ).inner( xBorder, yBorder ) );
+}
 
-	// normalize histogram
-	double factor = 1.0 / histogram.sum();
-	multiply( histogram, factor, histogram );
 
-	// compute joint entropy
-	double hxy = 0;
-	for (int j = 0; j < bucketCount; j++) {
-		for (int i = 0; i < bucketCount; i++) {
-			double v = histogram.data( i, j );
-			if (v > 1e-10)
-				hxy -= v * log( v );
-		}
-	}
+/// compute mutual info between a pair of images
+float mutualInfo( const ImageViewGrayU &img1, const ImageViewGrayU &img2, int bucketCount ) {
+	JointHistogram histogram( bucketCount );
+	histogram.add( img1, img2 );
+	return (float) histogram.mutualInfo();
+}
 
-	// get marginal entropies
-	double hx = entropy( rowSum( histogram ) );
-	double hy = entropy( colSum( histogram ) );
 
-	// return mutual information
-	return (float) (hx + hy - hxy);
+/// compute mutual info between a pair of images, ignoring the given border
+float mutualInfo( const ImageGrayU &img1, const ImageGrayU &img2, int xBorder, int yBorder, int bucketCount ) {
+	return mutualInfo( imageView( img1 ).inner( xBorder, yBorder ), imageView( img2 ).inner( xBorder, yBorder ), bucketCount );
 }
 
 
-/// compute bounds of the non-zero mask region
-void maskBounds( const ImageGrayU &mask, int &xMin, int &xMax, int &yMin, int &yMax ) {
+// bounds of non-zero values, used by maskBounds
+struct MaskBounds {
+	int xMin;
+	int xMax;
+	int yMin;
+	int yMax;
+};
+
+
+/// compute bounds of the non-zero mask region (in view coordinates)
+void maskBounds( const ImageViewGrayU &mask, int &xMin, int &xMax, int &yMin, int &yMax ) {
 	int width = mask.width(), height = mask.height();
-	xMin = width;
-	xMax = -1;
-	yMin = height;
-	yMax = -1;
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			if (mask.data( x, y )) {
-				if (x < xMin)
-					xMin = x;
-				if (x > xMax)
-					xMax = x;
-				if (y < yMin)
-					yMin = y;
-				if (y > yMax)
-					yMax = y;
+	MaskBounds bounds = { width, -1, height, -1 };
+	reduceRows( height, bounds, [&]( int begin, int end, MaskBounds &partial ) {
+		for (int y = begin; y < end; y++) {
+			int first = 0, last = 0;
+			if (nonZeroRangeRow( mask.row( y ), width, first, last )) {
+				if (first < partial.xMin)
+					partial.xMin = first;
+				if (last > partial.xMax)
+					partial.xMax = last;
+				if (y < partial.yMin)
+					partial.yMin = y;
+				partial.yMax = y;
 			}
 		}
-	}
+	}, []( MaskBounds &result, const MaskBounds &partial ) {
+		if (partial.xMin < result.xMin) result.xMin = partial.xMin;
+		if (partial.xMax > result.xMax) result.xMax = partial.xMax;
+		if (partial.yMin < result.yMin) result.yMin = partial.yMin;
+		if (partial.yMax > result.yMax) result.yMax = partial.yMax;
+	} );
+	xMin = bounds.xMin;
+	xMax = bounds.xMax;
+	yMin = bounds.yMin;
+	yMax = bounds.yMax;
 }
 
 
 /// count number of non-zero entries in mask
-int maskCount( const ImageGrayU &mask ) {
-	int width = mask.width(), height = mask.height();
+int maskCount( const ImageViewGrayU &mask ) {
+	int width = mask.width();
 	int count = 0;
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			if (mask.data( x, y ))
-				count++;
-		}
-	}
+	reduceRows( mask.height(), count, [&]( int begin, int end, int &partial ) {
+		for (int y = begin; y < end; y++)
+			partial += nonZeroCountRow( mask.row( y ), width );
+	}, []( int &result, int partial ) { result += partial; } );
 	return count;
 }
 
 
+// min, max, and sum of 8-bit values, used by imageStats
+struct ByteStats {
+	int min;
+	int max;
+	unsigned long long sum;
+};
+
 
 /// compute min/mean/max pixel values
-void imageStats( const ImageGrayU &img, int &minRet, float &meanRet, int &maxRet ) {
-	double sum = 0;
-	int min = img.data( 0, 0 );
-	int max = min;
+void imageStats( const ImageViewGrayU &img, int &minRet, float &meanRet, int &maxRet ) {
 	int width = img.width(), height = img.height();
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			int v = img.data( x, y );
-			sum += (double) v;
-			if (v < min)
-				min = v;
-			if (v > max)
-				max = v;
+	ByteStats stats = { 255, 0, 0 };
+	reduceRows( height, stats, [&]( int begin, int end, ByteStats &partial ) {
+		for (int y = begin; y < end; y++) {
+			const unsigned char *row = img.row( y );
+			minMaxRow( row, width, partial.min, partial.max );
+			partial.sum += sumRow( row, width );
+		}
+	}, []( ByteStats &result, const ByteStats &partial ) {
+		if (partial.min < result.min) result.min = partial.min;
+		if (partial.max > result.max) result.max = partial.max;
+		result.sum += partial.sum;
+	} );
+	int pixelCount = width * height;
+	if (pixelCount == 0)
+		stats.min = stats.max = 0;
+	meanRet = pixelCount ? (float) ((double) stats.sum / (double) pixelCount) : 0;
+	minRet = stats.min;
+	maxRet = stats.max;
+}
+
+
+/// compute min/mean/max pixel values and the histogram of pixel values (with 256 bins) in one pass
+void imageStats( const ImageViewGrayU &img, int &minRet, float &meanRet, int &maxRet, VectorI &histogram ) {
+	histogram.setLength( 256 );
+	histogram256( img, histogram.dataPtr() );
+
+	// the other stats follow from the histogram
+	long long count = 0, sum = 0;
+	minRet = 0;
+	maxRet = 0;
+	for (int i = 0; i < 256; i++) {
+		if (histogram[ i ]) {
+			if (count == 0)
+				minRet = i;
+			maxRet = i;
+			count += histogram[ i ];
+			sum += (long long) histogram[ i ] * i;
 		}
 	}
-	meanRet = (float) (sum / (double) (width * height));
-	minRet = min;
-	maxRet = max;
+	meanRet = count ? (float) ((double) sum / (double) count) : 0;
 }
 
 
+// min, max, and sum of float values, used by imageStats
+struct FloatStats {
+	float min;
+	float max;
+	double sum;
+};
+
+
 /// compute min/mean/max pixel values
-void imageStats( const ImageGrayF &img, float &minRet, float &meanRet, float &maxRet ) {
-	double sum = 0;
-	float min = img.data( 0, 0 );
-	float max = min;
+void imageStats( const ImageViewGrayF &img, float &minRet, float &meanRet, float &maxRet ) {
 	int width = img.width(), height = img.height();
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			float v = img.data( x, y );
-			sum += v;
-			if (v < min)
-				min = v;
-			if (v > max)
-				max = v;
-		}
+	if (width * height == 0) {
+		minRet = meanRet = maxRet = 0;
+		return;
 	}
-	meanRet = (float) (sum / (double) (width * height));
-	minRet = min;
-	maxRet = max;
+	FloatStats stats = { img.data( 0, 0 ), img.data( 0, 0 ), 0 };
+	reduceRows( height, stats, [&]( int begin, int end, FloatStats &partial ) {
+		for (int y = begin; y < end; y++)
+			floatStatsRow( img.row( y ), width, partial.sum, partial.min, partial.max );
+	}, []( FloatStats &result, const FloatStats &partial ) {
+		if (partial.min < result.min) result.min = partial.min;
+		if (partial.max > result.max) result.max = partial.max;
+		result.sum += partial.sum;
+	} );
+	meanRet = (float) (stats.sum / (double) (width * height));
+	minRet = stats.min;
+	maxRet = stats.max;
 }
 
 
 /// compute histogram of image pixel values
-VectorI imageHistogram( const ImageGrayU &image, int xMin, int xMax, int yMin, int yMax ) {
+VectorI imageHistogram( const ImageViewGrayU &image ) {
 	VectorI hist( 256 );
-	hist.clear( 0 );
-	for (int y = yMin; y <= yMax; y++)
-		for (int x = xMin; x <= xMax; x++)
-			hist[ image.data( x, y ) ]++;
+	histogram256( image, hist.dataPtr() );
 	return hist;
 }
 
 
+/// compute histogram of image pixel values within the given (inclusive) bounds
+VectorI imageHistogram( const ImageGrayU &image, int xMin, int xMax, int yMin, int yMax ) {
+	return imageHistogram( ImageViewGrayU( image, xMin, yMin, xMax - xMin + 1, yMax - yMin + 1 ) );
+}
+
+
 //-------------------------------------------
 // IMAGE FILE I/O
 //-------------------------------------------
@@ -586,6 +1352,10 @@ template <typename ImageType> aptr<ImageType> load( const String &fileName ) {
 	aptr<ImageType> img;
 #ifdef USE_OPENCV
 	cv::Mat mat = cv::imread(fileName.c_str());
+	if (mat.empty()) {
+		warning( "unable to load image: %s", fileName.c_str() );
+		return img;
+	}
 	img.reset(new ImageType(mat));
 #else
 	fatalError("load image not implemented");
@@ -699,44 +1469,41 @@ int floodFill( ImageGrayU &img, int minRegionValue, int maxRegionValue, int fill
 /// keep only mask components that have a pixel count within the given range (assumes mask has only 0 and 255 values)
 void filterMaskComponents( ImageGrayU &mask, int minSize, int maxSize ) {
 	int width = mask.width(), height = mask.height();
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			if (mask.data( x, y ) == 255) {
-				int count = floodFill( mask, 255, 255, 200, x, y );
-				if (count < minSize || count > maxSize) {
-					floodFill( mask, 200, 200, 0, x, y );
+	ImageGrayI labels( width, height );
+	Vector<ComponentStats> stats;
+	labelComponents( imageView( mask ), 255, 255, false, labels, &stats );
+	parallelFor( 0, height, 16, [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const int *labelRow = labels.row( y );
+			unsigned char *maskRow = mask.row( y );
+			for (int x = 0; x < width; x++) {
+				if (labelRow[ x ]) {
+					int count = stats[ labelRow[ x ] - 1 ].area;
+					if (count < minSize || count > maxSize)
+						maskRow[ x ] = 0;
 				}
 			}
 		}
-	}
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			if (mask.data( x, y ) == 200)
-				mask.data( x, y ) = 255;
-		}
-	}
+	} );
 }
 
 
 /// fill holes in mask smaller than given size (assumes mask has only 0 and 255 values)
 void fillMaskHoles( ImageGrayU &mask, int maxSize ) {
 	int width = mask.width(), height = mask.height();
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			if (mask.data( x, y ) == 0) {
-				int count = floodFill( mask, 0, 0, 100, x, y );
-				if (count < maxSize) {
-					floodFill( mask, 100, 100, 255, x, y );
-				}
+	ImageGrayI labels( width, height );
+	Vector<ComponentStats> stats;
+	labelComponents( imageView( mask ), 0, 0, false, labels, &stats );
+	parallelFor( 0, height, 16, [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const int *labelRow = labels.row( y );
+			unsigned char *maskRow = mask.row( y );
+			for (int x = 0; x < width; x++) {
+				if (labelRow[ x ] && stats[ labelRow[ x ] - 1 ].area < maxSize)
+					maskRow[ x ] = 255;
 			}
 		}
-	}
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			if (mask.data( x, y ) == 100)
-				mask.data( x, y ) = 0;
-		}
-	}
+	} );
 }
 
 
@@ -770,7 +1537,7 @@ bool lineIntersects( const ImageGrayU &mask, float x1, float y1, float x2, float
 /// (assumes points are inside image bounds)
 bool rectIntersects( const ImageGrayU &mask, int x1, int y1, int x2, int y2 ) {
 	assertAlways( y2 >= y1 );
-	assertAlways( x2 >= x2 );
+	assertAlways( x2 >= x1 );
 	for (int y = y1; y <= y2; y++) {
 		for (int x = x1; x <= x2; x++) {
 			if (mask.data( x, y ))
@@ -781,6 +1548,13 @@ bool rectIntersects( const ImageGrayU &mask, int x1, int y1, int x2, int y2 ) {
 }
 
 
+/// returns true if rectange intersects non-zero mask values, using an integral image of the mask
+bool rectIntersects( const IntegralImageGray &maskIntegral, int x1, int y1, int x2, int y2 ) {
+	assertAlways( x2 >= x1 && y2 >= y1 );
+	return maskIntegral.sum( x1, y1, x2, y2 ) != 0;
+}
+
+
 /// draw the an iso-contour of the mask on the given output image
 void drawMaskBoundary( ImageColorU &output, const ImageGrayU &mask, int thresh, int r, int g, int b, int xBorder, int yBorder ) {
 	int width = output.width(), height = output.height();
@@ -898,6 +1672,439 @@ void dispImage( const ImageGrayU &img, const String &label ) {
 }
 
 
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// check image row alignment, padding, and wrapping of external data
+bool testImageStorage() {
+
+	// rows should be aligned and padded
+	ImageGrayF img( 256, 5 );
+	unitAssert( ((size_t) img.raw()) % IMAGE_ROW_ALIGN == 0 );
+	unitAssert( img.rowBytes() == 256 * 4 + IMAGE_ROW_ALIGN );
+	ImageColorU colorImg( 7, 3 );
+	unitAssert( colorImg.rowBytes() == IMAGE_ROW_ALIGN && colorImg.isContiguous() == false );
+	for (int y = 0; y < 5; y++)
+		for (int x = 0; x < 256; x++)
+			img.data( x, y ) = (float) (x + y * 1000);
+
+	// copies and crops should preserve pixel values
+	ImageGrayF copy( img );
+	unitAssert( copy.data( 255, 4 ) == 4255 && copy.rowBytes() == img.rowBytes() );
+	aptr<ImageGrayF> cropped = crop( img, 10, 19, 2, 3 );
+	unitAssert( cropped->width() == 10 && cropped->data( 0, 0 ) == 2010 && cropped->data( 9, 1 ) == 3019 );
+
+	// a wrapped image should read and write the external data using the given stride
+	unsigned char buffer[ 4 * 10 ];
+	for (int i = 0; i < 40; i++)
+		buffer[ i ] = (unsigned char) i;
+	ImageGrayU wrapped( buffer + 1, 3, 4, 10 );
+	unitAssert( wrapped.data( 2, 3 ) == 33 );
+	wrapped.clear( 0 );
+	unitAssert( buffer[ 0 ] == 0 && buffer[ 1 ] == 0 && buffer[ 4 ] == 4 && buffer[ 31 ] == 0 && buffer[ 34 ] == 34 );
+	return true;
+}
+
+
+// check that image functions operate only on the region covered by a view
+bool testImageView() {
+	ImageGrayU img( 40, 30 );
+	for (int y = 0; y < 30; y++)
+		for (int x = 0; x < 40; x++)
+			img.data( x, y ) = (unsigned char) ((x * 7 + y * 3) % 256);
+
+	// stats on a view should match stats computed directly on the region
+	ImageViewGrayU view( img, 5, 4, 20, 10 );
+	double sum = 0;
+	int minValue = 255, maxValue = 0;
+	for (int y = 4; y < 14; y++) {
+		for (int x = 5; x < 25; x++) {
+			int v = img.data( x, y );
+			sum += v;
+			minValue = min( minValue, v );
+			maxValue = max( maxValue, v );
+		}
+	}
+	int viewMin = 0, viewMax = 0;
+	float viewMean = 0;
+	imageStats( view, viewMin, viewMean, viewMax );
+	unitAssert( viewMin == minValue && viewMax == maxValue && fabs( viewMean - sum / 200.0 ) < 1e-4 );
+	unitAssert( fabs( mean( view ) - sum / 200.0 ) < 1e-4 );
+	unitAssert( view.sub( 1, 2, 3, 4 ).data( 0, 0 ) == img.data( 6, 6 ) );
+
+	// writing through a view should only modify the region
+	ImageGrayU output( 40, 30 );
+	output.clear( 7 );
+	threshold( view, ImageViewGrayU( output, 5, 4, 20, 10 ), 100, false );
+	unitAssert( output.data( 4, 4 ) == 7 && output.data( 25, 13 ) == 7 && output.data( 5, 14 ) == 7 );
+	unitAssert( maskCount( ImageViewGrayU( output, 5, 4, 20, 10 ) ) == maskCount( *threshold( *crop( img, 5, 24, 4, 13 ), 100, false ) ) );
+
+	// border versions should match explicit inner views
+	ImageGrayU img2( img );
+	img2.data( 0, 0 ) = 200;
+	img2.data( 20, 15 ) = (unsigned char) (img.data( 20, 15 ) + 10);
+	unitAssert( fabs( meanAbsDiff( img, img2, 1, 1 ) - 10.0f / (38 * 28) ) < 1e-6 );
+	unitAssert( meanAbsDiff( imageView( img ).inner( 1, 1 ), imageView( img2 ).inner( 1, 1 ) ) == meanAbsDiff( img, img2, 1, 1 ) );
+	return true;
+}
+
+
+// check native image kernels against direct computations
+bool testImageKernels() {
+	int width = 37, height = 23;
+	ImageGrayU img( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			img.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+
+	// filters and resizing should preserve constant images
+	ImageColorU constant( width, height );
+	constant.clear( 77 );
+	unitAssert( blurBox( constant, 6 )->data( 0, 0, 1 ) == 77 && blurBox( constant, 6 )->data( width - 1, height - 1, 2 ) == 77 );
+	unitAssert( blurGauss( constant, 2.5f )->data( 3, 20, 0 ) == 77 );
+	unitAssert( resize( constant, 11, 9, true )->data( 10, 8, 2 ) == 77 && resize( constant, 80, 50, true )->data( 79, 0, 0 ) == 77 );
+	unitAssert( median( constant, 5 )->data( 0, 22, 0 ) == 77 );
+
+	// box filter should match a direct sum (with reflected borders)
+	aptr<ImageGrayU> box = blurBox( img, 5 );
+	for (int y = 0; y < height; y += 11) {
+		for (int x = 0; x < width; x += 9) {
+			int sum = 0;
+			for (int j = -2; j <= 2; j++) {
+				for (int i = -2; i <= 2; i++) {
+					int xs = x + i < 0 ? -(x + i) : (x + i >= width ? 2 * width - 2 - (x + i) : x + i);
+					int ys = y + j < 0 ? -(y + j) : (y + j >= height ? 2 * height - 2 - (y + j) : y + j);
+					sum += img.data( xs, ys );
+				}
+			}
+			unitAssert( abs( box->data( x, y ) - round( (float) sum / 25.0f ) ) <= 1 );
+		}
+	}
+
+	// median filters should match a direct computation (with replicated borders)
+	for (int apertureSize = 3; apertureSize <= 7; apertureSize += 2) {
+		aptr<ImageGrayU> med = median( img, apertureSize );
+		int radius = apertureSize / 2;
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				VectorI values;
+				for (int j = -radius; j <= radius; j++)
+					for (int i = -radius; i <= radius; i++)
+						values.append( img.data( bound( x + i, 0, width - 1 ), bound( y + j, 0, height - 1 ) ) );
+				values.sort();
+				unitAssert( med->data( x, y ) == values[ values.length() / 2 ] );
+			}
+		}
+	}
+
+	// Sobel gradients of a ramp
+	ImageGrayF ramp( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			ramp.data( x, y ) = 2.0f * x;
+	unitAssert( xGrad( ramp, 3 )->data( 10, 0 ) == 16.0f && xGrad( ramp, 1 )->data( 10, 5 ) == 4.0f );
+	unitAssert( yGrad( ramp, 3 )->data( 10, 5 ) == 0 && xGrad( ramp, 3 )->data( 0, 5 ) == 0 );
+
+	// area resizing by a factor of two should average 2x2 blocks
+	aptr<ImageGrayU> half = resize( *crop( img, 0, 35, 0, 21 ), 18, 11, true );
+	int blockSum = img.data( 10, 6 ) + img.data( 11, 6 ) + img.data( 10, 7 ) + img.data( 11, 7 );
+	unitAssert( abs( half->data( 5, 3 ) * 4 - blockSum ) <= 2 );
+
+	// conversions and thresholds
+	unitAssert( toGray( *toColor( img ) )->data( 7, 7 ) == img.data( 7, 7 ) );
+	ImageColorU color( 1, 1 );
+	color.setRGB( 0, 0, 30, 20, 10 );
+	unitAssert( toGray( color )->data( 0, 0 ) == 22 );
+	aptr<ImageGrayU> roundTrip = toUChar( *toFloat( img, 1.0f / 255.0f ), 255.0f );
+	aptr<ImageGrayU> thresh = threshold( img, 100.5f, false );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			unitAssert( roundTrip->data( x, y ) == img.data( x, y ) );
+			unitAssert( thresh->data( x, y ) == (img.data( x, y ) > 100 ? 255 : 0) );
+		}
+	}
+	return true;
+}
+
+
+// check the image statistics (on views that do not start at aligned positions) against direct computations
+bool testImageStats() {
+	int savedThreadCount = threadCount();
+	setThreadCount( 4 );
+	int width = 83, height = 131;
+	ImageGrayU gray( width, height ), gray2( width, height ), mask( width, height );
+	ImageColorU color( width, height ), color2( width, height );
+	ImageGrayF grayF( width, height );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			gray.data( x, y ) = (unsigned char) randomInt( 10, 240 );
+			gray2.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+			mask.data( x, y ) = (x > 20 && x < 70 && y > 30 && y < 90 && randomInt( 0, 3 ) == 0) ? (unsigned char) randomInt( 1, 255 ) : 0;
+			grayF.data( x, y ) = randomFloat( -5, 5 );
+			for (int c = 0; c < 3; c++) {
+				color.data( x, y, c ) = (unsigned char) randomInt( 0, 255 );
+				color2.data( x, y, c ) = (unsigned char) randomInt( 0, 255 );
+			}
+		}
+	}
+	ImageViewGrayU grayView = imageView( gray ).inner( 3, 2 ), gray2View = imageView( gray2 ).inner( 3, 2 ), maskView = imageView( mask ).inner( 3, 2 );
+	ImageViewColorU colorView = imageView( color ).inner( 3, 2 ), color2View = imageView( color2 ).inner( 3, 2 );
+	ImageViewGrayF grayFView = imageView( grayF ).inner( 3, 2 );
+	int viewWidth = grayView.width(), viewHeight = grayView.height();
+
+	// direct sums
+	double graySum = 0, grayFSum = 0, colorSum = 0, channelSums[ 3 ] = { 0, 0, 0 }, grayDiffSum = 0, colorDiffSum = 0;
+	int grayMin = 255, grayMax = 0, count = 0, xMin = viewWidth, xMax = -1, yMin = viewHeight, yMax = -1;
+	float grayFMin = grayFView.data( 0, 0 ), grayFMax = grayFMin;
+	VectorI hist( 256 );
+	hist.clear( 0 );
+	for (int y = 0; y < viewHeight; y++) {
+		for (int x = 0; x < viewWidth; x++) {
+			int v = grayView.data( x, y );
+			graySum += v;
+			grayMin = min( grayMin, v );
+			grayMax = max( grayMax, v );
+			hist[ v ]++;
+			grayDiffSum += abs( v - gray2View.data( x, y ) );
+			float f = grayFView.data( x, y );
+			grayFSum += f;
+			grayFMin = min( grayFMin, f );
+			grayFMax = max( grayFMax, f );
+			for (int c = 0; c < 3; c++) {
+				colorSum += colorView.data( x, y, c );
+				channelSums[ c ] += colorView.data( x, y, c );
+				colorDiffSum += abs( colorView.data( x, y, c ) - color2View.data( x, y, c ) );
+			}
+			if (maskView.data( x, y )) {
+				count++;
+				xMin = min( xMin, x );
+				xMax = max( xMax, x );
+				yMin = min( yMin, y );
+				yMax = max( yMax, y );
+			}
+		}
+	}
+	double size = (double) (viewWidth * viewHeight);
+
+	// compare
+	unitAssert( fabs( mean( grayView ) - graySum / size ) < 1e-4 && fabs( mean( grayFView ) - grayFSum / size ) < 1e-4 );
+	unitAssert( fabs( mean( colorView ) - colorSum / (size * 3) ) < 1e-4 );
+	float rMean = 0, gMean = 0, bMean = 0;
+	channelMean( colorView, rMean, gMean, bMean );
+	unitAssert( fabs( rMean - channelSums[ R_CHANNEL ] / size ) < 1e-4 && fabs( gMean - channelSums[ G_CHANNEL ] / size ) < 1e-4 && fabs( bMean - channelSums[ B_CHANNEL ] / size ) < 1e-4 );
+	unitAssert( fabs( meanAbsDiff( grayView, gray2View ) - grayDiffSum / size ) < 1e-4 && fabs( meanAbsDiff( colorView, color2View ) - colorDiffSum / (size * 3) ) < 1e-4 );
+	unitAssert( maskCount( maskView ) == count );
+	int xMinMask = 0, xMaxMask = 0, yMinMask = 0, yMaxMask = 0;
+	maskBounds( maskView, xMinMask, xMaxMask, yMinMask, yMaxMask );
+	unitAssert( xMinMask == xMin && xMaxMask == xMax && yMinMask == yMin && yMaxMask == yMax );
+	int statsMin = 0, statsMax = 0;
+	float statsMean = 0;
+	imageStats( grayView, statsMin, statsMean, statsMax );
+	unitAssert( statsMin == grayMin && statsMax == grayMax && fabs( statsMean - graySum / size ) < 1e-4 );
+	VectorI statsHist;
+	imageStats( grayView, statsMin, statsMean, statsMax, statsHist );
+	unitAssert( statsMin == grayMin && statsMax == grayMax && fabs( statsMean - graySum / size ) < 1e-4 );
+	unitAssert( statsHist == hist && imageHistogram( grayView ) == hist );
+	float fMin = 0, fMax = 0, fMean = 0;
+	imageStats( grayFView, fMin, fMean, fMax );
+	unitAssert( fMin == grayFMin && fMax == grayFMax && fabs( fMean - grayFSum / size ) < 1e-4 );
+
+	// float results don't depend on the number of threads
+	for (int threads = 1; threads <= 8; threads *= 2) {
+		setThreadCount( threads );
+		float threadMin = 0, threadMax = 0, threadMean = 0;
+		imageStats( grayFView, threadMin, threadMean, threadMax );
+		unitAssert( threadMin == fMin && threadMax == fMax && threadMean == fMean && mean( grayFView ) == fMean );
+	}
+	setThreadCount( 4 );
+
+	// an empty mask
+	mask.clear( 0 );
+	maskBounds( maskView, xMinMask, xMaxMask, yMinMask, yMaxMask );
+	unitAssert( maskCount( maskView ) == 0 && xMaxMask == -1 && yMaxMask == -1 );
+	setThreadCount( savedThreadCount );
+	return true;
+}
+
+
+// time a kernel (in milliseconds per call)
+template <typename F> double timeKernel( int iterations, const F &kernel ) {
+	Timer timer;
+	timer.start();
+	for (int i = 0; i < iterations; i++)
+		kernel();
+	timer.stop();
+	return timer.timeSum() * 1000.0 / iterations;
+}
+
+
+// display the time of a native kernel and (if available) the corresponding OpenCV function
+void reportKernel( const char *name, int pixelCount, double time, double openCVTime ) {
+	if (openCVTime > 0)
+		disp( 1, "%-28s %8.2f ms %8.1f Mpix/sec    OpenCV: %8.2f ms (%.2fx)", name, time, pixelCount / time * 1e-3, openCVTime, openCVTime / time );
+	else
+		disp( 1, "%-28s %8.2f ms %8.1f Mpix/sec", name, time, pixelCount / time * 1e-3 );
+}
+
+
+// time the native image kernels (and the OpenCV equivalents, if available)
+void benchmarkImageKernels( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 10 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, threads: %d", width, height, threadCount() );
+
+	// create random test images
+	ImageColorU color( width, height );
+	for (int y = 0; y < height; y++) {
+		unsigned char *row = color.row( y );
+		for (int i = 0; i < width * 3; i++)
+			row[ i ] = (unsigned char) randomInt( 0, 255 );
+	}
+	aptr<ImageGrayU> gray = toGray( color );
+	aptr<ImageGrayF> grayF = toFloat( *gray, 1.0f / 255.0f );
+	int pixelCount = width * height;
+
+	// the OpenCV versions write to newly allocated matrices (as the native versions do)
+#ifdef USE_OPENCV
+	#define OPENCV_TIME( ... ) timeKernel( iterations, [&]() { cv::Mat out, out2, out3; __VA_ARGS__; } )
+	cv::Mat colorMat = color.cvMat(), grayMat = gray->cvMat(), grayFMat = grayF->cvMat();
+#else
+	#define OPENCV_TIME( ... ) -1.0
+#endif
+
+	// conversions
+	reportKernel( "toGray", pixelCount, timeKernel( iterations, [&]() { toGray( color ); } ),
+		OPENCV_TIME( cv::cvtColor( colorMat, out, cv::COLOR_BGR2GRAY ) ) );
+	reportKernel( "toFloat (gray)", pixelCount, timeKernel( iterations, [&]() { toFloat( *gray, 1.0f / 255.0f ); } ),
+		OPENCV_TIME( grayMat.convertTo( out, CV_32F, 1.0 / 255.0 ) ) );
+	reportKernel( "toUChar (gray)", pixelCount, timeKernel( iterations, [&]() { toUChar( *grayF, 255.0f ); } ),
+		OPENCV_TIME( grayFMat.convertTo( out, CV_8U, 255.0 ) ) );
+	reportKernel( "threshold (gray)", pixelCount, timeKernel( iterations, [&]() { threshold( *gray, 128, false ); } ),
+		OPENCV_TIME( cv::threshold( grayMat, out, 128, 255, cv::THRESH_BINARY ) ) );
+
+	// filters
+	reportKernel( "blurBox 15 (gray)", pixelCount, timeKernel( iterations, [&]() { blurBox( *gray, 15 ); } ),
+		OPENCV_TIME( cv::blur( grayMat, out, cv::Size( 15, 15 ) ) ) );
+	reportKernel( "blurBox 15 (color)", pixelCount, timeKernel( iterations, [&]() { blurBox( color, 15 ); } ),
+		OPENCV_TIME( cv::blur( colorMat, out, cv::Size( 15, 15 ) ) ) );
+	reportKernel( "blurGauss 2 (gray)", pixelCount, timeKernel( iterations, [&]() { blurGauss( *gray, 2.0f ); } ),
+		OPENCV_TIME( cv::GaussianBlur( grayMat, out, cv::Size( 0, 0 ), 2.0 ) ) );
+	reportKernel( "blurGauss 2 (gray float)", pixelCount, timeKernel( iterations, [&]() { blurGauss( *grayF, 2.0f ); } ),
+		OPENCV_TIME( cv::GaussianBlur( grayFMat, out, cv::Size( 0, 0 ), 2.0 ) ) );
+	reportKernel( "blurGauss 2 (color)", pixelCount, timeKernel( iterations, [&]() { blurGauss( color, 2.0f ); } ),
+		OPENCV_TIME( cv::GaussianBlur( colorMat, out, cv::Size( 0, 0 ), 2.0 ) ) );
+	reportKernel( "median 3 (gray)", pixelCount, timeKernel( iterations, [&]() { median( *gray, 3 ); } ),
+		OPENCV_TIME( cv::medianBlur( grayMat, out, 3 ) ) );
+	reportKernel( "median 3 (color)", pixelCount, timeKernel( iterations, [&]() { median( color, 3 ); } ),
+		OPENCV_TIME( cv::medianBlur( colorMat, out, 3 ) ) );
+	reportKernel( "median 5 (gray)", pixelCount, timeKernel( iterations, [&]() { median( *gray, 5 ); } ),
+		OPENCV_TIME( cv::medianBlur( grayMat, out, 5 ) ) );
+	reportKernel( "xGrad 3 (gray)", pixelCount, timeKernel( iterations, [&]() { xGrad( *gray, 3 ); } ),
+		OPENCV_TIME( cv::Sobel( grayMat, out, CV_32F, 1, 0, 3 ) ) );
+	reportKernel( "yGrad 3 (gray)", pixelCount, timeKernel( iterations, [&]() { yGrad( *gray, 3 ); } ),
+		OPENCV_TIME( cv::Sobel( grayMat, out, CV_32F, 0, 1, 3 ) ) );
+	reportKernel( "gradientMagnitude 3", pixelCount, timeKernel( iterations, [&]() { gradientMagnitude( *gray, 3 ); } ),
+		OPENCV_TIME( cv::Sobel( grayMat, out, CV_32F, 1, 0, 3 ); cv::Sobel( grayMat, out2, CV_32F, 0, 1, 3 ); cv::magnitude( out, out2, out3 ) ) );
+
+	// resizing
+	reportKernel( "resize area 1/2 (gray)", pixelCount, timeKernel( iterations, [&]() { resize( *gray, width / 2, height / 2, true ); } ),
+		OPENCV_TIME( cv::resize( grayMat, out, cv::Size( width / 2, height / 2 ), 0, 0, cv::INTER_AREA ) ) );
+	reportKernel( "resize area 1/3 (color)", pixelCount, timeKernel( iterations, [&]() { resize( color, width / 3, height / 3, true ); } ),
+		OPENCV_TIME( cv::resize( colorMat, out, cv::Size( width / 3, height / 3 ), 0, 0, cv::INTER_AREA ) ) );
+	reportKernel( "resize linear 3/2 (color)", pixelCount, timeKernel( iterations, [&]() { resize( color, width * 3 / 2, height * 3 / 2, true ); } ),
+		OPENCV_TIME( cv::resize( colorMat, out, cv::Size( width * 3 / 2, height * 3 / 2 ), 0, 0, cv::INTER_LINEAR ) ) );
+#undef OPENCV_TIME
+}
+
+
+// time the image statistics functions on 1080p and 4K frames (and direct scalar versions of some of them)
+void benchmarkImageStats( Config &conf ) {
+
+	// get command parameters
+	int iterations = conf.readInt( "iterations", 20 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	for (int size = 0; size < 2; size++) {
+		int width = size ? 3840 : 1920, height = size ? 2160 : 1080;
+		disp( 1, "image: %d x %d, threads: %d", width, height, threadCount() );
+
+		// create random test images
+		ImageColorU color( width, height ), color2( width, height );
+		for (int y = 0; y < height; y++) {
+			unsigned char *row = color.row( y ), *row2 = color2.row( y );
+			for (int i = 0; i < width * 3; i++) {
+				row[ i ] = (unsigned char) randomInt( 0, 255 );
+				row2[ i ] = (unsigned char) randomInt( 0, 255 );
+			}
+		}
+		aptr<ImageGrayU> gray = toGray( color ), gray2 = toGray( color2 );
+		aptr<ImageGrayF> grayF = toFloat( *gray, 1.0f / 255.0f );
+		aptr<ImageGrayU> mask = threshold( *gray, 200.0f, false );
+		ImageViewGrayU grayView = imageView( *gray ), gray2View = imageView( *gray2 ), maskView = imageView( *mask );
+		ImageViewColorU colorView = imageView( color ), color2View = imageView( color2 );
+		int pixelCount = width * height, min = 0, max = 0;
+		float meanValue = 0, r = 0, g = 0, b = 0, fMin = 0, fMax = 0;
+		VectorI hist;
+
+		// direct scalar versions (as the functions were previously implemented)
+		double directMean = timeKernel( iterations, [&]() {
+			double sum = 0;
+			for (int y = 0; y < height; y++)
+				for (int x = 0; x < width; x++)
+					sum += grayView.data( x, y );
+			meanValue = (float) (sum / pixelCount);
+		} );
+		double directDiff = timeKernel( iterations, [&]() {
+			double sum = 0;
+			for (int y = 0; y < height; y++)
+				for (int x = 0; x < width; x++)
+					sum += abs( grayView.data( x, y ) - gray2View.data( x, y ) );
+			meanValue = (float) (sum / pixelCount);
+		} );
+		double directStats = timeKernel( iterations, [&]() {
+			double sum = 0;
+			min = max = grayView.data( 0, 0 );
+			hist.setLength( 256 );
+			hist.clear( 0 );
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					int v = grayView.data( x, y );
+					sum += v;
+					if (v < min) min = v;
+					if (v > max) max = v;
+					hist[ v ]++;
+				}
+			}
+			meanValue = (float) (sum / pixelCount);
+		} );
+		reportKernel( "mean (gray, direct)", pixelCount, directMean, -1 );
+		reportKernel( "mean (gray)", pixelCount, timeKernel( iterations, [&]() { meanValue = mean( grayView ); } ), -1 );
+		reportKernel( "mean (color)", pixelCount, timeKernel( iterations, [&]() { meanValue = mean( colorView ); } ), -1 );
+		reportKernel( "channelMean", pixelCount, timeKernel( iterations, [&]() { channelMean( colorView, r, g, b ); } ), -1 );
+		reportKernel( "meanAbsDiff (gray, direct)", pixelCount, directDiff, -1 );
+		reportKernel( "meanAbsDiff (gray)", pixelCount, timeKernel( iterations, [&]() { meanValue = meanAbsDiff( grayView, gray2View ); } ), -1 );
+		reportKernel( "meanAbsDiff (color)", pixelCount, timeKernel( iterations, [&]() { meanValue = meanAbsDiff( colorView, color2View ); } ), -1 );
+		reportKernel( "maskCount", pixelCount, timeKernel( iterations, [&]() { min = maskCount( maskView ); } ), -1 );
+		reportKernel( "maskBounds", pixelCount, timeKernel( iterations, [&]() { maskBounds( maskView, min, max, min, max ); } ), -1 );
+		reportKernel( "imageStats (gray)", pixelCount, timeKernel( iterations, [&]() { imageStats( grayView, min, meanValue, max ); } ), -1 );
+		reportKernel( "imageStats + hist (direct)", pixelCount, directStats, -1 );
+		reportKernel( "imageStats + hist", pixelCount, timeKernel( iterations, [&]() { imageStats( grayView, min, meanValue, max, hist ); } ), -1 );
+		reportKernel( "imageStats (gray float)", pixelCount, timeKernel( iterations, [&]() { imageStats( imageView( *grayF ), fMin, meanValue, fMax ); } ), -1 );
+	}
+}
+
+
 //-------------------------------------------
 // FILTER REGISTRY
 //-------------------------------------------
@@ -912,7 +2119,13 @@ aptr<ImageColorU> blurBox( const ImageColorU &input, Config &conf ) {
 
 // register commands, etc. defined in this module
 void initImageUtil() {
-	registerFilter( blurBox );
+	registerUnitTest( testImageStorage );
+	registerUnitTest( testImageView );
+	registerUnitTest( testImageKernels );
+	registerUnitTest( testImageStats );
+	registerCommand( "benchimage", benchmarkImageKernels );
+	registerCommand( "benchstats", benchmarkImageStats );
+	registerStatelessFilter( blurBox );
 }
 
 
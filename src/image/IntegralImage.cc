@@ -0,0 +1,389 @@
+#include <sbl/image/IntegralImage.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <sbl/image/ImageUtil.h> // for test and benchmark
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// PREFIX SUMS
+//-------------------------------------------
+
+
+// the number of table values per parallel strip when adding rows
+#define INTEGRAL_STRIP_LENGTH 1024
+
+
+#ifdef __SSE2__
+
+
+// compute the running sum of four 32-bit values (added to carry, which is then set to the last sum)
+inline __m128i prefixSum4( __m128i v, __m128i &carry ) {
+	v = _mm_add_epi32( v, _mm_slli_si128( v, 4 ) );
+	v = _mm_add_epi32( v, _mm_slli_si128( v, 8 ) );
+	v = _mm_add_epi32( v, carry );
+	carry = _mm_shuffle_epi32( v, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	return v;
+}
+
+
+// store four 32-bit values as 64-bit values
+inline void storeWide( unsigned long long *out, __m128i v ) {
+	__m128i zero = _mm_setzero_si128();
+	_mm_storeu_si128( (__m128i *) out, _mm_unpacklo_epi32( v, zero ) );
+	_mm_storeu_si128( (__m128i *) (out + 2), _mm_unpackhi_epi32( v, zero ) );
+}
+
+
+#endif
+
+
+// compute the running sums (and the running sums of squares, if squaredOut is not NULL) of a row of gray values
+void prefixSumRow( const unsigned char *in, int width, unsigned int *out, unsigned long long *squaredOut ) {
+	int x = 0;
+	unsigned int sum = 0, squaredSum = 0;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128(), carry = zero, squaredCarry = zero;
+	for (; x + 16 <= width; x += 16) {
+		__m128i v = _mm_loadu_si128( (const __m128i *) (in + x) );
+		__m128i lo = _mm_unpacklo_epi8( v, zero ), hi = _mm_unpackhi_epi8( v, zero );
+		__m128i v16[ 4 ] = { _mm_unpacklo_epi16( lo, zero ), _mm_unpackhi_epi16( lo, zero ), _mm_unpacklo_epi16( hi, zero ), _mm_unpackhi_epi16( hi, zero ) };
+		for (int i = 0; i < 4; i++) {
+			_mm_storeu_si128( (__m128i *) (out + x + i * 4), prefixSum4( v16[ i ], carry ) );
+
+			// (the squares fit in 16 bits, so a 16-bit multiply of the 32-bit lanes gives the squares)
+			if (squaredOut)
+				storeWide( squaredOut + x + i * 4, prefixSum4( _mm_madd_epi16( v16[ i ], v16[ i ] ), squaredCarry ) );
+		}
+	}
+	sum = (unsigned int) _mm_cvtsi128_si32( carry );
+	squaredSum = (unsigned int) _mm_cvtsi128_si32( squaredCarry );
+#endif
+	for (; x < width; x++) {
+		sum += in[ x ];
+		out[ x ] = sum;
+		if (squaredOut) {
+			squaredSum += in[ x ] * in[ x ];
+			squaredOut[ x ] = squaredSum;
+		}
+	}
+}
+
+
+// compute the running sums (and the running sums of squares, if squaredOut is not NULL) of each channel of a row of color values
+template <int CHANNEL_COUNT> void prefixSumRow( const unsigned char *in, int width, unsigned int *out, unsigned long long *squaredOut ) {
+	unsigned int sum[ CHANNEL_COUNT ];
+	unsigned long long squaredSum[ CHANNEL_COUNT ];
+	for (int c = 0; c < CHANNEL_COUNT; c++) {
+		sum[ c ] = 0;
+		squaredSum[ c ] = 0;
+	}
+	if (squaredOut) {
+		for (int x = 0; x < width; x++, in += CHANNEL_COUNT, out += CHANNEL_COUNT, squaredOut += CHANNEL_COUNT) {
+			for (int c = 0; c < CHANNEL_COUNT; c++) {
+				sum[ c ] += in[ c ];
+				squaredSum[ c ] += in[ c ] * in[ c ];
+				out[ c ] = sum[ c ];
+				squaredOut[ c ] = squaredSum[ c ];
+			}
+		}
+	} else {
+		for (int x = 0; x < width; x++, in += CHANNEL_COUNT, out += CHANNEL_COUNT) {
+			for (int c = 0; c < CHANNEL_COUNT; c++) {
+				sum[ c ] += in[ c ];
+				out[ c ] = sum[ c ];
+			}
+		}
+	}
+}
+template <> void prefixSumRow<1>( const unsigned char *in, int width, unsigned int *out, unsigned long long *squaredOut ) {
+	prefixSumRow( in, width, out, squaredOut );
+}
+
+
+// out[ i ] += in[ i ]
+void addRow( const unsigned int *in, unsigned int *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128( (__m128i *) (out + i), _mm_add_epi32( _mm_loadu_si128( (const __m128i *) (out + i) ), _mm_loadu_si128( (const __m128i *) (in + i) ) ) );
+#endif
+	for (; i < count; i++)
+		out[ i ] += in[ i ];
+}
+void addRow( const unsigned long long *in, unsigned long long *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 2 <= count; i += 2)
+		_mm_storeu_si128( (__m128i *) (out + i), _mm_add_epi64( _mm_loadu_si128( (const __m128i *) (out + i) ), _mm_loadu_si128( (const __m128i *) (in + i) ) ) );
+#endif
+	for (; i < count; i++)
+		out[ i ] += in[ i ];
+}
+
+
+// add each row of a table to the next, turning row sums into rectangle sums (in parallel strips of columns)
+template <typename T> void accumulateRows( T *table, int rowLength, int rowCount ) {
+	parallelFor( 0, rowLength, INTEGRAL_STRIP_LENGTH, [&]( int begin, int end ) {
+		for (int y = 1; y < rowCount; y++)
+			addRow( table + (size_t) (y - 1) * rowLength + begin, table + (size_t) y * rowLength + begin, end - begin );
+	} );
+}
+
+
+//-------------------------------------------
+// INTEGRAL IMAGE CLASS
+//-------------------------------------------
+
+
+/// compute the sums (and the sums of squared values, if squared) of the given image
+template <int CHANNEL_COUNT> IntegralImage<CHANNEL_COUNT>::IntegralImage( const ImageView<unsigned char, CHANNEL_COUNT> &input, bool squared ) {
+	m_width = input.width();
+	m_height = input.height();
+	m_rowLength = (m_width + 1) * CHANNEL_COUNT;
+
+	// (the running sums of squares along each row are computed with 32-bit values)
+	assertAlways( squared == false || m_width <= 66000 );
+	m_sums.setLength( m_rowLength * (m_height + 1) );
+	if (squared)
+		m_squaredSums.setLength( m_rowLength * (m_height + 1) );
+	unsigned int *sums = m_sums.dataPtr();
+	unsigned long long *squaredSums = squared ? m_squaredSums.dataPtr() : NULL;
+
+	// the first row and column are zero
+	for (int i = 0; i < m_rowLength; i++) {
+		sums[ i ] = 0;
+		if (squared)
+			squaredSums[ i ] = 0;
+	}
+
+	// compute the running sum along each row, then add the rows
+	parallelFor( 0, m_height, 16, [&]( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			size_t offset = (size_t) (y + 1) * m_rowLength;
+			for (int c = 0; c < CHANNEL_COUNT; c++) {
+				sums[ offset + c ] = 0;
+				if (squared)
+					squaredSums[ offset + c ] = 0;
+			}
+			offset += CHANNEL_COUNT;
+			prefixSumRow<CHANNEL_COUNT>( input.row( y ), m_width, sums + offset, squared ? squaredSums + offset : NULL );
+		}
+	} );
+	accumulateRows( sums, m_rowLength, m_height + 1 );
+	if (squared)
+		accumulateRows( squaredSums, m_rowLength, m_height + 1 );
+}
+
+
+/// the variance of the values of a channel within the given (inclusive) bounds
+template <int CHANNEL_COUNT> float IntegralImage<CHANNEL_COUNT>::variance( int xMin, int yMin, int xMax, int yMax, int c ) const {
+	assertAlways( hasSquared() );
+	double count = (double) ((xMax - xMin + 1) * (yMax - yMin + 1));
+	double mean = (double) sum( xMin, yMin, xMax, yMax, c ) / count;
+	double variance = (double) squaredSum( xMin, yMin, xMax, yMax, c ) / count - mean * mean;
+	return variance > 0 ? (float) variance : 0.0f;
+}
+
+
+/// compute windowMean for every pixel and channel of row y
+template <int CHANNEL_COUNT> void IntegralImage<CHANNEL_COUNT>::windowMeanRow( int y, int boxSize, float *out ) const {
+	assertAlways( boxSize > 0 && (double) min( boxSize, m_width ) * (double) min( boxSize, m_height ) < 8000000.0 );
+	int before = boxSize / 2, after = boxSize - 1 - before;
+	int yMin = max( y - before, 0 ), yMax = min( y + after, m_height - 1 );
+	const unsigned int *top = m_sums.dataPtr() + (size_t) yMin * m_rowLength;
+	const unsigned int *bottom = m_sums.dataPtr() + (size_t) (yMax + 1) * m_rowLength;
+	int rowCount = yMax - yMin + 1;
+
+	// the pixels whose windows are inside the image horizontally all have the same area
+	int xInnerBegin = min( before, m_width ), xInnerEnd = max( m_width - after, xInnerBegin );
+	float innerFactor = 1.0f / (float) (rowCount * boxSize);
+	for (int x = 0; x < m_width; x++) {
+		if (x == xInnerBegin && boxSize <= m_width) {
+			const unsigned int *topLeft = top + (x - before) * CHANNEL_COUNT, *topRight = top + (x + after + 1) * CHANNEL_COUNT;
+			const unsigned int *bottomLeft = bottom + (x - before) * CHANNEL_COUNT, *bottomRight = bottom + (x + after + 1) * CHANNEL_COUNT;
+			int count = (xInnerEnd - xInnerBegin) * CHANNEL_COUNT;
+			float *innerOut = out + x * CHANNEL_COUNT;
+			int i = 0;
+#ifdef __SSE2__
+
+			// (the box sums are less than 2^31, so a signed conversion is exact)
+			__m128 factor = _mm_set1_ps( innerFactor );
+			for (; i + 4 <= count; i += 4) {
+				__m128i sum = _mm_sub_epi32( _mm_loadu_si128( (const __m128i *) (bottomRight + i) ), _mm_loadu_si128( (const __m128i *) (bottomLeft + i) ) );
+				sum = _mm_sub_epi32( sum, _mm_loadu_si128( (const __m128i *) (topRight + i) ) );
+				sum = _mm_add_epi32( sum, _mm_loadu_si128( (const __m128i *) (topLeft + i) ) );
+				_mm_storeu_ps( innerOut + i, _mm_mul_ps( _mm_cvtepi32_ps( sum ), factor ) );
+			}
+#endif
+			for (; i < count; i++)
+				innerOut[ i ] = (float) (bottomRight[ i ] - bottomLeft[ i ] - topRight[ i ] + topLeft[ i ]) * innerFactor;
+			x = xInnerEnd - 1;
+			continue;
+		}
+		int xMin = max( x - before, 0 ), xMax = min( x + after, m_width - 1 );
+		float factor = 1.0f / (float) (rowCount * (xMax - xMin + 1));
+		for (int c = 0; c < CHANNEL_COUNT; c++) {
+			unsigned int sum = bottom[ (xMax + 1) * CHANNEL_COUNT + c ] - bottom[ xMin * CHANNEL_COUNT + c ] - top[ (xMax + 1) * CHANNEL_COUNT + c ] + top[ xMin * CHANNEL_COUNT + c ];
+			out[ x * CHANNEL_COUNT + c ] = (float) sum * factor;
+		}
+	}
+}
+
+
+template class IntegralImage<1>;
+template class IntegralImage<3>;
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// check integral image queries against direct sums
+bool testIntegralImage() {
+	int width = 53, height = 31;
+	ImageGrayU gray( width, height );
+	ImageColorU color( width, height );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			gray.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+			for (int c = 0; c < 3; c++)
+				color.data( x, y, c ) = (unsigned char) randomInt( 0, 255 );
+		}
+	}
+	IntegralImageGray grayIntegral( imageView( gray ), true );
+	IntegralImageColor colorIntegral( imageView( color ), true );
+
+	// rectangle sums, means, and variances
+	for (int i = 0; i < 50; i++) {
+		int xMin = randomInt( 0, width - 1 ), xMax = randomInt( xMin, width - 1 );
+		int yMin = randomInt( 0, height - 1 ), yMax = randomInt( yMin, height - 1 );
+		int c = randomInt( 0, 2 );
+		unsigned int sum = 0, colorSum = 0;
+		unsigned long long squaredSum = 0;
+		for (int y = yMin; y <= yMax; y++) {
+			for (int x = xMin; x <= xMax; x++) {
+				sum += gray.data( x, y );
+				squaredSum += gray.data( x, y ) * gray.data( x, y );
+				colorSum += color.data( x, y, c );
+			}
+		}
+		unitAssert( grayIntegral.sum( xMin, yMin, xMax, yMax ) == sum );
+		unitAssert( grayIntegral.squaredSum( xMin, yMin, xMax, yMax ) == squaredSum );
+		unitAssert( colorIntegral.sum( xMin, yMin, xMax, yMax, c ) == colorSum );
+		double count = (double) ((xMax - xMin + 1) * (yMax - yMin + 1)), mean = sum / count;
+		unitAssert( fabs( grayIntegral.mean( xMin, yMin, xMax, yMax ) - mean ) < 1e-3 );
+		unitAssert( fabs( grayIntegral.variance( xMin, yMin, xMax, yMax ) - (squaredSum / count - mean * mean) ) < 1e-2 );
+	}
+
+	// window means (clipped at the borders) for each row
+	VectorF rowMeans( width * 3 );
+	for (int boxSize = 1; boxSize <= 70; boxSize += 23) {
+		for (int y = 0; y < height; y += 5) {
+			colorIntegral.windowMeanRow( y, boxSize, rowMeans.dataPtr() );
+			for (int x = 0; x < width; x++) {
+				for (int c = 0; c < 3; c++) {
+					unitAssert( fabs( rowMeans[ x * 3 + c ] - colorIntegral.windowMean( x, y, boxSize, c ) ) < 1e-3 );
+				}
+			}
+		}
+	}
+
+	// local brightness normalization should match the box filter version away from the borders (where the windows are not clipped)
+	int windowSize = 9;
+	aptr<ImageGrayU> normalized = normalizeLocalBrightness( gray, windowSize );
+	aptr<ImageGrayU> blurred = blurBox( gray, windowSize );
+	aptr<ImageGrayU> threshold = blurBoxAndThreshold( gray, windowSize, 128 );
+	for (int y = windowSize / 2; y < height - windowSize / 2; y++) {
+		for (int x = windowSize / 2; x < width - windowSize / 2; x++) {
+			int expected = bound( gray.data( x, y ) + 128 - blurred->data( x, y ), 0, 255 );
+			unitAssert( abs( normalized->data( x, y ) - expected ) <= 1 );
+			if (abs( blurred->data( x, y ) - 128 ) > 1) {
+				unitAssert( threshold->data( x, y ) == (blurred->data( x, y ) > 128 ? 255 : 0) );
+			}
+		}
+	}
+
+	// rectangle intersection tests
+	ImageGrayU mask( width, height );
+	mask.clear( 0 );
+	mask.data( 20, 10 ) = 1;
+	IntegralImageGray maskIntegral( imageView( mask ), false );
+	unitAssert( rectIntersects( maskIntegral, 15, 5, 20, 10 ) && rectIntersects( maskIntegral, 20, 10, 40, 30 ) );
+	unitAssert( rectIntersects( maskIntegral, 0, 0, 19, 30 ) == false && rectIntersects( maskIntegral, 21, 0, 52, 30 ) == false );
+
+	// sums that wrap around 32 bits (the table wraps, but small rectangles are still exact)
+	ImageGrayU bright( 4200, 4100 );
+	bright.clear( 255 );
+	IntegralImageGray brightIntegral( imageView( bright ), false );
+	unitAssert( brightIntegral.sum( 4190, 4090, 4199, 4099 ) == 25500 );
+	return true;
+}
+
+
+// time integral image construction and local brightness normalization
+void benchmarkIntegralImage( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 10 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, threads: %d", width, height, threadCount() );
+
+	// create test images
+	ImageGrayU gray( width, height );
+	ImageColorU color( width, height );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			gray.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+			for (int c = 0; c < 3; c++)
+				color.data( x, y, c ) = (unsigned char) randomInt( 0, 255 );
+		}
+	}
+
+	// time each operation
+	for (int i = 0; i < 6; i++) {
+		Timer timer;
+		timer.start();
+		for (int j = 0; j < iterations; j++) {
+			switch (i) {
+			case 0: { IntegralImageGray integral( imageView( gray ), false ); } break;
+			case 1: { IntegralImageGray integral( imageView( gray ), true ); } break;
+			case 2: { IntegralImageColor integral( imageView( color ), false ); } break;
+			case 3: normalizeLocalBrightness( gray, 101 ); break;
+			case 4: normalizeLocalBrightness( color, 101 ); break;
+			case 5: blurBoxAndThreshold( gray, 101, 128 ); break;
+			}
+		}
+		timer.stop();
+		const char *names[] = { "integral (gray)", "integral + squared (gray)", "integral (color)",
+								"normalizeLocalBrightness 101 (gray)", "normalizeLocalBrightness 101 (color)", "blurBoxAndThreshold 101 (gray)" };
+		disp( 1, "%-38s %7.2f ms", names[ i ], timer.timeSum() * 1000.0 / iterations );
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initIntegralImage() {
+	registerUnitTest( testIntegralImage );
+	registerCommand( "benchintegral", benchmarkIntegralImage );
+}
+
+
+} // end namespace sbl
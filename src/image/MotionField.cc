@@ -1,6 +1,8 @@
 #include <sbl/image/MotionField.h>
 #include <sbl/image/ImageUtil.h>
 #include <sbl/image/ImageTransform.h>
+#include <sbl/image/ImageRemap.h>
+#include <sbl/system/FileSystem.h>
 namespace sbl {
 
 
@@ -16,6 +18,29 @@ MotionField::MotionField( int width, int height ) {
 	m_u = new ImageGrayF( width, height );
 	m_v = new ImageGrayF( width, height );
 	m_occMask = NULL;
+	m_mapping = NULL;
+
+	// init meta-data
+	m_buildTime = 0;
+	m_srcFrameIndex = -1;
+	m_destFrameIndex = -1;
+	m_originalWidth = -1;
+	m_originalHeight = -1;
+}
+
+
+/// create a motion field from the given images (which must have the same size; occMask may be NULL);
+/// takes ownership of the images and of the mapping (if not NULL), which is deleted after the images
+/// (so the images can wrap data in a memory-mapped file)
+MotionField::MotionField( ImageGrayF *u, ImageGrayF *v, ImageGrayU *occMask, MappedFile *mapping ) {
+	m_width = u->width();
+	m_height = u->height();
+	assertAlways( v->width() == m_width && v->height() == m_height );
+	assertAlways( occMask == NULL || (occMask->width() == m_width && occMask->height() == m_height) );
+	m_u = u;
+	m_v = v;
+	m_occMask = occMask;
+	m_mapping = mapping;
 
 	// init meta-data
 	m_buildTime = 0;
@@ -33,6 +58,7 @@ MotionField::MotionField( const MotionField &mf ) {
 	m_u = new ImageGrayF( mf.uRef() );
 	m_v = new ImageGrayF( mf.vRef() );
 	m_occMask = mf.occDefined() ? new ImageGrayU( mf.occRef() ) : NULL;
+	m_mapping = NULL;
 
 	// copy meta-data
 	m_buildTime = mf.buildTime();
@@ -50,6 +76,7 @@ MotionField::~MotionField() {
 	delete m_u;
 	delete m_v;
 	if (m_occMask) delete m_occMask;
+	if (m_mapping) delete m_mapping;
 }
 
 
@@ -62,6 +89,12 @@ void MotionField::enableOcc() {
 }
 
 
+/// returns number of bytes used by this object
+int MotionField::memUsed() const {
+	return sizeof( MotionField ) + m_u->memUsed() + m_v->memUsed() + (m_occMask ? m_occMask->memUsed() : 0);
+}
+
+
 /// compute number of occluded pixels (according to occlusion mask)
 int MotionField::occCount() const {
 	int count = 0;
@@ -125,43 +158,17 @@ void MotionField::clear() {
 
 
 /// map the given destination image back to the source coordinates
-// fix(faster): use opencv?
 aptr<ImageGrayU> MotionField::mapBackward( const ImageGrayU &img, int fillColor, float frac ) const {
-	int width = m_u->width(), height = m_u->height();
-	disp( 1, "flow: %.1f, %.1f, %.1f", m_u->data( 152, 152 ), m_v->data( 152, 152 ), frac );
-	aptr<ImageGrayU> mapped( new ImageGrayU( width, height ) );
-	mapped->clear( fillColor );
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			float xDest = x + m_u->data( x, y ) * frac;
-			float yDest = y + m_v->data( x, y ) * frac;
-			if (img.inBounds( xDest, yDest )) 
-				mapped->data( x, y ) = (int) img.interp( xDest, yDest );
-			if (x == 152 && y == 152) {
-				disp( 1, "dest: %.1f, %.1f", xDest, yDest );
-			}
-		}
-	}
+	aptr<ImageGrayU> mapped( new ImageGrayU( m_width, m_height ) );
+	remapField( imageView( img ), imageView( *mapped ), uView(), vView(), frac, true, (unsigned char) fillColor );
 	return mapped;
 }
 
 
 /// map the given destination image back to the source coordinates
-// fix(faster): use opencv?
 aptr<ImageColorU> MotionField::mapBackward( const ImageColorU &img, int fillColor, float frac ) const {
-	int width = m_u->width(), height = m_u->height();
-	aptr<ImageColorU> mapped( new ImageColorU( width, height ) );
-	mapped->clear( fillColor );
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			float xDest = x + m_u->data( x, y ) * frac;
-			float yDest = y + m_v->data( x, y ) * frac;
-			if (img.inBounds( xDest, yDest )) {
-				for (int c = 0; c < 3; c++)
-					mapped->data( x, y, c ) = (int) img.interp( xDest, yDest, c );
-			}
-		}
-	}
+	aptr<ImageColorU> mapped( new ImageColorU( m_width, m_height ) );
+	remapField( imageView( img ), imageView( *mapped ), uView(), vView(), frac, true, (unsigned char) fillColor );
 	return mapped;
 }
 
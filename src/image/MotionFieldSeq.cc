@@ -1,45 +1,439 @@
 #include <sbl/image/MotionFieldSeq.h>
 #include <sbl/core/StringUtil.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
 #include <sbl/image/MotionFieldUtil.h>
 #include <sbl/system/FileSystem.h>
+#include <sbl/system/Timer.h>
 namespace sbl {
 
 
+// remove an item from a vector (keeping the order of the other items)
+void removeVectorItem( VectorI &vector, int position ) {
+	VectorI remaining;
+	for (int i = 0; i < vector.length(); i++)
+		if (i != position)
+			remaining.append( vector[ i ] );
+	vector = remaining;
+}
+
+
 //-------------------------------------------
 // MOTION FIELD SEQ CLASS
 //-------------------------------------------
 
 
-/// specify the path containing (or that will contain) the motion field files
-MotionFieldSeq::MotionFieldSeq( const String &path ) {
+/// specify the path containing (or that will contain) the motion field files, the cache size in bytes
+/// (0 disables caching, prefetching, and asynchronous writes), and the number of fields to load ahead of sequential reads
+MotionFieldSeq::MotionFieldSeq( const String &path, int cacheBytes, int prefetchCount ) {
 	m_path = path;
 	m_count = 0;
-	Array<String> dirList = dirFileList( path, "motion.", ".mf" );
+	Array<String> dirList = dirFileList( path.length() ? path : ".", "motion.", ".mf" );
 	for (int i = 0; i < dirList.count(); i++) {
 		Array<String> split = dirList[ i ].split( "." );
 		if (split.count() == 4) {
-			int srcIndex = split[ 2 ].toInt();
-			int destIndex = split[ 3 ].toInt();
-			if (srcIndex > m_count)
+			int srcIndex = split[ 1 ].toInt();
+			int destIndex = split[ 2 ].toInt();
+			if (srcIndex >= m_count)
 				m_count = srcIndex + 1;
-			if (destIndex > m_count)
+			if (destIndex >= m_count)
 				m_count = destIndex + 1;
 		}
 	}
+	m_cacheBytes = cacheBytes;
+	m_cacheBytesUsed = 0;
+	m_useCount = 0;
+	m_writeBytes = 0;
+	m_writingCount = 0;
+	m_prefetchCount = prefetchCount;
+	m_loadingIndex = -1;
+	m_lastReadIndex = -1;
+	m_readDirection = 1;
+	m_hitCount = 0;
+	m_missCount = 0;
+	m_prefetchLoadCount = 0;
+	m_prefetchStallTime = 0;
+	m_writeStallTime = 0;
+	m_stopThread = false;
+}
+
+
+// wait for writes and stop the background thread
+MotionFieldSeq::~MotionFieldSeq() {
+	if (m_thread.get()) {
+		flush();
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_stopThread = true;
+		}
+		m_threadWake.notify_all();
+		m_thread->join();
+	}
+	for (int i = 0; i < m_cacheFields.count(); i++)
+		delete &m_cacheFields[ i ];
+	for (int i = 0; i < m_writeFields.count(); i++)
+		delete &m_writeFields[ i ];
 }
 
 
-/// read a motion field from the sequence
+/// read a motion field from the sequence; returns a copy of the cached field if available
 aptr<MotionField> MotionFieldSeq::read( int index ) {
-	String fileName = sprintF( "motion.%05d.%05d.mf", index, index + 1 );
-	return loadMotionField( fileName );
+	aptr<MotionField> motionField;
+	std::unique_lock<std::mutex> lock( m_mutex );
+	m_useCount++;
+
+	// update the read direction (keeping the previous direction if the same field is read again)
+	if (m_lastReadIndex >= 0 && index != m_lastReadIndex)
+		m_readDirection = index == m_lastReadIndex + 1 ? 1 : (index == m_lastReadIndex - 1 ? -1 : 0);
+	m_lastReadIndex = index;
+
+	// check the write queue (newest entry first) and the cache, waiting if the field is being loaded by the background thread
+	while (motionField.get() == NULL) {
+		int position = writePosition( index );
+		if (position >= 0) {
+			motionField.reset( new MotionField( m_writeFields[ position ] ) );
+			m_hitCount++;
+			break;
+		}
+		position = cachePosition( index );
+		if (position >= 0) {
+			m_cacheLastUse[ position ] = m_useCount;
+			motionField.reset( new MotionField( m_cacheFields[ position ] ) );
+			m_hitCount++;
+			break;
+		}
+		if (m_loadingIndex != index)
+			break;
+		Timer timer( true );
+		while (m_loadingIndex == index)
+			m_threadDone.wait( lock );
+		m_prefetchStallTime += timer.timeSum();
+	}
+
+	// if not found, load the field (without holding the lock) and add a copy to the cache
+	if (motionField.get() == NULL) {
+		m_missCount++;
+		lock.unlock();
+		motionField = loadMotionField( fileName( index ) );
+		lock.lock();
+		if (motionField.get() && m_cacheBytes && cachePosition( index ) < 0 && writePosition( index ) < 0)
+			addToCache( index, new MotionField( *motionField ) );
+	}
+
+	// request the next fields in the direction of sequential reads
+	if (m_cacheBytes && m_prefetchCount && m_readDirection) {
+		m_prefetchIndex.setLength( 0 );
+		for (int i = 1; i <= m_prefetchCount; i++) {
+			int prefetchIndex = index + i * m_readDirection;
+			if (prefetchIndex >= 0 && prefetchIndex + 1 < m_count && cachePosition( prefetchIndex ) < 0 && writePosition( prefetchIndex ) < 0)
+				m_prefetchIndex.append( prefetchIndex );
+		}
+		if (m_prefetchIndex.length()) {
+			startThread();
+			m_threadWake.notify_one();
+		}
+	}
+	return motionField;
 }
 
 
-/// write a motion field into the sequence
+/// write a motion field into the sequence; the field is copied and written by the background thread
 void MotionFieldSeq::write( int index, MotionField &motionField ) {
-	String fileName = sprintF( "motion.%05d.%05d.mf", index, index + 1 );
-	saveMotionField( motionField, fileName );
+	if (index + 2 > m_count)
+		m_count = index + 2;
+	if (m_cacheBytes == 0) {
+		saveMotionField( motionField, fileName( index ) );
+		return;
+	}
+	MotionField *copy = new MotionField( motionField );
+	int bytes = copy->memUsed();
+	std::unique_lock<std::mutex> lock( m_mutex );
+
+	// if the queue is full (half of the cache size), wait for the background thread to write the queued fields
+	if (m_writeFields.count() && m_writeBytes + bytes > m_cacheBytes / 2) {
+		Timer timer( true );
+		while (m_writeFields.count() && m_writeBytes + bytes > m_cacheBytes / 2)
+			m_threadDone.wait( lock );
+		m_writeStallTime += timer.timeSum();
+	}
+
+	// replace a queued field with the same index (if it isn't being written) or add to the end of the queue
+	int position = writePosition( index );
+	if (position >= m_writingCount) {
+		m_writeBytes -= m_writeFields[ position ].memUsed();
+		delete &m_writeFields[ position ];
+		m_writeFields.set( position, copy );
+	} else {
+		m_writeFields.append( copy );
+		m_writeIndex.append( index );
+	}
+	m_writeBytes += bytes;
+	startThread();
+	m_threadWake.notify_one();
+}
+
+
+/// wait until all writes have been completed
+void MotionFieldSeq::flush() {
+	std::unique_lock<std::mutex> lock( m_mutex );
+	while (m_writeFields.count())
+		m_threadDone.wait( lock );
+}
+
+
+// the name of the file holding the given motion field
+String MotionFieldSeq::fileName( int index ) const {
+	String name = sprintF( "motion.%05d.%05d.mf", index, index + 1 );
+	return m_path.length() ? m_path + "/" + name : name;
+}
+
+
+// the position of the field in the cache, or -1 if not found (assumes m_mutex is held)
+int MotionFieldSeq::cachePosition( int index ) const {
+	for (int i = 0; i < m_cacheIndex.length(); i++)
+		if (m_cacheIndex[ i ] == index)
+			return i;
+	return -1;
+}
+
+
+// the position of the newest queued write of the field, or -1 if not found (assumes m_mutex is held)
+int MotionFieldSeq::writePosition( int index ) const {
+	for (int i = m_writeIndex.length() - 1; i >= 0; i--)
+		if (m_writeIndex[ i ] == index)
+			return i;
+	return -1;
+}
+
+
+// add a field to the cache (taking ownership), removing the least-recently used fields as needed (assumes m_mutex is held)
+void MotionFieldSeq::addToCache( int index, MotionField *motionField ) {
+	int position = cachePosition( index );
+	if (position >= 0)
+		removeFromCache( position );
+	int bytes = motionField->memUsed();
+	if (bytes > m_cacheBytes) {
+		delete motionField;
+		return;
+	}
+	while (m_cacheBytesUsed + bytes > m_cacheBytes) {
+		int oldest = 0;
+		for (int i = 1; i < m_cacheLastUse.length(); i++)
+			if (m_cacheLastUse[ i ] < m_cacheLastUse[ oldest ])
+				oldest = i;
+		removeFromCache( oldest );
+	}
+	m_cacheFields.append( motionField );
+	m_cacheIndex.append( index );
+	m_cacheLastUse.append( m_useCount );
+	m_cacheBytesUsed += bytes;
+}
+
+
+// remove a field from the cache (assumes m_mutex is held)
+void MotionFieldSeq::removeFromCache( int position ) {
+	m_cacheBytesUsed -= m_cacheFields[ position ].memUsed();
+	delete &m_cacheFields[ position ];
+	m_cacheFields.remove( position );
+	removeVectorItem( m_cacheIndex, position );
+	removeVectorItem( m_cacheLastUse, position );
+}
+
+
+// start the background thread if it isn't running (assumes m_mutex is held)
+void MotionFieldSeq::startThread() {
+	if (m_thread.get() == NULL)
+		m_thread.reset( new std::thread( &MotionFieldSeq::threadMain, this ) );
+}
+
+
+// the background thread loop: write queued fields, then load requested fields
+void MotionFieldSeq::threadMain() {
+	markWorkerThread();
+	std::unique_lock<std::mutex> lock( m_mutex );
+	while (true) {
+		while (m_stopThread == false && m_writeFields.count() == 0 && m_prefetchIndex.length() == 0)
+			m_threadWake.wait( lock );
+
+		// write all queued fields (the queue may grow while we are writing, but these entries won't be modified or removed)
+		if (m_writeFields.count()) {
+			m_writingCount = m_writeFields.count();
+			PtrArray<MotionField> writeFields;
+			for (int i = 0; i < m_writingCount; i++)
+				writeFields.append( &m_writeFields[ i ] );
+			VectorI writeIndex = m_writeIndex;
+			lock.unlock();
+			for (int i = 0; i < writeFields.count(); i++)
+				saveMotionField( writeFields[ i ], fileName( writeIndex[ i ] ) );
+			lock.lock();
+
+			// move the written fields into the cache (unless a newer version is queued)
+			for (int i = 0; i < m_writingCount; i++) {
+				MotionField *motionField = &m_writeFields[ i ];
+				m_writeBytes -= motionField->memUsed();
+				if (writePosition( m_writeIndex[ i ] ) == i)
+					addToCache( m_writeIndex[ i ], motionField );
+				else
+					delete motionField;
+			}
+			for (int i = m_writingCount - 1; i >= 0; i--) {
+				m_writeFields.remove( i );
+				removeVectorItem( m_writeIndex, i );
+			}
+			m_writingCount = 0;
+			m_threadDone.notify_all();
+			continue;
+		}
+		if (m_stopThread)
+			break;
+
+		// load the next requested field (unless it is already available)
+		int index = m_prefetchIndex[ 0 ];
+		removeVectorItem( m_prefetchIndex, 0 );
+		if (cachePosition( index ) >= 0 || writePosition( index ) >= 0)
+			continue;
+		m_loadingIndex = index;
+		lock.unlock();
+		aptr<MotionField> motionField = loadMotionField( fileName( index ) );
+		lock.lock();
+		m_loadingIndex = -1;
+
+		// add to the cache unless the field has been written (or loaded by a read) in the meantime
+		if (motionField.get() && cachePosition( index ) < 0 && writePosition( index ) < 0) {
+			addToCache( index, motionField.release() );
+			m_prefetchLoadCount++;
+		}
+		m_threadDone.notify_all();
+	}
+}
+
+
+//-------------------------------------------
+// TEST / BENCHMARK
+//-------------------------------------------
+
+
+// create a small motion field with values determined by the index
+aptr<MotionField> motionSeqTestField( int width, int height, int index ) {
+	aptr<MotionField> mf( new MotionField( width, height ) );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			mf->setU( x, y, (float) (index * 1000 + x) );
+			mf->setV( x, y, (float) (index * 1000 + y) );
+		}
+	}
+	return mf;
+}
+
+
+// check that fields written to a sequence can be read back (from the cache, write queue, or disk) in various orders
+bool testMotionFieldSeq() {
+	String path = "_testMotionFieldSeq";
+	createDir( path );
+	int width = 40, height = 30, count = 12;
+	int fieldBytes = motionSeqTestField( width, height, 0 )->memUsed();
+	for (int pass = 0; pass < 3; pass++) {
+
+		// pass 0: no cache; pass 1: a large cache; pass 2: a cache holding 3 fields
+		int cacheBytes = pass == 0 ? 0 : (pass == 1 ? fieldBytes * 100 : fieldBytes * 3);
+		{
+			MotionFieldSeq seq( path, cacheBytes );
+			for (int i = 0; i < count; i++) {
+				aptr<MotionField> mf = motionSeqTestField( width, height, i + pass );
+				seq.write( i, *mf );
+			}
+			unitAssert( seq.count() == count + 1 );
+
+			// fields can be read back before or after they are written to disk
+			aptr<MotionField> mf = seq.read( count - 1 );
+			unitAssert( mf.get() && mf->u( 3, 0 ) == (float) ((count - 1 + pass) * 1000 + 3) );
+			seq.flush();
+		}
+
+		// read forward, backward, and in random order from a new sequence object
+		MotionFieldSeq seq( path, cacheBytes );
+		unitAssert( seq.count() == count + 1 );
+		for (int i = 0; i < count * 3; i++) {
+			int index = i < count ? i : (i < count * 2 ? count * 2 - 1 - i : randomInt( 0, count - 1 ));
+			aptr<MotionField> mf = seq.read( index );
+			unitAssert( mf.get() && mf->u( 5, 7 ) == (float) ((index + pass) * 1000 + 5) && mf->v( 5, 7 ) == (float) ((index + pass) * 1000 + 7) );
+		}
+		unitAssert( seq.hitCount() + seq.missCount() == count * 3 );
+		unitAssert( seq.cacheBytesUsed() <= cacheBytes );
+		if (pass == 0) {
+			unitAssert( seq.hitCount() == 0 );
+		} else {
+			unitAssert( seq.hitCount() > 0 );
+		}
+	}
+	for (int i = 0; i < count; i++)
+		deleteFile( path + sprintF( "/motion.%05d.%05d.mf", i, i + 1 ) );
+	return true;
+}
+
+
+// time reading and writing a motion field sequence with and without caching, with a given amount of work per field
+void benchmarkMotionFieldSeq( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1280 );
+	int height = conf.readInt( "height", 720 );
+	int count = conf.readInt( "count", 20 );
+	int workMs = conf.readInt( "workMs", 10 );
+	int cacheMegabytes = conf.readInt( "cacheMegabytes", 256 );
+	String path = conf.readString( "path", "_benchMotionFieldSeq" );
+	if (conf.initialPass())
+		return;
+	createDir( path );
+	aptr<MotionField> mf = motionSeqTestField( width, height, 0 );
+	disp( 1, "fields: %d x %d x %d, work: %d ms per field", width, height, count, workMs );
+
+	// simulate processing each field
+	auto work = [&]() {
+		double startTime = getPerfTime();
+		while ((getPerfTime() - startTime) * 1000.0 < (double) workMs) {}
+	};
+
+	// time writing the fields, then reading them (in a forward pass, a backward pass, and a second forward pass) from a new sequence object
+	for (int cached = 0; cached < 2; cached++) {
+		int cacheBytes = cached ? cacheMegabytes * 1024 * 1024 : 0;
+		Timer writeTimer( true );
+		{
+			MotionFieldSeq seq( path, cacheBytes );
+			for (int i = 0; i < count; i++) {
+				work();
+				seq.write( i, *mf );
+			}
+		}
+		writeTimer.stop();
+		MotionFieldSeq seq( path, cacheBytes );
+		Timer readTimer( true );
+		for (int i = 0; i < count * 3; i++) {
+			int index = i < count ? i : (i < count * 2 ? count * 2 - 1 - i : i - count * 2);
+			aptr<MotionField> loaded = seq.read( index );
+			work();
+		}
+		readTimer.stop();
+		disp( 1, "%-8s write: %7.3f ms/field, read: %7.3f ms/field (excluding work), hits: %d, misses: %d, prefetched: %d, stall: %.3f s",
+			cached ? "cached" : "uncached", writeTimer.timeSum() * 1000.0f / count - workMs, readTimer.timeSum() * 1000.0f / (count * 3) - workMs,
+			seq.hitCount(), seq.missCount(), seq.prefetchCount(), seq.prefetchStallTime() );
+	}
+	for (int i = 0; i < count; i++)
+		deleteFile( path + sprintF( "/motion.%05d.%05d.mf", i, i + 1 ) );
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initMotionFieldSeq() {
+	registerUnitTest( testMotionFieldSeq );
+	registerCommand( "benchmotionseq", benchmarkMotionFieldSeq );
 }
 
 
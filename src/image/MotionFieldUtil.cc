@@ -2,6 +2,16 @@
 #include <sbl/math/MathUtil.h>
 #include <sbl/math/Triangulation.h>
 #include <sbl/image/ImageUtil.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/system/FileSystem.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <string.h>
+#include <stdio.h>
+#ifdef USE_ZLIB
+	#include <zlib.h>
+#endif
 namespace sbl {
 
 
@@ -123,6 +133,266 @@ void dispMotion( const MotionField &mf, const String &caption ) {
 //-------------------------------------------
 
 
+// the binary motion field file format: version 1 stores interleaved u, v values (one value per write);
+// version 2 stores u, v, and the occlusion mask as separate blocks, each starting at a multiple of MOTION_FILE_ALIGN bytes
+#define MOTION_FILE_VERSION 2
+#define MOTION_FILE_ALIGN 64
+
+
+// the number of bytes before the first block in a version 2 file (the header, padded to MOTION_FILE_ALIGN bytes):
+// "mf\0", 0, version, width, height, build time (double), reserved (double), encoding, fixed step (float),
+// compressed flag, occlusion flag, and the row bytes and stored bytes of each of the 3 blocks
+#define MOTION_FILE_HEADER_BYTES 75
+#define MOTION_FILE_DATA_OFFSET 128
+
+
+// the number of motion field rows handed to a worker thread at a time when encoding or decoding
+#define MOTION_FILE_GRAIN_ROWS 16
+
+
+// round a file offset up to a multiple of MOTION_FILE_ALIGN
+inline int alignMotionFileOffset( int offset ) {
+	return (offset + MOTION_FILE_ALIGN - 1) / MOTION_FILE_ALIGN * MOTION_FILE_ALIGN;
+}
+
+
+// convert a float to a half-precision float (rounding to nearest even; saturating at the largest finite value)
+inline unsigned short floatToHalf( float value ) {
+	unsigned int bits = 0;
+	memcpy( &bits, &value, 4 );
+	unsigned int sign = (bits >> 16) & 0x8000;
+	int exponent = (int) ((bits >> 23) & 0xff);
+	unsigned int mantissa = bits & 0x7fffff;
+	if (exponent == 0xff)
+		return (unsigned short) (sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	exponent = exponent - 127 + 15;
+	unsigned int half = 0, remainder = 0, halfway = 0;
+	if (exponent <= 0) {
+
+		// subnormal half (or zero)
+		if (exponent < -10)
+			return (unsigned short) sign;
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		half = mantissa >> shift;
+		remainder = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	} else {
+		half = ((unsigned int) exponent << 10) | (mantissa >> 13);
+		remainder = mantissa & 0x1fff;
+		halfway = 0x1000;
+	}
+	if (remainder > halfway || (remainder == halfway && (half & 1)))
+		half++;
+	if (half >= 0x7c00)
+		half = 0x7bff;
+	return (unsigned short) (sign | half);
+}
+
+
+// convert a half-precision float to a float
+inline float halfToFloat( unsigned short half ) {
+	unsigned int sign = (unsigned int) (half & 0x8000) << 16;
+	unsigned int exponent = (half >> 10) & 0x1f, mantissa = half & 0x3ff;
+	unsigned int bits = 0;
+	if (exponent == 0) {
+		float value = (float) mantissa * (1.0f / 16777216.0f);
+		return sign ? -value : value;
+	} else if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+	float value = 0;
+	memcpy( &value, &bits, 4 );
+	return value;
+}
+
+
+// the number of bytes per row of an encoded motion block
+int motionBlockRowBytes( int width, MotionFieldEncoding encoding ) {
+	return encoding == MotionFieldEncoding::MOTION_FLOAT32 ? ImageGrayF::defaultRowBytes( width ) : width * 2;
+}
+
+
+// encode a motion component into the layout stored in a file
+void encodeMotionBlock( const ImageGrayF &plane, MotionFieldEncoding encoding, float fixedStep, int rowBytes, unsigned char *out ) {
+	int width = plane.width(), height = plane.height();
+	float fixedScale = 1.0f / fixedStep;
+	parallelFor( 0, height, MOTION_FILE_GRAIN_ROWS, [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const float *in = plane.row( y );
+			unsigned char *outRow = out + (size_t) y * rowBytes;
+			if (encoding == MotionFieldEncoding::MOTION_FLOAT32) {
+				memcpy( outRow, in, width * sizeof( float ) );
+				memset( outRow + width * sizeof( float ), 0, rowBytes - width * sizeof( float ) );
+			} else if (encoding == MotionFieldEncoding::MOTION_FLOAT16) {
+				unsigned short *outValues = (unsigned short *) outRow;
+				for (int x = 0; x < width; x++)
+					outValues[ x ] = floatToHalf( in[ x ] );
+			} else {
+				short *outValues = (short *) outRow;
+				for (int x = 0; x < width; x++) {
+					float scaled = in[ x ] * fixedScale;
+					if (scaled > 32767.0f) scaled = 32767.0f;
+					if (scaled < -32767.0f) scaled = -32767.0f;
+					outValues[ x ] = (short) round( scaled );
+				}
+			}
+		}
+	} );
+}
+
+
+// decode a motion component from the layout stored in a file
+void decodeMotionBlock( const unsigned char *in, int rowBytes, MotionFieldEncoding encoding, float fixedStep, ImageGrayF &plane ) {
+	int width = plane.width(), height = plane.height();
+	parallelFor( 0, height, MOTION_FILE_GRAIN_ROWS, [&]( int begin, int end ) {
+		for (int y = begin; y < end; y++) {
+			const unsigned char *inRow = in + (size_t) y * rowBytes;
+			float *out = plane.row( y );
+			if (encoding == MotionFieldEncoding::MOTION_FLOAT32) {
+				memcpy( out, inRow, width * sizeof( float ) );
+			} else if (encoding == MotionFieldEncoding::MOTION_FLOAT16) {
+				const unsigned short *inValues = (const unsigned short *) inRow;
+				for (int x = 0; x < width; x++)
+					out[ x ] = halfToFloat( inValues[ x ] );
+			} else {
+				const short *inValues = (const short *) inRow;
+				for (int x = 0; x < width; x++)
+					out[ x ] = (float) inValues[ x ] * fixedStep;
+			}
+		}
+	} );
+}
+
+
+// read bytes to advance from the given offset to the next aligned offset
+void skipMotionFilePadding( File &file, int &offset ) {
+	unsigned char padding[ MOTION_FILE_ALIGN ];
+	int aligned = alignMotionFileOffset( offset );
+	if (aligned > offset)
+		file.readBlock( padding, aligned - offset );
+	offset = aligned;
+}
+
+
+// write zeros to advance from the given offset to the next aligned offset
+void writeMotionFilePadding( File &file, int &offset ) {
+	unsigned char padding[ MOTION_FILE_ALIGN ];
+	memset( padding, 0, MOTION_FILE_ALIGN );
+	int aligned = alignMotionFileOffset( offset );
+	if (aligned > offset)
+		file.writeBlock( padding, aligned - offset );
+	offset = aligned;
+}
+
+
+// the part of a version 2 header after the common (version 1) fields
+struct MotionFileHeader {
+	int encoding;
+	float fixedStep;
+	int compressed;
+	int occDefined;
+	int rowBytes[ 3 ];
+	int storedBytes[ 3 ];
+};
+
+
+// check a version 2 header; returns false (after displaying a warning) if it is invalid
+bool checkMotionFileHeader( const MotionFileHeader &header, int width, int height ) {
+	bool valid = header.encoding >= 0 && header.encoding <= 2 && (header.encoding != 2 || header.fixedStep > 0);
+	MotionFieldEncoding encoding = (MotionFieldEncoding) header.encoding;
+	for (int i = 0; i < 3 && valid; i++) {
+		int minRowBytes = i < 2 ? (encoding == MotionFieldEncoding::MOTION_FLOAT32 ? width * 4 : width * 2) : width;
+		if (i == 2 && header.occDefined == 0)
+			continue;
+		if (header.rowBytes[ i ] < minRowBytes || header.storedBytes[ i ] < 0 || (double) header.rowBytes[ i ] * height > 2e9)
+			valid = false;
+		if (header.compressed == 0 && header.storedBytes[ i ] != header.rowBytes[ i ] * height)
+			valid = false;
+#ifdef USE_ZLIB
+		if (header.compressed && (double) header.storedBytes[ i ] > (double) compressBound( (uLong) header.rowBytes[ i ] * height ))
+			valid = false;
+#endif
+	}
+#ifndef USE_ZLIB
+	if (valid && header.compressed) {
+		warning( "motion field file is compressed; loading requires USE_ZLIB" );
+		return false;
+	}
+#endif
+	if (valid == false)
+		warning( "invalid motion field header" );
+	return valid;
+}
+
+
+// read a block of a version 2 file into the given image (decompressing and decoding as needed);
+// returns false (after displaying a warning) if the block could not be decompressed
+template <typename ImageType> bool readMotionBlock( File &file, const MotionFileHeader &header, int index, ImageType &image, int &offset ) {
+	int rowBytes = header.rowBytes[ index ], storedBytes = header.storedBytes[ index ], height = image.height();
+	skipMotionFilePadding( file, offset );
+	bool raw = index == 2 || header.encoding == (int) MotionFieldEncoding::MOTION_FLOAT32;
+
+	// if the stored layout matches the image, read directly into the image
+	if (header.compressed == 0 && raw && rowBytes == image.rowBytes()) {
+		file.readBlock( image.raw(), storedBytes );
+	} else {
+		Vector<unsigned char> stored( storedBytes ), decompressed;
+		file.readBlock( stored.dataPtr(), storedBytes );
+		const unsigned char *data = stored.dataPtr();
+#ifdef USE_ZLIB
+		if (header.compressed) {
+			decompressed.setLength( rowBytes * height );
+			uLongf length = (uLongf) decompressed.length();
+			if (uncompress( decompressed.dataPtr(), &length, stored.dataPtr(), storedBytes ) != Z_OK || (int) length != decompressed.length()) {
+				warning( "error decompressing motion field" );
+				return false;
+			}
+			data = decompressed.dataPtr();
+		}
+#endif
+		int width = image.width();
+		if (raw) {
+			for (int y = 0; y < height; y++)
+				memcpy( image.row( y ), data + (size_t) y * rowBytes, width * sizeof( *image.row( 0 ) ) );
+		} else {
+			decodeMotionBlock( data, rowBytes, (MotionFieldEncoding) header.encoding, header.fixedStep, (ImageGrayF &) image );
+		}
+	}
+	offset += storedBytes;
+	return true;
+}
+
+
+// load a version 2 motion field (after the common header fields)
+aptr<MotionField> loadMotionFieldBlocks( File &file, int width, int height ) {
+	aptr<MotionField> mf;
+	MotionFileHeader header;
+	header.encoding = file.readInt();
+	header.fixedStep = file.readFloat();
+	header.compressed = file.readInt();
+	header.occDefined = file.readInt();
+	for (int i = 0; i < 3; i++) {
+		header.rowBytes[ i ] = file.readInt();
+		header.storedBytes[ i ] = file.readInt();
+	}
+	if (checkMotionFileHeader( header, width, height ) == false)
+		return mf;
+	mf.reset( new MotionField( width, height ) );
+	int offset = MOTION_FILE_HEADER_BYTES;
+	bool success = readMotionBlock( file, header, 0, mf->uRef(), offset ) && readMotionBlock( file, header, 1, mf->vRef(), offset );
+	if (success && header.occDefined) {
+		mf->enableOcc();
+		success = readMotionBlock( file, header, 2, mf->occRef(), offset );
+	}
+	if (success == false)
+		mf.reset();
+	return mf;
+}
+
+
 /// load motion field from binary data file
 aptr<MotionField> loadMotionField( File &file ) {
 	aptr<MotionField> mf;
@@ -134,12 +404,10 @@ aptr<MotionField> loadMotionField( File &file ) {
 		warning( "invalid motion field header" );
 		return mf;
 	}
-	// TODO: should version be used?
-	// commented out due to -Werror
-	// int version = 0;
+	int version = 0;
 	int width = file.readInt();
 	if (width == 0) {
-		// version = file.readInt();
+		version = file.readInt();
 		width = file.readInt();
 	}
 	int height = file.readInt();
@@ -148,18 +416,29 @@ aptr<MotionField> loadMotionField( File &file ) {
 	if (width <= 0 || height <= 0)
 		return mf;
 
-	// read dimensions
-	mf.reset( new MotionField( width, height ) );
-
 	// read meta data
-	mf->setBuildTime( (float) file.readDouble() );
+	float buildTime = (float) file.readDouble();
 	file.readDouble(); // note: remove this for old files
 
-	// read motion
+	// read planar format
+	if (version >= 2) {
+		mf = loadMotionFieldBlocks( file, width, height );
+		if (mf.get())
+			mf->setBuildTime( buildTime );
+		return mf;
+	}
+	mf.reset( new MotionField( width, height ) );
+	mf->setBuildTime( buildTime );
+
+	// read interleaved motion (in one block)
+	VectorF motion( width * height * 2 );
+	file.readBlock( motion.dataPtr(), motion.length() * sizeof( float ) );
 	for (int y = 0; y < height; y++) {
+		const float *in = motion.dataPtr() + y * width * 2;
+		float *u = mf->uRef().row( y ), *v = mf->vRef().row( y );
 		for (int x = 0; x < width; x++) {
-			mf->setU( x, y, file.readFloat() );
-			mf->setV( x, y, file.readFloat() );
+			u[ x ] = in[ x * 2 ];
+			v[ x ] = in[ x * 2 + 1 ];
 		}
 	}
 
@@ -167,11 +446,8 @@ aptr<MotionField> loadMotionField( File &file ) {
 	int containsOccMask = file.readInt();
 	if (containsOccMask) {
 		mf->enableOcc();
-		for (int y = 0; y < height; y++) {
-			for (int x = 0; x < width; x++) {
-				mf->setOcc( x, y, file.readUChar() );
-			}
-		}
+		for (int y = 0; y < height; y++)
+			file.readBlock( mf->occRef().row( y ), width );
 	}
 	
 	// return loaded motion field
@@ -179,7 +455,7 @@ aptr<MotionField> loadMotionField( File &file ) {
 }
 
 
-/// load motion field from binary data file
+/// load motion field from binary data file (in either the current planar format or the older interleaved format)
 aptr<MotionField> loadMotionField( const String &fileName ) {
 	aptr<MotionField> mf;
 	File file( fileName, FileOpenMode::FILE_READ, FileOpenType::FILE_BINARY );
@@ -189,6 +465,60 @@ aptr<MotionField> loadMotionField( const String &fileName ) {
 }
 
 
+/// load motion field from binary data file by memory-mapping it; for uncompressed MOTION_FLOAT32 files
+/// (the default saveMotionField format), the motion field uses the mapped data without copying it;
+/// other files are loaded as with loadMotionField
+aptr<MotionField> mapMotionField( const String &fileName ) {
+	aptr<MotionField> mf;
+	MappedFile *mapping = new MappedFile( fileName );
+	if (mapping->openSuccess() && mapping->size() >= MOTION_FILE_DATA_OFFSET) {
+
+		// read the header fields
+		const unsigned char *data = mapping->data();
+		int fields[ 4 ] = { 0, 0, 0, 0 };
+		memcpy( fields, data + 3, 16 );
+		int version = fields[ 1 ], width = fields[ 2 ], height = fields[ 3 ];
+		double buildTime = 0;
+		memcpy( &buildTime, data + 19, 8 );
+		MotionFileHeader header;
+		memcpy( &header.encoding, data + 35, 4 );
+		memcpy( &header.fixedStep, data + 39, 4 );
+		memcpy( &header.compressed, data + 43, 4 );
+		memcpy( &header.occDefined, data + 47, 4 );
+		for (int i = 0; i < 3; i++) {
+			memcpy( &header.rowBytes[ i ], data + 51 + i * 8, 4 );
+			memcpy( &header.storedBytes[ i ], data + 55 + i * 8, 4 );
+		}
+
+		// if the blocks can be used as images, wrap them
+		if (strcmp( (const char *) data, "mf" ) == 0 && fields[ 0 ] == 0 && version == MOTION_FILE_VERSION && width > 0 && height > 0
+			&& header.encoding == (int) MotionFieldEncoding::MOTION_FLOAT32 && header.compressed == 0
+			&& header.rowBytes[ 0 ] % sizeof( float ) == 0 && checkMotionFileHeader( header, width, height )) {
+			size_t offsets[ 3 ] = { 0, 0, 0 };
+			size_t offset = MOTION_FILE_DATA_OFFSET;
+			for (int i = 0; i < (header.occDefined ? 3 : 2); i++) {
+				offsets[ i ] = offset;
+				offset = alignMotionFileOffset( (int) (offset + header.storedBytes[ i ]) );
+			}
+			size_t lastEnd = offsets[ header.occDefined ? 2 : 1 ] + header.storedBytes[ header.occDefined ? 2 : 1 ];
+			if (lastEnd <= mapping->size()) {
+				unsigned char *mapped = mapping->data();
+				ImageGrayF *u = new ImageGrayF( (float *) (mapped + offsets[ 0 ]), width, height, header.rowBytes[ 0 ] );
+				ImageGrayF *v = new ImageGrayF( (float *) (mapped + offsets[ 1 ]), width, height, header.rowBytes[ 1 ] );
+				ImageGrayU *occMask = header.occDefined ? new ImageGrayU( mapped + offsets[ 2 ], width, height, header.rowBytes[ 2 ] ) : NULL;
+				mf.reset( new MotionField( u, v, occMask, mapping ) );
+				mf->setBuildTime( (float) buildTime );
+				return mf;
+			}
+		}
+	}
+
+	// otherwise load the file normally
+	delete mapping;
+	return loadMotionField( fileName );
+}
+
+
 /// load motion field from floating-point image file
 aptr<MotionField> loadMotionFieldImage( const String &fileName ) {
 	aptr<MotionField> mf;
@@ -212,16 +542,65 @@ aptr<MotionField> loadMotionFieldImage( const String &fileName ) {
 }
 
 
-/// save motion field to binary data file
-void saveMotionField( const MotionField &mf, File &file ) {
+/// save motion field to binary data file, storing u, v, and the occlusion mask (if any) as separate aligned blocks;
+/// fixedStep is used with MOTION_FIXED16; if compress is true, the blocks are compressed with zlib (requires USE_ZLIB)
+void saveMotionField( const MotionField &mf, File &file, MotionFieldEncoding encoding, float fixedStep, bool compress ) {
+	int width = mf.width(), height = mf.height();
+	assertAlways( encoding != MotionFieldEncoding::MOTION_FIXED16 || fixedStep > 0 );
+#ifndef USE_ZLIB
+	if (compress) {
+		warning( "saveMotionField: compression requires USE_ZLIB; saving uncompressed" );
+		compress = false;
+	}
+#endif
+
+	// get the layout of each block; use the image data directly if it matches the layout
+	int blockCount = mf.occDefined() ? 3 : 2;
+	int rowBytes[ 3 ] = { motionBlockRowBytes( width, encoding ), motionBlockRowBytes( width, encoding ), mf.occDefined() ? mf.occRef().rowBytes() : 0 };
+	int storedBytes[ 3 ] = { 0, 0, 0 };
+	const unsigned char *blocks[ 3 ] = { NULL, NULL, NULL };
+	Vector<unsigned char> encoded[ 3 ];
+	for (int i = 0; i < blockCount; i++) {
+		if (i == 2) {
+			blocks[ i ] = (const unsigned char *) mf.occRef().rawConst();
+		} else {
+			const ImageGrayF &plane = i ? mf.vRef() : mf.uRef();
+			if (encoding == MotionFieldEncoding::MOTION_FLOAT32 && plane.rowBytes() == rowBytes[ i ]) {
+				blocks[ i ] = (const unsigned char *) plane.rawConst();
+			} else {
+				encoded[ i ].setLength( rowBytes[ i ] * height );
+				encodeMotionBlock( plane, encoding, fixedStep, rowBytes[ i ], encoded[ i ].dataPtr() );
+				blocks[ i ] = encoded[ i ].dataPtr();
+			}
+		}
+		storedBytes[ i ] = rowBytes[ i ] * height;
+	}
+
+	// compress the blocks; if any block fails, the file is saved uncompressed
+#ifdef USE_ZLIB
+	Vector<unsigned char> compressed[ 3 ];
+	int compressedBytes[ 3 ] = { 0, 0, 0 };
+	for (int i = 0; i < blockCount && compress; i++) {
+		uLongf length = compressBound( storedBytes[ i ] );
+		compressed[ i ].setLength( (int) length );
+		if (compress2( compressed[ i ].dataPtr(), &length, blocks[ i ], storedBytes[ i ], Z_DEFAULT_COMPRESSION ) != Z_OK) {
+			warning( "saveMotionField: error compressing motion field; saving uncompressed" );
+			compress = false;
+		}
+		compressedBytes[ i ] = (int) length;
+	}
+	if (compress) {
+		for (int i = 0; i < blockCount; i++) {
+			blocks[ i ] = compressed[ i ].dataPtr();
+			storedBytes[ i ] = compressedBytes[ i ];
+		}
+	}
+#endif
 
 	// write header
 	file.writeBlock( "mf", 3 );
-
-	// write dimensions
-	int width = mf.width(), height = mf.height();
 	file.writeInt( 0 );
-	file.writeInt( 1 );
+	file.writeInt( MOTION_FILE_VERSION );
 	file.writeInt( width );
 	file.writeInt( height );
 
@@ -229,31 +608,32 @@ void saveMotionField( const MotionField &mf, File &file ) {
 	file.writeDouble( mf.buildTime() );
 	file.writeDouble( 0 ); // note: remove this for old files
 
-	// write motion
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			file.writeFloat( mf.u( x, y ));
-			file.writeFloat( mf.v( x, y ));
-		}
+	// write the encoding and the layout of each block
+	file.writeInt( (int) encoding );
+	file.writeFloat( encoding == MotionFieldEncoding::MOTION_FIXED16 ? fixedStep : 0.0f );
+	file.writeInt( compress ? 1 : 0 );
+	file.writeInt( mf.occDefined() ? 1 : 0 );
+	for (int i = 0; i < 3; i++) {
+		file.writeInt( rowBytes[ i ] );
+		file.writeInt( storedBytes[ i ] );
 	}
 
-	// write occlusion mask (if any)
-	file.writeInt( mf.occDefined() ? 1 : 0 );
-	if (mf.occDefined()) {
-		for (int y = 0; y < height; y++) {
-			for (int x = 0; x < width; x++) {
-				file.writeUChar( mf.occ( x, y ));
-			}
-		}
+	// write the blocks
+	int offset = MOTION_FILE_HEADER_BYTES;
+	for (int i = 0; i < blockCount; i++) {
+		writeMotionFilePadding( file, offset );
+		file.writeBlock( blocks[ i ], storedBytes[ i ] );
+		offset += storedBytes[ i ];
 	}
 }
 
 
-/// save motion field to binary data file
-void saveMotionField( const MotionField &mf, const String &fileName ) {
+/// save motion field to binary data file, storing u, v, and the occlusion mask (if any) as separate aligned blocks;
+/// fixedStep is used with MOTION_FIXED16; if compress is true, the blocks are compressed with zlib (requires USE_ZLIB)
+void saveMotionField( const MotionField &mf, const String &fileName, MotionFieldEncoding encoding, float fixedStep, bool compress ) {
 	File file( fileName, FileOpenMode::FILE_WRITE, FileOpenType::FILE_BINARY ); 
 	if (file.openSuccess()) 
-		saveMotionField( mf, file );
+		saveMotionField( mf, file, encoding, fixedStep, compress );
 }
 
 
@@ -382,29 +762,25 @@ aptr<MotionField> computeDenseMotion( const VectorF &x, const VectorF &y, const
 	// for efficiency, compute motion on a smaller resolution then rescale motion field
 	float mfScaleFactor = 0.5f;
 
-	// prepare matrix of match points
+	// prepare matrix of match points and matrix of (u, v) values
 	int pointCount = x.size();
 	MatrixF points( pointCount, 2 );
+	MatrixF values( pointCount, 2 );
 	for (int i = 0; i < pointCount; i++) {
 		points.data( i, 0 ) = x[ i ] * mfScaleFactor;
 		points.data( i, 1 ) = y[ i ] * mfScaleFactor;
+		values.data( i, 0 ) = u[ i ];
+		values.data( i, 1 ) = v[ i ];
 	}
 
-	// fix(clean): should not be needed, but current triangulationInterpolation requires non-const u and v
-	VectorF uCopy( u ), vCopy( v );
-	
-	// triangulate the points and linearly intepolate on the triangles
+	// triangulate the points and linearly intepolate u and v on the triangles (directly into the motion field)
 	int mfWidth = round( width * mfScaleFactor );
 	int mfHeight = round( height * mfScaleFactor );
-	aptr<ImageGrayF> uMap = triangulationInterpolation( points, uCopy, mfWidth, mfHeight );
-	aptr<ImageGrayF> vMap = triangulationInterpolation( points, vCopy, mfWidth, mfHeight );
 	mf.reset( new MotionField( mfWidth, mfHeight ) );
-	for (int y = 0; y < mfHeight; y++) {
-		for (int x = 0; x < mfWidth; x++) {
-			mf->setU( x, y, uMap->data( x, y ) );
-			mf->setV( x, y, vMap->data( x, y ) );
-		}
-	}
+	PtrArray<ImageGrayF> images;
+	images.append( &mf->uRef() );
+	images.append( &mf->vRef() );
+	triangulationInterpolation( points, values, images );
 	mf->resize( width, height, false );
 #endif
 	return mf;
@@ -436,4 +812,201 @@ aptr<MotionField> invertMotionField( const MotionField &mf, const ImageGrayU &ma
 }
 
 
+//-------------------------------------------
+// TEST / BENCHMARK
+//-------------------------------------------
+
+
+// create a motion field with smooth motion plus noise (and an occlusion mask if requested)
+aptr<MotionField> motionFileTestField( int width, int height, bool occ ) {
+	aptr<MotionField> mf( new MotionField( width, height ) );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			mf->setU( x, y, 40.0f * sinf( (float) x * 0.01f ) + randomFloat( -2.0f, 2.0f ) );
+			mf->setV( x, y, 20.0f * cosf( (float) y * 0.02f ) + randomFloat( -2.0f, 2.0f ) );
+		}
+	}
+	if (occ) {
+		mf->enableOcc();
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				mf->setOcc( x, y, (unsigned char) randomInt( 0, 255 ) );
+	}
+	mf->setBuildTime( 1.5f );
+	return mf;
+}
+
+
+// save a motion field in the version 1 (interleaved) format, used for testing the loader
+void saveMotionFieldVersion1( const MotionField &mf, const String &fileName ) {
+	File file( fileName, FileOpenMode::FILE_WRITE, FileOpenType::FILE_BINARY );
+	if (file.openSuccess() == false)
+		return;
+	int width = mf.width(), height = mf.height();
+	file.writeBlock( "mf", 3 );
+	file.writeInt( 0 );
+	file.writeInt( 1 );
+	file.writeInt( width );
+	file.writeInt( height );
+	file.writeDouble( mf.buildTime() );
+	file.writeDouble( 0 );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			file.writeFloat( mf.u( x, y ) );
+			file.writeFloat( mf.v( x, y ) );
+		}
+	}
+	file.writeInt( mf.occDefined() ? 1 : 0 );
+	if (mf.occDefined())
+		for (int y = 0; y < height; y++)
+			file.writeBlock( mf.occRef().row( y ), width );
+}
+
+
+// the largest difference between the motion vector components of two motion fields (of the same size),
+// or a negative value if the occlusion masks differ
+float motionFileError( const MotionField &mf1, const MotionField &mf2 ) {
+	if (mf1.width() != mf2.width() || mf1.height() != mf2.height() || mf1.occDefined() != mf2.occDefined() || mf1.buildTime() != mf2.buildTime())
+		return -1;
+	float maxError = 0;
+	for (int y = 0; y < mf1.height(); y++) {
+		for (int x = 0; x < mf1.width(); x++) {
+			maxError = max( maxError, fAbs( mf1.u( x, y ) - mf2.u( x, y ) ) );
+			maxError = max( maxError, fAbs( mf1.v( x, y ) - mf2.v( x, y ) ) );
+			if (mf1.occDefined() && mf1.occ( x, y ) != mf2.occ( x, y ))
+				return -1;
+		}
+	}
+	return maxError;
+}
+
+
+// check that motion fields can be saved and loaded in each format
+bool testMotionFieldFile() {
+	String fileName = "_testMotionFieldFile.mf";
+
+	// check the half-precision conversion, including rounding, subnormals, and saturation
+	unitAssert( floatToHalf( 1.0f ) == 0x3c00 && floatToHalf( -2.0f ) == 0xc000 && floatToHalf( 65504.0f ) == 0x7bff );
+	unitAssert( floatToHalf( 1e6f ) == 0x7bff && floatToHalf( 1e-9f ) == 0 && floatToHalf( 1.0f + 1.0f / 2048.0f ) == 0x3c00 );
+	for (int i = 0; i < 0x7c00; i++) {
+		unitAssert( floatToHalf( halfToFloat( (unsigned short) i ) ) == i && floatToHalf( halfToFloat( (unsigned short) (i | 0x8000) ) ) == (i | 0x8000) );
+	}
+
+	// check each encoding
+	for (int i = 0; i < 4; i++) {
+		int width = randomInt( 1, 100 ), height = randomInt( 1, 50 );
+		bool occ = (i & 1) != 0;
+		aptr<MotionField> mf = motionFileTestField( width, height, occ );
+		for (int encodingIndex = 0; encodingIndex < 3; encodingIndex++) {
+			MotionFieldEncoding encoding = (MotionFieldEncoding) encodingIndex;
+			float step = 1.0f / 32.0f;
+			float maxError = encoding == MotionFieldEncoding::MOTION_FLOAT32 ? 0 : (encoding == MotionFieldEncoding::MOTION_FLOAT16 ? 42.0f / 2048.0f : step * 0.5f);
+#ifdef USE_ZLIB
+			int compressCount = 2;
+#else
+			int compressCount = 1;
+#endif
+			for (int compress = 0; compress < compressCount; compress++) {
+				saveMotionField( *mf, fileName, encoding, step, compress != 0 );
+				aptr<MotionField> loaded = loadMotionField( fileName );
+				unitAssert( loaded.get() );
+				float error = motionFileError( *mf, *loaded );
+				unitAssert( error >= 0 && error <= maxError );
+			}
+		}
+
+		// check the mapped version, which should be exact and writable (without changing the file)
+		saveMotionField( *mf, fileName );
+		aptr<MotionField> mapped = mapMotionField( fileName );
+		unitAssert( mapped.get() && motionFileError( *mf, *mapped ) == 0 );
+		mapped->uRef().data( 0, 0 ) += 1.0f;
+		mapped.reset();
+		aptr<MotionField> loaded = loadMotionField( fileName );
+		unitAssert( motionFileError( *mf, *loaded ) == 0 );
+
+		// check mapping a file that needs to be decoded
+		saveMotionField( *mf, fileName, MotionFieldEncoding::MOTION_FIXED16, 1.0f / 32.0f );
+		mapped = mapMotionField( fileName );
+		unitAssert( mapped.get() && motionFileError( *mf, *mapped ) <= 1.0f / 64.0f );
+
+		// check loading the old format
+		saveMotionFieldVersion1( *mf, fileName );
+		loaded = loadMotionField( fileName );
+		unitAssert( loaded.get() && motionFileError( *mf, *loaded ) == 0 );
+
+		// check that a corrupted compressed block is rejected (the zlib checksum is at the end of the last block)
+#ifdef USE_ZLIB
+		saveMotionField( *mf, fileName, MotionFieldEncoding::MOTION_FLOAT32, 0, true );
+		FILE *corruptFile = fopen( fileName.c_str(), "r+b" );
+		unitAssert( corruptFile );
+		fseek( corruptFile, -2, SEEK_END );
+		int c = fgetc( corruptFile );
+		fseek( corruptFile, -2, SEEK_END );
+		fputc( c ^ 0xff, corruptFile );
+		fclose( corruptFile );
+		loaded = loadMotionField( fileName );
+		unitAssert( loaded.get() == NULL );
+#endif
+	}
+	deleteFile( fileName );
+	return true;
+}
+
+
+// time saving and loading motion fields in each format
+void benchmarkMotionFile( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int iterations = conf.readInt( "iterations", 10 );
+	String fileName = conf.readString( "fileName", "_benchMotionFile.mf" );
+	if (conf.initialPass())
+		return;
+	disp( 1, "motion field: %d x %d", width, height );
+	aptr<MotionField> mf = motionFileTestField( width, height, true );
+
+	// time each format
+	const char *names[] = { "version 1", "float32", "float32 (mapped)", "float16", "fixed16", "float16 (compressed)" };
+	for (int i = 0; i < 6; i++) {
+#ifndef USE_ZLIB
+		if (i == 5)
+			break;
+#endif
+		MotionFieldEncoding encoding = i == 3 || i == 5 ? MotionFieldEncoding::MOTION_FLOAT16 : (i == 4 ? MotionFieldEncoding::MOTION_FIXED16 : MotionFieldEncoding::MOTION_FLOAT32);
+		Timer saveTimer, loadTimer;
+		float error = 0;
+		for (int j = 0; j < iterations; j++) {
+			saveTimer.start();
+			if (i == 0)
+				saveMotionFieldVersion1( *mf, fileName );
+			else
+				saveMotionField( *mf, fileName, encoding, 1.0f / 64.0f, i == 5 );
+			saveTimer.stop();
+			loadTimer.start();
+			aptr<MotionField> loaded = i == 2 ? mapMotionField( fileName ) : loadMotionField( fileName );
+			loadTimer.stop();
+			if (loaded.get())
+				error = motionFileError( *mf, *loaded );
+		}
+		MappedFile mapping( fileName );
+		disp( 1, "%-22s save: %8.3f ms, load: %8.3f ms, size: %9d bytes, max error: %f", names[ i ],
+			saveTimer.timeSum() * 1000.0 / iterations, loadTimer.timeSum() * 1000.0 / iterations, (int) mapping.size(), error );
+	}
+	deleteFile( fileName );
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initMotionFieldUtil() {
+	registerUnitTest( testMotionFieldFile );
+	registerCommand( "benchmotionfile", benchmarkMotionFile );
+}
+
+
 } // end namespace sbl
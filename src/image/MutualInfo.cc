@@ -0,0 +1,367 @@
+#include <sbl/image/MutualInfo.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <sbl/image/ImageUtil.h> // for test and benchmark
+#include <mutex>
+#include <math.h>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// N LOG N TABLE
+//-------------------------------------------
+
+
+// the number of precomputed n * log( n ) values
+#define NLOGN_TABLE_SIZE 65536
+
+
+// compute n * log( n ) for n in [0, NLOGN_TABLE_SIZE)
+VectorD createNLogNTable() {
+	VectorD table( NLOGN_TABLE_SIZE );
+	table[ 0 ] = 0;
+	for (int n = 1; n < NLOGN_TABLE_SIZE; n++)
+		table[ n ] = (double) n * log( (double) n );
+	return table;
+}
+
+
+// compute n * log( n ) (with 0 log 0 = 0), using the given table for small values
+inline double nLogN( unsigned int n, const double *table ) {
+	return n < NLOGN_TABLE_SIZE ? table[ n ] : (double) n * log( (double) n );
+}
+
+
+//-------------------------------------------
+// JOINT HISTOGRAM CLASS
+//-------------------------------------------
+
+
+/// create an empty histogram
+JointHistogram::JointHistogram( int bucketCount, bool parzen ) : m_bins( bucketCount * bucketCount ) {
+	assertAlways( bucketCount >= 2 && bucketCount <= 256 );
+	m_bucketCount = bucketCount;
+	m_parzen = parzen;
+	if (parzen) {
+		m_positions.setLength( 256 );
+		for (int v = 0; v < 256; v++)
+			m_positions[ v ] = (unsigned short) ((v * (bucketCount - 1) * 16 + 127) / 255);
+	}
+	reset();
+}
+
+
+/// remove all pairs from the histogram
+void JointHistogram::reset() {
+	m_bins.clear( 0 );
+	m_sampleCount = 0;
+}
+
+
+/// add the pairs (values1[ i ], values2[ i ]) for i in [0, count)
+void JointHistogram::add( const unsigned char *values1, const unsigned char *values2, int count ) {
+	assertAlways( (m_sampleCount + count) * (m_parzen ? 256 : 1) <= 0xffffffffLL );
+	unsigned int *bins = m_bins.dataPtr();
+	int bucketCount = m_bucketCount;
+	int i = 0;
+
+	// split each pair between the four nearest bins
+	if (m_parzen) {
+		const unsigned short *positions = m_positions.dataPtr();
+		int last = bucketCount - 1;
+		for (; i < count; i++) {
+			int p1 = positions[ values1[ i ] ], p2 = positions[ values2[ i ] ];
+			int i1 = p1 >> 4, f1 = p1 & 15, i2 = p2 >> 4, f2 = p2 & 15;
+
+			// (at the last bucket the fraction is zero, so the clamped neighbor receives nothing)
+			int n2 = min( i2 + 1, last );
+			unsigned int *row = bins + i1 * bucketCount, *nextRow = bins + min( i1 + 1, last ) * bucketCount;
+			row[ i2 ] += (16 - f1) * (16 - f2);
+			row[ n2 ] += (16 - f1) * f2;
+			nextRow[ i2 ] += f1 * (16 - f2);
+			nextRow[ n2 ] += f1 * f2;
+		}
+		m_sampleCount += count;
+		return;
+	}
+
+	// compute the bin indices of 16 pairs at a time, using x / 255 = (x + 1 + (x >> 8)) >> 8 (for x < 65535)
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16( 1 );
+	__m128i scale = _mm_set1_epi16( (short) (bucketCount - 1) ), stride = _mm_set1_epi16( (short) bucketCount );
+	unsigned short index[ 16 ];
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_loadu_si128( (const __m128i *) (values1 + i) ), b = _mm_loadu_si128( (const __m128i *) (values2 + i) );
+		__m128i a16[ 2 ] = { _mm_unpacklo_epi8( a, zero ), _mm_unpackhi_epi8( a, zero ) };
+		__m128i b16[ 2 ] = { _mm_unpacklo_epi8( b, zero ), _mm_unpackhi_epi8( b, zero ) };
+		for (int j = 0; j < 2; j++) {
+			__m128i x1 = _mm_mullo_epi16( a16[ j ], scale ), x2 = _mm_mullo_epi16( b16[ j ], scale );
+			__m128i q1 = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( x1, one ), _mm_srli_epi16( x1, 8 ) ), 8 );
+			__m128i q2 = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( x2, one ), _mm_srli_epi16( x2, 8 ) ), 8 );
+			_mm_storeu_si128( (__m128i *) (index + j * 8), _mm_add_epi16( _mm_mullo_epi16( q1, stride ), q2 ) );
+		}
+		for (int j = 0; j < 16; j++)
+			bins[ index[ j ] ]++;
+	}
+#endif
+
+	// add remaining pairs
+	for (; i < count; i++)
+		bins[ (values1[ i ] * (bucketCount - 1) / 255) * bucketCount + values2[ i ] * (bucketCount - 1) / 255 ]++;
+	m_sampleCount += count;
+}
+
+
+/// add the corresponding pixels of a pair of images (with the rows split across the worker threads)
+void JointHistogram::add( const ImageViewGrayU &img1, const ImageViewGrayU &img2 ) {
+	int width = img1.width(), height = img1.height();
+	assertAlways( img2.width() == width && img2.height() == height );
+
+	// fill a histogram for each range of rows, then add it to this histogram
+	std::mutex mergeMutex;
+	parallelFor( 0, height, 16, [&]( int begin, int end ) {
+		JointHistogram histogram( m_bucketCount, m_parzen );
+		for (int y = begin; y < end; y++)
+			histogram.add( img1.row( y ), img2.row( y ), width );
+		std::lock_guard<std::mutex> lock( mergeMutex );
+		merge( histogram );
+	} );
+}
+
+
+/// add the bins of another histogram (with the same bucket count and binning)
+void JointHistogram::merge( const JointHistogram &histogram ) {
+	assertAlways( histogram.m_bucketCount == m_bucketCount && histogram.m_parzen == m_parzen );
+	assertAlways( (m_sampleCount + histogram.m_sampleCount) * (m_parzen ? 256 : 1) <= 0xffffffffLL );
+	unsigned int *bins = m_bins.dataPtr();
+	const unsigned int *otherBins = histogram.m_bins.dataPtr();
+	for (int i = 0; i < m_bins.length(); i++)
+		bins[ i ] += otherBins[ i ];
+	m_sampleCount += histogram.m_sampleCount;
+}
+
+
+/// the mutual information (in nats) of the distribution given by the histogram
+double JointHistogram::mutualInfo() const {
+	if (m_sampleCount == 0)
+		return 0;
+	static const VectorD table = createNLogNTable();
+	const double *nLogNValues = table.dataPtr();
+
+	// with bin values n (summing to total), each entropy is log( total ) - sum( n log n ) / total
+	int bucketCount = m_bucketCount;
+	Vector<unsigned int> rowSums( bucketCount ), colSums( bucketCount );
+	rowSums.clear( 0 );
+	colSums.clear( 0 );
+	double jointSum = 0;
+	for (int i = 0; i < bucketCount; i++) {
+		const unsigned int *row = m_bins.dataPtr() + i * bucketCount;
+		unsigned int rowSum = 0;
+		for (int j = 0; j < bucketCount; j++) {
+			unsigned int n = row[ j ];
+			if (n) {
+				rowSum += n;
+				colSums[ j ] += n;
+				jointSum += nLogN( n, nLogNValues );
+			}
+		}
+		rowSums[ i ] = rowSum;
+	}
+	double marginalSum = 0;
+	for (int i = 0; i < bucketCount; i++)
+		marginalSum += nLogN( rowSums[ i ], nLogNValues ) + nLogN( colSums[ i ], nLogNValues );
+	double total = (double) m_sampleCount * (m_parzen ? 256.0 : 1.0);
+	return log( total ) + (jointSum - marginalSum) / total;
+}
+
+
+//-------------------------------------------
+// MUTUAL INFORMATION
+//-------------------------------------------
+
+
+/// compute mutual info between a pair of images using Parzen-window (soft) binning
+float mutualInfoParzen( const ImageViewGrayU &img1, const ImageViewGrayU &img2, int bucketCount ) {
+	JointHistogram histogram( bucketCount, true );
+	histogram.add( img1, img2 );
+	return (float) histogram.mutualInfo();
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// the previous (floating-point histogram) implementation of mutualInfo, used for testing and benchmarking
+double mutualInfoDirect( const ImageViewGrayU &img1, const ImageViewGrayU &img2, int bucketCount ) {
+	int width = img1.width(), height = img1.height();
+	VectorD histogram( bucketCount * bucketCount ), hist1( bucketCount ), hist2( bucketCount );
+	histogram.clear( 0 );
+	hist1.clear( 0 );
+	hist2.clear( 0 );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int i = img1.data( x, y ) * (bucketCount - 1) / 255, j = img2.data( x, y ) * (bucketCount - 1) / 255;
+			histogram[ i * bucketCount + j ]++;
+			hist1[ i ]++;
+			hist2[ j ]++;
+		}
+	}
+	double total = (double) (width * height), hxy = 0, hx = 0, hy = 0;
+	for (int i = 0; i < histogram.length(); i++)
+		if (histogram[ i ])
+			hxy -= histogram[ i ] / total * log( histogram[ i ] / total );
+	for (int i = 0; i < bucketCount; i++) {
+		if (hist1[ i ])
+			hx -= hist1[ i ] / total * log( hist1[ i ] / total );
+		if (hist2[ i ])
+			hy -= hist2[ i ] / total * log( hist2[ i ] / total );
+	}
+	return hx + hy - hxy;
+}
+
+
+// create a pair of related random test images: the second is a (non-monotonic) function of the first plus noise
+void mutualInfoTestImages( int width, int height, ImageGrayU &img1, ImageGrayU &img2 ) {
+	ImageGrayU noise( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			noise.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+	aptr<ImageGrayU> blurred = blurBox( noise, 5 );
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int v = blurred->data( x, y );
+			img1.data( x, y ) = (unsigned char) v;
+			img2.data( x, y ) = (unsigned char) bound( (v < 128 ? 255 - 2 * v : 2 * (v - 128)) + randomInt( -20, 20 ), 0, 255 );
+		}
+	}
+}
+
+
+// check joint histograms and mutual info against direct computations
+bool testMutualInfo() {
+	int width = 67, height = 45;
+	ImageGrayU img1( width, height ), img2( width, height );
+	mutualInfoTestImages( width, height, img1, img2 );
+	const unsigned char *values1 = img1.row( 0 ), *values2 = img2.row( 0 );
+	int bucketCounts[] = { 2, 17, 32, 256 };
+	for (int k = 0; k < 4; k++) {
+		int bucketCount = bucketCounts[ k ];
+
+		// hard-binned bins should match direct counts
+		JointHistogram histogram( bucketCount );
+		histogram.add( values1, values2, width );
+		VectorI counts( bucketCount * bucketCount );
+		counts.clear( 0 );
+		for (int x = 0; x < width; x++)
+			counts[ (values1[ x ] * (bucketCount - 1) / 255) * bucketCount + values2[ x ] * (bucketCount - 1) / 255 ]++;
+		for (int i = 0; i < bucketCount; i++) {
+			for (int j = 0; j < bucketCount; j++) {
+				unitAssert( histogram.bin( i, j ) == (unsigned int) counts[ i * bucketCount + j ] );
+			}
+		}
+
+		// the mutual info of the images (filled in parallel) should match the direct version
+		histogram.reset();
+		histogram.add( imageView( img1 ), imageView( img2 ) );
+		unitAssert( histogram.sampleCount() == width * height );
+		unitAssert( fabs( histogram.mutualInfo() - mutualInfoDirect( imageView( img1 ), imageView( img2 ), bucketCount ) ) < 1e-6 );
+		unitAssert( fabs( mutualInfo( imageView( img1 ), imageView( img2 ), bucketCount ) - mutualInfoDirect( imageView( img1 ), imageView( img2 ), bucketCount ) ) < 1e-5 );
+
+		// Parzen bins should sum to 256 per pair, with each pair's weight centered at its position
+		JointHistogram parzenHistogram( bucketCount, true );
+		parzenHistogram.add( values1, values2, width );
+		double sum = 0, iSum = 0, jSum = 0, iExpected = 0, jExpected = 0;
+		for (int i = 0; i < bucketCount; i++) {
+			for (int j = 0; j < bucketCount; j++) {
+				sum += parzenHistogram.bin( i, j );
+				iSum += parzenHistogram.bin( i, j ) * i;
+				jSum += parzenHistogram.bin( i, j ) * j;
+			}
+		}
+		for (int x = 0; x < width; x++) {
+			iExpected += values1[ x ] * (bucketCount - 1) / 255.0;
+			jExpected += values2[ x ] * (bucketCount - 1) / 255.0;
+		}
+		unitAssert( sum == 256.0 * width );
+		unitAssert( fabs( iSum / 256.0 - iExpected ) < 0.04 * width && fabs( jSum / 256.0 - jExpected ) < 0.04 * width );
+	}
+
+	// merging should match adding everything to one histogram
+	JointHistogram all( 32 ), part1( 32 ), part2( 32 );
+	all.add( values1, values2, width );
+	all.add( img1.row( 1 ), img2.row( 1 ), width );
+	part1.add( values1, values2, width );
+	part2.add( img1.row( 1 ), img2.row( 1 ), width );
+	part1.merge( part2 );
+	unitAssert( part1.sampleCount() == all.sampleCount() && part1.mutualInfo() == all.mutualInfo() );
+
+	// related images should have more mutual info than unrelated images; an image's mutual info with itself is its entropy
+	ImageGrayU unrelated( width, height );
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			unrelated.data( x, y ) = (unsigned char) randomInt( 0, 255 );
+	float related = mutualInfoParzen( imageView( img1 ), imageView( img2 ), 16 );
+	unitAssert( related > 2 * mutualInfoParzen( imageView( img1 ), imageView( unrelated ), 16 ) );
+	unitAssert( mutualInfoParzen( imageView( img1 ), imageView( img1 ), 16 ) > related );
+	return true;
+}
+
+
+// time joint histogram and mutual info computation
+void benchmarkMutualInfo( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 640 );
+	int height = conf.readInt( "height", 480 );
+	int bucketCount = conf.readInt( "bucketCount", 32 );
+	int iterations = conf.readInt( "iterations", 20 );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "image: %d x %d, buckets: %d, threads: %d", width, height, bucketCount, threadCount() );
+
+	// create test images
+	ImageGrayU img1( width, height ), img2( width, height );
+	mutualInfoTestImages( width, height, img1, img2 );
+	ImageViewGrayU view1 = imageView( img1 ), view2 = imageView( img2 );
+
+	// time each version
+	for (int i = 0; i < 3; i++) {
+		Timer timer( true );
+		double result = 0;
+		for (int j = 0; j < iterations; j++) {
+			switch (i) {
+			case 0: result = mutualInfoDirect( view1, view2, bucketCount ); break;
+			case 1: result = mutualInfo( view1, view2, bucketCount ); break;
+			case 2: result = mutualInfoParzen( view1, view2, bucketCount ); break;
+			}
+		}
+		timer.stop();
+		const char *names[] = { "direct (floating-point histogram)", "mutualInfo", "mutualInfoParzen" };
+		disp( 1, "%-36s %7.3f ms (mutual info: %f)", names[ i ], timer.timeSum() * 1000.0 / iterations, result );
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initMutualInfo() {
+	registerUnitTest( testMutualInfo );
+	registerCommand( "benchmutualinfo", benchmarkMutualInfo );
+}
+
+
+} // end namespace sbl
@@ -0,0 +1,564 @@
+#include <sbl/image/SeparableFilter.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// FILTER TAPS CLASS
+//-------------------------------------------
+
+
+// reflect a position into [0, length) without repeating the edge value (e.g. -1 -> 1, length -> length - 2)
+int reflect101( int i, int length ) {
+	if (length == 1)
+		return 0;
+	while (i < 0 || i >= length) {
+		if (i < 0)
+			i = -i;
+		if (i >= length)
+			i = 2 * length - 2 - i;
+	}
+	return i;
+}
+
+
+/// use a kernel (correlated with the input, centered on each position); borders are reflected
+void FilterTaps::setKernel( const VectorF &kernel, int length ) {
+	assertAlways( kernel.length() % 2 == 1 && length > 0 );
+	m_type = TAPS_KERNEL;
+	m_inputLength = length;
+	m_outputLength = length;
+	m_tapCount = kernel.length();
+	m_kernel = kernel;
+
+	// map each position of the extended axis (which has tapCount / 2 extra positions on each side) to an input position
+	int radius = m_tapCount / 2;
+	m_extendedIndex.setLength( length + m_tapCount - 1 );
+	for (int i = 0; i < m_extendedIndex.length(); i++)
+		m_extendedIndex[ i ] = reflect101( i - radius, length );
+}
+
+
+/// use a normalized box kernel of the given size
+void FilterTaps::setBox( int boxSize, int length ) {
+	assertAlways( boxSize > 0 && length > 0 );
+	VectorF kernel( boxSize );
+	kernel.clear( 1.0f / (float) boxSize );
+
+	// as with OpenCV, an even-sized box has one more element before the center than after it
+	m_type = TAPS_BOX;
+	m_inputLength = length;
+	m_outputLength = length;
+	m_tapCount = boxSize;
+	m_kernel = kernel;
+	int anchor = boxSize / 2;
+	m_extendedIndex.setLength( length + boxSize - 1 );
+	for (int i = 0; i < m_extendedIndex.length(); i++)
+		m_extendedIndex[ i ] = reflect101( i - anchor, length );
+}
+
+
+/// resample from inputLength to outputLength using area averaging (if area and shrinking) or bilinear interpolation
+void FilterTaps::setResample( int inputLength, int outputLength, bool area ) {
+	assertAlways( inputLength > 0 && outputLength > 0 );
+	m_type = TAPS_RESAMPLE;
+	m_inputLength = inputLength;
+	m_outputLength = outputLength;
+	double scale = (double) inputLength / (double) outputLength;
+
+	// area averaging: each output position averages the input positions it covers (weighted by overlap)
+	if (area && scale > 1.0) {
+		m_tapCount = (int) ceil( scale ) + 1;
+		m_index.setLength( outputLength * m_tapCount );
+		m_weight.setLength( outputLength * m_tapCount );
+		for (int x = 0; x < outputLength; x++) {
+			double start = x * scale, end = (x + 1) * scale;
+			int i = (int) floor( start );
+			for (int t = 0; t < m_tapCount; t++, i++) {
+				double overlap = 0;
+				if (i < inputLength) {
+					double left = i > start ? i : start;
+					double right = i + 1 < end ? i + 1 : end;
+					if (right > left)
+						overlap = right - left;
+				}
+				m_index[ x * m_tapCount + t ] = i < inputLength ? i : inputLength - 1;
+				m_weight[ x * m_tapCount + t ] = (float) (overlap / scale);
+			}
+		}
+
+	// bilinear interpolation: pixel centers are aligned (as with OpenCV's resize)
+	} else {
+		m_tapCount = 2;
+		m_index.setLength( outputLength * 2 );
+		m_weight.setLength( outputLength * 2 );
+		for (int x = 0; x < outputLength; x++) {
+			double pos = (x + 0.5) * scale - 0.5;
+			int i = (int) floor( pos );
+			float frac = (float) (pos - i);
+			if (i < 0) {
+				i = 0;
+				frac = 0;
+			}
+			if (i >= inputLength - 1) {
+				i = inputLength - 1;
+				frac = 0;
+			}
+			m_index[ x * 2 ] = i;
+			m_index[ x * 2 + 1 ] = i + 1 < inputLength ? i + 1 : i;
+			m_weight[ x * 2 ] = 1.0f - frac;
+			m_weight[ x * 2 + 1 ] = frac;
+		}
+	}
+}
+
+
+/// blur with a kernel and keep every other position, in one pass
+void FilterTaps::setDecimate( const VectorF &kernel, int length ) {
+	assertAlways( kernel.length() % 2 == 1 && length > 0 );
+
+	// output position x is centered on input position 2 * x
+	m_type = TAPS_RESAMPLE;
+	m_inputLength = length;
+	m_outputLength = (length + 1) / 2;
+	m_tapCount = kernel.length();
+	int radius = m_tapCount / 2;
+	m_index.setLength( m_outputLength * m_tapCount );
+	m_weight.setLength( m_outputLength * m_tapCount );
+	for (int x = 0; x < m_outputLength; x++) {
+		for (int t = 0; t < m_tapCount; t++) {
+			m_index[ x * m_tapCount + t ] = reflect101( 2 * x + t - radius, length );
+			m_weight[ x * m_tapCount + t ] = kernel[ t ];
+		}
+	}
+}
+
+
+/// upsample by a factor of two (inverting setDecimate) using the Burt-Adelson expansion kernel
+void FilterTaps::setExpand( int inputLength, int outputLength ) {
+	assertAlways( outputLength > 0 && inputLength == (outputLength + 1) / 2 );
+
+	// even output positions lie on input positions (weights 6/8 and 1/8 each side); odd positions lie half-way between two
+	// (weights 4/8 each); the center tap comes first, since the filter engine skips later taps with zero weight
+	m_type = TAPS_RESAMPLE;
+	m_inputLength = inputLength;
+	m_outputLength = outputLength;
+	m_tapCount = 3;
+	m_index.setLength( outputLength * 3 );
+	m_weight.setLength( outputLength * 3 );
+	for (int x = 0; x < outputLength; x++) {
+		int i = x / 2;
+		m_index[ x * 3 ] = i;
+		m_index[ x * 3 + 1 ] = reflect101( i + 1, inputLength );
+		m_index[ x * 3 + 2 ] = reflect101( i - 1, inputLength );
+		bool even = (x & 1) == 0;
+		m_weight[ x * 3 ] = even ? 0.75f : 0.5f;
+		m_weight[ x * 3 + 1 ] = even ? 0.125f : 0.5f;
+		m_weight[ x * 3 + 2 ] = even ? 0.125f : 0.0f;
+	}
+}
+
+
+//-------------------------------------------
+// ROW OPERATIONS
+//-------------------------------------------
+
+
+// convert a row of input values to float
+inline void rowToFloat( const float *in, float *out, int count ) {
+	memcpy( out, in, count * sizeof(float) );
+}
+inline void rowToFloat( const unsigned char *in, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128( (const __m128i *) (in + i) );
+		__m128i lo = _mm_unpacklo_epi8( v, zero ), hi = _mm_unpackhi_epi8( v, zero );
+		_mm_storeu_ps( out + i, _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ) );
+		_mm_storeu_ps( out + i + 4, _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ) );
+		_mm_storeu_ps( out + i + 8, _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ) );
+		_mm_storeu_ps( out + i + 12, _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ) );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = (float) in[ i ];
+}
+
+
+// convert a row of float values to output values (rounding to nearest and saturating for 8-bit output)
+inline void rowFromFloat( const float *in, float *out, int count ) {
+	memcpy( out, in, count * sizeof(float) );
+}
+inline void rowFromFloat( const float *in, unsigned char *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 16 <= count; i += 16) {
+		__m128i a = _mm_cvtps_epi32( _mm_loadu_ps( in + i ) ), b = _mm_cvtps_epi32( _mm_loadu_ps( in + i + 4 ) );
+		__m128i c = _mm_cvtps_epi32( _mm_loadu_ps( in + i + 8 ) ), d = _mm_cvtps_epi32( _mm_loadu_ps( in + i + 12 ) );
+		_mm_storeu_si128( (__m128i *) (out + i), _mm_packus_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) ) );
+	}
+	for (; i < count; i++) {
+		int v = _mm_cvtss_si32( _mm_load_ss( in + i ) );
+		out[ i ] = (unsigned char) (v < 0 ? 0 : (v > 255 ? 255 : v));
+	}
+#else
+	for (; i < count; i++)
+		out[ i ] = (unsigned char) bound( round( in[ i ] ), 0, 255 );
+#endif
+}
+
+
+// out[ i ] = factor * in[ i ]
+inline void scaleRow( const float *in, float factor, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 f = _mm_set1_ps( factor );
+	for (; i + 8 <= count; i += 8) {
+		_mm_storeu_ps( out + i, _mm_mul_ps( _mm_loadu_ps( in + i ), f ) );
+		_mm_storeu_ps( out + i + 4, _mm_mul_ps( _mm_loadu_ps( in + i + 4 ), f ) );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] = factor * in[ i ];
+}
+
+
+// out[ i ] += factor * in[ i ]
+inline void addScaledRow( const float *in, float factor, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 f = _mm_set1_ps( factor );
+	for (; i + 8 <= count; i += 8) {
+		_mm_storeu_ps( out + i, _mm_add_ps( _mm_loadu_ps( out + i ), _mm_mul_ps( _mm_loadu_ps( in + i ), f ) ) );
+		_mm_storeu_ps( out + i + 4, _mm_add_ps( _mm_loadu_ps( out + i + 4 ), _mm_mul_ps( _mm_loadu_ps( in + i + 4 ), f ) ) );
+	}
+#endif
+	for (; i < count; i++)
+		out[ i ] += factor * in[ i ];
+}
+
+
+// out[ i ] += add[ i ] - sub[ i ]
+inline void addDifferenceRow( const float *add, const float *sub, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps( out + i, _mm_add_ps( _mm_loadu_ps( out + i ), _mm_sub_ps( _mm_loadu_ps( add + i ), _mm_loadu_ps( sub + i ) ) ) );
+#endif
+	for (; i < count; i++)
+		out[ i ] += add[ i ] - sub[ i ];
+}
+
+
+// out[ i ] = in1[ i ] + in2[ i ]
+inline void addRows( const float *in1, const float *in2, float *out, int count ) {
+	int i = 0;
+#ifdef __SSE2__
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps( out + i, _mm_add_ps( _mm_loadu_ps( in1 + i ), _mm_loadu_ps( in2 + i ) ) );
+#endif
+	for (; i < count; i++)
+		out[ i ] = in1[ i ] + in2[ i ];
+}
+
+
+//-------------------------------------------
+// ROW CACHE
+//-------------------------------------------
+
+
+/// The FloatRowCache class provides float versions of input rows, converting (and caching) them as needed;
+/// float input rows are used directly.
+template <typename T, int CHANNEL_COUNT> class FloatRowCache {
+public:
+
+	// create a cache holding up to rowCount rows
+	FloatRowCache( const ImageView<T, CHANNEL_COUNT> &input, int rowCount )
+			: m_input( input ), m_rowCount( rowCount ), m_rowLength( input.width() * CHANNEL_COUNT ),
+			  m_rows( rowCount * input.width() * CHANNEL_COUNT ), m_rowIndex( rowCount ) {
+		m_rowIndex.clear( -1 );
+	}
+
+	// get a float version of the given input row (valid until rowCount other rows have been requested)
+	const float *row( int y ) {
+		int slot = y % m_rowCount;
+		float *data = m_rows.dataPtr() + slot * m_rowLength;
+		if (m_rowIndex[ slot ] != y) {
+			rowToFloat( m_input.row( y ), data, m_rowLength );
+			m_rowIndex[ slot ] = y;
+		}
+		return data;
+	}
+
+private:
+
+	// the source rows
+	const ImageView<T, CHANNEL_COUNT> &m_input;
+
+	// the cached rows and the input row stored in each slot
+	int m_rowCount;
+	int m_rowLength;
+	VectorF m_rows;
+	VectorI m_rowIndex;
+};
+
+
+/// float rows need no conversion
+template <int CHANNEL_COUNT> class FloatRowCache<float, CHANNEL_COUNT> {
+public:
+	FloatRowCache( const ImageView<float, CHANNEL_COUNT> &input, int rowCount ) : m_input( input ) {}
+	inline const float *row( int y ) { return m_input.row( y ); }
+private:
+	const ImageView<float, CHANNEL_COUNT> &m_input;
+};
+
+
+//-------------------------------------------
+// SEPARABLE FILTER
+//-------------------------------------------
+
+
+/// The SeparableFilterBand class applies a separable filter to a band of output rows, using its own buffers
+/// (so that several bands can be processed at once on different threads).
+template <typename InT, typename OutT, int CHANNEL_COUNT> class SeparableFilterBand {
+public:
+
+	// allocate buffers for filtering the given images
+	SeparableFilterBand( const ImageView<InT, CHANNEL_COUNT> &input, ImageView<OutT, CHANNEL_COUNT> &output, const FilterTaps &xTaps, const FilterTaps &yTaps )
+			: m_input( input ), m_output( output ), m_xTaps( xTaps ), m_yTaps( yTaps ),
+			  m_rows( input, yTaps.m_tapCount + 1 ),
+			  m_columnSum( input.width() * CHANNEL_COUNT ),
+			  m_extended( (xTaps.m_extendedIndex.length() ? xTaps.m_extendedIndex.length() : 1) * CHANNEL_COUNT ),
+			  m_outRow( output.width() * CHANNEL_COUNT ) {}
+
+	// filter output rows [yBegin, yEnd)
+	void run( int yBegin, int yEnd ) {
+		for (int y = yBegin; y < yEnd; y++) {
+			filterColumns( y, y == yBegin );
+			filterRow();
+			rowFromFloat( m_outRow.dataPtr(), m_output.row( y ), m_outRow.length() );
+		}
+	}
+
+private:
+
+	// compute the y-filtered version of input row y (in m_columnSum)
+	void filterColumns( int y, bool first ) {
+		const FilterTaps &taps = m_yTaps;
+		int tapCount = taps.m_tapCount;
+		int length = m_columnSum.length();
+		float *sum = m_columnSum.dataPtr();
+		if (taps.m_type == FilterTaps::TAPS_BOX) {
+
+			// start the running sum, then update it by adding the entering row and removing the leaving row
+			// (note: the sum is of integer values when the input is 8-bit, so it does not drift)
+			if (first) {
+				rowToFloat( m_rows.row( taps.m_extendedIndex[ y ] ), sum, length );
+				for (int t = 1; t < tapCount; t++)
+					addScaledRow( m_rows.row( taps.m_extendedIndex[ y + t ] ), 1.0f, sum, length );
+			} else {
+				addDifferenceRow( m_rows.row( taps.m_extendedIndex[ y + tapCount - 1 ] ), m_rows.row( taps.m_extendedIndex[ y - 1 ] ), sum, length );
+			}
+		} else if (taps.m_type == FilterTaps::TAPS_KERNEL) {
+			const float *kernel = taps.m_kernel.dataPtr();
+			const int *index = taps.m_extendedIndex.dataPtr() + y;
+			int radius = tapCount / 2;
+
+			// combine symmetric taps (e.g. for Gaussian kernels) to halve the multiplies
+			scaleRow( m_rows.row( index[ radius ] ), kernel[ radius ], sum, length );
+			for (int t = 0; t < radius; t++) {
+				int tMirror = tapCount - 1 - t;
+				if (kernel[ t ] == kernel[ tMirror ]) {
+					if (m_pair.length() != length)
+						m_pair.setLength( length );
+					addRows( m_rows.row( index[ t ] ), m_rows.row( index[ tMirror ] ), m_pair.dataPtr(), length );
+					addScaledRow( m_pair.dataPtr(), kernel[ t ], sum, length );
+				} else {
+					addScaledRow( m_rows.row( index[ t ] ), kernel[ t ], sum, length );
+					addScaledRow( m_rows.row( index[ tMirror ] ), kernel[ tMirror ], sum, length );
+				}
+			}
+		} else {
+			const int *index = taps.m_index.dataPtr() + y * tapCount;
+			const float *weight = taps.m_weight.dataPtr() + y * tapCount;
+			scaleRow( m_rows.row( index[ 0 ] ), weight[ 0 ], sum, length );
+			for (int t = 1; t < tapCount; t++)
+				if (weight[ t ])
+					addScaledRow( m_rows.row( index[ t ] ), weight[ t ], sum, length );
+		}
+	}
+
+	// apply the x taps to m_columnSum (storing the result in m_outRow)
+	void filterRow() {
+		const FilterTaps &taps = m_xTaps;
+		int tapCount = taps.m_tapCount;
+		float *out = m_outRow.dataPtr();
+		const float *in = m_columnSum.dataPtr();
+		int outLength = m_outRow.length();
+		float yScale = m_yTaps.m_type == FilterTaps::TAPS_BOX ? m_yTaps.m_kernel[ 0 ] : 1.0f;
+
+		// for kernel and box taps, extend the row at each side by reflecting values
+		if (taps.m_type == FilterTaps::TAPS_KERNEL || taps.m_type == FilterTaps::TAPS_BOX) {
+			int radius = taps.m_tapCount / 2;
+			int width = taps.m_inputLength;
+			float *ext = m_extended.dataPtr();
+			memcpy( ext + radius * CHANNEL_COUNT, in, width * CHANNEL_COUNT * sizeof(float) );
+			for (int i = 0; i < m_xTaps.m_extendedIndex.length(); i++) {
+				if (i == radius)
+					i += width;
+				if (i >= m_xTaps.m_extendedIndex.length())
+					break;
+				int src = m_xTaps.m_extendedIndex[ i ];
+				for (int c = 0; c < CHANNEL_COUNT; c++)
+					ext[ i * CHANNEL_COUNT + c ] = in[ src * CHANNEL_COUNT + c ];
+			}
+
+			// box: running sum along the row (per channel)
+			if (taps.m_type == FilterTaps::TAPS_BOX) {
+				float scale = taps.m_kernel[ 0 ] * yScale;
+				for (int c = 0; c < CHANNEL_COUNT; c++) {
+					double sum = 0;
+					for (int t = 0; t < tapCount; t++)
+						sum += ext[ t * CHANNEL_COUNT + c ];
+					for (int x = 0; x < width; x++) {
+						out[ x * CHANNEL_COUNT + c ] = (float) sum * scale;
+						sum += ext[ (x + tapCount) * CHANNEL_COUNT + c ] - ext[ x * CHANNEL_COUNT + c ];
+					}
+				}
+
+			// kernel: weighted sum of shifted copies of the extended row (vectorized along the row)
+			} else {
+				const float *kernel = taps.m_kernel.dataPtr();
+				scaleRow( ext, kernel[ 0 ] * yScale, out, outLength );
+				for (int t = 1; t < tapCount; t++)
+					if (kernel[ t ])
+						addScaledRow( ext + t * CHANNEL_COUNT, kernel[ t ] * yScale, out, outLength );
+			}
+
+		// resampling: gather the contributing values for each output position
+		} else {
+			const int *index = taps.m_index.dataPtr();
+			const float *weight = taps.m_weight.dataPtr();
+
+			// (bilinear interpolation is common enough to have its own loop)
+			if (tapCount == 2) {
+				for (int x = 0; x < taps.m_outputLength; x++, index += 2, weight += 2) {
+					const float *in0 = in + index[ 0 ] * CHANNEL_COUNT, *in1 = in + index[ 1 ] * CHANNEL_COUNT;
+					float w0 = weight[ 0 ] * yScale, w1 = weight[ 1 ] * yScale;
+					for (int c = 0; c < CHANNEL_COUNT; c++)
+						out[ x * CHANNEL_COUNT + c ] = w0 * in0[ c ] + w1 * in1[ c ];
+				}
+				return;
+			}
+			for (int x = 0; x < taps.m_outputLength; x++) {
+				for (int c = 0; c < CHANNEL_COUNT; c++) {
+					float sum = 0;
+					for (int t = 0; t < tapCount; t++)
+						sum += weight[ t ] * in[ index[ t ] * CHANNEL_COUNT + c ];
+					out[ x * CHANNEL_COUNT + c ] = sum * yScale;
+				}
+				index += tapCount;
+				weight += tapCount;
+			}
+		}
+	}
+
+	// the images and filter
+	const ImageView<InT, CHANNEL_COUNT> &m_input;
+	ImageView<OutT, CHANNEL_COUNT> &m_output;
+	const FilterTaps &m_xTaps;
+	const FilterTaps &m_yTaps;
+
+	// buffers
+	FloatRowCache<InT, CHANNEL_COUNT> m_rows;
+	VectorF m_columnSum;
+	VectorF m_extended;
+	VectorF m_outRow;
+	VectorF m_pair;
+};
+
+
+/// apply a separable filter: the y taps are applied to the input rows, then the x taps to the result
+template <typename InT, typename OutT, int CHANNEL_COUNT> void separableFilter( const ImageView<InT, CHANNEL_COUNT> &input, ImageView<OutT, CHANNEL_COUNT> output,
+																				const FilterTaps &xTaps, const FilterTaps &yTaps ) {
+	assertAlways( xTaps.inputLength() == input.width() && yTaps.inputLength() == input.height() );
+	assertAlways( xTaps.outputLength() == output.width() && yTaps.outputLength() == output.height() );
+
+	// use bands large enough that the rows needed to start a band are a small part of its work
+	int grain = max( 16, 2 * yTaps.tapCount() );
+	parallelFor( 0, output.height(), grain, [&]( int yBegin, int yEnd ) {
+		SeparableFilterBand<InT, OutT, CHANNEL_COUNT> band( input, output, xTaps, yTaps );
+		band.run( yBegin, yEnd );
+	} );
+}
+template void separableFilter( const ImageView<unsigned char, 1> &input, ImageView<unsigned char, 1> output, const FilterTaps &xTaps, const FilterTaps &yTaps );
+template void separableFilter( const ImageView<unsigned char, 3> &input, ImageView<unsigned char, 3> output, const FilterTaps &xTaps, const FilterTaps &yTaps );
+template void separableFilter( const ImageView<unsigned char, 1> &input, ImageView<float, 1> output, const FilterTaps &xTaps, const FilterTaps &yTaps );
+template void separableFilter( const ImageView<unsigned char, 3> &input, ImageView<float, 3> output, const FilterTaps &xTaps, const FilterTaps &yTaps );
+template void separableFilter( const ImageView<float, 1> &input, ImageView<float, 1> output, const FilterTaps &xTaps, const FilterTaps &yTaps );
+template void separableFilter( const ImageView<float, 3> &input, ImageView<float, 3> output, const FilterTaps &xTaps, const FilterTaps &yTaps );
+
+
+//-------------------------------------------
+// KERNELS
+//-------------------------------------------
+
+
+/// create a normalized Gaussian kernel; if size is zero, the size is computed from sigma
+VectorF gaussianKernel( float sigma, int size, bool forFloatImage ) {
+	assertAlways( sigma > 0 );
+	if (size <= 0)
+		size = (round( sigma * (forFloatImage ? 4.0f : 3.0f) * 2.0f + 1.0f ) | 1);
+	assertAlways( size % 2 == 1 );
+	VectorF kernel( size );
+	int radius = size / 2;
+	double sum = 0;
+	for (int i = 0; i < size; i++) {
+		double d = i - radius;
+		double v = exp( -d * d / (2.0 * sigma * sigma) );
+		kernel[ i ] = (float) v;
+		sum += v;
+	}
+	for (int i = 0; i < size; i++)
+		kernel[ i ] = (float) (kernel[ i ] / sum);
+	return kernel;
+}
+
+
+/// create the derivative and smoothing kernels of a Sobel filter with the given aperture size
+void sobelKernels( int apertureSize, VectorF &derivKernel, VectorF &smoothKernel ) {
+	assertAlways( apertureSize == 1 || apertureSize == 3 || apertureSize == 5 || apertureSize == 7 );
+
+	// smoothing: binomial coefficients (none for aperture size 1)
+	int smoothSize = apertureSize == 1 ? 1 : apertureSize;
+	smoothKernel.setLength( smoothSize );
+	for (int i = 0; i < smoothSize; i++) {
+		double c = 1;
+		for (int j = 0; j < i; j++)
+			c = c * (smoothSize - 1 - j) / (j + 1);
+		smoothKernel[ i ] = (float) c;
+	}
+
+	// derivative: central difference convolved with binomial coefficients of size apertureSize - 2
+	int derivSize = apertureSize == 1 ? 3 : apertureSize;
+	derivKernel.setLength( derivSize );
+	derivKernel.clear( 0 );
+	int binomialSize = derivSize - 2;
+	for (int i = 0; i < binomialSize; i++) {
+		double c = 1;
+		for (int j = 0; j < i; j++)
+			c = c * (binomialSize - 1 - j) / (j + 1);
+		derivKernel[ i ] -= (float) c;
+		derivKernel[ i + 2 ] += (float) c;
+	}
+}
+
+
+} // end namespace sbl
@@ -1,15 +1,730 @@
 #include <sbl/image/Video.h>
 #include <sbl/core/StringUtil.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
 #include <sbl/math/MathUtil.h>
 #include <sbl/system/FileSystem.h>
+#include <sbl/system/Timer.h>
 #include <sbl/image/ImageUtil.h>
 #include <sbl/image/ImageTransform.h>
-#ifdef USE_OPENCV3
-	#include <opencv/highgui.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#ifdef USE_OPENCV
+	#include <opencv2/videoio.hpp>
 #endif
 namespace sbl {
 
 
+//-------------------------------------------
+// VIDEO FRAME SOURCES
+//-------------------------------------------
+
+
+/// The VideoFrameSource class is the interface used by VideoFrameReader to decode frames (sequentially, with occasional seeks).
+/// Sources that can decode any frame independently (e.g. image files) can also provide random access, which allows
+/// several frames to be decoded at once.
+class VideoFrameSource {
+public:
+
+	// basic destructor
+	virtual ~VideoFrameSource() {}
+
+	/// decode the frame at the current position and advance to the next frame; the image may hold a buffer
+	/// (of any size) to decode into, which the source may use or replace; returns false if unable to decode the frame
+	virtual bool read( aptr<ImageColorU> &image ) = 0;
+
+	/// advance to the next frame without converting it to an image
+	virtual bool skip() = 0;
+
+	/// move to the given frame index
+	virtual bool seek( int frameIndex ) = 0;
+
+	/// true if the source provides readFrame
+	virtual bool randomAccess() const { return false; }
+
+	/// decode the given frame (as with read); may be called from several threads at once
+	virtual bool readFrame( int frameIndex, aptr<ImageColorU> &image ) { return false; }
+};
+
+
+/// The ImageListFrameSource class reads frames from a list of image files.
+class ImageListFrameSource : public VideoFrameSource {
+public:
+
+	// create a source for the given files
+	ImageListFrameSource( const String &imagePath, const Array<String> &imageList ) : m_imagePath( imagePath ), m_imageList( imageList ), m_position( 0 ) {}
+
+	// load the image at the current position
+	bool read( aptr<ImageColorU> &image ) { return readFrame( m_position++, image ); }
+
+	// skip an image (no decoding needed)
+	bool skip() { m_position++; return true; }
+
+	// move to the given image (no decoding needed)
+	bool seek( int frameIndex ) { m_position = frameIndex; return true; }
+
+	// each image can be loaded independently
+	bool randomAccess() const { return true; }
+
+	// load the given image (the image list isn't modified, so this can be called from several threads)
+	bool readFrame( int frameIndex, aptr<ImageColorU> &image ) {
+		if (frameIndex < 0 || frameIndex >= m_imageList.count())
+			return false;
+		image = load<ImageColorU>( m_imagePath + m_imageList[ frameIndex ] );
+		return image.get() != NULL;
+	}
+
+private:
+
+	// the image files and the index of the next file to load
+	String m_imagePath;
+	Array<String> m_imageList;
+	int m_position;
+};
+
+
+#ifdef USE_OPENCV
+
+
+/// The CaptureFrameSource class reads frames from a video file using an OpenCV video capture object.
+class CaptureFrameSource : public VideoFrameSource {
+public:
+
+	// open the video file
+	explicit CaptureFrameSource( const String &fileName ) : m_fileName( fileName ), m_capture( fileName.c_str() ) {}
+
+	// returns true if the video was opened
+	bool isOpened() const { return m_capture.isOpened(); }
+
+	// the properties of the video (as reported by the file; may be zero)
+	int frameCount() const { return (int) round( m_capture.get( cv::CAP_PROP_FRAME_COUNT ) ); }
+	int frameWidth() const { return (int) round( m_capture.get( cv::CAP_PROP_FRAME_WIDTH ) ); }
+	int frameHeight() const { return (int) round( m_capture.get( cv::CAP_PROP_FRAME_HEIGHT ) ); }
+
+	// count the frames by decoding through the whole video, then reopen it at the first frame
+	// (for files that don't report their length)
+	int countFrames() {
+		int count = 0;
+		while (m_capture.grab())
+			count++;
+		m_capture.release();
+		m_capture.open( m_fileName.c_str() );
+		return count;
+	}
+
+	// decode the frame at the current position, into the given buffer if it has the right size
+	bool read( aptr<ImageColorU> &image ) {
+		if (m_capture.grab() == false)
+			return false;
+		cv::Mat mat;
+		if (image.get())
+			mat = image->cvMat(); // shares the buffer; retrieve() writes into it if the size and type match
+		if (m_capture.retrieve( mat ) == false || mat.empty() || mat.type() != CV_8UC3)
+			return false;
+
+		// if the capture object didn't decode into our buffer, copy the frame (the capture object may reuse its own buffer)
+		if (image.get() == NULL || mat.data != (uchar *) image->raw()) {
+			ImageColorU wrapper( mat );
+			image.reset( new ImageColorU( wrapper ) );
+		}
+		return true;
+	}
+
+	// advance without retrieving the frame
+	bool skip() { return m_capture.grab(); }
+
+	// move to the given frame
+	bool seek( int frameIndex ) { return m_capture.set( cv::CAP_PROP_POS_FRAMES, frameIndex ); }
+
+private:
+
+	// the video file and the OpenCV video object
+	String m_fileName;
+	cv::VideoCapture m_capture;
+};
+
+
+#endif // USE_OPENCV
+
+
+//-------------------------------------------
+// VIDEO FRAME READER
+//-------------------------------------------
+
+
+// the number of frames the reader will decode and discard rather than seeking forward
+#define VIDEO_SKIP_LIMIT 32
+
+
+/// The VideoFrame class holds a decoded frame (and its grayscale version, if requested).
+class VideoFrame {
+public:
+	VideoFrame( int frameIndex ) : index( frameIndex ) {}
+	int index;
+	aptr<ImageColorU> color;
+	aptr<ImageGrayU> gray;
+};
+
+
+/// The VideoFrameReader class decodes frames from a VideoFrameSource on a background thread.  After each request
+/// for frame i, the thread decodes frames i + step, i + 2 * step, ... (up to aheadCount frames), where step is the
+/// difference between the last two requests (if small and positive; otherwise 1).  The most recently used frames
+/// are kept (up to recentCount frames) for requests that step backward.  Decoded images are reused as decoding buffers.
+/// For random-access sources, several threads decode frames at once (each frame is stored by index, so the order in which
+/// the threads finish doesn't matter); the number of frames decoded ahead is also limited by a memory size.
+class VideoFrameReader {
+public:
+
+	// create a reader for the given source (takes ownership)
+	VideoFrameReader( VideoFrameSource *source, int length, int aheadCount = 8, int recentCount = 8 );
+
+	// stop the background thread
+	~VideoFrameReader();
+
+	// set the number of frames to decode ahead of each request, the number of decoding threads (used only for random-access
+	// sources; 0 for the number of threads used by parallel loops), and the maximum bytes of frames decoded ahead;
+	// the thread count only takes effect if set before the first request
+	void setReadAhead( int aheadCount, int threadCount, int maxBytes );
+
+	// get a copy of the given frame (or NULL if it could not be decoded)
+	aptr<ImageColorU> frame( int frameIndex );
+	aptr<ImageGrayU> frameGray( int frameIndex );
+
+	// statistics
+	inline int hitCount() const { return m_hitCount; }
+	inline int missCount() const { return m_missCount; }
+	inline int seekCount() const { return m_seekCount; }
+	inline int decodeCount() const { return m_decodeCount; }
+	inline float waitTime() const { return (float) m_waitTime; }
+
+private:
+
+	// find the decoded frame and move it to the end of the recent frame list, waiting for the background thread if needed
+	VideoFrame *useFrame( int frameIndex, std::unique_lock<std::mutex> &lock );
+
+	// the position of a frame in the given list, or -1 if not found
+	int findFrame( const PtrArray<VideoFrame> &frames, int frameIndex ) const;
+
+	// true if the frame is one that the background threads should decode for the current request
+	bool isTarget( int frameIndex ) const;
+
+	// the number of frames to decode ahead (limited by the memory size)
+	int aheadCount() const;
+
+	// delete a frame, keeping its image as a decoding buffer if there is room in the pool
+	void releaseFrame( VideoFrame *frame );
+
+	// the background thread loop: decode the next target frame that isn't available or being decoded
+	void threadMain();
+
+	// the frame source and the number of frames
+	aptr<VideoFrameSource> m_source;
+	int m_length;
+
+	// decoded frames that have not been used (in decoding order), recently used frames (oldest first), and decoding buffers
+	PtrArray<VideoFrame> m_ready;
+	PtrArray<VideoFrame> m_recent;
+	PtrArray<ImageColorU> m_pool;
+	int m_aheadCount;
+	int m_recentCount;
+
+	// frames being decoded, the bytes used by each decoded frame (0 until known), and the limit on bytes of frames decoded ahead
+	VectorI m_decoding;
+	int m_frameBytes;
+	int m_maxBytes;
+
+	// the most recently requested frame and the predicted step to the next request
+	int m_requestIndex;
+	int m_step;
+
+	// true if the background thread should also create grayscale frames
+	bool m_grayWanted;
+
+	// the frame the source will decode next (used only by the background thread; -1 if unknown)
+	int m_sourceIndex;
+
+	// statistics
+	int m_hitCount;
+	int m_missCount;
+	int m_seekCount;
+	int m_decodeCount;
+	double m_waitTime;
+
+	// the background threads and the state used to communicate with them
+	Array<std::thread> m_threads;
+	int m_threadCount;
+	std::mutex m_mutex;
+	std::condition_variable m_threadWake;
+	std::condition_variable m_threadDone;
+	bool m_stopThread;
+
+	// disable copy constructor and assignment operator
+	VideoFrameReader( const VideoFrameReader &x );
+	VideoFrameReader &operator=( const VideoFrameReader &x );
+};
+
+
+// create a reader for the given source (takes ownership)
+VideoFrameReader::VideoFrameReader( VideoFrameSource *source, int length, int aheadCount, int recentCount ) : m_source( source ) {
+	m_length = length;
+	m_aheadCount = aheadCount > 1 ? aheadCount : 1;
+	m_recentCount = recentCount > 1 ? recentCount : 1;
+	m_frameBytes = 0;
+	m_maxBytes = 512 * 1024 * 1024;
+	m_threadCount = 1;
+	m_requestIndex = -1;
+	m_step = 1;
+	m_grayWanted = false;
+	m_sourceIndex = 0;
+	m_hitCount = 0;
+	m_missCount = 0;
+	m_seekCount = 0;
+	m_decodeCount = 0;
+	m_waitTime = 0;
+	m_stopThread = false;
+}
+
+
+// stop the background thread
+VideoFrameReader::~VideoFrameReader() {
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_stopThread = true;
+	}
+	m_threadWake.notify_all();
+	for (int i = 0; i < m_threads.count(); i++)
+		m_threads[ i ].join();
+	for (int i = 0; i < m_ready.count(); i++)
+		delete &m_ready[ i ];
+	for (int i = 0; i < m_recent.count(); i++)
+		delete &m_recent[ i ];
+	for (int i = 0; i < m_pool.count(); i++)
+		delete &m_pool[ i ];
+}
+
+
+// set the number of frames to decode ahead of each request, the number of decoding threads (used only for random-access
+// sources; 0 for the number of threads used by parallel loops), and the maximum bytes of frames decoded ahead;
+// the thread count only takes effect if set before the first request
+void VideoFrameReader::setReadAhead( int aheadCount, int threadCount, int maxBytes ) {
+	std::lock_guard<std::mutex> lock( m_mutex );
+	m_aheadCount = aheadCount > 1 ? aheadCount : 1;
+	m_threadCount = threadCount > 0 ? threadCount : sbl::threadCount();
+	m_maxBytes = maxBytes;
+}
+
+
+// get a copy of the given frame (or NULL if it could not be decoded)
+aptr<ImageColorU> VideoFrameReader::frame( int frameIndex ) {
+	std::unique_lock<std::mutex> lock( m_mutex );
+	VideoFrame *frame = useFrame( frameIndex, lock );
+	aptr<ImageColorU> image;
+	if (frame->color.get())
+		image.reset( new ImageColorU( *frame->color ) );
+	return image;
+}
+
+
+// get a copy of the given frame (or NULL if it could not be decoded), converted to grayscale
+aptr<ImageGrayU> VideoFrameReader::frameGray( int frameIndex ) {
+	std::unique_lock<std::mutex> lock( m_mutex );
+	m_grayWanted = true;
+	VideoFrame *frame = useFrame( frameIndex, lock );
+	if (frame->gray.get() == NULL && frame->color.get())
+		frame->gray = toGray( *frame->color );
+	aptr<ImageGrayU> image;
+	if (frame->gray.get())
+		image.reset( new ImageGrayU( *frame->gray ) );
+	return image;
+}
+
+
+// find the decoded frame and move it to the end of the recent frame list, waiting for the background thread if needed
+VideoFrame *VideoFrameReader::useFrame( int frameIndex, std::unique_lock<std::mutex> &lock ) {
+	assertAlways( frameIndex >= 0 && frameIndex < m_length );
+
+	// predict the next request
+	if (m_requestIndex >= 0 && frameIndex != m_requestIndex) {
+		int step = frameIndex - m_requestIndex;
+		m_step = step > 0 && step <= VIDEO_SKIP_LIMIT ? step : 1;
+	}
+	m_requestIndex = frameIndex;
+
+	// discard decoded frames that are no longer needed, then let the thread decode the frames following this one
+	for (int i = m_ready.count() - 1; i >= 0; i--) {
+		if (m_ready[ i ].index != frameIndex && isTarget( m_ready[ i ].index ) == false) {
+			releaseFrame( &m_ready[ i ] );
+			m_ready.remove( i );
+		}
+	}
+	if (m_threads.count() == 0) {
+		int threadCount = m_source->randomAccess() ? m_threadCount : 1;
+		for (int i = 0; i < threadCount; i++)
+			m_threads.append( new std::thread( &VideoFrameReader::threadMain, this ) );
+	}
+	m_threadWake.notify_all();
+
+	// if recently used, move to the end of the recent list
+	int position = findFrame( m_recent, frameIndex );
+	if (position >= 0) {
+		VideoFrame *frame = &m_recent[ position ];
+		m_recent.remove( position );
+		m_recent.append( frame );
+		m_hitCount++;
+		return frame;
+	}
+
+	// wait for the frame to be decoded
+	position = findFrame( m_ready, frameIndex );
+	if (position >= 0) {
+		m_hitCount++;
+	} else {
+		m_missCount++;
+		Timer timer( true );
+		while (position < 0) {
+			m_threadDone.wait( lock );
+			position = findFrame( m_ready, frameIndex );
+		}
+		m_waitTime += timer.timeSum();
+	}
+
+	// move from the ready list to the recent list
+	VideoFrame *frame = &m_ready[ position ];
+	m_ready.remove( position );
+	m_recent.append( frame );
+	if (m_recent.count() > m_recentCount) {
+		releaseFrame( &m_recent[ 0 ] );
+		m_recent.remove( 0 );
+	}
+	return frame;
+}
+
+
+// the position of a frame in the given list, or -1 if not found
+int VideoFrameReader::findFrame( const PtrArray<VideoFrame> &frames, int frameIndex ) const {
+	for (int i = 0; i < frames.count(); i++)
+		if (frames[ i ].index == frameIndex)
+			return i;
+	return -1;
+}
+
+
+// true if the frame is one that the background threads should decode for the current request
+bool VideoFrameReader::isTarget( int frameIndex ) const {
+	int offset = frameIndex - m_requestIndex;
+	return m_requestIndex >= 0 && frameIndex < m_length && offset >= 0 && offset % m_step == 0 && offset / m_step < aheadCount();
+}
+
+
+// the number of frames to decode ahead (limited by the memory size)
+int VideoFrameReader::aheadCount() const {
+	int aheadCount = m_aheadCount;
+	if (m_frameBytes && aheadCount > m_maxBytes / m_frameBytes)
+		aheadCount = m_maxBytes / m_frameBytes;
+	return aheadCount > 1 ? aheadCount : 1;
+}
+
+
+// delete a frame, keeping its image as a decoding buffer if there is room in the pool
+void VideoFrameReader::releaseFrame( VideoFrame *frame ) {
+	if (frame->color.get() && m_pool.count() < aheadCount())
+		m_pool.append( frame->color.release() );
+	delete frame;
+}
+
+
+// the background thread loop: decode the next target frame that isn't available or being decoded
+void VideoFrameReader::threadMain() {
+	markWorkerThread();
+	std::unique_lock<std::mutex> lock( m_mutex );
+	bool randomAccess = m_source->randomAccess();
+	while (m_stopThread == false) {
+
+		// find the first target frame that isn't available
+		int target = -1, aheadCount = this->aheadCount();
+		for (int i = 0; i < aheadCount && target < 0; i++) {
+			int frameIndex = m_requestIndex + i * m_step;
+			if (m_requestIndex < 0 || frameIndex >= m_length)
+				break;
+			if (findFrame( m_ready, frameIndex ) < 0 && findFrame( m_recent, frameIndex ) < 0 && m_decoding.contains( frameIndex ) == false)
+				target = frameIndex;
+		}
+		if (target < 0) {
+			m_threadWake.wait( lock );
+			continue;
+		}
+		aptr<ImageColorU> image;
+		if (m_pool.count()) {
+			image.reset( &m_pool[ m_pool.count() - 1 ] );
+			m_pool.remove( m_pool.count() - 1 );
+		}
+		bool gray = m_grayWanted;
+		m_decoding.append( target );
+		lock.unlock();
+
+		// decode the frame directly if the source allows it; otherwise decode forward to the frame if it is close enough or seek
+		bool seek = false, success = false;
+		if (randomAccess) {
+			success = m_source->readFrame( target, image );
+		} else {
+			if (target < m_sourceIndex || m_sourceIndex < 0 || target - m_sourceIndex > VIDEO_SKIP_LIMIT) {
+				m_source->seek( target );
+				m_sourceIndex = target;
+				seek = true;
+			}
+			while (m_sourceIndex < target) {
+				m_source->skip();
+				m_sourceIndex++;
+			}
+			success = m_source->read( image );
+			m_sourceIndex = success ? m_sourceIndex + 1 : -1;
+		}
+		VideoFrame *frame = new VideoFrame( target );
+		if (success) {
+			frame->color = image;
+			if (gray)
+				frame->gray = toGray( *frame->color );
+		}
+		lock.lock();
+
+		// keep the frame if it is still needed; a frame that could not be decoded is kept (without an image) so that requests for it return
+		VectorI decoding;
+		for (int i = 0; i < m_decoding.length(); i++)
+			if (m_decoding[ i ] != target)
+				decoding.append( m_decoding[ i ] );
+		m_decoding = decoding;
+		m_decodeCount++;
+		if (seek)
+			m_seekCount++;
+		if (success && m_frameBytes == 0)
+			m_frameBytes = frame->color->memUsed() + (frame->gray.get() ? frame->gray->memUsed() : 0);
+		if (isTarget( target ) && findFrame( m_ready, target ) < 0 && findFrame( m_recent, target ) < 0)
+			m_ready.append( frame );
+		else
+			releaseFrame( frame );
+		m_threadDone.notify_all();
+	}
+}
+
+
+//-------------------------------------------
+// VIDEO FRAME WRITER
+//-------------------------------------------
+
+
+/// The VideoFrameSink class is the interface used by VideoFrameWriter to encode frames.
+class VideoFrameSink {
+public:
+
+	// basic destructor
+	virtual ~VideoFrameSink() {}
+
+	/// encode a frame; returns false if unable to write the frame
+	virtual bool write( const ImageColorU &image ) = 0;
+
+	/// finish writing the video; returns false if unable to complete the file
+	virtual bool close() { return true; }
+};
+
+
+#ifdef USE_OPENCV
+
+
+/// The WriterFrameSink class writes frames to a video file using an OpenCV video writer object.
+class WriterFrameSink : public VideoFrameSink {
+public:
+
+	// open the video file; .avi files use HuffYUV (lossless) encoding
+	WriterFrameSink( const String &fileName, int width, int height, double fps ) {
+		int fourcc = fileName.endsWith( ".avi" ) ? cv::VideoWriter::fourcc( 'H', 'F', 'Y', 'U' ) : cv::VideoWriter::fourcc( 'm', 'p', '4', 'v' );
+		m_writer.open( fileName.c_str(), fourcc, fps, cv::Size( width, height ), true );
+	}
+
+	// returns true if the video was opened
+	bool isOpened() const { return m_writer.isOpened(); }
+
+	// encode a frame (the writer doesn't report encoding errors, so this fails only if the file isn't open)
+	bool write( const ImageColorU &image ) {
+		if (m_writer.isOpened() == false)
+			return false;
+		m_writer.write( image.cvMat() );
+		return true;
+	}
+
+	// finish writing the video
+	bool close() {
+		bool opened = m_writer.isOpened();
+		m_writer.release();
+		return opened;
+	}
+
+private:
+
+	// the OpenCV video object
+	cv::VideoWriter m_writer;
+};
+
+
+#endif // USE_OPENCV
+
+
+/// The VideoFrameWriter class encodes frames using a VideoFrameSink on a background thread.  Frames are added to a queue
+/// (without copying); append waits if the queue holds queueLength frames.  Grayscale frames are converted to color by
+/// the background thread.
+class VideoFrameWriter {
+public:
+
+	// create a writer for the given sink (takes ownership) and start the background thread
+	VideoFrameWriter( VideoFrameSink *sink, int queueLength );
+
+	// finish writing (if not already closed)
+	~VideoFrameWriter();
+
+	// add a frame to the queue (taking ownership of the frame), waiting if the queue is full
+	void append( VideoFrame *frame );
+
+	// wait for the queued frames to be encoded, stop the background thread, and close the sink; returns false if 
+	// any frames could not be written or the sink could not be closed
+	bool close();
+
+	// the number of frames in the queue (not including a frame being encoded)
+	int queueCount();
+
+	// true if close has been called
+	inline bool closed() const { return m_closed; }
+
+	// statistics
+	inline int frameCount() const { return m_frameCount; }
+	inline int failCount() const { return m_failCount; }
+	inline float waitTime() const { return (float) m_waitTime; }
+
+private:
+
+	// the background thread loop: encode queued frames until stopped and the queue is empty
+	void threadMain();
+
+	// the frame sink
+	aptr<VideoFrameSink> m_sink;
+
+	// frames waiting to be encoded (oldest first) and the maximum number of waiting frames
+	PtrArray<VideoFrame> m_queue;
+	int m_queueLength;
+
+	// the result of closing the writer (once closed)
+	bool m_closed;
+	bool m_closeSuccess;
+
+	// statistics
+	int m_frameCount;
+	int m_failCount;
+	double m_waitTime;
+
+	// the background thread and the state used to communicate with it
+	aptr<std::thread> m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_threadWake;
+	std::condition_variable m_threadDone;
+	bool m_stopThread;
+
+	// disable copy constructor and assignment operator
+	VideoFrameWriter( const VideoFrameWriter &x );
+	VideoFrameWriter &operator=( const VideoFrameWriter &x );
+};
+
+
+// create a writer for the given sink (takes ownership) and start the background thread
+VideoFrameWriter::VideoFrameWriter( VideoFrameSink *sink, int queueLength ) : m_sink( sink ) {
+	m_queueLength = queueLength > 1 ? queueLength : 1;
+	m_closed = false;
+	m_closeSuccess = false;
+	m_frameCount = 0;
+	m_failCount = 0;
+	m_waitTime = 0;
+	m_stopThread = false;
+	m_thread.reset( new std::thread( &VideoFrameWriter::threadMain, this ) );
+}
+
+
+// finish writing (if not already closed)
+VideoFrameWriter::~VideoFrameWriter() {
+	close();
+}
+
+
+// add a frame to the queue (taking ownership of the frame), waiting if the queue is full
+void VideoFrameWriter::append( VideoFrame *frame ) {
+	std::unique_lock<std::mutex> lock( m_mutex );
+	assertAlways( m_closed == false );
+	if (m_queue.count() >= m_queueLength) {
+		Timer timer( true );
+		while (m_queue.count() >= m_queueLength)
+			m_threadDone.wait( lock );
+		m_waitTime += timer.timeSum();
+	}
+	m_queue.append( frame );
+	m_threadWake.notify_one();
+}
+
+
+// wait for the queued frames to be encoded, stop the background thread, and close the sink; returns false if 
+// any frames could not be written or the sink could not be closed
+bool VideoFrameWriter::close() {
+	if (m_closed)
+		return m_closeSuccess;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_stopThread = true;
+		m_closed = true;
+	}
+	m_threadWake.notify_one();
+	m_thread->join();
+	m_closeSuccess = m_sink->close() && m_failCount == 0;
+	return m_closeSuccess;
+}
+
+
+// the number of frames in the queue (not including a frame being encoded)
+int VideoFrameWriter::queueCount() {
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_queue.count();
+}
+
+
+// the background thread loop: encode queued frames until stopped and the queue is empty
+void VideoFrameWriter::threadMain() {
+	markWorkerThread();
+	std::unique_lock<std::mutex> lock( m_mutex );
+	while (true) {
+		if (m_queue.count() == 0) {
+			if (m_stopThread)
+				break;
+			m_threadWake.wait( lock );
+			continue;
+		}
+
+		// take the oldest frame, making room in the queue
+		VideoFrame *frame = &m_queue[ 0 ];
+		m_queue.remove( 0 );
+		m_threadDone.notify_all();
+		lock.unlock();
+
+		// convert and encode the frame
+		if (frame->color.get() == NULL)
+			frame->color = toColor( *frame->gray );
+		bool success = m_sink->write( *frame->color );
+		delete frame;
+		lock.lock();
+		if (success)
+			m_frameCount++;
+		else
+			m_failCount++;
+	}
+}
+
+
 //-------------------------------------------
 // INPUT VIDEO CLASS
 //-------------------------------------------
@@ -17,7 +732,7 @@ namespace sbl {
 
 /// open a video file
 InputVideo::InputVideo( const String &fileName ) {
-	m_cvCapture = NULL;
+	m_reader = NULL;
 	m_width = 0;
 	m_height = 0;
 	m_length = 0;
@@ -28,6 +743,12 @@ InputVideo::InputVideo( const String &fileName ) {
 
 /// open a video file
 void InputVideo::open( const String &fileName ) {
+	delete m_reader;
+	m_reader = NULL;
+	m_imageList.reset();
+	m_width = 0;
+	m_height = 0;
+	m_length = 0;
 	if (fileName.contains( '*' )) { 
 		m_imagePath = fileName.leftOfLast( '/' ) + "/"; 
 		String filePattern = fileName.rightOfLast( '/' );
@@ -40,19 +761,36 @@ void InputVideo::open( const String &fileName ) {
 		m_imageList = loadStrings( fileName, false );
 		disp( 1, "image list file count: %d, path: %s", m_imageList.count(), m_imagePath.c_str() );
 	} else {
-#ifdef USE_OPENCV3
-		m_cvCapture = cvCreateFileCapture( fileName.c_str() );
+#ifdef USE_OPENCV
+		CaptureFrameSource *source = new CaptureFrameSource( fileName );
+		if (source->isOpened()) {
+			m_length = source->frameCount();
+			if (m_length <= 0) {
+				disp( 1, "video length not available; counting frames: %s", fileName.c_str() );
+				m_length = source->countFrames();
+			}
+		}
+		if (source->isOpened() && m_length > 0) {
+			m_width = source->frameWidth();
+			m_height = source->frameHeight();
+			m_reader = new VideoFrameReader( source, m_length );
+		} else {
+			m_length = 0;
+			delete source;
+		}
 #endif
 	}
+	if (m_imageList.count()) {
+		m_length = m_imageList.count();
+		m_reader = new VideoFrameReader( new ImageListFrameSource( m_imagePath, m_imageList ), m_length );
+		m_reader->setReadAhead( 16, 0, 512 * 1024 * 1024 );
+	}
 }
 
 
 /// close the video file
 InputVideo::~InputVideo() {
-#ifdef USE_OPENCV3
-	if (m_cvCapture)
-		cvReleaseCapture( &m_cvCapture );
-#endif
+	delete m_reader;
 }
 
 
@@ -60,76 +798,68 @@ InputVideo::~InputVideo() {
 aptr<ImageColorU> InputVideo::frame( int frameIndex ) {
 	if (frameIndex < 0 || frameIndex >= length())
 		fatalError( "invalid input frame: %d, video length: %d", frameIndex, length() );
-	aptr<ImageColorU> img;
-
-	// get frame from OpenCV
-	if (m_cvCapture) {
-#ifdef USE_OPENCV3
-		cvSetCaptureProperty( m_cvCapture, CV_CAP_PROP_POS_FRAMES, frameIndex );
-		/*  TODO: upgrade to C++ OpenCV functions
-		IplImage *iplImg = cvQueryFrame( m_cvCapture );
-		if (iplImg) {
-			ImageColorU imgMustCopy( iplImg, false ); // need to copy this image, because it contains reference to iplImage which we do not own
-			img = flipVert( imgMustCopy );
-		}
-		*/
-#endif
-
-	// image file
-	} else if (m_imageList.count()) {
-		img = load<ImageColorU>( m_imagePath + m_imageList[ frameIndex ] );
-	}
-	return img;
+	return m_reader->frame( frameIndex );
 }
 
 
-/// retrieve frame by frame index, as grayscale image
+/// retrieve frame by frame index, as grayscale image (converted by the background thread)
 aptr<ImageGrayU> InputVideo::frameGray( int frameIndex ) {
-	return toGray( *frame( frameIndex ) );
+	if (frameIndex < 0 || frameIndex >= length())
+		fatalError( "invalid input frame: %d, video length: %d", frameIndex, length() );
+	return m_reader->frameGray( frameIndex );
+}
+
+
+/// set the number of frames to decode ahead of each request (at most maxMegabytes of frames) and, for image sequences,
+/// the number of images to load at once (0 for the number of threads used by parallel loops); call before requesting frames
+void InputVideo::setReadAhead( int frameCount, int threadCount, int maxMegabytes ) {
+	if (m_reader)
+		m_reader->setReadAhead( frameCount, threadCount, maxMegabytes * 1024 * 1024 );
 }
 
 
 /// the number of frames
 int InputVideo::length() { 
-	if (m_length == 0) {
-		if (m_cvCapture) {
-#ifdef USE_OPENCV3
-			m_length = round( cvGetCaptureProperty( m_cvCapture, CV_CAP_PROP_FRAME_COUNT ) );
-#endif
-		} else if (m_imageList.count()) {
-			m_length = m_imageList.count();
-		}
-	}
 	return m_length;
 }
 
 
 /// the width of the video frames
 int InputVideo::width() { 
-	if (m_width == 0) {
-		aptr<ImageColorU> img = frame( 0 ); // don't want to use CV_CAP_PROP_FRAME_WIDTH/HEIGHT because may not return valid value if not already loaded a frame
-		if (img.get()) {
-			m_width = img->width();
-			m_height = img->height();
-		}
-	}
+	initSize();
 	return m_width;
 }
 
 
 /// the height of the video frames
 int InputVideo::height() { 
-	if (m_height == 0) {
-		aptr<ImageColorU> img = frame( 0 ); // don't want to use CV_CAP_PROP_FRAME_WIDTH/HEIGHT because may not return valid value if not already loaded a frame
+	initSize();
+	return m_height;
+}
+
+
+// get the frame size (from the first frame if not provided by the video file)
+void InputVideo::initSize() {
+	if ((m_width == 0 || m_height == 0) && m_length) {
+		aptr<ImageColorU> img = frame( 0 ); // the frame stays in the reader's cache, so this doesn't add a decode if frame 0 is used next
 		if (img.get()) {
 			m_width = img->width();
 			m_height = img->height();
 		}
 	}
-	return m_height;
 }
 
 
+/// the number of frame requests that were / were not already decoded, and the number of times the decoder seeked
+int InputVideo::hitCount() const { return m_reader ? m_reader->hitCount() : 0; }
+int InputVideo::missCount() const { return m_reader ? m_reader->missCount() : 0; }
+int InputVideo::seekCount() const { return m_reader ? m_reader->seekCount() : 0; }
+
+
+/// the total time (in seconds) that frame requests have waited for the decoder
+float InputVideo::waitTime() const { return m_reader ? m_reader->waitTime() : 0; }
+
+
 //-------------------------------------------
 // OUTPUT VIDEO CLASS
 //-------------------------------------------
@@ -137,63 +867,500 @@ int InputVideo::height() {
 
 /// create unopened output video object
 OutputVideo::OutputVideo() {
-	m_videoWriter = NULL;
+	m_writer = NULL;
 	m_width = 0;
 	m_height = 0;
 }
 
 
-/// open the output video file
-OutputVideo::OutputVideo( const String &fileName, int outputWidth, int outputHeight, double fps ) {
-	m_videoWriter = NULL;
-	open( fileName, outputWidth, outputHeight, fps );
+/// open the output video file; up to queueLength frames can wait to be encoded
+OutputVideo::OutputVideo( const String &fileName, int outputWidth, int outputHeight, double fps, int queueLength ) {
+	m_writer = NULL;
+	open( fileName, outputWidth, outputHeight, fps, queueLength );
 }
 
 
-/// open the output video file
-void OutputVideo::open( const String &fileName, int outputWidth, int outputHeight, double fps ) {
-#ifdef USE_OPENCV3
-	int fourcc = CV_FOURCC_DEFAULT;
-	if (fileName.endsWith( ".avi" ))
-		fourcc = CV_FOURCC( 'H', 'F', 'Y', 'U' ); // HuffYUV (lossless)
-	m_videoWriter = cvCreateVideoWriter( fileName.c_str(), fourcc, fps, cvSize( outputWidth, outputHeight ) );
-#endif
+/// open the output video file; up to queueLength frames can wait to be encoded
+void OutputVideo::open( const String &fileName, int outputWidth, int outputHeight, double fps, int queueLength ) {
+	close();
+	delete m_writer;
+	m_writer = NULL;
+	m_fileName = fileName;
 	m_width = outputWidth;
 	m_height = outputHeight;
+#ifdef USE_OPENCV
+	WriterFrameSink *sink = new WriterFrameSink( fileName, outputWidth, outputHeight, fps );
+	if (sink->isOpened())
+		m_writer = new VideoFrameWriter( sink, queueLength );
+	else
+		delete sink;
+#endif
 }
 
 
-/// close the video file
+/// finish encoding and close the output video file
 OutputVideo::~OutputVideo() {
-#ifdef USE_OPENCV3
-	if (m_videoWriter)
-		cvReleaseVideoWriter( &m_videoWriter );
-#endif
+	close();
+	delete m_writer;
 }
 
 
-/// add a frame to the video
+/// add a copy of a frame to the video
 void OutputVideo::append( const ImageColorU &img ) {
 	assertAlways( img.width() == m_width && img.height() == m_height );
-	if (m_videoWriter) {
-#ifdef USE_OPENCV3
-		// TODO: upgrade to C++ OpenCV functions
-		// cvWriteFrame(m_videoWriter, img->iplImage());
-#endif
-	}
+	if (m_writer) 
+		append( aptr<ImageColorU>( new ImageColorU( img ) ) );
 }
 
 
-/// add a frame to the video
+/// add a copy of a frame to the video (converted to color by the background thread)
 void OutputVideo::append( const ImageGrayU &img ) {
-	aptr<ImageColorU> color = toColor( img );
-	append( *color );
+	assertAlways( img.width() == m_width && img.height() == m_height );
+	if (m_writer) 
+		append( aptr<ImageGrayU>( new ImageGrayU( img ) ) );
+}
+
+
+/// add a frame to the video, taking ownership of the image (so that it doesn't need to be copied)
+void OutputVideo::append( aptr<ImageColorU> img ) {
+	assertAlways( img->width() == m_width && img->height() == m_height );
+	if (m_writer) {
+		VideoFrame *frame = new VideoFrame( 0 );
+		frame->color = img;
+		m_writer->append( frame );
+	}
+}
+
+
+/// add a frame to the video, taking ownership of the image (converted to color by the background thread)
+void OutputVideo::append( aptr<ImageGrayU> img ) {
+	assertAlways( img->width() == m_width && img->height() == m_height );
+	if (m_writer) {
+		VideoFrame *frame = new VideoFrame( 0 );
+		frame->gray = img;
+		m_writer->append( frame );
+	}
+}
+
+
+/// wait for the queued frames to be encoded and close the output video file; 
+/// returns false (and displays a warning) if any frames could not be written
+bool OutputVideo::close() {
+	if (m_writer == NULL)
+		return false;
+	bool reported = m_writer->closed();
+	bool success = m_writer->close();
+	if (success == false && reported == false)
+		warning( "unable to write %d of %d frames to video: %s", m_writer->failCount(), m_writer->failCount() + m_writer->frameCount(), m_fileName.c_str() );
+	return success;
 }
 
 
 /// returns true if video file successfully created
 bool OutputVideo::openSuccess() { 
-	return m_videoWriter ? true : false;
+	return m_writer ? true : false;
+}
+
+
+/// the number of frames written, and the total time (in seconds) that append has waited for space in the queue
+int OutputVideo::frameCount() const { return m_writer ? m_writer->frameCount() : 0; }
+float OutputVideo::waitTime() const { return m_writer ? m_writer->waitTime() : 0; }
+//-------------------------------------------
+// TEST / BENCHMARK
+//-------------------------------------------
+
+
+// wait for the given number of milliseconds (without sleeping, to simulate decoding work)
+void videoBusyWait( double milliseconds ) {
+	double startTime = getPerfTime();
+	while ((getPerfTime() - startTime) * 1000.0 < milliseconds) {}
+}
+
+
+/// The SyntheticFrameSource class generates frames (identified by their pixel values) with a simulated decoding cost;
+/// as with long-GOP video, seeking to a frame requires decoding the frames since the previous key frame.  If keyFrameInterval
+/// is 1, the source provides random access (as with image files); loadMs simulates waiting for a file to be read.
+class SyntheticFrameSource : public VideoFrameSource {
+public:
+
+	// create a source with the given frame size, key frame interval, and decoding time per frame
+	SyntheticFrameSource( int width, int height, int keyFrameInterval, double decodeMs, int failIndex = -1, double loadMs = 0 ) 
+		: m_width( width ), m_height( height ), m_keyFrameInterval( keyFrameInterval ), m_decodeMs( decodeMs ), m_loadMs( loadMs ), m_failIndex( failIndex ), m_position( 0 ) {}
+
+	// generate the frame at the current position
+	bool read( aptr<ImageColorU> &image ) { return readFrame( m_position++, image ); }
+
+	// decoding is needed to advance
+	bool skip() { videoBusyWait( m_decodeMs ); m_position++; return true; }
+
+	// decode from the previous key frame
+	bool seek( int frameIndex ) { 
+		videoBusyWait( m_decodeMs * (frameIndex % m_keyFrameInterval) );
+		m_position = frameIndex;
+		return true; 
+	}
+
+	// frames can be generated independently if each is a key frame
+	bool randomAccess() const { return m_keyFrameInterval == 1; }
+
+	// generate the given frame
+	bool readFrame( int frameIndex, aptr<ImageColorU> &image ) {
+		if (m_loadMs)
+			std::this_thread::sleep_for( std::chrono::microseconds( (int) (m_loadMs * 1000.0) ) );
+		videoBusyWait( m_decodeMs );
+		if (frameIndex == m_failIndex)
+			return false;
+		if (image.get() == NULL || image->width() != m_width || image->height() != m_height)
+			image.reset( new ImageColorU( m_width, m_height ) );
+		for (int y = 0; y < m_height; y++) {
+			unsigned char *row = image->row( y );
+			for (int x = 0; x < m_width * 3; x++)
+				row[ x ] = (unsigned char) (frameIndex * 7 + x + y);
+		}
+		return true;
+	}
+
+	// true if the image is the given frame
+	static bool checkFrame( const ImageColorU &image, int frameIndex ) {
+		for (int y = 0; y < image.height(); y++) {
+			const unsigned char *row = image.row( y );
+			for (int x = 0; x < image.width() * 3; x++)
+				if (row[ x ] != (unsigned char) (frameIndex * 7 + x + y))
+					return false;
+		}
+		return true;
+	}
+
+private:
+
+	// the frame size, key frame interval, simulated decoding and loading times, a frame that can't be decoded (for testing), and the current frame
+	int m_width;
+	int m_height;
+	int m_keyFrameInterval;
+	double m_decodeMs;
+	double m_loadMs;
+	int m_failIndex;
+	int m_position;
+};
+
+
+// check that the frame reader returns the requested frames for various access patterns, without seeking for sequential access
+bool testVideoFrameReader() {
+	int length = 100, failIndex = 77;
+	VideoFrameReader reader( new SyntheticFrameSource( 13, 7, 10, 0, failIndex ), length, 4, 3 );
+
+	// forward, then forward with a step of 3
+	for (int i = 0; i < length; i++) {
+		aptr<ImageColorU> image = reader.frame( i );
+		if (i == failIndex) {
+			unitAssert( image.get() == NULL );
+		} else {
+			unitAssert( image.get() && SyntheticFrameSource::checkFrame( *image, i ) );
+		}
+	}
+	for (int i = 0; i < length; i += 3) {
+		aptr<ImageColorU> image = reader.frame( i );
+		unitAssert( image.get() && SyntheticFrameSource::checkFrame( *image, i ) );
+	}
+	unitAssert( reader.seekCount() == 2 ); // after the failed frame and when returning to the start
+	unitAssert( reader.hitCount() + reader.missCount() == length + (length + 2) / 3 );
+
+	// backward, random, and grayscale
+	for (int i = 50; i > 30; i--) {
+		aptr<ImageColorU> image = reader.frame( i );
+		unitAssert( image.get() && SyntheticFrameSource::checkFrame( *image, i ) );
+	}
+	for (int i = 0; i < 50; i++) {
+		int frameIndex = randomInt( 0, length - 1 );
+		if (frameIndex != failIndex) {
+			aptr<ImageColorU> image = reader.frame( frameIndex );
+			unitAssert( image.get() && SyntheticFrameSource::checkFrame( *image, frameIndex ) );
+			if (i % 5 == 0) {
+				aptr<ImageGrayU> gray = reader.frameGray( frameIndex );
+				aptr<ImageGrayU> grayCheck = toGray( *image );
+				unitAssert( gray.get() && gray->width() == 13 && gray->height() == 7 );
+				for (int y = 0; y < 7; y++) {
+					unitAssert( memcmp( gray->row( y ), grayCheck->row( y ), 13 ) == 0 );
+				}
+			}
+		}
+	}
+
+	// random access (as with image files), with several threads and a memory limit of 5 frames
+	for (int pass = 0; pass < 2; pass++) {
+		VideoFrameReader listReader( new SyntheticFrameSource( 13, 7, 1, 0, failIndex ), length );
+		listReader.setReadAhead( 16, 4, pass ? 5 * ImageColorU( 13, 7 ).memUsed() : 1000000 );
+		for (int i = 0; i < length; i++) {
+			int frameIndex = i < 80 ? i : randomInt( 0, length - 1 );
+			aptr<ImageColorU> image = listReader.frame( frameIndex );
+			if (frameIndex == failIndex) {
+				unitAssert( image.get() == NULL );
+			} else {
+				unitAssert( image.get() && SyntheticFrameSource::checkFrame( *image, frameIndex ) );
+			}
+		}
+		unitAssert( listReader.seekCount() == 0 );
+	}
+	return true;
+}
+
+
+/// The SyntheticFrameSink class compares the frames it receives with the expected frames, with a simulated encoding cost.
+class SyntheticFrameSink : public VideoFrameSink {
+public:
+
+	// create a sink that expects the given frames (in order); writing failIndex fails (for testing)
+	SyntheticFrameSink( const Array<ImageColorU> &expected, double encodeMs, int failIndex = -1 ) 
+		: m_expected( expected ), m_encodeMs( encodeMs ), m_failIndex( failIndex ), m_mismatchCount( 0 ), m_closeCount( 0 ) {}
+
+	// check and record the frame
+	bool write( const ImageColorU &image ) {
+		videoBusyWait( m_encodeMs );
+		int frameIndex = m_written.count();
+		m_written.append( (ImageColorU *) &image );
+		if (frameIndex == m_failIndex)
+			return false;
+		if (frameIndex >= m_expected.count() || sameImage( image, m_expected[ frameIndex ] ) == false)
+			m_mismatchCount++;
+		return true;
+	}
+
+	// count the calls
+	bool close() { m_closeCount++; return true; }
+
+	// the images written, in order (not owned; may no longer exist)
+	inline const PtrArray<ImageColorU> &written() const { return m_written; }
+
+	// the number of frames that did not match the expected frames and the number of times the sink was closed
+	inline int mismatchCount() const { return m_mismatchCount; }
+	inline int closeCount() const { return m_closeCount; }
+
+	// true if the images have the same size and pixel values
+	static bool sameImage( const ImageColorU &image1, const ImageColorU &image2 ) {
+		if (image1.width() != image2.width() || image1.height() != image2.height())
+			return false;
+		for (int y = 0; y < image1.height(); y++)
+			if (memcmp( image1.row( y ), image2.row( y ), image1.width() * 3 ))
+				return false;
+		return true;
+	}
+
+private:
+
+	// the expected frames, the simulated encoding time, and the frame to fail
+	const Array<ImageColorU> &m_expected;
+	double m_encodeMs;
+	int m_failIndex;
+
+	// the frames received and the results
+	PtrArray<ImageColorU> m_written;
+	int m_mismatchCount;
+	int m_closeCount;
+};
+
+
+// check that the frame writer encodes color and grayscale frames in order, without copying handed-off images and without 
+// exceeding the queue length; check that a failed frame is reported by close
+bool testVideoFrameWriter() {
+	int length = 30, queueLength = 3, width = 13, height = 7;
+	for (int pass = 0; pass < 2; pass++) {
+		int failIndex = pass ? 17 : -1;
+
+		// generate frames: every third frame is grayscale (expected as a color image after conversion)
+		SyntheticFrameSource source( width, height, 1, 0 );
+		Array<ImageColorU> expected;
+		for (int i = 0; i < length; i++) {
+			aptr<ImageColorU> image;
+			source.readFrame( i, image );
+			if (i % 3 == 2)
+				image = toColor( *toGray( *image ) );
+			expected.append( image.release() );
+		}
+
+		// append frames (handing off or copying color frames); the sink is slow enough that appending must wait
+		SyntheticFrameSink *sink = new SyntheticFrameSink( expected, 1.0, failIndex );
+		VideoFrameWriter writer( sink, queueLength );
+		PtrArray<ImageColorU> handedOff;
+		for (int i = 0; i < length; i++) {
+			VideoFrame *frame = new VideoFrame( i );
+			if (i % 3 == 0) {
+				frame->color.reset( new ImageColorU( expected[ i ] ) );
+				handedOff.append( frame->color.get() );
+			} else if (i % 3 == 1) {
+				frame->color.reset( new ImageColorU( expected[ i ] ) );
+			} else {
+				frame->gray = toGray( expected[ i ] );
+			}
+			writer.append( frame );
+			unitAssert( writer.queueCount() <= queueLength );
+		}
+		bool success = writer.close();
+		unitAssert( success == (failIndex < 0) );
+		unitAssert( writer.frameCount() == length - (failIndex < 0 ? 0 : 1) );
+		unitAssert( writer.failCount() == (failIndex < 0 ? 0 : 1) );
+		unitAssert( writer.waitTime() > 0 );
+		unitAssert( writer.close() == success && sink->closeCount() == 1 );
+		unitAssert( sink->written().count() == length && sink->mismatchCount() == 0 );
+		for (int i = 0; i < length; i += 3) {
+			unitAssert( &sink->written()[ i ] == &handedOff[ i / 3 ] );
+		}
+	}
+	return true;
+}
+
+
+// time reading frames with the frame reader and by seeking to each frame, for a simulated long-GOP video
+void benchmarkVideoRead( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int length = conf.readInt( "length", 100 );
+	int keyFrameInterval = conf.readInt( "keyFrameInterval", 30 );
+	float decodeMs = conf.readFloat( "decodeMs", 2.0f );
+	float workMs = conf.readFloat( "workMs", 2.0f );
+	if (conf.initialPass())
+		return;
+	disp( 1, "frames: %d x %d x %d, key frame interval: %d, decode: %4.2f ms, work: %4.2f ms", width, height, length, keyFrameInterval, decodeMs, workMs );
+
+	// seek to each frame (as done previously)
+	SyntheticFrameSource source( width, height, keyFrameInterval, decodeMs );
+	Timer seekTimer( true );
+	for (int i = 0; i < length; i++) {
+		aptr<ImageColorU> image;
+		source.seek( i );
+		source.read( image );
+		videoBusyWait( workMs );
+	}
+	seekTimer.stop();
+	disp( 1, "seek per frame: %8.3f ms/frame", seekTimer.timeSum() * 1000.0f / length );
+
+	// sequential access with the frame reader, with a step of 1, a step of 2, and backward
+	for (int pass = 0; pass < 3; pass++) {
+		VideoFrameReader reader( new SyntheticFrameSource( width, height, keyFrameInterval, decodeMs ), length );
+		int step = pass == 1 ? 2 : 1, count = (length + step - 1) / step;
+		Timer timer( true );
+		for (int i = 0; i < count; i++) {
+			aptr<ImageColorU> image = reader.frame( pass == 2 ? length - 1 - i : i * step );
+			videoBusyWait( workMs );
+		}
+		timer.stop();
+		const char *names[] = { "reader (step 1)", "reader (step 2)", "reader (backward)" };
+		disp( 1, "%-18s %8.3f ms/frame, hits: %d, misses: %d, seeks: %d, decodes: %d, wait: %.3f s", names[ pass ], 
+			timer.timeSum() * 1000.0f / count, reader.hitCount(), reader.missCount(), reader.seekCount(), reader.decodeCount(), reader.waitTime() );
+	}
+}
+
+
+// time writing frames on the caller's thread and with the frame writer, for a simulated encoder
+void benchmarkVideoWrite( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int length = conf.readInt( "length", 100 );
+	int queueLength = conf.readInt( "queueLength", 8 );
+	float encodeMs = conf.readFloat( "encodeMs", 4.0f );
+	float workMs = conf.readFloat( "workMs", 4.0f );
+	if (conf.initialPass())
+		return;
+	disp( 1, "frames: %d x %d x %d, encode: %4.2f ms, work: %4.2f ms, queue length: %d", width, height, length, encodeMs, workMs, queueLength );
+
+	// the frames expected by the sink (all the same, so that checking them isn't part of the timing)
+	SyntheticFrameSource source( width, height, 1, 0 );
+	aptr<ImageColorU> image;
+	source.readFrame( 0, image );
+	Array<ImageColorU> expected;
+	for (int i = 0; i < length; i++)
+		expected.append( new ImageColorU( *image ) );
+
+	// encode each frame after producing it (as done previously), then hand off frames to the writer
+	for (int pass = 0; pass < 2; pass++) {
+		SyntheticFrameSink *sink = new SyntheticFrameSink( expected, encodeMs );
+		aptr<VideoFrameWriter> writer( pass ? new VideoFrameWriter( sink, queueLength ) : NULL );
+		Timer timer( true );
+		for (int i = 0; i < length; i++) {
+			videoBusyWait( workMs );
+			if (pass) {
+				VideoFrame *frame = new VideoFrame( i );
+				frame->color.reset( new ImageColorU( *image ) ); // stands in for the newly produced frame
+				writer->append( frame );
+			} else {
+				sink->write( *image );
+			}
+		}
+		if (pass)
+			writer->close();
+		timer.stop();
+		disp( 1, "%-8s %8.3f ms/frame, wait: %.3f s, mismatches: %d", pass ? "queued" : "direct", timer.timeSum() * 1000.0f / length, 
+			pass ? writer->waitTime() : 0.0f, sink->mismatchCount() );
+		if (pass == 0)
+			delete sink;
+	}
+}
+
+
+// time reading an image sequence with various numbers of loading threads; uses simulated images unless a path is given
+void benchmarkImageListRead( Config &conf ) {
+
+	// get command parameters
+	String inputFileName = conf.readString( "inputFileName", "" );
+	int width = conf.readInt( "width", 1920 );
+	int height = conf.readInt( "height", 1080 );
+	int length = conf.readInt( "length", 1000 );
+	float decodeMs = conf.readFloat( "decodeMs", 2.0f );
+	float loadMs = conf.readFloat( "loadMs", 4.0f );
+	int maxThreads = conf.readInt( "maxThreads", 8 );
+	if (conf.initialPass())
+		return;
+	if (inputFileName.length()) {
+		disp( 1, "image sequence: %s", inputFileName.c_str() );
+	} else {
+		disp( 1, "simulated images: %d x %d x %d, load: %4.2f ms (waiting), decode: %4.2f ms (computing)", width, height, length, loadMs, decodeMs );
+	}
+
+	// read each frame (in order) with 1, 2, 4, ... threads
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		aptr<InputVideo> inputVideo;
+		aptr<VideoFrameReader> reader;
+		if (inputFileName.length()) {
+			inputVideo.reset( new InputVideo( inputFileName ) );
+			if (inputVideo->openSuccess() == false) {
+				warning( "unable to open: %s", inputFileName.c_str() );
+				return;
+			}
+			inputVideo->setReadAhead( threads * 4, threads );
+			length = inputVideo->length();
+		} else {
+			reader.reset( new VideoFrameReader( new SyntheticFrameSource( width, height, 1, decodeMs, -1, loadMs ), length ) );
+			reader->setReadAhead( threads * 4, threads, 512 * 1024 * 1024 );
+		}
+		int failCount = 0;
+		Timer timer( true );
+		for (int i = 0; i < length; i++) {
+			aptr<ImageColorU> image = inputVideo.get() ? inputVideo->frame( i ) : reader->frame( i );
+			if (image.get() == NULL)
+				failCount++;
+		}
+		timer.stop();
+		disp( 1, "threads: %d, %8.1f frames/sec, wait: %6.3f s, failed: %d", threads, (float) length / timer.timeSum(), 
+			inputVideo.get() ? inputVideo->waitTime() : reader->waitTime(), failCount );
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initVideo() {
+	registerUnitTest( testVideoFrameReader );
+	registerUnitTest( testVideoFrameWriter );
+	registerCommand( "benchvideoread", benchmarkVideoRead );
+	registerCommand( "benchvideowrite", benchmarkVideoWrite );
+	registerCommand( "benchimagelist", benchmarkImageListRead );
 }
 
 
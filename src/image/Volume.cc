@@ -0,0 +1,516 @@
+#include <sbl/image/Volume.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/math/MathUtil.h>
+#include <sbl/system/Timer.h> // for benchmark
+#include <string.h> // for memcpy
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
+namespace sbl {
+
+
+//-------------------------------------------
+// VOLUME CLASS
+//-------------------------------------------
+
+
+/// create a volume; does not initialize the values
+template <typename T> Volume<T>::Volume( int width, int height, int length ) {
+	assertAlways( width >= 0 && height >= 0 && length >= 0 );
+	m_width = width;
+	m_height = height;
+	m_length = length;
+	m_rowStride = Image<T, 1>::defaultRowBytes( width ) / sizeof( T );
+
+	// as with rows, avoid frame strides that are multiples of 4K (which would make the rows of nearby frames share cache sets)
+	size_t frameBytes = (size_t) m_rowStride * sizeof( T ) * height;
+	if (frameBytes && (frameBytes & 4095) == 0)
+		frameBytes += IMAGE_ROW_ALIGN;
+	m_frameStride = frameBytes / sizeof( T );
+
+	// alloc values, with extra space so that the first row can be aligned
+	m_alloc = new unsigned char[ frameBytes * length + IMAGE_ROW_ALIGN ];
+	if (m_alloc == NULL) fatalError( "error allocating Volume data" );
+	size_t offset = IMAGE_ROW_ALIGN - ((size_t) m_alloc % IMAGE_ROW_ALIGN);
+	m_raw = (T *) (m_alloc + (offset == IMAGE_ROW_ALIGN ? 0 : offset));
+}
+
+
+// basic destructor
+template <typename T> Volume<T>::~Volume() {
+	delete [] m_alloc;
+}
+
+
+/// set all values
+template <typename T> void Volume<T>::clear( T value ) {
+	for (int z = 0; z < m_length; z++) {
+		for (int y = 0; y < m_height; y++) {
+			T *r = row( y, z );
+			for (int x = 0; x < m_width; x++)
+				r[ x ] = value;
+		}
+	}
+}
+
+
+/// perform trilinear interpolation (assumes the point is inside the volume)
+template <typename T> float Volume<T>::interp( float x, float y, float z ) const {
+	int xInt = (int) x, yInt = (int) y, zInt = (int) z;
+	assertDebug( inBounds( xInt, yInt, zInt ) );
+	float xFrac = x - xInt, yFrac = y - yInt, zFrac = z - zInt;
+
+	// as in Image::interp, in the last column/row/frame, the next column/row/frame is the current one
+	const T *p = row( yInt, zInt ) + xInt;
+	int xStep = xInt < m_width - 1 ? 1 : 0;
+	size_t yStep = yInt < m_height - 1 ? m_rowStride : 0;
+	size_t zStep = zInt < m_length - 1 ? m_frameStride : 0;
+	const T *p0 = p, *p1 = p + yStep, *p2 = p + zStep, *p3 = p + zStep + yStep;
+	float top0 = p0[ 0 ] + xFrac * (float) (p0[ xStep ] - p0[ 0 ]);
+	float bottom0 = p1[ 0 ] + xFrac * (float) (p1[ xStep ] - p1[ 0 ]);
+	float top1 = p2[ 0 ] + xFrac * (float) (p2[ xStep ] - p2[ 0 ]);
+	float bottom1 = p3[ 0 ] + xFrac * (float) (p3[ xStep ] - p3[ 0 ]);
+	float v0 = top0 + yFrac * (bottom0 - top0);
+	float v1 = top1 + yFrac * (bottom1 - top1);
+	return v0 + zFrac * (v1 - v0);
+}
+
+
+/// perform trilinear interpolation at each of the given points (assumes the points are inside the volume)
+template <typename T> void Volume<T>::interp( const float *x, const float *y, const float *z, int count, float *out ) const {
+	parallelFor( 0, count, 4096, [&]( int begin, int end ) {
+		for (int i = begin; i < end; i++)
+			out[ i ] = interp( x[ i ], y[ i ], z[ i ] );
+	} );
+}
+
+
+// explicit instantiation of the supported volume types
+template class Volume<unsigned char>;
+template class Volume<float>;
+
+
+//-------------------------------------------
+// CONVERSION
+//-------------------------------------------
+
+
+// the number of rows handed to a worker thread at a time
+#define VOLUME_GRAIN_ROWS 16
+
+
+// copy an image sequence into a new volume
+template <typename T> aptr< Volume<T> > toVolumeInternal( const Array< Image<T, 1> > &seq ) {
+	int length = seq.count();
+	int width = length ? seq[ 0 ].width() : 0, height = length ? seq[ 0 ].height() : 0;
+	aptr< Volume<T> > volume( new Volume<T>( width, height, length ) );
+	for (int z = 0; z < length; z++)
+		assertAlways( seq[ z ].width() == width && seq[ z ].height() == height );
+	parallelFor( 0, length * height, VOLUME_GRAIN_ROWS, [&]( int begin, int end ) {
+		for (int i = begin; i < end; i++) {
+			int z = i / height, y = i - z * height;
+			memcpy( volume->row( y, z ), seq[ z ].row( y ), width * sizeof( T ) );
+		}
+	} );
+	return volume;
+}
+
+
+// append a copy of each frame of a volume to an image sequence
+template <typename T> void toImageSeqInternal( const Volume<T> &volume, Array< Image<T, 1> > &seq ) {
+	assertAlways( seq.count() == 0 );
+	int width = volume.width(), height = volume.height();
+	for (int z = 0; z < volume.length(); z++) {
+		Image<T, 1> *img = new Image<T, 1>( width, height );
+		for (int y = 0; y < height; y++)
+			memcpy( img->row( y ), volume.row( y, z ), width * sizeof( T ) );
+		seq.append( img );
+	}
+}
+
+
+/// create a volume holding a copy of an image sequence (the images must all have the same size)
+aptr<VolumeU> toVolume( const ImageGrayUSeq &seq ) {
+	return toVolumeInternal( seq );
+}
+
+
+/// create a volume holding a copy of an image sequence (the images must all have the same size)
+aptr<VolumeF> toVolume( const ImageGrayFSeq &seq ) {
+	return toVolumeInternal( seq );
+}
+
+
+/// append a copy of each frame of a volume to an (empty) image sequence
+void toImageSeq( const VolumeU &volume, ImageGrayUSeq &seq ) {
+	toImageSeqInternal( volume, seq );
+}
+
+
+/// append a copy of each frame of a volume to an (empty) image sequence
+void toImageSeq( const VolumeF &volume, ImageGrayFSeq &seq ) {
+	toImageSeqInternal( volume, seq );
+}
+
+
+//-------------------------------------------
+// VOLUME FILTERS
+//-------------------------------------------
+
+
+// set out[ x ] to the weighted sum of rows[ i ][ x ] for i in [0, count), rounded and clamped to [0, 255]
+void weightedRowSum( const unsigned char **rows, const float *weights, int count, int width, unsigned char *out ) {
+	int x = 0;
+#ifdef __SSE2__
+
+	// keep 16 sums in registers while streaming the rows; rounds by adding 0.5 and truncating, as in the scalar loop below
+	// (the sums are non-negative for the weights used here, so this matches sbl::round)
+	__m128i zero = _mm_setzero_si128();
+	__m128 half = _mm_set1_ps( 0.5f );
+	for (; x + 16 <= width; x += 16) {
+		__m128 sum0 = _mm_setzero_ps(), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+		for (int i = 0; i < count; i++) {
+			__m128i v = _mm_loadu_si128( (const __m128i *) (rows[ i ] + x) );
+			__m128i lo = _mm_unpacklo_epi8( v, zero ), hi = _mm_unpackhi_epi8( v, zero );
+			__m128 w = _mm_set1_ps( weights[ i ] );
+			sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ), w ) );
+			sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ), w ) );
+			sum2 = _mm_add_ps( sum2, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ), w ) );
+			sum3 = _mm_add_ps( sum3, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ), w ) );
+		}
+		__m128i packed0 = _mm_packs_epi32( _mm_cvttps_epi32( _mm_add_ps( sum0, half ) ), _mm_cvttps_epi32( _mm_add_ps( sum1, half ) ) );
+		__m128i packed1 = _mm_packs_epi32( _mm_cvttps_epi32( _mm_add_ps( sum2, half ) ), _mm_cvttps_epi32( _mm_add_ps( sum3, half ) ) );
+		_mm_storeu_si128( (__m128i *) (out + x), _mm_packus_epi16( packed0, packed1 ) );
+	}
+#endif
+	for (; x < width; x++) {
+		float sum = 0;
+		for (int i = 0; i < count; i++)
+			sum += weights[ i ] * rows[ i ][ x ];
+		out[ x ] = (unsigned char) bound( (int) (sum + 0.5f), 0, 255 );
+	}
+}
+
+
+// set out[ x ] to the weighted sum of rows[ i ][ x ] for i in [0, count)
+void weightedRowSum( const float **rows, const float *weights, int count, int width, float *out ) {
+	int x = 0;
+#ifdef __SSE2__
+	for (; x + 8 <= width; x += 8) {
+		__m128 sum0 = _mm_setzero_ps(), sum1 = sum0;
+		for (int i = 0; i < count; i++) {
+			__m128 w = _mm_set1_ps( weights[ i ] );
+			sum0 = _mm_add_ps( sum0, _mm_mul_ps( _mm_loadu_ps( rows[ i ] + x ), w ) );
+			sum1 = _mm_add_ps( sum1, _mm_mul_ps( _mm_loadu_ps( rows[ i ] + x + 4 ), w ) );
+		}
+		_mm_storeu_ps( out + x, sum0 );
+		_mm_storeu_ps( out + x + 4, sum1 );
+	}
+#endif
+	for (; x < width; x++) {
+		float sum = 0;
+		for (int i = 0; i < count; i++)
+			sum += weights[ i ] * rows[ i ][ x ];
+		out[ x ] = sum;
+	}
+}
+
+
+// compute each output frame as a weighted sum of input frames, a row at a time (in parallel);
+// the weights of output frame z are weights[ z * maxCount + i ] for input frames firstFrame[ z ] + i, i in [0, frameCount[ z ])
+template <typename T> void weightedFrameSum( const Volume<T> &input, Volume<T> &output, const VectorI &firstFrame, const VectorI &frameCount, const VectorF &weights, int maxCount ) {
+	int height = output.height(), width = output.width();
+	ProgressCounter counter( output.length() * height );
+	parallelFor( 0, output.length() * height, VOLUME_GRAIN_ROWS, [&]( int begin, int end ) {
+		Vector<const T *> rowPtrs( maxCount );
+		for (int i = begin; i < end; i++) {
+			int z = i / height, y = i - z * height;
+			for (int j = 0; j < frameCount[ z ]; j++)
+				rowPtrs[ j ] = input.row( y, firstFrame[ z ] + j );
+			weightedRowSum( rowPtrs.dataPtr(), weights.dataPtr() + z * maxCount, frameCount[ z ], width, output.row( y, z ) );
+		}
+		counter.add( end - begin );
+	} );
+}
+
+
+// blur along the z axis, streaming whole rows from the frames within the kernel
+template <typename T> aptr< Volume<T> > blurGaussZInternal( const Volume<T> &input, float sigma ) {
+	int width = input.width(), height = input.height(), length = input.length();
+	aptr< Volume<T> > output( new Volume<T>( width, height, length ) );
+
+	// generate Gaussian table (as in blurGaussSeqZ)
+	int tableRadius = (int) sigma * 3;
+	double gFactor = gaussFactor( sigma );
+	int tableSize = tableRadius * 2 + 1;
+	VectorD table( tableSize );
+	for (int i = 0; i < tableSize; i++) {
+		double x = (double) (i - tableRadius);
+		table[ i ] = gauss( x * x, gFactor );
+	}
+
+	// normalize the weights of the frames within the volume for each output frame
+	VectorI firstFrame( length ), frameCount( length );
+	VectorF weights( length * tableSize );
+	for (int z = 0; z < length; z++) {
+		int zMin = max( z - tableRadius, 0 ), zMax = min( z + tableRadius, length - 1 );
+		double sumWt = 0;
+		for (int j = zMin; j <= zMax; j++)
+			sumWt += table[ j - z + tableRadius ];
+		firstFrame[ z ] = zMin;
+		frameCount[ z ] = zMax - zMin + 1;
+		for (int j = zMin; j <= zMax; j++)
+			weights[ z * tableSize + j - zMin ] = (float) (table[ j - z + tableRadius ] / sumWt);
+	}
+	weightedFrameSum( input, *output, firstFrame, frameCount, weights, tableSize );
+	return output;
+}
+
+
+// resize along the z axis, interpolating between pairs of frames
+template <typename T> aptr< Volume<T> > resizeZInternal( const Volume<T> &input, int newLength ) {
+	int oldLength = input.length();
+	assertAlways( oldLength && newLength > 1 );
+	aptr< Volume<T> > output( new Volume<T>( input.width(), input.height(), newLength ) );
+
+	// the input frames and weights of each output frame (as in resizeSeqZ)
+	VectorI firstFrame( newLength ), frameCount( newLength );
+	VectorF weights( newLength * 2 );
+	float zScale = (float) (oldLength - 1) / (float) (newLength - 1);
+	for (int z = 0; z < newLength; z++) {
+		float zOld = z * zScale;
+		int zOldInt = (int) zOld;
+		if (zOldInt >= oldLength - 1) {
+			firstFrame[ z ] = oldLength - 1;
+			frameCount[ z ] = 1;
+			weights[ z * 2 ] = 1.0f;
+		} else {
+			float frac = zOld - zOldInt;
+			firstFrame[ z ] = zOldInt;
+			frameCount[ z ] = 2;
+			weights[ z * 2 ] = 1.0f - frac;
+			weights[ z * 2 + 1 ] = frac;
+		}
+	}
+	weightedFrameSum( input, *output, firstFrame, frameCount, weights, 2 );
+	return output;
+}
+
+
+// transpose the Y and Z axes, copying whole rows
+template <typename T> aptr< Volume<T> > transposeYZInternal( const Volume<T> &input ) {
+	int width = input.width(), height = input.height(), length = input.length();
+	aptr< Volume<T> > output( new Volume<T>( width, length, height ) );
+	parallelFor( 0, length * height, VOLUME_GRAIN_ROWS, [&]( int begin, int end ) {
+		for (int i = begin; i < end; i++) {
+			int z = i / height, y = i - z * height;
+			memcpy( output->row( z, y ), input.row( y, z ), width * sizeof( T ) );
+		}
+	} );
+	return output;
+}
+
+
+/// blur along the z axis (with the same Gaussian kernel as blurGaussSeqZ)
+aptr<VolumeU> blurGaussZ( const VolumeU &input, float sigma ) {
+	return blurGaussZInternal( input, sigma );
+}
+
+
+/// blur along the z axis (with the same Gaussian kernel as blurGaussSeqZ)
+aptr<VolumeF> blurGaussZ( const VolumeF &input, float sigma ) {
+	return blurGaussZInternal( input, sigma );
+}
+
+
+/// resize along the z axis (with linear interpolation, as in resizeSeqZ)
+aptr<VolumeU> resizeZ( const VolumeU &input, int newLength ) {
+	return resizeZInternal( input, newLength );
+}
+
+
+/// resize along the z axis (with linear interpolation, as in resizeSeqZ)
+aptr<VolumeF> resizeZ( const VolumeF &input, int newLength ) {
+	return resizeZInternal( input, newLength );
+}
+
+
+/// transpose the Y and Z axes: output( x, z, y ) = input( x, y, z )
+aptr<VolumeU> transposeYZ( const VolumeU &input ) {
+	return transposeYZInternal( input );
+}
+
+
+/// transpose the Y and Z axes: output( x, z, y ) = input( x, y, z )
+aptr<VolumeF> transposeYZ( const VolumeF &input ) {
+	return transposeYZInternal( input );
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// create a random image sequence (smoothed in x and y, so that interpolation is meaningful)
+void volumeTestSeq( int width, int height, int length, ImageGrayUSeq &seq ) {
+	initImageSeq( seq, width, height, length, false, 0 );
+	for (int z = 0; z < length; z++)
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				seq[ z ].data( x, y ) = (unsigned char) randomInt( 0, 255 );
+	blurGaussSeqXY( seq, 1.0f );
+}
+
+
+// check the volume operations against the corresponding image sequence functions
+bool testVolume() {
+	int savedThreadCount = threadCount();
+	setThreadCount( 4 );
+	for (int i = 0; i < 4; i++) {
+		int width = randomInt( 1, 70 ), height = randomInt( 1, 30 ), length = randomInt( 2, 20 );
+		ImageGrayUSeq seq;
+		volumeTestSeq( width, height, length, seq );
+		ImageGrayFSeq seqF;
+		initImageSeq( seqF, width, height, length, false, 0.0f );
+		for (int z = 0; z < length; z++)
+			for (int y = 0; y < height; y++)
+				for (int x = 0; x < width; x++)
+					seqF[ z ].data( x, y ) = (float) seq[ z ].data( x, y ) / 255.0f;
+
+		// conversion and frame views
+		aptr<VolumeU> volume = toVolume( seq );
+		aptr<VolumeF> volumeF = toVolume( seqF );
+		unitAssert( volume->width() == width && volume->height() == height && volume->length() == length );
+		unitAssert( (size_t) volume->row( 0, 1 ) % IMAGE_ROW_ALIGN == 0 && (size_t) volumeF->row( 1, 0 ) % IMAGE_ROW_ALIGN == 0 );
+		ImageGrayUSeq restored;
+		toImageSeq( *volume, restored );
+		unitAssert( restored.count() == length );
+		for (int z = 0; z < length; z++) {
+			ImageViewGrayU frame = volume->frame( z );
+			aptr<ImageGrayU> frameImage = volume->frameImage( z );
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					int v = seq[ z ].data( x, y );
+					unitAssert( volume->data( x, y, z ) == v && frame.data( x, y ) == v && frameImage->data( x, y ) == v && restored[ z ].data( x, y ) == v );
+					unitAssert( volumeF->data( x, y, z ) == seqF[ z ].data( x, y ) );
+				}
+			}
+		}
+
+		// filters
+		float sigma = (float) randomInt( 1, 3 );
+		int newLength = randomInt( 2, 30 );
+		ImageGrayUSeq blurred, resized, transposed;
+		ImageGrayFSeq blurredF, resizedF;
+		blurGaussSeqZ( seq, blurred, sigma );
+		blurGaussSeqZ( seqF, blurredF, sigma );
+		resizeSeqZ( seq, resized, newLength );
+		resizeSeqZ( seqF, resizedF, newLength );
+		transposeYZ( seq, transposed );
+		aptr<VolumeU> blurredVolume = blurGaussZ( *volume, sigma ), resizedVolume = resizeZ( *volume, newLength ), transposedVolume = transposeYZ( *volume );
+		aptr<VolumeF> blurredVolumeF = blurGaussZ( *volumeF, sigma ), resizedVolumeF = resizeZ( *volumeF, newLength ), transposedVolumeF = transposeYZ( *volumeF );
+		unitAssert( transposedVolume->width() == width && transposedVolume->height() == length && transposedVolume->length() == height );
+		for (int z = 0; z < length; z++) {
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+
+					// (blurGaussSeqZ sums in double precision, so 8-bit values near 0.5 may round differently)
+					unitAssert( abs( blurredVolume->data( x, y, z ) - blurred[ z ].data( x, y ) ) <= 1 );
+					unitAssert( fabs( blurredVolumeF->data( x, y, z ) - blurredF[ z ].data( x, y ) ) < 1e-5 );
+					unitAssert( transposedVolume->data( x, z, y ) == transposed[ y ].data( x, z ) && transposedVolumeF->data( x, z, y ) == seqF[ z ].data( x, y ) );
+				}
+			}
+		}
+		for (int z = 0; z < newLength; z++) {
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					unitAssert( resizedVolume->data( x, y, z ) == resized[ z ].data( x, y ) );
+					unitAssert( fabs( resizedVolumeF->data( x, y, z ) - resizedF[ z ].data( x, y ) ) < 1e-5 );
+				}
+			}
+		}
+
+		// interpolation (single and batch)
+		VectorF xs( 100 ), ys( 100 ), zs( 100 ), values( 100 ), valuesF( 100 );
+		for (int j = 0; j < 100; j++) {
+			xs[ j ] = randomFloat( 0, (float) (width - 1) );
+			ys[ j ] = randomFloat( 0, (float) (height - 1) );
+			zs[ j ] = j ? randomFloat( 0, (float) (length - 1) ) : (float) (length - 1);
+		}
+		volume->interp( xs.dataPtr(), ys.dataPtr(), zs.dataPtr(), 100, values.dataPtr() );
+		volumeF->interp( xs.dataPtr(), ys.dataPtr(), zs.dataPtr(), 100, valuesF.dataPtr() );
+		for (int j = 0; j < 100; j++) {
+			unitAssert( fabs( values[ j ] - interp( seq, xs[ j ], ys[ j ], zs[ j ] ) ) < 1e-3 && values[ j ] == volume->interp( xs[ j ], ys[ j ], zs[ j ] ) );
+			unitAssert( fabs( valuesF[ j ] - interp( seqF, xs[ j ], ys[ j ], zs[ j ] ) ) < 1e-5 );
+		}
+	}
+	setThreadCount( savedThreadCount );
+	return true;
+}
+
+
+// time the volume operations and the corresponding image sequence functions
+void benchmarkVolume( Config &conf ) {
+
+	// get command parameters
+	int width = conf.readInt( "width", 320 );
+	int height = conf.readInt( "height", 240 );
+	int length = conf.readInt( "length", 100 );
+	float sigma = conf.readFloat( "sigma", 2.0f );
+	int threads = conf.readInt( "threads", threadCount() );
+	if (conf.initialPass())
+		return;
+	setThreadCount( threads );
+	disp( 1, "sequence: %d x %d x %d, sigma: %.1f, threads: %d", width, height, length, sigma, threadCount() );
+
+	// create a random sequence
+	ImageGrayUSeq seq;
+	volumeTestSeq( width, height, length, seq );
+	int pointCount = 1000000;
+	VectorF xs( pointCount ), ys( pointCount ), zs( pointCount ), values( pointCount );
+	for (int i = 0; i < pointCount; i++) {
+		xs[ i ] = randomFloat( 0, (float) (width - 1) );
+		ys[ i ] = randomFloat( 0, (float) (height - 1) );
+		zs[ i ] = randomFloat( 0, (float) (length - 1) );
+	}
+
+	// time each operation
+	aptr<VolumeU> volume;
+	for (int i = 0; i < 9; i++) {
+		ImageGrayUSeq outSeq;
+		Timer timer( true );
+		switch (i) {
+		case 0: volume = toVolume( seq ); break;
+		case 1: blurGaussSeqZ( seq, outSeq, sigma ); break;
+		case 2: blurGaussZ( *volume, sigma ); break;
+		case 3: transposeYZ( seq, outSeq ); break;
+		case 4: transposeYZ( *volume ); break;
+		case 5: resizeSeqZ( seq, outSeq, length * 2 ); break;
+		case 6: resizeZ( *volume, length * 2 ); break;
+		case 7: for (int j = 0; j < pointCount; j++) values[ j ] = interp( seq, xs[ j ], ys[ j ], zs[ j ] ); break;
+		case 8: volume->interp( xs.dataPtr(), ys.dataPtr(), zs.dataPtr(), pointCount, values.dataPtr() ); break;
+		}
+		timer.stop();
+		const char *names[] = { "toVolume", "blurGaussSeqZ (sequence)", "blurGaussZ (volume)", "transposeYZ (sequence)", "transposeYZ (volume)",
+								"resizeSeqZ (sequence)", "resizeZ (volume)", "interp (sequence, 1M points)", "interp (volume, 1M points)" };
+		disp( 1, "%-32s %8.2f ms", names[ i ], timer.timeSum() * 1000.0 );
+	}
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initVolume() {
+	registerUnitTest( testVolume );
+	registerCommand( "benchvolume", benchmarkVolume );
+}
+
+
+} // end namespace sbl
@@ -1,6 +1,17 @@
 #include <sbl/math/Geometry.h>
 #include <sbl/math/MathUtil.h>
+#include <sbl/math/GeometryUtil.h>
+#include <sbl/core/Display.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/system/Timer.h>
 #include <math.h>
+#include <float.h>
+#include <mutex>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 namespace sbl {
 
 
@@ -42,6 +53,16 @@ Point3 Matrix3::operator*( const Point3 &p ) const {
 }
 
 
+/// multiply two matrices
+Matrix3 Matrix3::operator*( const Matrix3 &m ) const {
+	Matrix3 result;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			result.data[ i ][ j ] = data[ i ][ 0 ] * m.data[ 0 ][ j ] + data[ i ][ 1 ] * m.data[ 1 ][ j ] + data[ i ][ 2 ] * m.data[ 2 ][ j ];
+	return result;
+}
+
+
 //-------------------------------------------
 // AFFINE TRANSFORM 3 CLASS
 //-------------------------------------------
@@ -157,6 +178,332 @@ AffineTransform3 AffineTransform3::inverse() const {
 }
 
 
+/// compose transformations: the result applies t and then this transformation
+AffineTransform3 AffineTransform3::operator*( const AffineTransform3 &t ) const {
+	AffineTransform3 result;
+	result.a = a * t.a;
+	result.b = transform( t.b );
+	return result;
+}
+
+
+//-------------------------------------------
+// POINT SET STATS
+//-------------------------------------------
+
+
+/// root-mean-square distance between the transformed points and the target points
+double PointSetStats::rmsError() const {
+	return count ? sqrt( sumSqError / count ) : 0;
+}
+
+
+/// clear the stats
+void PointSetStats::reset() {
+	minBound = Point3D( DBL_MAX, DBL_MAX, DBL_MAX );
+	maxBound = Point3D( -DBL_MAX, -DBL_MAX, -DBL_MAX );
+	sumSqError = 0;
+	maxSqError = 0;
+	count = 0;
+}
+
+
+/// add stats from another set of points
+void PointSetStats::merge( const PointSetStats &stats ) {
+	if (stats.minBound.x < minBound.x) minBound.x = stats.minBound.x;
+	if (stats.minBound.y < minBound.y) minBound.y = stats.minBound.y;
+	if (stats.minBound.z < minBound.z) minBound.z = stats.minBound.z;
+	if (stats.maxBound.x > maxBound.x) maxBound.x = stats.maxBound.x;
+	if (stats.maxBound.y > maxBound.y) maxBound.y = stats.maxBound.y;
+	if (stats.maxBound.z > maxBound.z) maxBound.z = stats.maxBound.z;
+	if (stats.maxSqError > maxSqError) maxSqError = stats.maxSqError;
+	sumSqError += stats.sumSqError;
+	count += stats.count;
+}
+
+
+//-------------------------------------------
+// BATCH TRANSFORM KERNELS
+//-------------------------------------------
+
+
+// scalar arithmetic with the same interface as the SIMD lane classes below
+template <typename T> class ScalarLanes {
+public:
+	typedef T Value;
+	static const int width = 1;
+	static inline T load( const T *p ) { return *p; }
+	static inline void store( T *p, T v ) { *p = v; }
+	static inline T set( T v ) { return v; }
+	static inline T add( T a, T b ) { return a + b; }
+	static inline T sub( T a, T b ) { return a - b; }
+	static inline T mul( T a, T b ) { return a * b; }
+	static inline T min( T a, T b ) { return a < b ? a : b; }
+	static inline T max( T a, T b ) { return a > b ? a : b; }
+};
+
+
+#ifdef __SSE2__
+
+
+// four float values per SSE register
+class FloatLanes {
+public:
+	typedef __m128 Value;
+	static const int width = 4;
+	static inline __m128 load( const float *p ) { return _mm_loadu_ps( p ); }
+	static inline void store( float *p, __m128 v ) { _mm_storeu_ps( p, v ); }
+	static inline __m128 set( float v ) { return _mm_set1_ps( v ); }
+	static inline __m128 add( __m128 a, __m128 b ) { return _mm_add_ps( a, b ); }
+	static inline __m128 sub( __m128 a, __m128 b ) { return _mm_sub_ps( a, b ); }
+	static inline __m128 mul( __m128 a, __m128 b ) { return _mm_mul_ps( a, b ); }
+	static inline __m128 min( __m128 a, __m128 b ) { return _mm_min_ps( a, b ); }
+	static inline __m128 max( __m128 a, __m128 b ) { return _mm_max_ps( a, b ); }
+};
+
+
+// two double values per SSE register
+class DoubleLanes {
+public:
+	typedef __m128d Value;
+	static const int width = 2;
+	static inline __m128d load( const double *p ) { return _mm_loadu_pd( p ); }
+	static inline void store( double *p, __m128d v ) { _mm_storeu_pd( p, v ); }
+	static inline __m128d set( double v ) { return _mm_set1_pd( v ); }
+	static inline __m128d add( __m128d a, __m128d b ) { return _mm_add_pd( a, b ); }
+	static inline __m128d sub( __m128d a, __m128d b ) { return _mm_sub_pd( a, b ); }
+	static inline __m128d mul( __m128d a, __m128d b ) { return _mm_mul_pd( a, b ); }
+	static inline __m128d min( __m128d a, __m128d b ) { return _mm_min_pd( a, b ); }
+	static inline __m128d max( __m128d a, __m128d b ) { return _mm_max_pd( a, b ); }
+};
+
+
+#endif // __SSE2__
+
+
+// selects the widest available lane class for a value type
+template <typename T> class SimdLanes { public: typedef ScalarLanes<T> Type; };
+#ifdef __SSE2__
+template <> class SimdLanes<float> { public: typedef FloatLanes Type; };
+template <> class SimdLanes<double> { public: typedef DoubleLanes Type; };
+#endif
+
+
+// the coordinate arrays used by the batch transform kernels; the z pointers are unused for 2D points
+template <typename T> class PointArrays {
+public:
+	const T *x;
+	const T *y;
+	const T *z;
+	T *xOut;
+	T *yOut;
+	T *zOut;
+	const T *xTarget;
+	const T *yTarget;
+	const T *zTarget;
+};
+
+
+// transform points [begin, end) using the given lane class (end - begin must be a multiple of the lane width);
+// coef holds the translation followed by the row-major 3x3 matrix (only the upper-left 2x2 block is used for 2D points);
+// the operation order matches AffineTransform3::transform so that double results are identical to the per-point path
+template <typename T, typename L, bool is3D> void transformBlock( const T *coef, const PointArrays<T> &arrays, int begin, int end, bool computeStats, PointSetStats &stats ) {
+	typedef typename L::Value V;
+	V bx = L::set( coef[ 0 ] ), by = L::set( coef[ 1 ] ), bz = L::set( coef[ 2 ] );
+	V a00 = L::set( coef[ 3 ] ), a01 = L::set( coef[ 4 ] ), a02 = L::set( coef[ 5 ] );
+	V a10 = L::set( coef[ 6 ] ), a11 = L::set( coef[ 7 ] ), a12 = L::set( coef[ 8 ] );
+	V a20 = L::set( coef[ 9 ] ), a21 = L::set( coef[ 10 ] ), a22 = L::set( coef[ 11 ] );
+	V xMin = L::set( (T) HUGE_VAL ), yMin = xMin, zMin = xMin;
+	V xMax = L::set( (T) -HUGE_VAL ), yMax = xMax, zMax = xMax;
+	V errSum = L::set( 0 ), errMax = L::set( 0 );
+	bool useTarget = arrays.xTarget != NULL;
+	for (int i = begin; i < end; i += L::width) {
+		V px = L::load( arrays.x + i );
+		V py = L::load( arrays.y + i );
+		V qx, qy, qz;
+		if (is3D) {
+			V pz = L::load( arrays.z + i );
+			qx = L::add( bx, L::add( L::add( L::mul( px, a00 ), L::mul( py, a01 ) ), L::mul( pz, a02 ) ) );
+			qy = L::add( by, L::add( L::add( L::mul( px, a10 ), L::mul( py, a11 ) ), L::mul( pz, a12 ) ) );
+			qz = L::add( bz, L::add( L::add( L::mul( px, a20 ), L::mul( py, a21 ) ), L::mul( pz, a22 ) ) );
+			L::store( arrays.zOut + i, qz );
+		} else {
+			qx = L::add( bx, L::add( L::mul( px, a00 ), L::mul( py, a01 ) ) );
+			qy = L::add( by, L::add( L::mul( px, a10 ), L::mul( py, a11 ) ) );
+			qz = bz;
+		}
+		L::store( arrays.xOut + i, qx );
+		L::store( arrays.yOut + i, qy );
+		if (computeStats) {
+			xMin = L::min( xMin, qx );
+			yMin = L::min( yMin, qy );
+			xMax = L::max( xMax, qx );
+			yMax = L::max( yMax, qy );
+			if (is3D) {
+				zMin = L::min( zMin, qz );
+				zMax = L::max( zMax, qz );
+			}
+			if (useTarget) {
+				V dx = L::sub( qx, L::load( arrays.xTarget + i ) );
+				V dy = L::sub( qy, L::load( arrays.yTarget + i ) );
+				V err = L::add( L::mul( dx, dx ), L::mul( dy, dy ) );
+				if (is3D) {
+					V dz = L::sub( qz, L::load( arrays.zTarget + i ) );
+					err = L::add( err, L::mul( dz, dz ) );
+				}
+				errSum = L::add( errSum, err );
+				errMax = L::max( errMax, err );
+			}
+		}
+	}
+
+	// fold the lanes into the stats
+	if (computeStats && end > begin) {
+		T lanes[ 8 ][ L::width ];
+		L::store( lanes[ 0 ], xMin );
+		L::store( lanes[ 1 ], yMin );
+		L::store( lanes[ 2 ], zMin );
+		L::store( lanes[ 3 ], xMax );
+		L::store( lanes[ 4 ], yMax );
+		L::store( lanes[ 5 ], zMax );
+		L::store( lanes[ 6 ], errSum );
+		L::store( lanes[ 7 ], errMax );
+		PointSetStats blockStats;
+		if (is3D == false) {
+			blockStats.minBound.z = 0;
+			blockStats.maxBound.z = 0;
+		}
+		for (int j = 0; j < L::width; j++) {
+			if (lanes[ 0 ][ j ] < blockStats.minBound.x) blockStats.minBound.x = lanes[ 0 ][ j ];
+			if (lanes[ 1 ][ j ] < blockStats.minBound.y) blockStats.minBound.y = lanes[ 1 ][ j ];
+			if (is3D && lanes[ 2 ][ j ] < blockStats.minBound.z) blockStats.minBound.z = lanes[ 2 ][ j ];
+			if (lanes[ 3 ][ j ] > blockStats.maxBound.x) blockStats.maxBound.x = lanes[ 3 ][ j ];
+			if (lanes[ 4 ][ j ] > blockStats.maxBound.y) blockStats.maxBound.y = lanes[ 4 ][ j ];
+			if (is3D && lanes[ 5 ][ j ] > blockStats.maxBound.z) blockStats.maxBound.z = lanes[ 5 ][ j ];
+			blockStats.sumSqError += lanes[ 6 ][ j ];
+			if (lanes[ 7 ][ j ] > blockStats.maxSqError) blockStats.maxSqError = lanes[ 7 ][ j ];
+		}
+		blockStats.count = end - begin;
+		stats.merge( blockStats );
+	}
+}
+
+
+// transform points [begin, end) in blocks (so that float error sums are moved into double precision stats
+// every few hundred points), using SIMD lanes where available and scalar code for the remainder of each block
+template <typename T, bool is3D> void transformRange( const T *coef, const PointArrays<T> &arrays, int begin, int end, bool computeStats, PointSetStats &stats ) {
+	typedef typename SimdLanes<T>::Type L;
+	const int blockSize = 1024;
+	while (begin < end) {
+		int blockEnd = begin + blockSize;
+		if (blockEnd > end)
+			blockEnd = end;
+		int simdEnd = begin + (blockEnd - begin) / L::width * L::width;
+		transformBlock<T, L, is3D>( coef, arrays, begin, simdEnd, computeStats, stats );
+		transformBlock<T, ScalarLanes<T>, is3D>( coef, arrays, simdEnd, blockEnd, computeStats, stats );
+		begin = blockEnd;
+	}
+}
+
+
+// transform a set of points using the worker threads, merging the per-range stats (if requested)
+template <typename T, bool is3D> void transformPointArrays( const T *coef, const PointArrays<T> &arrays, int count, PointSetStats *stats ) {
+	if (stats)
+		stats->reset();
+	std::mutex statsMutex;
+	parallelFor( 0, count, 16384, [&]( int begin, int end ) {
+		PointSetStats rangeStats;
+		transformRange<T, is3D>( coef, arrays, begin, end, stats != NULL, rangeStats );
+		if (stats) {
+			std::lock_guard<std::mutex> lock( statsMutex );
+			stats->merge( rangeStats );
+		}
+	});
+}
+
+
+// apply a 3D transformation to a set of points (see transformPoints)
+template <typename T> void transformPointSet( const AffineTransform3 &transform, const PointSet3<T> &input, PointSet3<T> &output, PointSetStats *stats, const PointSet3<T> *target ) {
+	int count = input.count();
+	assertAlways( target == NULL || target->count() == count );
+	if (output.count() != count)
+		output.setCount( count );
+	T coef[ 12 ];
+	coef[ 0 ] = (T) transform.b.x;
+	coef[ 1 ] = (T) transform.b.y;
+	coef[ 2 ] = (T) transform.b.z;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			coef[ 3 + i * 3 + j ] = (T) transform.a.data[ i ][ j ];
+	PointArrays<T> arrays;
+	arrays.x = input.x.dataPtr();
+	arrays.y = input.y.dataPtr();
+	arrays.z = input.z.dataPtr();
+	arrays.xOut = output.x.dataPtr();
+	arrays.yOut = output.y.dataPtr();
+	arrays.zOut = output.z.dataPtr();
+	arrays.xTarget = target ? target->x.dataPtr() : NULL;
+	arrays.yTarget = target ? target->y.dataPtr() : NULL;
+	arrays.zTarget = target ? target->z.dataPtr() : NULL;
+	transformPointArrays<T, true>( coef, arrays, count, stats );
+}
+
+
+// apply a 2D affine transformation to a set of points (see transformPoints)
+template <typename T> void transformPointSet( const double *params, const PointSet2<T> &input, PointSet2<T> &output, PointSetStats *stats, const PointSet2<T> *target ) {
+	int count = input.count();
+	assertAlways( target == NULL || target->count() == count );
+	if (output.count() != count)
+		output.setCount( count );
+	T coef[ 12 ] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	coef[ 0 ] = (T) params[ 0 ];
+	coef[ 1 ] = (T) params[ 1 ];
+	coef[ 3 ] = (T) params[ 2 ];
+	coef[ 4 ] = (T) params[ 4 ];
+	coef[ 6 ] = (T) params[ 3 ];
+	coef[ 7 ] = (T) params[ 5 ];
+	PointArrays<T> arrays;
+	arrays.x = input.x.dataPtr();
+	arrays.y = input.y.dataPtr();
+	arrays.z = NULL;
+	arrays.xOut = output.x.dataPtr();
+	arrays.yOut = output.y.dataPtr();
+	arrays.zOut = NULL;
+	arrays.xTarget = target ? target->x.dataPtr() : NULL;
+	arrays.yTarget = target ? target->y.dataPtr() : NULL;
+	arrays.zTarget = NULL;
+	transformPointArrays<T, false>( coef, arrays, count, stats );
+}
+
+
+//-------------------------------------------
+// BATCH POINT TRANSFORMS
+//-------------------------------------------
+
+
+/// apply a 3D transformation to each point of the input set, storing the results in the output set
+void transformPoints( const AffineTransform3 &transform, const PointSet3F &input, PointSet3F &output, PointSetStats *stats, const PointSet3F *target ) {
+	transformPointSet( transform, input, output, stats, target );
+}
+void transformPoints( const AffineTransform3 &transform, const PointSet3D &input, PointSet3D &output, PointSetStats *stats, const PointSet3D *target ) {
+	transformPointSet( transform, input, output, stats, target );
+}
+
+
+/// apply a 2D affine transformation (with parameters in ImageTransform order) to each point of the input set
+void transformPoints( const double *params, const PointSet2F &input, PointSet2F &output, PointSetStats *stats, const PointSet2F *target ) {
+	transformPointSet( params, input, output, stats, target );
+}
+void transformPoints( const double *params, const PointSet2D &input, PointSet2D &output, PointSetStats *stats, const PointSet2D *target ) {
+	transformPointSet( params, input, output, stats, target );
+}
+
+
+//-------------------------------------------
+// TRANSFORM FILES
+//-------------------------------------------
+
+
 /// load 3D affine transformation parameters from text file
 AffineTransform3 loadTransform( File &file ) {
 	AffineTransform3 transform;
@@ -185,4 +532,168 @@ void saveTransform( File &file, AffineTransform3 &transform ) {
 }
 
 
+//-------------------------------------------
+// TEST / BENCHMARK COMMANDS
+//-------------------------------------------
+
+
+// check batch point transforms against the per-point path
+bool testTransformPoints() {
+	AffineTransform3 t1, t2;
+	t1.setRotation( 0.3, -0.2, 0.7 );
+	t1.setTranslation( 1, -2, 3 );
+	t2.setDiag( 2, 0.5, 1.5 );
+	t2.setOffDiag( 0.1 );
+	t2.setTranslation( -4, 0.5, 2 );
+
+	// create random points and noisy targets; the count exercises the worker threads and the scalar remainder
+	const int count = 40003;
+	randomSeed( 3 );
+	PointSet3D points( count ), target( count ), result;
+	PointSet3F pointsF( count ), targetF( count ), resultF;
+	for (int i = 0; i < count; i++) {
+		Point3 p( randomFloat( -10, 10 ), randomFloat( -10, 10 ), randomFloat( -10, 10 ) );
+		Point3 noise( randomFloat( -0.1f, 0.1f ), randomFloat( -0.1f, 0.1f ), randomFloat( -0.1f, 0.1f ) );
+		points.setPoint( i, p );
+		target.setPoint( i, t1.transform( p ) + noise );
+		pointsF.setPoint( i, point3DtoF( points.point( i ) ) );
+		targetF.setPoint( i, point3DtoF( target.point( i ) ) );
+	}
+
+	// double results and stats should match the per-point path
+	PointSetStats stats;
+	transformPoints( t1, points, result, &stats, &target );
+	PointSetStats expected;
+	bool exactOk = true;
+	for (int i = 0; i < count; i++) {
+		Point3 p = t1.transform( points.point( i ) );
+		Point3 r = result.point( i );
+		if (p.x != r.x || p.y != r.y || p.z != r.z)
+			exactOk = false;
+		if (p.x < expected.minBound.x) expected.minBound.x = p.x;
+		if (p.z > expected.maxBound.z) expected.maxBound.z = p.z;
+		Point3 d = p - target.point( i );
+		double sqErr = d.x * d.x + d.y * d.y + d.z * d.z;
+		expected.sumSqError += sqErr;
+		if (sqErr > expected.maxSqError) expected.maxSqError = sqErr;
+	}
+	unitAssert( exactOk );
+	unitAssert( stats.count == count );
+	unitAssert( stats.minBound.x == expected.minBound.x && stats.maxBound.z == expected.maxBound.z );
+	unitAssert( stats.maxSqError == expected.maxSqError );
+	unitAssert( fabs( stats.sumSqError - expected.sumSqError ) < 1e-9 * expected.sumSqError );
+
+	// float results should be close to double results
+	PointSetStats statsF;
+	transformPoints( t1, pointsF, resultF, &statsF, &targetF );
+	double maxDiff = 0;
+	for (int i = 0; i < count; i++) {
+		Point3 d = point3FtoD( resultF.point( i ) ) - result.point( i );
+		maxDiff = max( maxDiff, max( fabs( d.x ), max( fabs( d.y ), fabs( d.z ) ) ) );
+	}
+	unitAssert( maxDiff < 1e-4 );
+	unitAssert( fabs( statsF.rmsError() - stats.rmsError() ) < 1e-3 * stats.rmsError() );
+
+	// composed transform should match applying the transforms in sequence; inverse (in place) should restore the points
+	AffineTransform3 t21 = t2 * t1;
+	Point3 p = points.point( 17 );
+	Point3 d = t21.transform( p ) - t2.transform( t1.transform( p ) );
+	unitAssert( fabs( d.x ) + fabs( d.y ) + fabs( d.z ) < 1e-9 );
+	transformPoints( t1.inverse(), result, result );
+	d = result.point( 17 ) - p;
+	unitAssert( fabs( d.x ) + fabs( d.y ) + fabs( d.z ) < 1e-9 );
+
+	// 2D transform with bounds
+	double params[ 6 ] = { 3, -1, 1.1, 0.2, -0.3, 0.9 };
+	PointSet2D points2( 7 ), result2;
+	for (int i = 0; i < 7; i++)
+		points2.setPoint( i, Point2( i, 2 * i ) );
+	PointSetStats stats2;
+	transformPoints( params, points2, result2, &stats2 );
+	unitAssert( fabs( result2.x[ 6 ] - (3 + 1.1 * 6 - 0.3 * 12) ) < 1e-12 );
+	unitAssert( fabs( result2.y[ 6 ] - (-1 + 0.2 * 6 + 0.9 * 12) ) < 1e-12 );
+	unitAssert( stats2.minBound.x == 3 && stats2.maxBound.y == result2.y[ 6 ] && stats2.minBound.z == 0 );
+	return true;
+}
+
+
+// compare batch point transforms with the per-point path
+void benchmarkTransformPoints( Config &conf ) {
+
+	// get command parameters
+	int count = conf.readInt( "count", 1000000 );
+	if (conf.initialPass())
+		return;
+
+	// create random points
+	AffineTransform3 transform;
+	transform.setRotation( 0.3, -0.2, 0.7 );
+	transform.setTranslation( 1, -2, 3 );
+	Point3 *points = new Point3[ count ];
+	Point3 *output = new Point3[ count ];
+	PointSet3D pointSet( count ), outputSet( count );
+	PointSet3F pointSetF( count ), outputSetF( count );
+	for (int i = 0; i < count; i++) {
+		points[ i ] = Point3( randomFloat( -10, 10 ), randomFloat( -10, 10 ), randomFloat( -10, 10 ) );
+		pointSet.setPoint( i, points[ i ] );
+		pointSetF.setPoint( i, point3DtoF( points[ i ] ) );
+	}
+	double checkSum = 0;
+
+	// per-point path
+	Timer timer;
+	timer.start();
+	for (int i = 0; i < count; i++)
+		output[ i ] = transform.transform( points[ i ] );
+	timer.stop();
+	checkSum += output[ count / 2 ].x;
+	disp( 1, "per point: %.1f M/sec", (double) count / timer.timeSum() * 1e-6 );
+
+	// per-point path with inverse computed for each point (as in callers that map points backward one at a time)
+	timer.reset();
+	timer.start();
+	for (int i = 0; i < count; i++)
+		output[ i ] = transform.inverse().transform( points[ i ] );
+	timer.stop();
+	checkSum += output[ count / 2 ].x;
+	disp( 1, "per point inverse: %.1f M/sec", (double) count / timer.timeSum() * 1e-6 );
+
+	// batch paths
+	timer.reset();
+	timer.start();
+	transformPoints( transform, pointSet, outputSet );
+	timer.stop();
+	checkSum += outputSet.x[ count / 2 ];
+	disp( 1, "batch double (%d threads): %.1f M/sec", threadCount(), (double) count / timer.timeSum() * 1e-6 );
+	timer.reset();
+	timer.start();
+	transformPoints( transform, pointSetF, outputSetF );
+	timer.stop();
+	checkSum += outputSetF.x[ count / 2 ];
+	disp( 1, "batch float (%d threads): %.1f M/sec", threadCount(), (double) count / timer.timeSum() * 1e-6 );
+	PointSetStats stats;
+	timer.reset();
+	timer.start();
+	transformPoints( transform, pointSetF, outputSetF, &stats, &pointSetF );
+	timer.stop();
+	checkSum += stats.rmsError();
+	disp( 1, "batch float with bounds and error (%d threads): %.1f M/sec", threadCount(), (double) count / timer.timeSum() * 1e-6 );
+	disp( 2, "checksum: %f", checkSum );
+	delete [] points;
+	delete [] output;
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initGeometry() {
+	registerUnitTest( testTransformPoints );
+	registerCommand( "benchtransform", benchmarkTransformPoints );
+}
+
+
 } // end namespace sbl
@@ -1,36 +1,371 @@
 #include <sbl/math/MathUtil.h>
 #include <sbl/core/Display.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/system/Timer.h>
 #include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 namespace sbl {
 
 
-/// returns a random float between 0.0 and 1.0;
-/// note: this isn't a very good random number
-float randomFloat() {
-	double r = (double) randomInt( 0, 10000 );
-	return (float) (r / 10000.0);
+//-------------------------------------------
+// RANDOM GENERATOR CLASS
+//-------------------------------------------
+
+
+/// splitmix64 step; used to expand seeds into generator states
+inline unsigned long long splitMix( unsigned long long &x ) {
+	x += 0x9E3779B97F4A7C15ULL;
+	unsigned long long z = x;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+
+/// restart the generator with the given seed and stream
+void RandomGenerator::setSeed( unsigned long long seed, unsigned long long streamIndex ) {
+	unsigned long long x = seed;
+	x ^= splitMix( streamIndex ); // decorrelate nearby stream indices
+	for (int i = 0; i < 4; i++)
+		m_state[ i ] = splitMix( x );
+	if (m_state[ 0 ] == 0 && m_state[ 1 ] == 0 && m_state[ 2 ] == 0 && m_state[ 3 ] == 0)
+		m_state[ 0 ] = 1;
+	m_hasSpareGaussian = false;
+	m_spareGaussian = 0;
+}
+
+
+/// returns an integer in [min, max] (without modulo bias)
+int RandomGenerator::uniformInt( int min, int max ) {
+	assertDebug( max >= min );
+	unsigned long long range = (unsigned long long) ((long long) max - (long long) min) + 1;
+
+	// multiply a 32-bit value by the range and keep the high bits; reject the few values that would cause bias
+	unsigned long long product = (next() >> 32) * range;
+	unsigned int low = (unsigned int) product;
+	if (low < range) {
+		unsigned int threshold = (unsigned int) ((0x100000000ULL - range) % range);
+		while (low < threshold) {
+			product = (next() >> 32) * range;
+			low = (unsigned int) product;
+		}
+	}
+	return (int) ((long long) min + (long long) (product >> 32));
+}
+
+
+/// returns a sample from a normal distribution with zero mean and unit variance (Marsaglia polar method)
+float RandomGenerator::gaussian() {
+	if (m_hasSpareGaussian) {
+		m_hasSpareGaussian = false;
+		return m_spareGaussian;
+	}
+	double u = 0, v = 0, s = 0;
+	do {
+		u = 2.0 * uniformDouble() - 1.0;
+		v = 2.0 * uniformDouble() - 1.0;
+		s = u * u + v * v;
+	} while (s >= 1.0 || s == 0.0);
+	double factor = sqrt( -2.0 * log( s ) / s );
+	m_spareGaussian = (float) (v * factor);
+	m_hasSpareGaussian = true;
+	return (float) (u * factor);
+}
+
+
+/// fill an array with values sampled uniformly between min and max (vectorized);
+/// uses four interleaved xoshiro128+ lanes seeded from this generator, keeping the top 24 bits of each output
+void RandomGenerator::fillUniform( float *data, int count, float min, float max ) {
+	unsigned int lanes[ 4 ][ 4 ]; // [ state word ][ lane ]
+	for (int j = 0; j < 4; j++) {
+		unsigned long long a = next(), b = next();
+		lanes[ 0 ][ j ] = (unsigned int) a;
+		lanes[ 1 ][ j ] = (unsigned int) (a >> 32);
+		lanes[ 2 ][ j ] = (unsigned int) b;
+		lanes[ 3 ][ j ] = (unsigned int) (b >> 32) | 1; // lane state is never all zero
+	}
+	float scale = (max - min) * (1.0f / 16777216.0f);
+	int i = 0;
+#ifdef __SSE2__
+	__m128i s0 = _mm_loadu_si128( (const __m128i *) lanes[ 0 ] );
+	__m128i s1 = _mm_loadu_si128( (const __m128i *) lanes[ 1 ] );
+	__m128i s2 = _mm_loadu_si128( (const __m128i *) lanes[ 2 ] );
+	__m128i s3 = _mm_loadu_si128( (const __m128i *) lanes[ 3 ] );
+	__m128 scaleVect = _mm_set1_ps( scale );
+	__m128 minVect = _mm_set1_ps( min );
+	for (; i + 4 <= count; i += 4) {
+		__m128i result = _mm_add_epi32( s0, s3 );
+		__m128i t = _mm_slli_epi32( s1, 9 );
+		s2 = _mm_xor_si128( s2, s0 );
+		s3 = _mm_xor_si128( s3, s1 );
+		s1 = _mm_xor_si128( s1, s2 );
+		s0 = _mm_xor_si128( s0, s3 );
+		s2 = _mm_xor_si128( s2, t );
+		s3 = _mm_or_si128( _mm_slli_epi32( s3, 11 ), _mm_srli_epi32( s3, 21 ) );
+		__m128 value = _mm_cvtepi32_ps( _mm_srli_epi32( result, 8 ) );
+		_mm_storeu_ps( data + i, _mm_add_ps( minVect, _mm_mul_ps( value, scaleVect ) ) );
+	}
+	_mm_storeu_si128( (__m128i *) lanes[ 0 ], s0 );
+	_mm_storeu_si128( (__m128i *) lanes[ 1 ], s1 );
+	_mm_storeu_si128( (__m128i *) lanes[ 2 ], s2 );
+	_mm_storeu_si128( (__m128i *) lanes[ 3 ], s3 );
+#endif
+
+	// scalar version of the same lanes (for the remainder, or for the whole array without SSE2)
+	while (i < count) {
+		for (int j = 0; j < 4; j++) {
+			unsigned int result = lanes[ 0 ][ j ] + lanes[ 3 ][ j ];
+			unsigned int t = lanes[ 1 ][ j ] << 9;
+			lanes[ 2 ][ j ] ^= lanes[ 0 ][ j ];
+			lanes[ 3 ][ j ] ^= lanes[ 1 ][ j ];
+			lanes[ 1 ][ j ] ^= lanes[ 2 ][ j ];
+			lanes[ 0 ][ j ] ^= lanes[ 3 ][ j ];
+			lanes[ 2 ][ j ] ^= t;
+			lanes[ 3 ][ j ] = (lanes[ 3 ][ j ] << 11) | (lanes[ 3 ][ j ] >> 21);
+			if (i + j < count)
+				data[ i + j ] = min + (float) (result >> 8) * scale;
+		}
+		i += 4;
+	}
 }
 
 
-/// returns a random float between the specified bounds;
-/// note: this isn't a very good random number
-float randomFloat( float min, float max ) {
-	return min + randomFloat() * (max - min);
+/// fill an array with values sampled from a normal distribution (Box-Muller transform of bulk uniform values)
+void RandomGenerator::fillGaussian( float *data, int count, float mean, float sdev ) {
+	const float twoPi = 6.28318530718f;
+	int pairCount = count / 2;
+	fillUniform( data, pairCount * 2, 0.0f, 1.0f );
+	for (int i = 0; i < pairCount; i++) {
+		float u1 = 1.0f - data[ 2 * i ]; // in (0, 1]
+		float u2 = data[ 2 * i + 1 ];
+		float radius = sdev * sqrtf( -2.0f * logf( u1 ) );
+		float angle = twoPi * u2;
+		data[ 2 * i ] = mean + radius * cosf( angle );
+		data[ 2 * i + 1 ] = mean + radius * sinf( angle );
+	}
+	if (count & 1)
+		data[ count - 1 ] = mean + sdev * gaussian();
 }
 
 
-/// returns a random integer within specified bounds;
-/// note: this isn't a very good random number
-int randomInt( int min, int max ) {
-	assertDebug( max > min );
-	return min + rand() % (max - min + 1);
+//-------------------------------------------
+// PER-THREAD RANDOM GENERATORS
+//-------------------------------------------
+
+
+// the seed from which all per-thread streams are derived
+unsigned long long g_randomSeed = 0;
+
+
+// incremented when the seed changes, so that each thread restarts its stream
+std::atomic<int> g_randomSeedVersion( 0 );
+
+
+// the next stream index to assign to a thread
+std::atomic<int> g_nextRandomStream( 0 );
+
+
+// each thread's generator, stream index, and the seed version it was seeded from
+thread_local RandomGenerator t_randomGenerator;
+thread_local int t_randomStream = -1;
+thread_local int t_randomSeedVersion = -1;
+
+
+/// the calling thread's random number generator
+RandomGenerator &randomGenerator() {
+	int seedVersion = g_randomSeedVersion.load();
+	if (t_randomSeedVersion != seedVersion) {
+		t_randomStream = g_nextRandomStream.fetch_add( 1 );
+		t_randomSeedVersion = seedVersion;
+		t_randomGenerator.setSeed( g_randomSeed, t_randomStream );
+	}
+	return t_randomGenerator;
 }
 
 
-/// set the random number generator seed;
-/// note: this isn't a very good random number
+/// set the random number generator seed; restarts the streams of all threads
 void randomSeed( int seed ) {
-	srand( seed );
+	g_randomSeed = (unsigned long long) (long long) seed;
+	g_nextRandomStream = 1;
+	int seedVersion = g_randomSeedVersion.fetch_add( 1 ) + 1;
+	t_randomStream = 0;
+	t_randomSeedVersion = seedVersion;
+	t_randomGenerator.setSeed( g_randomSeed, 0 );
+}
+
+
+// number of values per independently-seeded block in parallel fills
+const int g_randomBlockSize = 4096;
+
+
+/// fill an array with values sampled uniformly between min and max (in parallel, independent of thread count)
+void randomFillUniform( float *data, int count, float min, float max ) {
+	unsigned long long seed = randomGenerator().next();
+	int blockCount = (count + g_randomBlockSize - 1) / g_randomBlockSize;
+	parallelFor( 0, blockCount, 4, [&]( int blockBegin, int blockEnd ) {
+		for (int block = blockBegin; block < blockEnd; block++) {
+			int start = block * g_randomBlockSize;
+			int blockLength = count - start < g_randomBlockSize ? count - start : g_randomBlockSize;
+			RandomGenerator generator( seed, block );
+			generator.fillUniform( data + start, blockLength, min, max );
+		}
+	});
+}
+
+
+/// fill an array with values sampled from a normal distribution (in parallel, independent of thread count)
+void randomFillGaussian( float *data, int count, float mean, float sdev ) {
+	unsigned long long seed = randomGenerator().next();
+	int blockCount = (count + g_randomBlockSize - 1) / g_randomBlockSize;
+	parallelFor( 0, blockCount, 1, [&]( int blockBegin, int blockEnd ) {
+		for (int block = blockBegin; block < blockEnd; block++) {
+			int start = block * g_randomBlockSize;
+			int blockLength = count - start < g_randomBlockSize ? count - start : g_randomBlockSize;
+			RandomGenerator generator( seed, block );
+			generator.fillGaussian( data + start, blockLength, mean, sdev );
+		}
+	});
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// test uniform and gaussian statistics, bounds, and reproducibility of parallel fills
+bool testRandomGenerator() {
+	const int count = 100003;
+	float *data = new float[ count ];
+	float *data2 = new float[ count ];
+
+	// uniform values should lie in bounds with mean near the center
+	randomSeed( 7 );
+	randomFillUniform( data, count, -1.0f, 3.0f );
+	double sum = 0;
+	bool inBounds = true;
+	for (int i = 0; i < count; i++) {
+		sum += data[ i ];
+		if (data[ i ] < -1.0f || data[ i ] > 3.0f)
+			inBounds = false;
+	}
+	bool uniformOk = inBounds && fabs( sum / count - 1.0 ) < 0.02;
+
+	// the same seed should give the same values, regardless of thread count
+	int oldThreadCount = threadCount();
+	setThreadCount( oldThreadCount > 1 ? 1 : 4 );
+	randomSeed( 7 );
+	randomFillUniform( data2, count, -1.0f, 3.0f );
+	setThreadCount( oldThreadCount );
+	bool repeatOk = memcmp( data, data2, count * sizeof( float ) ) == 0;
+
+	// gaussian values should have the requested mean and standard deviation
+	randomFillGaussian( data, count, 2.0f, 0.5f );
+	double sumSqd = 0;
+	sum = 0;
+	for (int i = 0; i < count; i++) {
+		sum += data[ i ];
+		sumSqd += data[ i ] * data[ i ];
+	}
+	double mean = sum / count;
+	double sdev = sqrt( sumSqd / count - mean * mean );
+	bool gaussianOk = fabs( mean - 2.0 ) < 0.01 && fabs( sdev - 0.5 ) < 0.01;
+	delete [] data;
+	delete [] data2;
+	unitAssert( uniformOk );
+	unitAssert( repeatOk );
+	unitAssert( gaussianOk );
+
+	// integers should cover the full inclusive range
+	int hits[ 5 ] = { 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 10000; i++) {
+		int v = randomInt( -2, 2 );
+		unitAssert( v >= -2 && v <= 2 );
+		hits[ v + 2 ]++;
+	}
+	for (int i = 0; i < 5; i++)
+		unitAssert( hits[ i ] > 1800 && hits[ i ] < 2200 );
+	return true;
+}
+
+
+// the rand()-based generator previously used by randomFloat(); kept for benchmark comparison
+float legacyRandomFloat( float min, float max ) {
+	double r = (double) (rand() % 10001);
+	return min + (float) (r / 10000.0) * (max - min);
+}
+
+
+// compare throughput of random number generation methods
+void benchmarkRandom( Config &conf ) {
+
+	// get command parameters
+	int count = conf.readInt( "count", 10000000 );
+	if (conf.initialPass())
+		return;
+
+	// run each method, accumulating a checksum so that the loops are not optimized away
+	float *data = new float[ count ];
+	double checkSum = 0;
+	Timer timer;
+	timer.start();
+	for (int i = 0; i < count; i++)
+		data[ i ] = legacyRandomFloat( 0.0f, 1.0f );
+	timer.stop();
+	checkSum += data[ count / 2 ];
+	disp( 1, "rand() per value: %.1f M/sec", (double) count / timer.timeSum() * 1e-6 );
+	timer.reset();
+	timer.start();
+	for (int i = 0; i < count; i++)
+		data[ i ] = randomFloat( 0.0f, 1.0f );
+	timer.stop();
+	checkSum += data[ count / 2 ];
+	disp( 1, "randomFloat per value: %.1f M/sec", (double) count / timer.timeSum() * 1e-6 );
+	timer.reset();
+	timer.start();
+	randomGenerator().fillUniform( data, count, 0.0f, 1.0f );
+	timer.stop();
+	checkSum += data[ count / 2 ];
+	disp( 1, "fillUniform (one thread): %.1f M/sec", (double) count / timer.timeSum() * 1e-6 );
+	timer.reset();
+	timer.start();
+	randomFillUniform( data, count, 0.0f, 1.0f );
+	timer.stop();
+	checkSum += data[ count / 2 ];
+	disp( 1, "randomFillUniform (%d threads): %.1f M/sec", threadCount(), (double) count / timer.timeSum() * 1e-6 );
+	timer.reset();
+	timer.start();
+	for (int i = 0; i < count; i++)
+		data[ i ] = randomGaussian( 0.0f, 1.0f );
+	timer.stop();
+	checkSum += data[ count / 2 ];
+	disp( 1, "randomGaussian per value: %.1f M/sec", (double) count / timer.timeSum() * 1e-6 );
+	timer.reset();
+	timer.start();
+	randomFillGaussian( data, count, 0.0f, 1.0f );
+	timer.stop();
+	checkSum += data[ count / 2 ];
+	disp( 1, "randomFillGaussian (%d threads): %.1f M/sec", threadCount(), (double) count / timer.timeSum() * 1e-6 );
+	disp( 2, "checksum: %f", checkSum );
+	delete [] data;
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initMathUtil() {
+	registerUnitTest( testRandomGenerator );
+	registerCommand( "benchrandom", benchmarkRandom );
 }
 
 
@@ -626,9 +626,15 @@ aptr<MatrixF> toMatrixF( const Array<VectorF> &vectorArray ) {
 /// create a matrix of random values, sampled uniformly between min and max
 aptr<MatrixF> randomMatrixF( int rows, int cols, float min, float max ) {
 	aptr<MatrixF> m( new MatrixF( rows, cols ) );
-	for (int i = 0; i < rows; i++) 
-		for (int j = 0; j < cols; j++)
-			m->data( i, j ) = randomFloat( min, max );
+	randomFillUniform( m->dataVectPtr(), rows * cols, min, max );
+	return m;
+}
+
+
+/// create a matrix of random values, sampled from a normal distribution
+aptr<MatrixF> randomGaussianMatrixF( int rows, int cols, float mean, float sdev ) {
+	aptr<MatrixF> m( new MatrixF( rows, cols ) );
+	randomFillGaussian( m->dataVectPtr(), rows * cols, mean, sdev );
 	return m;
 }
 
@@ -190,19 +190,29 @@ void Optimizer::dispHistoryStats( int indent ) const {
 
 
 /// evaluate objective function at given point, applying a penality to out-of-bounds points
-double Optimizer::evalWithPenalty( const VectorD &point ) {
+double Optimizer::evalWithPenalty( const VectorD &point, double abortValue ) {
 
-	// compute objective function value
-	double obj = m_objective.eval( point );
-
-	// add penalty
+	// compute penalty
+	double penalty = 0;
 	int dim = point.length();
 	for (int j = 0; j < dim; j++) {
 		double v = point[ j ];
 		if (v < m_lBound[ j ]) 
-			obj += m_penaltyFactor * (m_lBound[ j ] - v) / (m_uBound[ j ] - m_lBound[ j ]);
+			penalty += m_penaltyFactor * (m_lBound[ j ] - v) / (m_uBound[ j ] - m_lBound[ j ]);
 		if (v > m_uBound[ j ])
-			obj += m_penaltyFactor * (v - m_uBound[ j ]) / (m_uBound[ j ] - m_lBound[ j ]);
+			penalty += m_penaltyFactor * (v - m_uBound[ j ]) / (m_uBound[ j ] - m_lBound[ j ]);
+	}
+
+	// compute objective function value (allowing the objective to stop early once the total will reach abortValue)
+	double obj = 0;
+	if (abortValue == DBL_MAX) {
+		obj = m_objective.eval( point ) + penalty;
+	} else {
+		double objAbortValue = abortValue - penalty;
+		double objValue = m_objective.evalBounded( point, objAbortValue );
+		obj = objValue + penalty;
+		if (objValue >= objAbortValue && obj < abortValue) // guard against rounding
+			obj = abortValue;
 	}
 
 	// if requested, add to history
@@ -308,10 +318,11 @@ void SimplexOptimizer::step() {
 	}
 
 	// compute point by reflecting across centroid
+	// (the new points are only used if better than the worst point, so their evaluation can stop once they are known to be worse)
 	VectorD reflectedPoint( dim );
 	for (int j = 0; j < dim; j++) 
 		reflectedPoint[ j ] = center[ j ] + (center[ j ] - worstPoint[ j ]);
-	double reflectedValue = evalWithPenalty( reflectedPoint );
+	double reflectedValue = evalWithPenalty( reflectedPoint, m_values[ count - 1 ] );
 	if (m_values[ 0 ] <= reflectedValue && reflectedValue < m_values[ count - 2 ]) {
 		m_values[ count - 1 ] = reflectedValue;
 		m_points[ count - 1 ] = reflectedPoint;
@@ -325,7 +336,7 @@ void SimplexOptimizer::step() {
 		for (int j = 0; j < dim; j++) {
 			expandedPoint[ j ] = center[ j ] + 2.0 * (center[ j ] - worstPoint[ j ]);
 		}
-		double expandedValue = evalWithPenalty( expandedPoint );
+		double expandedValue = evalWithPenalty( expandedPoint, m_values[ count - 1 ] );
 		if (expandedValue < reflectedValue) {
 			m_values[ count - 1 ] = expandedValue;
 			m_points[ count - 1 ] = expandedPoint;
@@ -342,7 +353,7 @@ void SimplexOptimizer::step() {
 	for (int j = 0; j < dim; j++) {
 		contractedPoint[ j ] = worstPoint[ j ] + 0.5 * (center[ j ] - worstPoint[ j ]);
 	}
-	double contractedValue = evalWithPenalty( contractedPoint );
+	double contractedValue = evalWithPenalty( contractedPoint, m_values[ count - 1 ] );
 	if (contractedValue < m_values[ count - 1 ]) {
 		m_values[ count - 1 ] = contractedValue;
 		m_points[ count - 1 ] = contractedPoint;
@@ -2,6 +2,9 @@
 #include <sbl/math/Triangulation.h>
 #include <sbl/math/VectorUtil.h>
 #include <sbl/math/MathUtil.h>
+#include <sbl/core/Parallel.h>
+#include <sbl/core/Command.h>
+#include <sbl/core/UnitTest.h>
 #include <../external/CDT/CDT.h>
 namespace sbl {
 
@@ -127,125 +130,439 @@ aptr<MatrixI> triangulateIndex( const MatrixF &points ) {
 }
 
 
-// stores results computed by PerTriangle
-int g_triCount = 0;
-ImageGrayF *g_triResult = NULL;
-
-
-/// callback used for TriangulationInterpolation
-void perTriangle( Point2d p1, Point2d p2, Point2d p3 ) {
-
-	// get values at points
-	float *pval1 = (float *) p1.tag;
-	float *pval2 = (float *) p2.tag;
-	float *pval3 = (float *) p3.tag;
-	float val1 = pval1 ? *pval1 : 0;
-	float val2 = pval2 ? *pval2 : 0;
-	float val3 = pval3 ? *pval3 : 0;
-
-	// get locations of points
-	float x1 = (float) p1[ 0 ];
-	float y1 = (float) p1[ 1 ];
-	float x2 = (float) p2[ 0 ];
-	float y2 = (float) p2[ 1 ];
-	float x3 = (float) p3[ 0 ];
-	float y3 = (float) p3[ 1 ];
-
-	// prepare for interpolation
-	float ux = x2 - x1;
-	float uy = y2 - y1;
-	float vx = x3 - x1;
-	float vy = y3 - y1;
-	float uVal = val2 - val1;
-	float vVal = val3 - val1;
-	float uStep = 0.5f / ((float) fabs( ux ) + (float) fabs( uy ) + 1);
-	float vStep = 0.5f / ((float) fabs( vx ) + (float) fabs( vy ) + 1);
-
-	// do interpolation
-	for (float uFrac = 0; uFrac <= 1; uFrac += uStep) {
-		for (float vFrac = 0; vFrac <= 1 - uFrac; vFrac += vStep) {
-			float x = x1 + ux * uFrac + vx * vFrac;
-			float y = y1 + uy * uFrac + vy * vFrac;
-			int xInt = round( x ), yInt = round( y );
-			float val = val1 + uVal * uFrac + vVal * vFrac;
-			g_triResult->data( xInt, yInt ) = val;
-		}
+//-------------------------------------------
+// TRIANGULATION INTERPOLATION
+//-------------------------------------------
+
+
+/// The PointGrid class is a uniform grid of point buckets used for nearest-point queries
+/// and for ordering points so that consecutive mesh insertions are spatially close.
+class PointGrid {
+public:
+
+	/// build the grid from the first two columns of the point matrix
+	explicit PointGrid( const MatrixF &points );
+
+	/// index of the point nearest to (x, y); -1 if there are no points
+	int nearest( float x, float y ) const;
+
+	/// point indices ordered by cell (rows of cells, alternating direction)
+	inline const VectorI &order() const { return m_order; }
+
+private:
+
+	// cell containing the given position (clamped to the grid)
+	inline int cellX( float x ) const { int cx = (int) ((x - m_xMin) * m_xScale); return cx < 0 ? 0 : (cx >= m_xCount ? m_xCount - 1 : cx); }
+	inline int cellY( float y ) const { int cy = (int) ((y - m_yMin) * m_yScale); return cy < 0 ? 0 : (cy >= m_yCount ? m_yCount - 1 : cy); }
+
+	// the points
+	const MatrixF &m_points;
+
+	// grid geometry
+	float m_xMin, m_yMin;
+	float m_xScale, m_yScale;
+	float m_minCellSize;
+	int m_xCount, m_yCount;
+
+	// point indices sorted by cell; the points of cell i are m_cellPoints[ m_cellStart[ i ] ... m_cellStart[ i + 1 ] - 1 ]
+	VectorI m_cellStart;
+	VectorI m_cellPoints;
+
+	// point indices in insertion order
+	VectorI m_order;
+};
+
+
+/// build the grid from the first two columns of the point matrix
+PointGrid::PointGrid( const MatrixF &points ) : m_points( points ) {
+	int pointCount = points.rows();
+
+	// get bounds
+	float xMin = 0, xMax = 0, yMin = 0, yMax = 0;
+	for (int i = 0; i < pointCount; i++) {
+		float x = points.data( i, 0 );
+		float y = points.data( i, 1 );
+		if (x < xMin || i == 0) xMin = x;
+		if (x > xMax || i == 0) xMax = x;
+		if (y < yMin || i == 0) yMin = y;
+		if (y > yMax || i == 0) yMax = y;
 	}
 
-	// keep diagnostic info
-	g_triCount++;
+	// choose roughly square cells with about two points per cell
+	float xSize = xMax - xMin + 1.0f, ySize = yMax - yMin + 1.0f;
+	float cellSize = sqrtf( 2.0f * xSize * ySize / (float) (pointCount + 1) );
+	m_xCount = (int) (xSize / cellSize) + 1;
+	m_yCount = (int) (ySize / cellSize) + 1;
+	m_xMin = xMin;
+	m_yMin = yMin;
+	m_xScale = (float) m_xCount / xSize;
+	m_yScale = (float) m_yCount / ySize;
+	m_minCellSize = xSize / (float) m_xCount;
+	if (ySize / (float) m_yCount < m_minCellSize)
+		m_minCellSize = ySize / (float) m_yCount;
+
+	// bucket the points by cell (counting sort)
+	int cellCount = m_xCount * m_yCount;
+	VectorI pointCell( pointCount );
+	m_cellStart.setLength( cellCount + 1 );
+	m_cellStart.clear( 0 );
+	for (int i = 0; i < pointCount; i++) {
+		int cell = cellY( points.data( i, 1 ) ) * m_xCount + cellX( points.data( i, 0 ) );
+		pointCell[ i ] = cell;
+		m_cellStart[ cell + 1 ]++;
+	}
+	for (int i = 0; i < cellCount; i++)
+		m_cellStart[ i + 1 ] += m_cellStart[ i ];
+	VectorI cellPos( m_cellStart );
+	m_cellPoints.setLength( pointCount );
+	for (int i = 0; i < pointCount; i++)
+		m_cellPoints[ cellPos[ pointCell[ i ] ]++ ] = i;
+
+	// walk the rows of cells in alternating directions so that consecutive points are near each other
+	m_order.setLength( pointCount );
+	int orderIndex = 0;
+	for (int cy = 0; cy < m_yCount; cy++) {
+		for (int j = 0; j < m_xCount; j++) {
+			int cx = (cy & 1) ? m_xCount - 1 - j : j;
+			int cell = cy * m_xCount + cx;
+			for (int k = m_cellStart[ cell ]; k < m_cellStart[ cell + 1 ]; k++)
+				m_order[ orderIndex++ ] = m_cellPoints[ k ];
+		}
+	}
 }
 
 
-/// get value of point nearest to query point
-float *nearestValue( float x, float y, const MatrixF &points, VectorF &values ) {
-	int count = points.rows(); 
-	float *value = NULL;
+/// index of the point nearest to (x, y); -1 if there are no points
+int PointGrid::nearest( float x, float y ) const {
+	int cx = cellX( x ), cy = cellY( y );
+	int maxRadius = m_xCount > m_yCount ? m_xCount : m_yCount;
+	int bestIndex = -1;
 	float bestDistSqd = 0;
-	for (int i = 0; i < count; i++) {
-		float xDiff = x - (float) points.data( i, 0 );
-		float yDiff = y - (float) points.data( i, 1 );
-		float distSqd = xDiff * xDiff + yDiff * yDiff;
-		if (distSqd < bestDistSqd || i == 0) {
-			bestDistSqd = distSqd;
-			value = &(values.data( i ));
+
+	// search rings of cells around the query cell until no closer point can be found
+	for (int radius = 0; radius <= maxRadius; radius++) {
+		for (int gy = cy - radius; gy <= cy + radius; gy++) {
+			if (gy < 0 || gy >= m_yCount)
+				continue;
+			bool fullRow = (gy == cy - radius || gy == cy + radius);
+			int gxStep = (fullRow || radius == 0) ? 1 : 2 * radius;
+			for (int gx = cx - radius; gx <= cx + radius; gx += gxStep) {
+				if (gx < 0 || gx >= m_xCount)
+					continue;
+				int cell = gy * m_xCount + gx;
+				for (int k = m_cellStart[ cell ]; k < m_cellStart[ cell + 1 ]; k++) {
+					int i = m_cellPoints[ k ];
+					float xDiff = x - m_points.data( i, 0 );
+					float yDiff = y - m_points.data( i, 1 );
+					float distSqd = xDiff * xDiff + yDiff * yDiff;
+					if (distSqd < bestDistSqd || bestIndex == -1) {
+						bestDistSqd = distSqd;
+						bestIndex = i;
+					}
+				}
+			}
 		}
+
+		// points in outer rings are at least radius cells away
+		float minOuterDist = (float) radius * m_minCellSize;
+		if (bestIndex >= 0 && bestDistSqd <= minOuterDist * minOuterDist)
+			break;
 	}
-	return value;
+	return bestIndex;
 }
 
 
-/// use triangulation to interpolate values across an image
-aptr<ImageGrayF> triangulationInterpolation( const MatrixF &points, VectorF &values, int width, int height ) {
-	ImageGrayF *result = new ImageGrayF( width, height );
-	result->clear( -777 );
+/// The TriangleSet class holds the triangles of a mesh along with the point index of each corner.
+class TriangleSet {
+public:
 
-	// create mesh using image bounds
-	float xMin = 0, xMax = (float) (width - 1), yMin = 0, yMax = (float) (height - 1);
-	Mesh *mesh = new Mesh( Point2d( xMin, yMin, nearestValue( xMin, yMin, points, values ) ),
-						   Point2d( xMax, yMin, nearestValue( xMax, yMin, points, values ) ),
-						   Point2d( xMax, yMax, nearestValue( xMax, yMax, points, values ) ),
-						   Point2d( xMin, yMax, nearestValue( xMin, yMax, points, values ) ) );
+	// corner positions: x1, y1, x2, y2, x3, y3 for each triangle
+	VectorF coords;
 
-	// add points
+	// corner point indices (or -1 if the corner has no point) for each triangle
+	VectorI indices;
+};
+
+
+/// callback used to collect mesh triangles into a TriangleSet
+void collectTriangle( Point2d p1, Point2d p2, Point2d p3, void *data ) {
+	TriangleSet *triangleSet = (TriangleSet *) data;
+	triangleSet->coords.append( (float) p1[ 0 ] );
+	triangleSet->coords.append( (float) p1[ 1 ] );
+	triangleSet->coords.append( (float) p2[ 0 ] );
+	triangleSet->coords.append( (float) p2[ 1 ] );
+	triangleSet->coords.append( (float) p3[ 0 ] );
+	triangleSet->coords.append( (float) p3[ 1 ] );
+	triangleSet->indices.append( p1.tag ? *((int *) p1.tag) : -1 );
+	triangleSet->indices.append( p2.tag ? *((int *) p2.tag) : -1 );
+	triangleSet->indices.append( p3.tag ? *((int *) p3.tag) : -1 );
+}
+
+
+/// rasterize a triangle into rows [yBegin, yEnd) of the output images, evaluating the plane through
+/// the corner values of each channel; marks covered pixels in the coverage mask
+void rasterizeTriangle( const float *coords, const int *indices, const MatrixF &values, int yBegin, int yEnd,
+						PtrArray<ImageGrayF> &images, ImageGrayU &coverage ) {
+	double x1 = coords[ 0 ], y1 = coords[ 1 ];
+	double x2 = coords[ 2 ], y2 = coords[ 3 ];
+	double x3 = coords[ 4 ], y3 = coords[ 5 ];
+
+	// skip degenerate triangles (their pixels are covered by neighbors or filled afterward)
+	double det = (x2 - x1) * (y3 - y1) - (x3 - x1) * (y2 - y1);
+	if (fabs( det ) < 1e-8)
+		return;
+	double sign = det > 0 ? 1.0 : -1.0;
+
+	// edge functions e(x, y) = a * x + b * y + c, non-negative inside the triangle
+	double xa[ 3 ] = { x1, x2, x3 }, ya[ 3 ] = { y1, y2, y3 };
+	double edgeA[ 3 ], edgeB[ 3 ], edgeC[ 3 ];
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		edgeA[ i ] = -sign * (ya[ j ] - ya[ i ]);
+		edgeB[ i ] = sign * (xa[ j ] - xa[ i ]);
+		edgeC[ i ] = sign * ((ya[ j ] - ya[ i ]) * xa[ i ] - (xa[ j ] - xa[ i ]) * ya[ i ]);
+
+		// include pixels on (or within round-off of) the edge so that shared edges leave no gaps
+		edgeC[ i ] += 1e-4 * (fabs( edgeA[ i ] ) + fabs( edgeB[ i ] ));
+	}
+
+	// row range covered by the triangle
+	double yMin = y1, yMax = y1;
+	if (y2 < yMin) yMin = y2;
+	if (y3 < yMin) yMin = y3;
+	if (y2 > yMax) yMax = y2;
+	if (y3 > yMax) yMax = y3;
+	int yStart = (int) ceil( yMin - 1e-4 ), yStop = (int) floor( yMax + 1e-4 ) + 1;
+	if (yStart < yBegin) yStart = yBegin;
+	if (yStop > yEnd) yStop = yEnd;
+
+	// plane coefficients for each channel: value(x, y) = a * x + b * y + c
+	int channelCount = values.cols();
+	const int maxChannelCount = 16;
+	double planeA[ maxChannelCount ], planeB[ maxChannelCount ], planeC[ maxChannelCount ];
+	for (int k = 0; k < channelCount; k++) {
+		double v1 = indices[ 0 ] >= 0 ? values.data( indices[ 0 ], k ) : 0;
+		double v2 = indices[ 1 ] >= 0 ? values.data( indices[ 1 ], k ) : 0;
+		double v3 = indices[ 2 ] >= 0 ? values.data( indices[ 2 ], k ) : 0;
+		planeA[ k ] = ((v2 - v1) * (y3 - y1) - (v3 - v1) * (y2 - y1)) / det;
+		planeB[ k ] = ((x2 - x1) * (v3 - v1) - (x3 - x1) * (v2 - v1)) / det;
+		planeC[ k ] = v1 - planeA[ k ] * x1 - planeB[ k ] * y1;
+	}
+
+	// find the span of each row from the edge functions, then fill it
+	int xLimit = coverage.width() - 1;
+	for (int y = yStart; y < yStop; y++) {
+		double xLow = 0, xHigh = xLimit;
+		for (int i = 0; i < 3; i++) {
+			double rowC = edgeB[ i ] * y + edgeC[ i ];
+			if (edgeA[ i ] > 0) {
+				double xBound = -rowC / edgeA[ i ];
+				if (xBound > xLow) xLow = xBound;
+			} else if (edgeA[ i ] < 0) {
+				double xBound = -rowC / edgeA[ i ];
+				if (xBound < xHigh) xHigh = xBound;
+			} else if (rowC < 0) {
+				xHigh = -1;
+			}
+		}
+		int xStart = (int) ceil( xLow ), xStop = (int) floor( xHigh ) + 1;
+		if (xStart >= xStop)
+			continue;
+		for (int k = 0; k < channelCount; k++) {
+			float *row = &images[ k ].data( 0, y );
+			float a = (float) planeA[ k ];
+			float rowValue = (float) (planeB[ k ] * y + planeC[ k ]);
+			for (int x = xStart; x < xStop; x++)
+				row[ x ] = a * (float) x + rowValue;
+		}
+		memset( &coverage.data( xStart, y ), 1, xStop - xStart );
+	}
+}
+
+
+/// use triangulation to interpolate several values per point (one column of values per channel) across a set of images;
+/// the images must be allocated by the caller, with one image per channel, all the same size (1 to 16 channels)
+void triangulationInterpolation( const MatrixF &points, const MatrixF &values, PtrArray<ImageGrayF> &images ) {
 	int pointCount = points.rows();
-	for (int i = 0; i < pointCount; i++) {
+	int channelCount = values.cols();
+	assertAlways( values.rows() == pointCount );
+	assertAlways( images.count() == channelCount && channelCount > 0 && channelCount <= 16 );
+	int width = images[ 0 ].width(), height = images[ 0 ].height();
+	for (int k = 1; k < channelCount; k++)
+		assertAlways( images[ k ].width() == width && images[ k ].height() == height );
+
+	// store point indices in mesh
+	VectorI seq( pointCount );
+	for (int i = 0; i < pointCount; i++)
+		seq[ i ] = i;
+
+	// create mesh using image bounds; each corner takes the value of the nearest point
+	PointGrid grid( points );
+	int nearestIndex[ 4 ];
+	float xMin = 0, xMax = (float) (width - 1), yMin = 0, yMax = (float) (height - 1);
+	nearestIndex[ 0 ] = grid.nearest( xMin, yMin );
+	nearestIndex[ 1 ] = grid.nearest( xMax, yMin );
+	nearestIndex[ 2 ] = grid.nearest( xMax, yMax );
+	nearestIndex[ 3 ] = grid.nearest( xMin, yMax );
+	int *cornerTag[ 4 ];
+	for (int i = 0; i < 4; i++) 
+		cornerTag[ i ] = nearestIndex[ i ] >= 0 ? &(seq.data( nearestIndex[ i ] )) : NULL;
+	Mesh *mesh = new Mesh( Point2d( xMin, yMin, cornerTag[ 0 ] ),
+						   Point2d( xMax, yMin, cornerTag[ 1 ] ),
+						   Point2d( xMax, yMax, cornerTag[ 2 ] ),
+						   Point2d( xMin, yMax, cornerTag[ 3 ] ) );
+
+	// add points in grid order, so that each point location search starts near the previous point
+	const VectorI &order = grid.order();
+	for (int j = 0; j < pointCount; j++) {
+		int i = order[ j ];
 		float x = points.data( i, 0 );
 		float y = points.data( i, 1 );
 		const float eps = 0.01f;
 		if (x > xMin + eps && x < xMax - eps && y > yMin + eps && y < yMax - eps) 
-			mesh->InsertSite( Point2d( x, y, &(values.data( i )) ));
+			mesh->InsertSite( Point2d( x, y, &(seq.data( i )) ));
 	}
 
-	// store data for per-triangle callback
-	g_triCount = 0;
-	g_triResult = result;
-
-	// execute per-triangle callback for each triangle
-	mesh->ApplyTriangles( perTriangle );
+	// collect the triangles, then we are done with the mesh
+	TriangleSet triangleSet;
+	mesh->ApplyTriangles( collectTriangle, &triangleSet );
+	delete mesh;
+	int triangleCount = triangleSet.indices.length() / 3;
+
+	// bin the triangles into horizontal bands of rows (counting sort), so bands can be rasterized independently
+	const int bandHeight = 16;
+	int bandCount = (height + bandHeight - 1) / bandHeight;
+	VectorI triangleBandStart( triangleCount ), triangleBandEnd( triangleCount );
+	VectorI bandStart( bandCount + 1 );
+	bandStart.clear( 0 );
+	for (int i = 0; i < triangleCount; i++) {
+		const float *coords = triangleSet.coords.dataPtr() + i * 6;
+		float yLow = coords[ 1 ], yHigh = coords[ 1 ];
+		if (coords[ 3 ] < yLow) yLow = coords[ 3 ];
+		if (coords[ 5 ] < yLow) yLow = coords[ 5 ];
+		if (coords[ 3 ] > yHigh) yHigh = coords[ 3 ];
+		if (coords[ 5 ] > yHigh) yHigh = coords[ 5 ];
+		int bandLow = bound( (int) floorf( yLow ) / bandHeight, 0, bandCount - 1 );
+		int bandHigh = bound( (int) ceilf( yHigh ) / bandHeight, 0, bandCount - 1 );
+		triangleBandStart[ i ] = bandLow;
+		triangleBandEnd[ i ] = bandHigh + 1;
+		for (int band = bandLow; band <= bandHigh; band++)
+			bandStart[ band + 1 ]++;
+	}
+	for (int band = 0; band < bandCount; band++)
+		bandStart[ band + 1 ] += bandStart[ band ];
+	VectorI bandPos( bandStart );
+	VectorI bandTriangles( bandStart[ bandCount ] );
+	for (int i = 0; i < triangleCount; i++) 
+		for (int band = triangleBandStart[ i ]; band < triangleBandEnd[ i ]; band++)
+			bandTriangles[ bandPos[ band ]++ ] = i;
+
+	// rasterize each band (in parallel); each pixel is computed once per covering triangle, for all channels
+	ImageGrayU coverage( width, height );
+	coverage.clear( 0 );
+	parallelFor( 0, bandCount, 1, [&]( int bandBegin, int bandEnd ) {
+		for (int band = bandBegin; band < bandEnd; band++) {
+			int yBegin = band * bandHeight;
+			int yEnd = yBegin + bandHeight < height ? yBegin + bandHeight : height;
+			for (int j = bandStart[ band ]; j < bandStart[ band + 1 ]; j++) {
+				int i = bandTriangles[ j ];
+				rasterizeTriangle( triangleSet.coords.dataPtr() + i * 6, triangleSet.indices.dataPtr() + i * 3, 
+								   values, yBegin, yEnd, images, coverage );
+			}
+		}
+	});
 
-	// fill holes 
+	// fill holes (e.g. from degenerate triangles) using already-defined neighbors
 	for (int y = 0; y < height; y++) {
 		for (int x = 0; x < width; x++) {
-			if (result->data( x, y ) == -777) {
-				if (x > 0 && result->data( x - 1, y ) != -777) {
-					result->data( x, y ) = result->data( x - 1, y );
-				} else if (y > 0 && result->data( x, y - 1 ) != -777) {
-					result->data( x, y ) = result->data( x, y - 1 );
-				} else if (x < width - 1 && result->data( x + 1, y ) != -777) {
-					result->data( x, y ) = result->data( x + 1, y );
-				} else if (y < height - 1 && result->data( x, y + 1 ) != -777) {
-					result->data( x, y ) = result->data( x, y + 1 );
-				} else {
-					result->data( x, y ) = 0;
+			if (coverage.data( x, y ) == 0) {
+				int xSrc = -1, ySrc = -1;
+				if (x > 0 && coverage.data( x - 1, y )) {
+					xSrc = x - 1; ySrc = y;
+				} else if (y > 0 && coverage.data( x, y - 1 )) {
+					xSrc = x; ySrc = y - 1;
+				} else if (x < width - 1 && coverage.data( x + 1, y )) {
+					xSrc = x + 1; ySrc = y;
+				} else if (y < height - 1 && coverage.data( x, y + 1 )) {
+					xSrc = x; ySrc = y + 1;
 				}
+				for (int k = 0; k < channelCount; k++) 
+					images[ k ].data( x, y ) = xSrc >= 0 ? images[ k ].data( xSrc, ySrc ) : 0;
+				coverage.data( x, y ) = 1;
 			}
 		}
 	}
+}
 
-	// done; clean up
-	delete mesh;
-	return aptr<ImageGrayF>( result );
+
+/// use triangulation to interpolate values across an image
+aptr<ImageGrayF> triangulationInterpolation( const MatrixF &points, const VectorF &values, int width, int height ) {
+	int pointCount = points.rows();
+	MatrixF valueMatrix( pointCount, 1 );
+	for (int i = 0; i < pointCount; i++)
+		valueMatrix.data( i, 0 ) = values[ i ];
+	aptr<ImageGrayF> result( new ImageGrayF( width, height ) );
+	PtrArray<ImageGrayF> images;
+	images.append( result.get() );
+	triangulationInterpolation( points, valueMatrix, images );
+	return result;
+}
+
+
+//-------------------------------------------
+// TEST COMMANDS
+//-------------------------------------------
+
+
+// check multi-channel interpolation against the single-channel path
+bool testTriangulationInterpolation() {
+	int width = 61, height = 43, pointCount = 50, channelCount = 3;
+	randomSeed( 5 );
+
+	// random points with a different value per channel
+	MatrixF points( pointCount, 2 ), values( pointCount, channelCount );
+	for (int i = 0; i < pointCount; i++) {
+		points.data( i, 0 ) = randomFloat( 1, (float) (width - 2) );
+		points.data( i, 1 ) = randomFloat( 1, (float) (height - 2) );
+		for (int k = 0; k < channelCount; k++)
+			values.data( i, k ) = randomFloat( -100, 100 );
+	}
+
+	// interpolate all channels at once
+	Array<ImageGrayF> channels;
+	PtrArray<ImageGrayF> images;
+	for (int k = 0; k < channelCount; k++) {
+		channels.append( new ImageGrayF( width, height ) );
+		images.append( &channels[ k ] );
+	}
+	triangulationInterpolation( points, values, images );
+
+	// each channel should match interpolating that channel alone (and stay within the range of the point values)
+	for (int k = 0; k < channelCount; k++) {
+		VectorF channelValues( pointCount );
+		for (int i = 0; i < pointCount; i++)
+			channelValues[ i ] = values.data( i, k );
+		float vMin = channelValues.min() - 0.001f, vMax = channelValues.max() + 0.001f;
+		aptr<ImageGrayF> single = triangulationInterpolation( points, channelValues, width, height );
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				float v = channels[ k ].data( x, y );
+				unitAssert( v == single->data( x, y ) && v >= vMin && v <= vMax );
+			}
+		}
+	}
+	return true;
+}
+
+
+//-------------------------------------------
+// INIT / CLEAN-UP
+//-------------------------------------------
+
+
+// register commands, etc. defined in this module
+void initTriangulation() {
+	registerUnitTest( testTriangulationInterpolation );
 }
 
 
@@ -456,8 +456,15 @@ VectorF stepSubset( const VectorF &v, int step ) {
 VectorF randomVectorF( int len, float min, float max ) {
 	assertDebug( len );
 	VectorF result( len );
-	for (int i = 0; i < len; i++) 
-		result[ i ] = randomFloat( min, max );
+	randomFillUniform( result.dataPtr(), len, min, max );
+	return result;
+}
+
+
+/// create a vector of random elements sampled from a normal distribution
+VectorF randomGaussianVectorF( int len, float mean, float sdev ) {
+	VectorF result( len );
+	randomFillGaussian( result.dataPtr(), len, mean, sdev );
 	return result;
 }
 
@@ -6,9 +6,12 @@
 #include <sys/stat.h>
 #ifdef WIN32
 	#include <external/win_dirent.h>
+	#include <windows.h>
 #else
 	#include <dirent.h>
 	#include <unistd.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
 #endif
 namespace sbl {
 
@@ -199,6 +202,65 @@ int fileModificationTimestamp( const String &fileName ) {
 }
 
 
+//-------------------------------------------
+// MAPPED FILE CLASS
+//-------------------------------------------
+
+
+/// map the given file; check openSuccess() before using the data
+MappedFile::MappedFile( const String &fileName ) {
+	m_data = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+#ifdef WIN32
+	HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	m_fileHandle = file;
+	LARGE_INTEGER size;
+	if (GetFileSizeEx( file, &size ) == 0 || size.QuadPart == 0)
+		return;
+	HANDLE mapping = CreateFileMapping( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+	if (mapping == NULL)
+		return;
+	m_mappingHandle = mapping;
+	m_data = (unsigned char *) MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+	if (m_data)
+		m_size = (size_t) size.QuadPart;
+#else
+	int file = ::open( fileName.c_str(), O_RDONLY );
+	if (file < 0)
+		return;
+	struct stat fileInfo;
+	if (fstat( file, &fileInfo ) == 0 && fileInfo.st_size > 0) {
+		void *data = mmap( NULL, (size_t) fileInfo.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0 );
+		if (data != MAP_FAILED) {
+			m_data = (unsigned char *) data;
+			m_size = (size_t) fileInfo.st_size;
+		}
+	}
+	::close( file ); // (the mapping remains valid after the file is closed)
+#endif
+}
+
+
+/// unmap the file
+MappedFile::~MappedFile() {
+#ifdef WIN32
+	if (m_data)
+		UnmapViewOfFile( m_data );
+	if (m_mappingHandle)
+		CloseHandle( (HANDLE) m_mappingHandle );
+	if (m_fileHandle)
+		CloseHandle( (HANDLE) m_fileHandle );
+#else
+	if (m_data)
+		munmap( m_data, m_size );
+#endif
+}
+
+
 //-------------------------------------------
 // OPERATING SYSTEM UTILITIES
 //-------------------------------------------
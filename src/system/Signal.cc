@@ -8,16 +8,16 @@
 namespace sbl {
 
 
-// control-C handler
+// control-C handler; sets the command cancel token first (a lock-free store), so that worker threads polling it stop promptly
 void handleCtrlC( int signal ) {
 	static int s_count = 0;
+	commandCancelToken().cancel();
 	s_count++;
 	if (s_count >= 3) {
 		warning( "three Ctrl-C events; shutting down" );
 		exit( 1 );
 	} 
 	disp( 1, "cancelling..." );
-	setCancelCommand( true );
 }
 
 